@@ -1,14 +1,19 @@
 #ifndef FFI_CONFIG_HPP
 #define FFI_CONFIG_HPP
 
+#include <cstdint>
 #include <libfreenect2/libfreenect2.hpp>
 #include <memory>
 
 #include "macros.hpp"
 
+enum class DepthStreams : ::std::uint8_t;
+
 namespace libfreenect2_ffi {
   class Config {
    public:
+    Config();
+
     LIBFREENECT2_RS_FUNC float get_min_depth() const noexcept;
 
     LIBFREENECT2_RS_FUNC float get_max_depth() const noexcept;
@@ -17,6 +22,8 @@ namespace libfreenect2_ffi {
 
     LIBFREENECT2_RS_FUNC bool get_enable_edge_aware_filter() const noexcept;
 
+    LIBFREENECT2_RS_FUNC DepthStreams get_depth_streams() const noexcept;
+
     LIBFREENECT2_MAYBE_UNUSED void set_min_depth(float min_depth) noexcept;
 
     LIBFREENECT2_MAYBE_UNUSED void set_max_depth(float max_depth) noexcept;
@@ -27,7 +34,11 @@ namespace libfreenect2_ffi {
     LIBFREENECT2_MAYBE_UNUSED void set_enable_edge_aware_filter(
         bool enable_edge_aware_filter) noexcept;
 
+    LIBFREENECT2_MAYBE_UNUSED void set_depth_streams(
+        DepthStreams streams) noexcept;
+
     libfreenect2::Freenect2Device::Config config;
+    DepthStreams depth_streams;
   };
 
   LIBFREENECT2_RS_FUNC std::unique_ptr<Config> create_config();
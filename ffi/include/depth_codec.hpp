@@ -0,0 +1,97 @@
+#ifndef FFI_DEPTH_CODEC_HPP
+#define FFI_DEPTH_CODEC_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "frame.hpp"
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+namespace libfreenect2_ffi {
+  /**
+   * Get the maximum size of an encoded depth frame, including the
+   * header. Encoded frames are never larger than the float frame plus
+   * the 32 byte header and one trailing partial word, 36 bytes in total.
+   */
+  LIBFREENECT2_RS_FUNC uint64_t max_encoded_depth_size(uint64_t width,
+                                                       uint64_t height);
+
+  /**
+   * Check whether encoded depth data is a keyframe,
+   * which can be decoded without the previous frames.
+   */
+  LIBFREENECT2_RS_FUNC bool is_depth_keyframe(rust::Slice<const uint8_t> data);
+
+  /**
+   * Compresses float depth frames for transport.
+   *
+   * Depths are rounded to 16 bit millimeters. Keyframes store the
+   * depths, the frames in between the difference to the previous
+   * frame. Both are compressed using RVL, which stores runs of zeros
+   * and variable-length deltas of the other values, see
+   * https://www.microsoft.com/en-us/research/publication/fast-lossless-depth-image-compression/
+   */
+  class DepthEncoder {
+   public:
+    explicit DepthEncoder(uint32_t keyframe_interval);
+
+    /**
+     * Encode a frame into dst, which must hold at least
+     * max_encoded_depth_size() bytes. Returns the encoded size.
+     */
+    LIBFREENECT2_RS_FUNC uint64_t encode(rust::Slice<const uint8_t> depth,
+                                         uint64_t width, uint64_t height,
+                                         uint32_t timestamp, uint32_t sequence,
+                                         uint32_t status,
+                                         rust::Slice<uint8_t> dst);
+
+    /**
+     * Encode the next frame as a keyframe.
+     */
+    LIBFREENECT2_MAYBE_UNUSED void force_keyframe() noexcept;
+
+   private:
+    const uint32_t keyframe_interval;
+    uint32_t index;
+    bool keyframe;
+    uint64_t width;
+    uint64_t height;
+    std::vector<uint16_t> current;
+    std::vector<uint16_t> previous;
+  };
+
+  /**
+   * Decodes the frames of a DepthEncoder to float depth frames.
+   * Frames must be decoded in the order they were encoded in,
+   * starting with a keyframe.
+   */
+  class DepthDecoder {
+   public:
+    DepthDecoder();
+
+    LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> decode(
+        rust::Slice<const uint8_t> data);
+
+    /**
+     * Drop the previous frame, so only a keyframe can be decoded next.
+     */
+    LIBFREENECT2_MAYBE_UNUSED void reset() noexcept;
+
+   private:
+    bool has_previous;
+    uint32_t index;
+    uint64_t width;
+    uint64_t height;
+    std::vector<uint16_t> previous;
+    std::vector<uint16_t> decoded;
+  };
+
+  LIBFREENECT2_RS_FUNC std::unique_ptr<DepthEncoder> create_depth_encoder(
+      uint32_t keyframe_interval);
+
+  LIBFREENECT2_RS_FUNC std::unique_ptr<DepthDecoder> create_depth_decoder();
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_DEPTH_CODEC_HPP
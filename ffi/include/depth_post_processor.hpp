@@ -0,0 +1,71 @@
+#ifndef FFI_DEPTH_POST_PROCESSOR_HPP
+#define FFI_DEPTH_POST_PROCESSOR_HPP
+
+#include <cstdint>
+#include <libfreenect2/frame_listener.hpp>
+#include <memory>
+#include <vector>
+
+#include "frame.hpp"
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+struct DepthPostProcessingParams;
+
+namespace libfreenect2_ffi {
+  /**
+   * Post-processes float depth frames in place. The enabled stages run
+   * in a fixed order: range clipping, decimation, hole filling and
+   * temporal smoothing. Depths <= 0 and NaN are invalid, every stage
+   * writes invalid depths as 0.
+   *
+   * The temporal stage keeps the previous output, so a processor should
+   * only be used for the frames of a single stream.
+   */
+  class DepthPostProcessor {
+   public:
+    explicit DepthPostProcessor(const DepthPostProcessingParams &params);
+
+    /**
+     * Process a depth frame in place. Decimation reduces the width and
+     * height of the frame and packs the pixels at the start of its data.
+     */
+    LIBFREENECT2_MAYBE_UNUSED void apply(libfreenect2::Frame &frame);
+
+    /**
+     * Process a copy of a depth frame, with the metadata of the frame.
+     */
+    LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> process(
+        rust::Slice<const uint8_t> depth, uint64_t width, uint64_t height,
+        uint32_t timestamp, uint32_t sequence, uint32_t status);
+
+    /**
+     * Forget the previous frame, so the next frame isn't smoothed.
+     */
+    LIBFREENECT2_MAYBE_UNUSED void reset() noexcept;
+
+   private:
+    void fill_holes(float *depth, size_t width, size_t height);
+
+    void smooth(float *depth, size_t width, size_t height);
+
+    const bool clip_range;
+    const float min_depth;
+    const float max_depth;
+    const size_t decimation;
+    const size_t hole_fill_radius;
+    const bool temporal;
+    const float temporal_alpha;
+    const float temporal_threshold;
+
+    size_t history_width;
+    size_t history_height;
+    std::vector<float> history;
+    std::vector<float> scratch;
+  };
+
+  LIBFREENECT2_RS_FUNC std::unique_ptr<DepthPostProcessor>
+  create_depth_post_processor(const DepthPostProcessingParams &params);
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_DEPTH_POST_PROCESSOR_HPP
@@ -4,6 +4,7 @@
 #include <libfreenect2/frame_listener.hpp>
 #include <memory>
 
+#include "frame_pool.hpp"
 #include "macros.hpp"
 #include "rust/cxx.h"
 
@@ -17,6 +18,9 @@ namespace libfreenect2_ffi {
    public:
     explicit Frame(libfreenect2::Frame* frame);
 
+    Frame(libfreenect2::Frame* frame, libfreenect2::Frame::Type type,
+          std::shared_ptr<FramePool> pool);
+
     LIBFREENECT2_RS_FUNC uint64_t width() const;
     LIBFREENECT2_RS_FUNC uint64_t height() const;
     LIBFREENECT2_RS_FUNC uint64_t bytes_per_pixel() const;
@@ -29,11 +33,27 @@ namespace libfreenect2_ffi {
     LIBFREENECT2_RS_FUNC uint32_t status() const;
     LIBFREENECT2_RS_FUNC FrameFormat format() const;
 
+    /**
+     * The steady_clock_ns() time the frame was received from
+     * the packet pipeline, 0 if it wasn't received from a pipeline.
+     */
+    LIBFREENECT2_RS_FUNC uint64_t received_ns() const;
+
     ~Frame();
 
     libfreenect2::Frame* frame;
+    uint64_t received;
+
+   private:
+    libfreenect2::Frame::Type type;
+    std::shared_ptr<FramePool> pool;
   };
 
+  /**
+   * Get the current time of the steady clock in nanoseconds.
+   */
+  LIBFREENECT2_RS_FUNC uint64_t steady_clock_ns() noexcept;
+
   LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> create_frame(
       uint64_t width, uint64_t height, uint64_t bytes_per_pixel,
       unsigned char* data, uint32_t timestamp, uint32_t sequence,
@@ -43,16 +63,32 @@ namespace libfreenect2_ffi {
   LIBFREENECT2_RS_FUNC std::unique_ptr<libfreenect2::FrameListener>
   create_frame_listener(
       rust::cxxbridge1::Box<CallContext> ctx,
-      rust::Fn<rust::String(FrameType, std::unique_ptr<Frame>,
-                            const rust::cxxbridge1::Box<CallContext>&)>
+      rust::Fn<void(FrameType, std::unique_ptr<Frame>,
+                    const rust::cxxbridge1::Box<CallContext>&)>
           on_new_frame);
 
-#ifndef NDEBUG
+  LIBFREENECT2_RS_FUNC std::unique_ptr<libfreenect2::FrameListener>
+  create_pooled_frame_listener(
+      rust::cxxbridge1::Box<CallContext> ctx,
+      rust::Fn<void(FrameType, std::unique_ptr<Frame>,
+                    const rust::cxxbridge1::Box<CallContext>&)>
+          on_new_frame,
+      const std::shared_ptr<FramePool>& pool);
+
+  /**
+   * Pass a copy of a frame to a listener, as if it was
+   * received from a packet pipeline.
+   */
+  LIBFREENECT2_MAYBE_UNUSED void replay_frame(
+      const std::unique_ptr<libfreenect2::FrameListener>& listener,
+      FrameType type, const Frame& frame);
+
+#if !defined(NDEBUG) || defined(LIBFREENECT2_RS_BENCH)
   namespace test {
     LIBFREENECT2_MAYBE_UNUSED void call_frame_listener(
-        std::unique_ptr<libfreenect2::FrameListener>& listener, FrameType type,
-        uint64_t width, uint64_t height, uint64_t bytes_per_pixel,
-        unsigned char* data);
+        const std::unique_ptr<libfreenect2::FrameListener>& listener,
+        FrameType type, uint64_t width, uint64_t height,
+        uint64_t bytes_per_pixel, unsigned char* data);
   }
 #endif
 }  // namespace libfreenect2_ffi
@@ -0,0 +1,51 @@
+#ifndef FFI_FRAME_CONVERT_HPP
+#define FFI_FRAME_CONVERT_HPP
+
+#include <cstdint>
+
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+enum class PixelLayout : ::std::uint8_t;
+enum class Colormap : ::std::uint8_t;
+
+namespace libfreenect2_ffi {
+  /**
+   * Reorder the channels of packed 8 bit pixels from src_layout to
+   * dst_layout. Alpha channels are always written as 255, the unused
+   * byte of BGRX and RGBX pixels is read as alpha and ignored.
+   * dst must hold at least as many pixels as src.
+   */
+  LIBFREENECT2_MAYBE_UNUSED void convert_pixels(rust::Slice<const uint8_t> src,
+                                                PixelLayout src_layout,
+                                                rust::Slice<uint8_t> dst,
+                                                PixelLayout dst_layout);
+
+  /**
+   * Convert float depth values in millimeters, as stored in depth
+   * frames, to 16 bit millimeters. Values are rounded to the nearest
+   * millimeter and saturated at 65535, invalid values are written as 0.
+   */
+  LIBFREENECT2_MAYBE_UNUSED void depth_to_millimeters(
+      rust::Slice<const uint8_t> depth, rust::Slice<uint16_t> dst);
+
+  /**
+   * Map float depth values to RGB pixels using a colormap.
+   * min_depth maps to the first and max_depth to the last color of the
+   * colormap, depths outside the range are clamped. Invalid values are
+   * written as black.
+   */
+  LIBFREENECT2_MAYBE_UNUSED void depth_to_colormap(
+      rust::Slice<const uint8_t> depth, float min_depth, float max_depth,
+      Colormap colormap, rust::Slice<uint8_t> dst);
+
+  /**
+   * Scale float IR values from [0, max_value] to 8 bit gray values.
+   * Values above max_value are saturated.
+   */
+  LIBFREENECT2_MAYBE_UNUSED void normalize_ir(rust::Slice<const uint8_t> ir,
+                                              float max_value,
+                                              rust::Slice<uint8_t> dst);
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_FRAME_CONVERT_HPP
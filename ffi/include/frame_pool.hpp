@@ -0,0 +1,65 @@
+#ifndef FFI_FRAME_POOL_HPP
+#define FFI_FRAME_POOL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <libfreenect2/frame_listener.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "macros.hpp"
+
+enum class FrameType : ::std::uint8_t;
+
+namespace libfreenect2_ffi {
+  /**
+   * A fixed-size ring of preallocated frames per frame type.
+   * Frames are handed out by pooled frame listeners and
+   * returned to the pool once the owning Frame is destroyed.
+   * The frames of a type are allocated and touched by the thread
+   * delivering the first frame, so they follow its NUMA memory policy.
+   */
+  class FramePool {
+   public:
+    explicit FramePool(uint64_t capacity);
+
+    ~FramePool();
+
+    /**
+     * Get a free frame matching the dimensions of source.
+     * Returns nullptr if all frames of that type are in use.
+     */
+    libfreenect2::Frame *acquire(libfreenect2::Frame::Type type,
+                                 const libfreenect2::Frame &source);
+
+    void release(libfreenect2::Frame::Type type, libfreenect2::Frame *frame);
+
+    LIBFREENECT2_RS_FUNC uint64_t capacity() const noexcept;
+
+    LIBFREENECT2_RS_FUNC uint64_t exhausted_count() const noexcept;
+
+    LIBFREENECT2_RS_FUNC uint64_t available(FrameType type) const;
+
+   private:
+    struct Ring {
+      size_t width = 0;
+      size_t height = 0;
+      size_t bytes_per_pixel = 0;
+      std::vector<libfreenect2::Frame *> free;
+    };
+
+    void reset_ring(Ring &ring, const libfreenect2::Frame &source) const;
+
+    const uint64_t capacity_;
+    std::atomic<uint64_t> exhausted;
+    mutable std::mutex mutex;
+    std::map<libfreenect2::Frame::Type, Ring> rings;
+  };
+
+  LIBFREENECT2_RS_FUNC std::shared_ptr<FramePool> create_frame_pool(
+      uint64_t capacity);
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_FRAME_POOL_HPP
@@ -1,17 +1,51 @@
 #ifndef FFI_FREENECT2_DEVICE_HPP
 #define FFI_FREENECT2_DEVICE_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <libfreenect2/libfreenect2.hpp>
 #include <memory>
 
 #include "config.hpp"
+#include "depth_post_processor.hpp"
 #include "macros.hpp"
+#include "packet_stats.hpp"
 #include "registration.hpp"
 #include "rust/cxx.h"
 
 struct LedSettings;
+struct PacketStats;
+struct CameraParams;
+struct DepthPostProcessingParams;
+enum class DepthStreams : ::std::uint8_t;
 
 namespace libfreenect2_ffi {
+  /**
+   * Forwards the IR and depth frames selected by the device config to
+   * the listener. Other frames are left to the depth packet processor,
+   * which reuses them for the next packet.
+   * Depth frames are post-processed in place before they are forwarded.
+   * All frames are counted, including the ones which are not forwarded.
+   *
+   * libfreenect2 does not wait for the depth processor thread when the
+   * device is stopped, so the post-processor may be replaced while a frame
+   * is processed. It is only accessed through atomic shared_ptr operations,
+   * so the thread keeps the previous post-processor alive until it is done.
+   */
+  class DepthStreamFilter : public libfreenect2::FrameListener {
+   public:
+    DepthStreamFilter();
+
+    bool onNewFrame(libfreenect2::Frame::Type type,
+                    libfreenect2::Frame* frame) override;
+
+    libfreenect2::FrameListener* listener;
+    // Replaced by set_config while the depth processor thread may run
+    std::atomic<uint8_t> streams;
+    std::shared_ptr<DepthPostProcessor> post_processor;
+    PacketCounter* counter;
+  };
+
   class Freenect2Device {
    public:
     explicit Freenect2Device(libfreenect2::Freenect2Device* device);
@@ -41,11 +75,36 @@ namespace libfreenect2_ffi {
 
     LIBFREENECT2_RS_FUNC std::unique_ptr<Registration> get_registration();
 
+    LIBFREENECT2_RS_FUNC std::unique_ptr<Registration>
+    get_registration_with_engine(RegistrationEngine engine, uint64_t threads);
+
+    /**
+     * Get the camera parameters the registration is computed from.
+     * Only valid once the device was started.
+     */
+    LIBFREENECT2_RS_FUNC CameraParams get_camera_params();
+
+    LIBFREENECT2_MAYBE_UNUSED void set_depth_post_processing(
+        const DepthPostProcessingParams& params);
+
+    LIBFREENECT2_MAYBE_UNUSED void clear_depth_post_processing() noexcept;
+
     LIBFREENECT2_MAYBE_UNUSED void set_led_settings(
         const LedSettings& settings);
 
+    /**
+     * Get the number of frames received and packets lost per stream
+     * since the device was opened or the stats were last reset.
+     */
+    LIBFREENECT2_RS_FUNC PacketStats get_packet_stats() const noexcept;
+
+    LIBFREENECT2_MAYBE_UNUSED void reset_packet_stats() noexcept;
+
    private:
     libfreenect2::Freenect2Device* device;
+    PacketCounter packets;
+    ColorStreamCounter color_counter;
+    DepthStreamFilter depth_filter;
 
    public:
     Freenect2Device() = default;
@@ -0,0 +1,19 @@
+#ifndef FFI_GPU_DEVICES_HPP
+#define FFI_GPU_DEVICES_HPP
+
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+struct GpuDevice;
+
+namespace libfreenect2_ffi {
+  /**
+   * List the OpenCL and CUDA devices packet pipelines can run on.
+   * The index of every device is the device id the matching
+   * libfreenect2 pipeline expects. Only APIs enabled at
+   * compile time are queried.
+   */
+  LIBFREENECT2_RS_FUNC rust::Vec<GpuDevice> list_gpu_devices();
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_GPU_DEVICES_HPP
@@ -0,0 +1,55 @@
+#ifndef FFI_JPEG_DECODER_HPP
+#define FFI_JPEG_DECODER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "frame.hpp"
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+struct ColorDecodeParams;
+
+namespace libfreenect2_ffi {
+  /**
+   * Decodes the JPEG payload of undecoded color frames using
+   * libjpeg-turbo. Scaling is done by the decoder by dropping
+   * DCT coefficients, so a 1/8 scale decode only runs the inverse
+   * DCT on one coefficient per 8x8 block. Regions are cropped
+   * losslessly, before decoding, to the smallest MCU aligned
+   * rectangle containing them.
+   */
+  class JpegDecoder {
+   public:
+    JpegDecoder();
+
+    JpegDecoder(const JpegDecoder&) = delete;
+    JpegDecoder& operator=(const JpegDecoder&) = delete;
+
+    ~JpegDecoder();
+
+    /**
+     * Decode a JPEG image into a new frame.
+     * The metadata is copied to the returned frame.
+     */
+    LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> decode(
+        rust::Slice<const uint8_t> jpeg, const ColorDecodeParams& params,
+        uint32_t timestamp, uint32_t sequence, float exposure, float gain,
+        float gamma, uint32_t status);
+
+   private:
+    void* decompressor;
+    void* transformer;
+    std::vector<uint8_t> scratch;
+  };
+
+  /**
+   * Check if the library was built with a JPEG decoder.
+   */
+  LIBFREENECT2_RS_FUNC bool jpeg_decoder_available() noexcept;
+
+  LIBFREENECT2_RS_FUNC std::unique_ptr<JpegDecoder> create_jpeg_decoder();
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_JPEG_DECODER_HPP
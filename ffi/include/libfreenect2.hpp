@@ -10,6 +10,7 @@
 #include "rust/cxx.h"
 
 enum class PacketPipeline : uint8_t;
+enum class RawPackets : uint8_t;
 
 namespace libfreenect2_ffi {
   class Freenect2 {
@@ -29,19 +30,24 @@ namespace libfreenect2_ffi {
 
     LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device>
     open_device_by_id_with_packet_pipeline(int32_t idx,
-                                           PacketPipeline pipeline);
+                                           PacketPipeline pipeline,
+                                           int32_t device_id, RawPackets raw);
 
     LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device> open_device_by_serial(
         rust::Str serial);
 
     LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device>
     open_device_by_serial_with_packet_pipeline(rust::Str serial,
-                                               PacketPipeline pipeline);
+                                               PacketPipeline pipeline,
+                                               int32_t device_id,
+                                               RawPackets raw);
 
     LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device> open_default_device();
 
     LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device>
-    open_default_device_with_packet_pipeline(PacketPipeline pipeline);
+    open_default_device_with_packet_pipeline(PacketPipeline pipeline,
+                                             int32_t device_id,
+                                             RawPackets raw);
 
    private:
     libfreenect2::Freenect2 freenect2;
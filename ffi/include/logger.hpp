@@ -9,8 +9,19 @@
 enum class LogLevel : ::std::uint8_t;
 
 namespace libfreenect2_ffi {
+  /**
+   * Install a global libfreenect2 logger.
+   *
+   * The logger only accepts messages up to the level returned by
+   * level_fn, so libfreenect2 doesn't format messages which would be
+   * dropped. Accepted messages are copied into a fixed-size lock-free
+   * ring and passed to log_fn by a background thread, which also
+   * polls level_fn. Logging never blocks or allocates on the calling
+   * thread, messages are dropped if the ring is full.
+   */
   LIBFREENECT2_MAYBE_UNUSED void create_logger(
-      rust::Fn<void(LogLevel, const rust::String &)> log_fn);
+      rust::Fn<void(LogLevel, rust::Str)> log_fn,
+      rust::Fn<LogLevel()> level_fn);
 }  // namespace libfreenect2_ffi
 
-#endif  // FFI_LOGGER_HPP
\ No newline at end of file
+#endif  // FFI_LOGGER_HPP
@@ -0,0 +1,80 @@
+#ifndef FFI_PACKET_STATS_HPP
+#define FFI_PACKET_STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <libfreenect2/frame_listener.hpp>
+
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+struct PacketStats;
+struct StreamStats;
+
+namespace libfreenect2_ffi {
+  /**
+   * Counts the frames of a device and the packets lost in between.
+   *
+   * libfreenect2 numbers the packets of every stream and copies the
+   * number into the sequence of the frames. Packets dropped on the USB
+   * bus, packets which were received incompletely and packets skipped
+   * because the packet processor was still busy never become frames,
+   * so they show up as gaps in the sequence of the delivered frames.
+   * Every stream is recorded by a single thread, stats may be read
+   * and reset from any thread.
+   */
+  class PacketCounter {
+   public:
+    PacketCounter();
+
+    void record(libfreenect2::Frame::Type type, uint32_t sequence) noexcept;
+
+    PacketStats stats() const noexcept;
+
+    void reset() noexcept;
+
+   private:
+    struct Stream {
+      std::atomic<uint64_t> frames;
+      std::atomic<uint64_t> lost;
+      std::atomic<uint64_t> gaps;
+      // The last sequence plus one, or zero if no frame was recorded
+      std::atomic<uint64_t> next;
+
+      StreamStats stats() const noexcept;
+
+      void reset() noexcept;
+    };
+
+    Stream color;
+    Stream ir;
+    Stream depth;
+  };
+
+  /**
+   * Forwards the frames of the color stream to the listener,
+   * counting them using the device's packet counter.
+   */
+  class ColorStreamCounter : public libfreenect2::FrameListener {
+   public:
+    ColorStreamCounter();
+
+    bool onNewFrame(libfreenect2::Frame::Type type,
+                    libfreenect2::Frame* frame) override;
+
+    libfreenect2::FrameListener* listener;
+    PacketCounter* counter;
+  };
+
+#if !defined(NDEBUG) || defined(LIBFREENECT2_RS_BENCH)
+  namespace test {
+    /**
+     * Count the color frames with the given sequences.
+     */
+    LIBFREENECT2_RS_FUNC StreamStats
+    count_packets(rust::Slice<const uint32_t> sequences);
+  }
+#endif
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_PACKET_STATS_HPP
@@ -0,0 +1,86 @@
+#ifndef FFI_PARALLEL_REGISTRATION_HPP
+#define FFI_PARALLEL_REGISTRATION_HPP
+
+#include <libfreenect2/libfreenect2.hpp>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "registration_tables.hpp"
+#include "worker_pool.hpp"
+
+struct Region;
+
+namespace libfreenect2_ffi {
+  /**
+   * A multi-threaded implementation of libfreenect2::Registration.
+   * Uses the same lookup tables as libfreenect2, which may be shared
+   * with other registrations, and splits the per-pixel passes of apply
+   * into row blocks executed on a worker pool.
+   * The filter pass is partitioned by output index instead of by input
+   * pixel, so no two threads ever write the same filter map entry and
+   * the result does not depend on the order tasks are executed in.
+   */
+  class ParallelRegistration {
+   public:
+    ParallelRegistration(std::shared_ptr<const RegistrationTables> tables,
+                         size_t threads);
+
+    /**
+     * Same as libfreenect2::Registration::apply.
+     * Does nothing if any of the frames has an invalid size.
+     */
+    void apply(const libfreenect2::Frame *rgb,
+               const libfreenect2::Frame *depth,
+               libfreenect2::Frame *undistorted,
+               libfreenect2::Frame *registered, bool enable_filter,
+               libfreenect2::Frame *bigdepth) const;
+
+    /**
+     * Same as apply without a big depth frame, but only computes the
+     * registered pixels within a region of the depth frame. The result
+     * within the region equals the result of apply. If the filter is
+     * enabled, the undistorted frame is still computed for all pixels,
+     * as pixels outside the region may occlude pixels within it.
+     * Otherwise, both output frames are left unchanged outside the region.
+     * The region must be within the depth frame.
+     */
+    void apply(const libfreenect2::Frame *rgb,
+               const libfreenect2::Frame *depth,
+               libfreenect2::Frame *undistorted,
+               libfreenect2::Frame *registered, bool enable_filter,
+               const Region &region) const;
+
+    /**
+     * Same as libfreenect2::Registration::undistortDepth.
+     */
+    void undistort_depth(const libfreenect2::Frame *depth,
+                         libfreenect2::Frame *undistorted) const;
+
+   private:
+    /**
+     * A rectangle of depth pixels.
+     */
+    struct Rect {
+      int x, y, width, height;
+    };
+
+    void apply(const libfreenect2::Frame *rgb,
+               const libfreenect2::Frame *depth,
+               libfreenect2::Frame *undistorted,
+               libfreenect2::Frame *registered, bool enable_filter,
+               libfreenect2::Frame *bigdepth, const Rect &rect) const;
+
+    const std::shared_ptr<const RegistrationTables> tables;
+
+    mutable std::mutex mutex;
+    mutable std::vector<int> color_offsets;
+    mutable std::vector<std::pair<int, int>> block_ranges;
+    mutable std::vector<std::pair<int, int>> rect_ranges;
+    mutable std::vector<float> filter_map;
+    mutable WorkerPool pool;
+  };
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_PARALLEL_REGISTRATION_HPP
@@ -1,22 +1,57 @@
 #ifndef FFI_REGISTRATION_HPP
 #define FFI_REGISTRATION_HPP
 
+#include <cstdint>
 #include <libfreenect2/registration.h>
+#include <memory>
+#include <vector>
 
 #include "frame.hpp"
 #include "macros.hpp"
+#include "parallel_registration.hpp"
+#include "registration_tables.hpp"
+#include "rust/cxx.h"
+
+enum class RegistrationEngine : ::std::uint8_t;
+struct Region;
 
 namespace libfreenect2_ffi {
   class Registration {
    public:
     explicit Registration(libfreenect2::Freenect2Device* device);
 
+    Registration(libfreenect2::Freenect2Device* device,
+                 RegistrationEngine engine, uint64_t threads);
+
+    Registration(const libfreenect2::Freenect2Device::IrCameraParams& depth_p,
+                 const libfreenect2::Freenect2Device::ColorCameraParams& rgb_p,
+                 RegistrationEngine engine, uint64_t threads);
+
+    /**
+     * Create a registration from precomputed tables. The parallel engine
+     * uses the tables as they are, the libfreenect2 engine computes its
+     * own tables from the camera parameters of the tables.
+     */
+    Registration(std::shared_ptr<const RegistrationTables> tables,
+                 RegistrationEngine engine, uint64_t threads);
+
     LIBFREENECT2_MAYBE_UNUSED void map_depth_to_color(const Frame& depth,
                                                       const Frame& color,
                                                       Frame& undistorted_depth,
                                                       Frame& color_depth_image,
                                                       bool enable_filter) const;
 
+    /**
+     * Same as map_depth_to_color, but only the pixels within region
+     * of the output frames are guaranteed to be computed. The parallel
+     * engine skips the other pixels, the libfreenect2 engine computes
+     * the whole frames.
+     */
+    LIBFREENECT2_MAYBE_UNUSED void map_depth_to_color_region(
+        const Frame& depth, const Frame& color, Frame& undistorted_depth,
+        Frame& color_depth_image, bool enable_filter,
+        const Region& region) const;
+
     LIBFREENECT2_MAYBE_UNUSED void map_depth_to_full_color(
         const Frame& depth, const Frame& color, Frame& undistorted_depth,
         Frame& color_depth_image, bool enable_filter, Frame& big_depth) const;
@@ -24,9 +59,62 @@ namespace libfreenect2_ffi {
     LIBFREENECT2_MAYBE_UNUSED void undistort_depth(
         const Frame& depth, Frame& undistorted_depth) const;
 
+    /**
+     * Write the points of an undistorted depth frame to points as
+     * interleaved x, y, z values in meters. Returns the number of points.
+     * Invalid pixels are skipped or written as NaN.
+     */
+    LIBFREENECT2_RS_FUNC uint64_t get_points_xyz(const Frame& undistorted_depth,
+                                                 rust::Slice<float> points,
+                                                 bool skip_invalid) const;
+
+    /**
+     * Same as get_points_xyz, but every point is followed by
+     * the color of the registered pixel, stored in the bits of a float.
+     */
+    LIBFREENECT2_RS_FUNC uint64_t get_points_xyzrgb(
+        const Frame& undistorted_depth, const Frame& color_depth_image,
+        rust::Slice<float> points, bool skip_invalid) const;
+
+    /**
+     * Same as get_points_xyz, but only for the pixels within region,
+     * in row-major order of the region.
+     */
+    LIBFREENECT2_RS_FUNC uint64_t get_points_xyz_region(
+        const Frame& undistorted_depth, const Region& region,
+        rust::Slice<float> points, bool skip_invalid) const;
+
+    /**
+     * Same as get_points_xyzrgb, but only for the pixels within region,
+     * in row-major order of the region.
+     */
+    LIBFREENECT2_RS_FUNC uint64_t get_points_xyzrgb_region(
+        const Frame& undistorted_depth, const Frame& color_depth_image,
+        const Region& region, rust::Slice<float> points,
+        bool skip_invalid) const;
+
    private:
-    libfreenect2::Registration registration;
+    template <size_t Stride>
+    uint64_t get_points(const Frame& undistorted_depth,
+                        const Frame* color_depth_image, const Region* region,
+                        rust::Slice<float> points, bool skip_invalid) const;
+
+    std::shared_ptr<const RegistrationTables> tables;
+    std::unique_ptr<libfreenect2::Registration> registration;
+    std::unique_ptr<ParallelRegistration> parallel;
   };
+
+  LIBFREENECT2_RS_FUNC std::unique_ptr<Registration>
+  create_registration_from_tables(
+      const std::shared_ptr<RegistrationTables>& tables,
+      RegistrationEngine engine, uint64_t threads);
+
+#if !defined(NDEBUG) || defined(LIBFREENECT2_RS_BENCH)
+  namespace test {
+    LIBFREENECT2_RS_FUNC std::unique_ptr<Registration> create_registration(
+        RegistrationEngine engine, uint64_t threads);
+  }
+#endif
 }  // namespace libfreenect2_ffi
 
 #endif  // FFI_REGISTRATION_HPP
@@ -0,0 +1,105 @@
+#ifndef FFI_REGISTRATION_TABLES_HPP
+#define FFI_REGISTRATION_TABLES_HPP
+
+#include <cstdint>
+#include <libfreenect2/libfreenect2.hpp>
+#include <memory>
+#include <vector>
+
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+struct CameraParams;
+
+namespace libfreenect2_ffi {
+  CameraParams to_camera_params(
+      const libfreenect2::Freenect2Device::IrCameraParams &depth_p,
+      const libfreenect2::Freenect2Device::ColorCameraParams &rgb_p);
+
+  /**
+   * The camera parameters of a device and the lookup tables computed
+   * from them, which map depth pixels to undistorted and color pixels.
+   * The tables are immutable once created, so a single instance can be
+   * shared by any number of registrations on any number of threads.
+   *
+   * Serialized tables start with a 164 byte header holding the camera
+   * parameters, followed by the tables in native byte order.
+   */
+  class RegistrationTables {
+   public:
+    RegistrationTables(
+        const libfreenect2::Freenect2Device::IrCameraParams &depth_p,
+        const libfreenect2::Freenect2Device::ColorCameraParams &rgb_p);
+
+    /**
+     * Read serialized tables, without computing them again.
+     */
+    static std::shared_ptr<RegistrationTables> deserialize(
+        rust::Slice<const uint8_t> data);
+
+    LIBFREENECT2_RS_FUNC CameraParams camera_params() const noexcept;
+
+    LIBFREENECT2_RS_FUNC uint64_t serialized_size() const noexcept;
+
+    /**
+     * Serialize the tables into dst, which must be
+     * exactly serialized_size() bytes long.
+     */
+    LIBFREENECT2_MAYBE_UNUSED void serialize(rust::Slice<uint8_t> dst) const;
+
+    const libfreenect2::Freenect2Device::IrCameraParams &depth_params()
+        const noexcept;
+
+    const libfreenect2::Freenect2Device::ColorCameraParams &color_params()
+        const noexcept;
+
+    /**
+     * The index of the distorted depth pixel of every
+     * undistorted depth pixel, or -1 if it is outside the frame.
+     */
+    const std::vector<int> &distort_map() const noexcept;
+
+    /**
+     * The color column of every depth pixel, before the depth
+     * dependent shift is applied, in units of the focal length.
+     */
+    const std::vector<float> &depth_to_color_map_x() const noexcept;
+
+    /**
+     * The color row of every depth pixel.
+     */
+    const std::vector<int> &depth_to_color_map_yi() const noexcept;
+
+    /**
+     * The x component of the ray of every column
+     * of an undistorted depth frame.
+     */
+    const std::vector<float> &ray_x() const noexcept;
+
+    /**
+     * The y component of the ray of every row
+     * of an undistorted depth frame.
+     */
+    const std::vector<float> &ray_y() const noexcept;
+
+   private:
+    RegistrationTables() = default;
+
+    libfreenect2::Freenect2Device::IrCameraParams depth;
+    libfreenect2::Freenect2Device::ColorCameraParams color;
+
+    std::vector<int> distort;
+    std::vector<float> color_x;
+    std::vector<int> color_yi;
+    std::vector<float> rays_x;
+    std::vector<float> rays_y;
+  };
+
+  LIBFREENECT2_RS_FUNC std::shared_ptr<RegistrationTables>
+  create_registration_tables(const CameraParams &params);
+
+  LIBFREENECT2_RS_FUNC std::shared_ptr<RegistrationTables>
+  deserialize_registration_tables(rust::Slice<const uint8_t> data);
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_REGISTRATION_TABLES_HPP
@@ -0,0 +1,70 @@
+#ifndef FFI_THREAD_POLICY_HPP
+#define FFI_THREAD_POLICY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "macros.hpp"
+#include "rust/cxx.h"
+
+struct ThreadPolicy;
+
+namespace libfreenect2_ffi {
+  /**
+   * Applies a thread policy to the calling thread and restores the
+   * previous settings once destroyed, unless keep has been called.
+   *
+   * Threads inherit the CPU affinity, the scheduling policy and the
+   * NUMA memory policy of the thread creating them, so every thread
+   * libfreenect2 starts while the scope is alive, like the packet
+   * processor threads the frame listeners are called on, is subject
+   * to the policy as well, and so are the frames they allocate.
+   * Only supported on Linux. On other platforms, a policy which is not
+   * the default policy throws.
+   */
+  class ThreadPolicyScope {
+   public:
+    explicit ThreadPolicyScope(const ThreadPolicy &policy);
+
+    ~ThreadPolicyScope();
+
+    ThreadPolicyScope(const ThreadPolicyScope &) = delete;
+    ThreadPolicyScope &operator=(const ThreadPolicyScope &) = delete;
+
+    /**
+     * Keep the policy after the scope is destroyed.
+     */
+    LIBFREENECT2_MAYBE_UNUSED void keep() noexcept;
+
+   private:
+    void restore() noexcept;
+
+    bool restore_cpus;
+    bool restore_scheduler;
+    bool restore_nice;
+    bool restore_memory;
+    std::vector<uint32_t> previous_cpus;
+    int previous_scheduler;
+    int previous_priority;
+    int previous_nice;
+    int previous_memory_mode;
+    std::vector<unsigned long> previous_nodes;
+  };
+
+  LIBFREENECT2_RS_FUNC std::unique_ptr<ThreadPolicyScope> enter_thread_policy(
+      const ThreadPolicy &policy);
+
+  /**
+   * Get the CPUs the calling thread may run on.
+   */
+  LIBFREENECT2_RS_FUNC rust::Vec<uint32_t> current_thread_cpus();
+
+  /**
+   * Get the CPUs of a NUMA node.
+   * Throws if the node does not exist.
+   */
+  LIBFREENECT2_RS_FUNC rust::Vec<uint32_t> numa_node_cpus(uint32_t node);
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_THREAD_POLICY_HPP
@@ -0,0 +1,49 @@
+#ifndef FFI_USB_TRANSFERS_HPP
+#define FFI_USB_TRANSFERS_HPP
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "macros.hpp"
+
+struct UsbTransferConfig;
+
+namespace libfreenect2_ffi {
+  /**
+   * Overrides the USB transfer settings libfreenect2 reads from its
+   * environment variables when opening a device, and restores the
+   * previous values once destroyed.
+   *
+   * The environment is process wide, so scopes are serialized by a
+   * global lock, which is held for the lifetime of the scope. Zero
+   * values keep the current setting, libfreenect2 defaults to its
+   * platform specific settings if the variables are not set.
+   *
+   * The lock only serializes scopes against each other. setenv and
+   * unsetenv still race with every getenv call of other threads, so
+   * scopes may only be entered while no other thread reads the
+   * environment.
+   */
+  class UsbTransferScope {
+   public:
+    explicit UsbTransferScope(const UsbTransferConfig& config);
+
+    ~UsbTransferScope();
+
+    UsbTransferScope(const UsbTransferScope&) = delete;
+    UsbTransferScope& operator=(const UsbTransferScope&) = delete;
+
+   private:
+    std::unique_lock<std::recursive_mutex> lock;
+    std::vector<std::pair<const char*, std::optional<std::string>>> previous;
+  };
+
+  LIBFREENECT2_RS_FUNC std::unique_ptr<UsbTransferScope>
+  enter_usb_transfer_config(const UsbTransferConfig& config);
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_USB_TRANSFERS_HPP
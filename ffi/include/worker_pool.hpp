@@ -0,0 +1,64 @@
+#ifndef FFI_WORKER_POOL_HPP
+#define FFI_WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libfreenect2_ffi {
+  /**
+   * A fixed set of worker threads executing indexed tasks.
+   * The calling thread takes part in every run, so a pool
+   * with a single thread does not start any workers.
+   */
+  class WorkerPool {
+   public:
+    /**
+     * Create a pool with the given number of threads,
+     * including the calling thread. If threads is 0,
+     * the number of hardware threads is used.
+     */
+    explicit WorkerPool(size_t threads);
+
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * The number of threads tasks are executed on,
+     * including the calling thread.
+     */
+    [[nodiscard]] size_t size() const noexcept;
+
+    /**
+     * Call task for every index in [0, tasks) and
+     * return once all calls are done. Concurrent
+     * calls to run are executed one after another.
+     */
+    void run(size_t tasks, const std::function<void(size_t)>& task);
+
+   private:
+    void work();
+
+    void execute(const std::function<void(size_t)>& task, size_t tasks);
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const std::function<void(size_t)>* job;
+    size_t job_tasks;
+    std::atomic<size_t> next;
+    size_t active;
+    uint64_t generation;
+    bool stopping;
+  };
+}  // namespace libfreenect2_ffi
+
+#endif  // FFI_WORKER_POOL_HPP
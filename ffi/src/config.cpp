@@ -1,7 +1,11 @@
 #include "config.hpp"
 
+#include "libfreenect2-rs/src/ffi.rs.h"
+
 using namespace libfreenect2_ffi;
 
+Config::Config() : config(), depth_streams(DepthStreams::IrAndDepth) {}
+
 LIBFREENECT2_MAYBE_UNUSED float Config::get_min_depth() const noexcept {
   return config.MinDepth;
 }
@@ -20,6 +24,11 @@ LIBFREENECT2_MAYBE_UNUSED bool Config::get_enable_edge_aware_filter()
   return config.EnableEdgeAwareFilter;
 }
 
+LIBFREENECT2_MAYBE_UNUSED DepthStreams Config::get_depth_streams()
+    const noexcept {
+  return depth_streams;
+}
+
 LIBFREENECT2_MAYBE_UNUSED void Config::set_min_depth(float min_depth) noexcept {
   config.MinDepth = min_depth;
 }
@@ -38,6 +47,11 @@ LIBFREENECT2_MAYBE_UNUSED void Config::set_enable_edge_aware_filter(
   config.EnableEdgeAwareFilter = enable_edge_aware_filter;
 }
 
+LIBFREENECT2_MAYBE_UNUSED void Config::set_depth_streams(
+    DepthStreams streams) noexcept {
+  depth_streams = streams;
+}
+
 LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Config>
 libfreenect2_ffi::create_config() {
   return std::make_unique<Config>();
@@ -0,0 +1,359 @@
+#include "depth_codec.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include "frame_convert.hpp"
+
+using namespace libfreenect2_ffi;
+
+namespace {
+  // "KRVL" in little-endian
+  constexpr uint32_t magic = 0x4C56524B;
+  constexpr uint32_t keyframe_flag = 1;
+  constexpr size_t header_size = 8 * sizeof(uint32_t);
+  // Rejects corrupted headers before allocating
+  constexpr uint64_t max_dimension = 4096;
+
+  struct Header {
+    uint32_t flags;
+    uint32_t width;
+    uint32_t height;
+    uint32_t index;
+    uint32_t timestamp;
+    uint32_t sequence;
+    uint32_t status;
+  };
+
+  void write_u32(uint8_t *dst, uint32_t value) {
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+      dst[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+  }
+
+  uint32_t read_u32(const uint8_t *src) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+      value |= static_cast<uint32_t>(src[i]) << (8 * i);
+    }
+
+    return value;
+  }
+
+  void write_header(uint8_t *dst, const Header &header) {
+    const uint32_t fields[] = {
+        magic,        header.flags,     header.width,    header.height,
+        header.index, header.timestamp, header.sequence, header.status,
+    };
+
+    for (size_t i = 0; i < 8; i++) {
+      write_u32(dst + i * sizeof(uint32_t), fields[i]);
+    }
+  }
+
+  Header read_header(rust::Slice<const uint8_t> data) {
+    if (data.size() < header_size || read_u32(data.data()) != magic) {
+      throw std::runtime_error("The data is not an encoded depth frame");
+    }
+
+    const auto field = [&](size_t i) {
+      return read_u32(data.data() + i * sizeof(uint32_t));
+    };
+
+    return {field(1), field(2), field(3), field(4),
+            field(5), field(6), field(7)};
+  }
+
+  uint16_t zigzag(uint16_t delta) {
+    const auto value = static_cast<int16_t>(delta);
+    return static_cast<uint16_t>((static_cast<uint32_t>(value) << 1) ^
+                                 static_cast<uint32_t>(value >> 15));
+  }
+
+  uint16_t unzigzag(uint32_t value) {
+    return static_cast<uint16_t>((value >> 1) ^ (0u - (value & 1)));
+  }
+
+  /**
+   * Writes variable-length values as groups of 3 bit nibbles,
+   * least significant first, with the fourth bit set if more follow.
+   * Nibbles are packed into 32 bit words, most significant first.
+   */
+  class NibbleWriter {
+   public:
+    explicit NibbleWriter(uint8_t *dst)
+        : dst(dst), size(0), word(0), count(0) {}
+
+    void put(uint32_t value) {
+      do {
+        uint32_t nibble = value & 0x7;
+        value >>= 3;
+        if (value != 0) nibble |= 0x8;
+
+        word = (word << 4) | nibble;
+        if (++count == 8) flush();
+      } while (value != 0);
+    }
+
+    size_t finish() {
+      if (count > 0) {
+        word <<= 4 * (8 - count);
+        flush();
+      }
+
+      return size;
+    }
+
+   private:
+    void flush() {
+      write_u32(dst + size, word);
+      size += sizeof(uint32_t);
+      word = 0;
+      count = 0;
+    }
+
+    uint8_t *dst;
+    size_t size;
+    uint32_t word;
+    size_t count;
+  };
+
+  class NibbleReader {
+   public:
+    NibbleReader(const uint8_t *src, size_t size)
+        : src(src), size(size), pos(0), word(0), count(0) {}
+
+    uint32_t get() {
+      uint32_t value = 0;
+      uint32_t nibble = 0;
+      size_t shift = 0;
+
+      do {
+        // Runs and deltas fit into 32 bits, more nibbles mean corrupted data
+        if (shift > 30 || (count == 0 && pos + sizeof(uint32_t) > size)) {
+          throw std::runtime_error("The encoded depth frame is corrupted");
+        }
+
+        if (count == 0) {
+          word = read_u32(src + pos);
+          pos += sizeof(uint32_t);
+          count = 8;
+        }
+
+        nibble = word >> 28;
+        word <<= 4;
+        count--;
+
+        value |= (nibble & 0x7) << shift;
+        shift += 3;
+      } while ((nibble & 0x8) != 0);
+
+      return value;
+    }
+
+   private:
+    const uint8_t *src;
+    size_t size;
+    size_t pos;
+    uint32_t word;
+    size_t count;
+  };
+
+  size_t rvl_encode(const uint16_t *values, size_t n, uint8_t *dst) {
+    NibbleWriter writer(dst);
+    uint16_t previous = 0;
+
+    size_t i = 0;
+    while (i < n) {
+      const size_t zeros_start = i;
+      while (i < n && values[i] == 0) i++;
+      writer.put(static_cast<uint32_t>(i - zeros_start));
+
+      const size_t start = i;
+      while (i < n && values[i] != 0) i++;
+      writer.put(static_cast<uint32_t>(i - start));
+
+      for (size_t j = start; j < i; j++) {
+        writer.put(zigzag(static_cast<uint16_t>(values[j] - previous)));
+        previous = values[j];
+      }
+    }
+
+    return writer.finish();
+  }
+
+  void rvl_decode(const uint8_t *src, size_t size, uint16_t *values,
+                  size_t n) {
+    NibbleReader reader(src, size);
+    uint16_t previous = 0;
+
+    size_t i = 0;
+    while (i < n) {
+      const size_t zeros = reader.get();
+      if (zeros > n - i) {
+        throw std::runtime_error("The encoded depth frame is corrupted");
+      }
+
+      std::fill_n(values + i, zeros, 0);
+      i += zeros;
+
+      const size_t nonzeros = reader.get();
+      if (nonzeros > n - i) {
+        throw std::runtime_error("The encoded depth frame is corrupted");
+      }
+
+      for (size_t end = i + nonzeros; i < end; i++) {
+        previous = static_cast<uint16_t>(previous + unzigzag(reader.get()));
+        values[i] = previous;
+      }
+    }
+  }
+}  // namespace
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t
+libfreenect2_ffi::max_encoded_depth_size(uint64_t width, uint64_t height) {
+  // At most 8 nibbles per pixel, plus the last partial word
+  return header_size + width * height * 4 + sizeof(uint32_t);
+}
+
+LIBFREENECT2_MAYBE_UNUSED bool libfreenect2_ffi::is_depth_keyframe(
+    rust::Slice<const uint8_t> data) {
+  return (read_header(data).flags & keyframe_flag) != 0;
+}
+
+DepthEncoder::DepthEncoder(uint32_t keyframe_interval)
+    : keyframe_interval(keyframe_interval),
+      index(0),
+      keyframe(true),
+      width(0),
+      height(0),
+      current(),
+      previous() {
+  if (keyframe_interval == 0) {
+    throw std::runtime_error("The keyframe interval must be at least 1");
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t DepthEncoder::encode(
+    rust::Slice<const uint8_t> depth, uint64_t width, uint64_t height,
+    uint32_t timestamp, uint32_t sequence, uint32_t status,
+    rust::Slice<uint8_t> dst) {
+  if (width > max_dimension || height > max_dimension) {
+    throw std::runtime_error("The depth frame is too large to encode");
+  }
+
+  if (depth.size() != width * height * sizeof(float)) {
+    throw std::runtime_error("The depth data doesn't match the frame size");
+  }
+
+  if (dst.size() < max_encoded_depth_size(width, height)) {
+    throw std::runtime_error("The output buffer is too small");
+  }
+
+  const size_t n = width * height;
+  current.resize(n);
+  depth_to_millimeters(depth, rust::Slice<uint16_t>(current.data(), n));
+
+  if (width != this->width || height != this->height ||
+      index % keyframe_interval == 0) {
+    keyframe = true;
+  }
+
+  if (!keyframe) {
+    // Wraps around, which the decoder reverses
+    for (size_t i = 0; i < n; i++) {
+      previous[i] = static_cast<uint16_t>(current[i] - previous[i]);
+    }
+  }
+
+  write_header(dst.data(), {keyframe ? keyframe_flag : 0,
+                            static_cast<uint32_t>(width),
+                            static_cast<uint32_t>(height), index, timestamp,
+                            sequence, status});
+  const size_t size = rvl_encode(keyframe ? current.data() : previous.data(),
+                                 n, dst.data() + header_size);
+
+  std::swap(current, previous);
+  this->width = width;
+  this->height = height;
+  keyframe = false;
+  index++;
+
+  return header_size + size;
+}
+
+LIBFREENECT2_MAYBE_UNUSED void DepthEncoder::force_keyframe() noexcept {
+  keyframe = true;
+}
+
+DepthDecoder::DepthDecoder()
+    : has_previous(false),
+      index(0),
+      width(0),
+      height(0),
+      previous(),
+      decoded() {}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Frame> DepthDecoder::decode(
+    rust::Slice<const uint8_t> data) {
+  const Header header = read_header(data);
+  if (header.width > max_dimension || header.height > max_dimension) {
+    throw std::runtime_error("The encoded depth frame is corrupted");
+  }
+
+  const bool keyframe = (header.flags & keyframe_flag) != 0;
+  if (!keyframe &&
+      (!has_previous || header.index != index + 1 || header.width != width ||
+       header.height != height)) {
+    throw std::runtime_error(
+        "The previous frame is missing, wait for the next keyframe");
+  }
+
+  const size_t n = static_cast<size_t>(header.width) * header.height;
+  decoded.resize(n);
+  rvl_decode(data.data() + header_size, data.size() - header_size,
+             decoded.data(), n);
+
+  if (keyframe) {
+    std::swap(decoded, previous);
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      previous[i] = static_cast<uint16_t>(previous[i] + decoded[i]);
+    }
+  }
+
+  has_previous = true;
+  index = header.index;
+  width = header.width;
+  height = header.height;
+
+  auto frame = std::make_unique<libfreenect2::Frame>(
+      header.width, header.height, sizeof(float));
+  auto *depth = reinterpret_cast<float *>(frame->data);
+  for (size_t i = 0; i < n; i++) {
+    depth[i] = static_cast<float>(previous[i]);
+  }
+
+  frame->timestamp = header.timestamp;
+  frame->sequence = header.sequence;
+  frame->status = header.status;
+  frame->format = libfreenect2::Frame::Float;
+
+  return std::make_unique<Frame>(frame.release());
+}
+
+LIBFREENECT2_MAYBE_UNUSED void DepthDecoder::reset() noexcept {
+  has_previous = false;
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<DepthEncoder>
+libfreenect2_ffi::create_depth_encoder(uint32_t keyframe_interval) {
+  return std::make_unique<DepthEncoder>(keyframe_interval);
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<DepthDecoder>
+libfreenect2_ffi::create_depth_decoder() {
+  return std::make_unique<DepthDecoder>();
+}
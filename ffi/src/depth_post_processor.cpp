@@ -0,0 +1,425 @@
+#include "depth_post_processor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LIBFREENECT2_RS_NEON
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIBFREENECT2_RS_SSE2
+#endif
+
+using namespace libfreenect2_ffi;
+
+namespace {
+  constexpr size_t max_hole_fill_radius = 8;
+
+  bool is_valid(float depth) {
+    // Also false for NaN
+    return depth > 0.f;
+  }
+
+#if defined(LIBFREENECT2_RS_SSE2)
+  // The sums of the adjacent pairs of a and b
+  __m128 add_pairs(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                      _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+
+  size_t clip_simd(float *depth, size_t n, float min_depth, float max_depth) {
+    const __m128 min = _mm_set1_ps(min_depth);
+    const __m128 max = _mm_set1_ps(max_depth);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      const __m128 value = _mm_loadu_ps(depth + i);
+      // Comparisons with NaN are false
+      const __m128 inside =
+          _mm_and_ps(_mm_cmpge_ps(value, min), _mm_cmple_ps(value, max));
+      _mm_storeu_ps(depth + i, _mm_and_ps(value, inside));
+    }
+
+    return i;
+  }
+
+  /**
+   * Average the valid depths of factor x factor blocks of the rows
+   * starting at src into four pixels of dst at a time.
+   */
+  size_t decimate_simd(const float *src, size_t stride, float *dst,
+                       size_t width, size_t factor) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+      __m128 sum = zero;
+      __m128 count = zero;
+
+      for (size_t row = 0; row < factor; row++) {
+        const float *p = src + row * stride + x * factor;
+
+        __m128 values[4];
+        __m128 valid[4];
+        for (size_t i = 0; i < factor; i++) {
+          const __m128 value = _mm_loadu_ps(p + i * 4);
+          const __m128 mask = _mm_cmpgt_ps(value, zero);
+          values[i] = _mm_and_ps(value, mask);
+          valid[i] = _mm_and_ps(one, mask);
+        }
+
+        // Reduce the factor values of each pixel to one
+        for (size_t n = factor; n > 1; n /= 2) {
+          for (size_t i = 0; i < n / 2; i++) {
+            values[i] = add_pairs(values[2 * i], values[2 * i + 1]);
+            valid[i] = add_pairs(valid[2 * i], valid[2 * i + 1]);
+          }
+        }
+
+        sum = _mm_add_ps(sum, values[0]);
+        count = _mm_add_ps(count, valid[0]);
+      }
+
+      const __m128 mean = _mm_div_ps(sum, _mm_max_ps(count, one));
+      _mm_storeu_ps(dst + x, mean);
+    }
+
+    return x;
+  }
+
+  size_t smooth_simd(float *depth, float *history, size_t n, float alpha,
+                     float threshold) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 a = _mm_set1_ps(alpha);
+    const __m128 t = _mm_set1_ps(threshold);
+    const __m128 abs_mask =
+        _mm_castsi128_ps(_mm_set1_epi32(std::numeric_limits<int32_t>::max()));
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      const __m128 value = _mm_loadu_ps(depth + i);
+      const __m128 previous = _mm_loadu_ps(history + i);
+      const __m128 diff = _mm_sub_ps(value, previous);
+
+      const __m128 current_valid = _mm_cmpgt_ps(value, zero);
+      const __m128 valid = _mm_and_ps(
+          _mm_and_ps(current_valid, _mm_cmpgt_ps(previous, zero)),
+          _mm_cmplt_ps(_mm_and_ps(diff, abs_mask), t));
+      const __m128 smoothed = _mm_add_ps(previous, _mm_mul_ps(a, diff));
+      // Invalid depths are written as 0
+      const __m128 current = _mm_and_ps(value, current_valid);
+      const __m128 res = _mm_or_ps(_mm_and_ps(valid, smoothed),
+                                   _mm_andnot_ps(valid, current));
+
+      _mm_storeu_ps(depth + i, res);
+      _mm_storeu_ps(history + i, res);
+    }
+
+    return i;
+  }
+#elif defined(LIBFREENECT2_RS_NEON)
+  size_t clip_simd(float *depth, size_t n, float min_depth, float max_depth) {
+    const float32x4_t min = vdupq_n_f32(min_depth);
+    const float32x4_t max = vdupq_n_f32(max_depth);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      const float32x4_t value = vld1q_f32(depth + i);
+      // Comparisons with NaN are false
+      const uint32x4_t inside = vandq_u32(vcgeq_f32(value, min),
+                                          vcleq_f32(value, max));
+      vst1q_f32(depth + i, vreinterpretq_f32_u32(vandq_u32(
+                               vreinterpretq_u32_f32(value), inside)));
+    }
+
+    return i;
+  }
+
+  size_t decimate_simd(const float *src, size_t stride, float *dst,
+                       size_t width, size_t factor) {
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t one = vdupq_n_f32(1.f);
+
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+      float32x4_t sum = zero;
+      float32x4_t count = zero;
+
+      for (size_t row = 0; row < factor; row++) {
+        const float *p = src + row * stride + x * factor;
+
+        float32x4_t values[4];
+        float32x4_t valid[4];
+        for (size_t i = 0; i < factor; i++) {
+          const float32x4_t value = vld1q_f32(p + i * 4);
+          const uint32x4_t mask = vcgtq_f32(value, zero);
+          values[i] = vreinterpretq_f32_u32(
+              vandq_u32(vreinterpretq_u32_f32(value), mask));
+          valid[i] = vreinterpretq_f32_u32(
+              vandq_u32(vreinterpretq_u32_f32(one), mask));
+        }
+
+        // Reduce the factor values of each pixel to one
+        for (size_t n = factor; n > 1; n /= 2) {
+          for (size_t i = 0; i < n / 2; i++) {
+            values[i] = vpaddq_f32(values[2 * i], values[2 * i + 1]);
+            valid[i] = vpaddq_f32(valid[2 * i], valid[2 * i + 1]);
+          }
+        }
+
+        sum = vaddq_f32(sum, values[0]);
+        count = vaddq_f32(count, valid[0]);
+      }
+
+      vst1q_f32(dst + x, vdivq_f32(sum, vmaxq_f32(count, one)));
+    }
+
+    return x;
+  }
+
+  size_t smooth_simd(float *depth, float *history, size_t n, float alpha,
+                     float threshold) {
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t a = vdupq_n_f32(alpha);
+    const float32x4_t t = vdupq_n_f32(threshold);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      const float32x4_t value = vld1q_f32(depth + i);
+      const float32x4_t previous = vld1q_f32(history + i);
+      const float32x4_t diff = vsubq_f32(value, previous);
+
+      const uint32x4_t current_valid = vcgtq_f32(value, zero);
+      const uint32x4_t valid = vandq_u32(
+          vandq_u32(current_valid, vcgtq_f32(previous, zero)),
+          vcltq_f32(vabsq_f32(diff), t));
+      const float32x4_t smoothed = vaddq_f32(previous, vmulq_f32(a, diff));
+      // Invalid depths are written as 0
+      const float32x4_t current = vreinterpretq_f32_u32(
+          vandq_u32(vreinterpretq_u32_f32(value), current_valid));
+      const float32x4_t res = vbslq_f32(valid, smoothed, current);
+
+      vst1q_f32(depth + i, res);
+      vst1q_f32(history + i, res);
+    }
+
+    return i;
+  }
+#else
+  size_t clip_simd(float *, size_t, float, float) { return 0; }
+
+  size_t decimate_simd(const float *, size_t, float *, size_t, size_t) {
+    return 0;
+  }
+
+  size_t smooth_simd(float *, float *, size_t, float, float) { return 0; }
+#endif
+
+  void clip(float *depth, size_t n, float min_depth, float max_depth) {
+    for (size_t i = clip_simd(depth, n, min_depth, max_depth); i < n; i++) {
+      if (!(depth[i] >= min_depth && depth[i] <= max_depth)) depth[i] = 0.f;
+    }
+  }
+
+  /**
+   * Replace every factor x factor block with the mean of its valid
+   * depths. The blocks are written to the start of depth, which is
+   * safe since every block is read before its pixel is written.
+   * Returns the width and height of the decimated image.
+   */
+  std::pair<size_t, size_t> decimate(float *depth, size_t width,
+                                     size_t height, size_t factor) {
+    const size_t out_width = width / factor;
+    const size_t out_height = height / factor;
+
+    for (size_t y = 0; y < out_height; y++) {
+      const float *src = depth + y * factor * width;
+      float *dst = depth + y * out_width;
+
+      for (size_t x = decimate_simd(src, width, dst, out_width, factor);
+           x < out_width; x++) {
+        float sum = 0.f;
+        size_t count = 0;
+        for (size_t row = 0; row < factor; row++) {
+          for (size_t col = 0; col < factor; col++) {
+            const float value = src[row * width + x * factor + col];
+            if (is_valid(value)) {
+              sum += value;
+              count++;
+            }
+          }
+        }
+
+        dst[x] = count > 0 ? sum / static_cast<float>(count) : 0.f;
+      }
+    }
+
+    return {out_width, out_height};
+  }
+}  // namespace
+
+DepthPostProcessor::DepthPostProcessor(const DepthPostProcessingParams &params)
+    : clip_range(params.clip_range),
+      min_depth(params.min_depth),
+      max_depth(params.max_depth),
+      decimation(static_cast<size_t>(params.decimation)),
+      hole_fill_radius(params.hole_fill_radius),
+      temporal(params.temporal),
+      temporal_alpha(params.temporal_alpha),
+      temporal_threshold(params.temporal_threshold),
+      history_width(0),
+      history_height(0),
+      history(),
+      scratch() {
+  if (clip_range && !(min_depth >= 0.f && min_depth < max_depth)) {
+    throw std::runtime_error(
+        "The min depth must be at least 0 and less than the max depth");
+  }
+
+  if (decimation != 1 && decimation != 2 && decimation != 4) {
+    throw std::runtime_error("Invalid decimation factor");
+  }
+
+  if (hole_fill_radius > max_hole_fill_radius) {
+    throw std::runtime_error("The hole fill radius must be at most " +
+                             std::to_string(max_hole_fill_radius));
+  }
+
+  if (temporal && !(temporal_alpha > 0.f && temporal_alpha <= 1.f)) {
+    throw std::runtime_error("The temporal alpha must be in (0, 1]");
+  }
+
+  if (temporal && !(temporal_threshold > 0.f)) {
+    throw std::runtime_error("The temporal threshold must be greater than 0");
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED void DepthPostProcessor::apply(
+    libfreenect2::Frame &frame) {
+  if (frame.format != libfreenect2::Frame::Float ||
+      frame.bytes_per_pixel != sizeof(float)) {
+    throw std::runtime_error("Only float depth frames can be post-processed");
+  }
+
+  // Frame data is allocated aligned by libfreenect2
+  auto *depth = reinterpret_cast<float *>(frame.data);
+  size_t width = frame.width;
+  size_t height = frame.height;
+
+  if (clip_range) {
+    clip(depth, width * height, min_depth, max_depth);
+  }
+
+  if (decimation > 1) {
+    std::tie(width, height) = decimate(depth, width, height, decimation);
+  }
+
+  if (hole_fill_radius > 0) {
+    fill_holes(depth, width, height);
+  }
+
+  if (temporal) {
+    smooth(depth, width, height);
+  }
+
+  frame.width = width;
+  frame.height = height;
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Frame> DepthPostProcessor::process(
+    rust::Slice<const uint8_t> depth, uint64_t width, uint64_t height,
+    uint32_t timestamp, uint32_t sequence, uint32_t status) {
+  if (depth.size() != width * height * sizeof(float)) {
+    throw std::runtime_error("The depth data doesn't match the frame size");
+  }
+
+  auto frame =
+      std::make_unique<libfreenect2::Frame>(width, height, sizeof(float));
+  std::memcpy(frame->data, depth.data(), depth.size());
+  frame->timestamp = timestamp;
+  frame->sequence = sequence;
+  frame->status = status;
+  frame->format = libfreenect2::Frame::Float;
+
+  apply(*frame);
+
+  return std::make_unique<Frame>(frame.release());
+}
+
+LIBFREENECT2_MAYBE_UNUSED void DepthPostProcessor::reset() noexcept {
+  history_width = 0;
+  history_height = 0;
+}
+
+void DepthPostProcessor::fill_holes(float *depth, size_t width,
+                                    size_t height) {
+  // Read from a copy, so filled pixels don't fill other holes
+  scratch.assign(depth, depth + width * height);
+  const size_t radius = hole_fill_radius;
+
+  for (size_t y = 0; y < height; y++) {
+    const size_t y0 = y > radius ? y - radius : 0;
+    const size_t y1 = std::min(height - 1, y + radius);
+
+    for (size_t x = 0; x < width; x++) {
+      if (is_valid(scratch[y * width + x])) continue;
+
+      const size_t x0 = x > radius ? x - radius : 0;
+      const size_t x1 = std::min(width - 1, x + radius);
+
+      // Use the nearest surface around the hole
+      float nearest = std::numeric_limits<float>::infinity();
+      for (size_t ny = y0; ny <= y1; ny++) {
+        for (size_t nx = x0; nx <= x1; nx++) {
+          const float value = scratch[ny * width + nx];
+          if (is_valid(value)) nearest = std::min(nearest, value);
+        }
+      }
+
+      depth[y * width + x] = std::isinf(nearest) ? 0.f : nearest;
+    }
+  }
+}
+
+void DepthPostProcessor::smooth(float *depth, size_t width, size_t height) {
+  const size_t n = width * height;
+  if (history_width != width || history_height != height) {
+    // Nothing to smooth with, start over from this frame
+    history_width = width;
+    history_height = height;
+    history.assign(n, 0.f);
+  }
+
+  for (size_t i = smooth_simd(depth, history.data(), n, temporal_alpha,
+                              temporal_threshold);
+       i < n; i++) {
+    const float value = depth[i];
+    const float previous = history[i];
+
+    float res = is_valid(value) ? value : 0.f;
+    if (is_valid(value) && is_valid(previous) &&
+        std::abs(value - previous) < temporal_threshold) {
+      res = previous + temporal_alpha * (value - previous);
+    }
+
+    depth[i] = res;
+    history[i] = res;
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<DepthPostProcessor>
+libfreenect2_ffi::create_depth_post_processor(
+    const DepthPostProcessingParams &params) {
+  return std::make_unique<DepthPostProcessor>(params);
+}
@@ -1,8 +1,17 @@
 #include "frame.hpp"
 
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
 using namespace libfreenect2_ffi;
 
-Frame::Frame(libfreenect2::Frame *frame) : frame(frame) {}
+Frame::Frame(libfreenect2::Frame *frame)
+    : frame(frame), received(0), type(libfreenect2::Frame::Color), pool() {}
+
+Frame::Frame(libfreenect2::Frame *frame, libfreenect2::Frame::Type type,
+             std::shared_ptr<FramePool> pool)
+    : frame(frame), received(0), type(type), pool(std::move(pool)) {}
 
 LIBFREENECT2_MAYBE_UNUSED uint64_t Frame::width() const {
   return frame->width;
@@ -48,36 +57,94 @@ LIBFREENECT2_MAYBE_UNUSED FrameFormat Frame::format() const {
   return static_cast<FrameFormat>(frame->format);
 }
 
+LIBFREENECT2_MAYBE_UNUSED uint64_t Frame::received_ns() const {
+  return received;
+}
+
+LIBFREENECT2_RS_FUNC uint64_t libfreenect2_ffi::steady_clock_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 Frame::~Frame() {
-  delete frame;
+  if (pool) {
+    pool->release(type, frame);
+  } else {
+    delete frame;
+  }
 }
 
+namespace {
+  void copy_frame(const libfreenect2::Frame &src, libfreenect2::Frame &dst) {
+    std::memcpy(dst.data, src.data,
+                src.width * src.height * src.bytes_per_pixel);
+
+    dst.timestamp = src.timestamp;
+    dst.sequence = src.sequence;
+    dst.exposure = src.exposure;
+    dst.gain = src.gain;
+    dst.gamma = src.gamma;
+    dst.status = src.status;
+    dst.format = src.format;
+  }
+}  // namespace
+
 class FrameListenerImpl : public libfreenect2::FrameListener {
  public:
   explicit FrameListenerImpl(
       rust::cxxbridge1::Box<CallContext> &&ctx,
-      rust::Fn<rust::String(FrameType, std::unique_ptr<Frame>,
-                            const rust::cxxbridge1::Box<CallContext> &)>
-          on_new_frame)
-      : on_new_frame(on_new_frame), ctx(std::move(ctx)) {}
+      rust::Fn<void(FrameType, std::unique_ptr<Frame>,
+                    const rust::cxxbridge1::Box<CallContext> &)>
+          on_new_frame,
+      std::shared_ptr<FramePool> pool = nullptr)
+      : on_new_frame(on_new_frame),
+        ctx(std::move(ctx)),
+        pool(std::move(pool)) {}
 
   bool onNewFrame(libfreenect2::Frame::Type type,
                   libfreenect2::Frame *frame) override {
-    rust::String res = on_new_frame(static_cast<FrameType>(type),
-                                    std::make_unique<Frame>(frame), ctx);
+    const uint64_t received = steady_clock_ns();
+
+    // Raw packets point into a buffer of the stream parser, which is reused
+    // once this returns. Their size changes with every packet, so they are
+    // copied into a new frame instead of a pool frame
+    libfreenect2::Frame *packet = nullptr;
+    if (frame->format == libfreenect2::Frame::Raw) {
+      packet = new libfreenect2::Frame(frame->width, frame->height,
+                                       frame->bytes_per_pixel);
+      copy_frame(*frame, *packet);
+    }
+
+    libfreenect2::Frame *pooled =
+        pool && packet == nullptr ? pool->acquire(type, *frame) : nullptr;
+    if (pooled != nullptr) {
+      copy_frame(*frame, *pooled);
+    }
 
-    if (!res.empty()) {
-      throw std::runtime_error(res.operator std::string());
+    // If the pool is exhausted, fall back to taking ownership of the frame
+    std::unique_ptr<Frame> wrapped;
+    if (pooled != nullptr) {
+      wrapped = std::make_unique<Frame>(pooled, type, pool);
+    } else {
+      wrapped = std::make_unique<Frame>(packet != nullptr ? packet : frame);
     }
+    wrapped->received = received;
 
-    return true;
+    // Errors are recorded by the Rust listener, throwing here
+    // would terminate the thread of the packet pipeline
+    on_new_frame(static_cast<FrameType>(type), std::move(wrapped), ctx);
+
+    // Returning false lets the pipeline reuse its frame
+    return pooled == nullptr && packet == nullptr;
   }
 
  private:
-  rust::Fn<rust::String(FrameType, std::unique_ptr<Frame>,
-                        const rust::cxxbridge1::Box<CallContext> &)>
+  rust::Fn<void(FrameType, std::unique_ptr<Frame>,
+                const rust::cxxbridge1::Box<CallContext> &)>
       on_new_frame;
   const rust::cxxbridge1::Box<CallContext> ctx;
+  const std::shared_ptr<FramePool> pool;
 };
 
 LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> libfreenect2_ffi::create_frame(
@@ -100,22 +167,57 @@ LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> libfreenect2_ffi::create_frame(
 LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<libfreenect2::FrameListener>
 libfreenect2_ffi::create_frame_listener(
     rust::cxxbridge1::Box<CallContext> ctx,
-    rust::Fn<rust::String(FrameType, std::unique_ptr<Frame>,
-                          const rust::cxxbridge1::Box<CallContext> &)>
+    rust::Fn<void(FrameType, std::unique_ptr<Frame>,
+                  const rust::cxxbridge1::Box<CallContext> &)>
         on_new_frame) {
   return std::make_unique<FrameListenerImpl>(std::move(ctx), on_new_frame);
 }
 
-#ifndef NDEBUG
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<libfreenect2::FrameListener>
+libfreenect2_ffi::create_pooled_frame_listener(
+    rust::cxxbridge1::Box<CallContext> ctx,
+    rust::Fn<void(FrameType, std::unique_ptr<Frame>,
+                  const rust::cxxbridge1::Box<CallContext> &)>
+        on_new_frame,
+    const std::shared_ptr<FramePool> &pool) {
+  return std::make_unique<FrameListenerImpl>(std::move(ctx), on_new_frame,
+                                             pool);
+}
+
+LIBFREENECT2_MAYBE_UNUSED void libfreenect2_ffi::replay_frame(
+    const std::unique_ptr<libfreenect2::FrameListener> &listener,
+    FrameType type, const Frame &frame) {
+  if (!listener) {
+    throw std::runtime_error("The frame listener is not set");
+  }
+
+  // Pipelines hand out frames owning their buffer, so the listener may keep it
+  auto copy = std::make_unique<libfreenect2::Frame>(
+      frame.frame->width, frame.frame->height, frame.frame->bytes_per_pixel);
+  copy_frame(*frame.frame, *copy);
+
+  // The listener only takes ownership if it returns true
+  if (listener->onNewFrame(static_cast<libfreenect2::Frame::Type>(type),
+                           copy.get())) {
+    copy.release();
+  }
+}
+
+#if !defined(NDEBUG) || defined(LIBFREENECT2_RS_BENCH)
 namespace libfreenect2_ffi {
   namespace test {
     LIBFREENECT2_MAYBE_UNUSED void call_frame_listener(
-        std::unique_ptr<libfreenect2::FrameListener> &listener, FrameType type,
-        uint64_t width, uint64_t height, uint64_t bytes_per_pixel,
-        unsigned char *data) {
-      listener->onNewFrame(
-          static_cast<libfreenect2::Frame::Type>(type),
-          new libfreenect2::Frame(width, height, bytes_per_pixel, data));
+        const std::unique_ptr<libfreenect2::FrameListener> &listener,
+        FrameType type, uint64_t width, uint64_t height,
+        uint64_t bytes_per_pixel, unsigned char *data) {
+      auto frame = std::make_unique<libfreenect2::Frame>(
+          width, height, bytes_per_pixel, data);
+
+      // The listener only takes ownership if it returns true
+      if (listener->onNewFrame(static_cast<libfreenect2::Frame::Type>(type),
+                               frame.get())) {
+        frame.release();
+      }
     }
   }  // namespace test
 }  // namespace libfreenect2_ffi
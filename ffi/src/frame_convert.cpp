@@ -0,0 +1,420 @@
+#include "frame_convert.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LIBFREENECT2_RS_NEON
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIBFREENECT2_RS_SSE2
+#if defined(__GNUC__) || defined(__clang__)
+// Not part of x86-64, only used after checking the cpu supports it
+#include <tmmintrin.h>
+#define LIBFREENECT2_RS_SSSE3
+#endif
+#endif
+
+using namespace libfreenect2_ffi;
+
+namespace {
+  // Marks destination bytes which are set to alpha
+  constexpr uint8_t alpha_byte = 0x80;
+
+  struct Layout {
+    size_t bytes_per_pixel;
+    // The byte offset of red, green, blue and alpha, -1 if not present
+    int channels[4];
+  };
+
+  Layout get_layout(PixelLayout layout) {
+    switch (layout) {
+      case PixelLayout::RGB:
+        return {3, {0, 1, 2, -1}};
+      case PixelLayout::BGR:
+        return {3, {2, 1, 0, -1}};
+      case PixelLayout::RGBA:
+        return {4, {0, 1, 2, 3}};
+      case PixelLayout::BGRA:
+        return {4, {2, 1, 0, 3}};
+      default:
+        throw std::runtime_error("Invalid pixel layout");
+    }
+  }
+
+  /**
+   * The source byte of every destination byte of a pixel, and the
+   * same as a byte shuffle mask for four pixels at once.
+   */
+  struct Shuffle {
+    size_t src_bpp;
+    size_t dst_bpp;
+    uint8_t index[4];
+    alignas(16) uint8_t mask[16];
+    alignas(16) uint8_t alpha[16];
+  };
+
+  Shuffle make_shuffle(PixelLayout src_layout, PixelLayout dst_layout) {
+    const Layout src = get_layout(src_layout);
+    const Layout dst = get_layout(dst_layout);
+
+    Shuffle res{};
+    res.src_bpp = src.bytes_per_pixel;
+    res.dst_bpp = dst.bytes_per_pixel;
+    for (int channel = 0; channel < 4; channel++) {
+      if (dst.channels[channel] < 0) continue;
+
+      res.index[dst.channels[channel]] =
+          channel == 3 ? alpha_byte
+                       : static_cast<uint8_t>(src.channels[channel]);
+    }
+
+    // Out of range mask bytes, like alpha_byte, are set to zero
+    std::fill(std::begin(res.mask), std::end(res.mask), alpha_byte);
+    for (size_t pixel = 0; pixel < 4; pixel++) {
+      for (size_t byte = 0; byte < res.dst_bpp; byte++) {
+        const size_t i = pixel * res.dst_bpp + byte;
+        if (res.index[byte] == alpha_byte) {
+          res.alpha[i] = 0xFF;
+        } else {
+          res.mask[i] =
+              static_cast<uint8_t>(pixel * res.src_bpp + res.index[byte]);
+        }
+      }
+    }
+
+    return res;
+  }
+
+#if defined(LIBFREENECT2_RS_SSSE3) || defined(LIBFREENECT2_RS_NEON)
+  // Whether 16 bytes can be read and written at pixel i of n pixels
+  bool fits_vector(const Shuffle &shuffle, size_t i, size_t n) {
+    return i * shuffle.src_bpp + 16 <= n * shuffle.src_bpp &&
+           i * shuffle.dst_bpp + 16 <= n * shuffle.dst_bpp;
+  }
+#endif
+
+#if defined(LIBFREENECT2_RS_SSSE3)
+  __attribute__((target("ssse3"))) size_t shuffle_ssse3(
+      const uint8_t *src, uint8_t *dst, size_t n, const Shuffle &shuffle) {
+    const __m128i mask =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(shuffle.mask));
+    const __m128i alpha =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(shuffle.alpha));
+
+    // 3 byte pixels write 4 zero bytes past the end of a vector,
+    // they are overwritten by the next one
+    size_t i = 0;
+    for (; fits_vector(shuffle, i, n); i += 4) {
+      __m128i v = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(src + i * shuffle.src_bpp));
+      v = _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * shuffle.dst_bpp),
+                       v);
+    }
+
+    return i;
+  }
+
+  size_t shuffle_simd(const uint8_t *src, uint8_t *dst, size_t n,
+                      const Shuffle &shuffle) {
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    return has_ssse3 ? shuffle_ssse3(src, dst, n, shuffle) : 0;
+  }
+#elif defined(LIBFREENECT2_RS_NEON)
+  size_t shuffle_simd(const uint8_t *src, uint8_t *dst, size_t n,
+                      const Shuffle &shuffle) {
+    const uint8x16_t mask = vld1q_u8(shuffle.mask);
+    const uint8x16_t alpha = vld1q_u8(shuffle.alpha);
+
+    size_t i = 0;
+    for (; fits_vector(shuffle, i, n); i += 4) {
+      uint8x16_t v = vld1q_u8(src + i * shuffle.src_bpp);
+      v = vorrq_u8(vqtbl1q_u8(v, mask), alpha);
+      vst1q_u8(dst + i * shuffle.dst_bpp, v);
+    }
+
+    return i;
+  }
+#else
+  size_t shuffle_simd(const uint8_t *, uint8_t *, size_t, const Shuffle &) {
+    return 0;
+  }
+#endif
+
+  /**
+   * Maps floats to bytes by clamping (value - offset) * scale to
+   * [0, max] and rounding it. If reserve_zero is set, 1 is added to
+   * every byte and values <= 0 or NaN are mapped to 0.
+   */
+  struct Quantizer {
+    float offset;
+    float scale;
+    float max;
+    bool reserve_zero;
+
+    uint8_t operator()(float value) const {
+      if (reserve_zero && !(value > 0.f)) return 0;
+
+      float res = (value - offset) * scale;
+      // Also catches NaN
+      if (!(res > 0.f)) res = 0.f;
+
+      return static_cast<uint8_t>(std::lrint(std::min(res, max)) +
+                                  (reserve_zero ? 1 : 0));
+    }
+  };
+
+#if defined(LIBFREENECT2_RS_SSE2)
+  __m128i quantize4(const float *src, const Quantizer &q) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 value = _mm_loadu_ps(src);
+
+    __m128 res = _mm_mul_ps(_mm_sub_ps(value, _mm_set1_ps(q.offset)),
+                            _mm_set1_ps(q.scale));
+    // maxps returns the second operand if the first one is NaN
+    res = _mm_min_ps(_mm_max_ps(res, zero), _mm_set1_ps(q.max));
+
+    __m128i n = _mm_cvtps_epi32(res);
+    if (q.reserve_zero) {
+      n = _mm_add_epi32(n, _mm_set1_epi32(1));
+      n = _mm_and_si128(n, _mm_castps_si128(_mm_cmpgt_ps(value, zero)));
+    }
+
+    return n;
+  }
+
+  size_t quantize_simd(const float *src, uint8_t *dst, size_t n,
+                       const Quantizer &q) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      const __m128i lo = _mm_packs_epi32(quantize4(src + i, q),
+                                         quantize4(src + i + 4, q));
+      const __m128i hi = _mm_packs_epi32(quantize4(src + i + 8, q),
+                                         quantize4(src + i + 12, q));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                       _mm_packus_epi16(lo, hi));
+    }
+
+    return i;
+  }
+
+  size_t millimeters_simd(const float *src, uint16_t *dst, size_t n) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(65535.f);
+    // SSE2 can only pack to signed 16 bit integers
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i unbias = _mm_set1_epi16(-32768);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      const __m128 lo =
+          _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), zero), max);
+      const __m128 hi =
+          _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), zero), max);
+
+      const __m128i packed =
+          _mm_packs_epi32(_mm_sub_epi32(_mm_cvtps_epi32(lo), bias),
+                          _mm_sub_epi32(_mm_cvtps_epi32(hi), bias));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                       _mm_xor_si128(packed, unbias));
+    }
+
+    return i;
+  }
+#elif defined(LIBFREENECT2_RS_NEON)
+  uint32x4_t quantize4(const float *src, const Quantizer &q) {
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t value = vld1q_f32(src);
+
+    float32x4_t res = vmulq_f32(vsubq_f32(value, vdupq_n_f32(q.offset)),
+                                vdupq_n_f32(q.scale));
+    // vmaxnm returns the number if one operand is NaN
+    res = vminq_f32(vmaxnmq_f32(res, zero), vdupq_n_f32(q.max));
+
+    uint32x4_t n = vcvtnq_u32_f32(res);
+    if (q.reserve_zero) {
+      n = vaddq_u32(n, vdupq_n_u32(1));
+      n = vandq_u32(n, vcgtq_f32(value, zero));
+    }
+
+    return n;
+  }
+
+  size_t quantize_simd(const float *src, uint8_t *dst, size_t n,
+                       const Quantizer &q) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      const uint16x8_t packed =
+          vcombine_u16(vmovn_u32(quantize4(src + i, q)),
+                       vmovn_u32(quantize4(src + i + 4, q)));
+      vst1_u8(dst + i, vmovn_u16(packed));
+    }
+
+    return i;
+  }
+
+  size_t millimeters_simd(const float *src, uint16_t *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      // Saturates and maps NaN and negative values to 0
+      const uint32x4_t lo = vcvtnq_u32_f32(vld1q_f32(src + i));
+      const uint32x4_t hi = vcvtnq_u32_f32(vld1q_f32(src + i + 4));
+      vst1q_u16(dst + i, vcombine_u16(vqmovn_u32(lo), vqmovn_u32(hi)));
+    }
+
+    return i;
+  }
+#else
+  size_t quantize_simd(const float *, uint8_t *, size_t, const Quantizer &) {
+    return 0;
+  }
+
+  size_t millimeters_simd(const float *, uint16_t *, size_t) { return 0; }
+#endif
+
+  void quantize(const uint8_t *src, uint8_t *dst, size_t n,
+                const Quantizer &q) {
+    // Frame data is aligned, the data of owned frames may not be
+    const auto *values = reinterpret_cast<const float *>(src);
+    for (size_t i = quantize_simd(values, dst, n, q); i < n; i++) {
+      float value;
+      std::memcpy(&value, src + i * sizeof(float), sizeof(float));
+      dst[i] = q(value);
+    }
+  }
+
+  using Palette = std::array<std::array<uint8_t, 3>, 256>;
+
+  /**
+   * Create a palette of 255 colors, preceded by black for invalid
+   * values. color maps (0, 1] to RGB values in [0, 1].
+   */
+  template <class F>
+  Palette make_palette(F &&color) {
+    Palette res{};
+    for (size_t i = 1; i < res.size(); i++) {
+      const std::array<float, 3> rgb = color(float(i) / 255.f);
+      for (size_t c = 0; c < 3; c++) {
+        res[i][c] = static_cast<uint8_t>(
+            std::lrint(std::clamp(rgb[c], 0.f, 1.f) * 255.f));
+      }
+    }
+
+    return res;
+  }
+
+  const Palette &get_palette(Colormap colormap) {
+    static const Palette gray = make_palette([](float t) {
+      return std::array<float, 3>{t, t, t};
+    });
+    static const Palette jet = make_palette([](float t) {
+      return std::array<float, 3>{1.5f - std::abs(4.f * t - 3.f),
+                                  1.5f - std::abs(4.f * t - 2.f),
+                                  1.5f - std::abs(4.f * t - 1.f)};
+    });
+
+    switch (colormap) {
+      case Colormap::Gray:
+        return gray;
+      case Colormap::Jet:
+        return jet;
+      default:
+        throw std::runtime_error("Invalid colormap");
+    }
+  }
+
+  size_t float_count(rust::Slice<const uint8_t> data) {
+    if (data.size() % sizeof(float) != 0) {
+      throw std::runtime_error("The frame data must consist of floats");
+    }
+
+    return data.size() / sizeof(float);
+  }
+
+  void check_dst_size(size_t size, size_t required) {
+    if (size < required) {
+      throw std::runtime_error("The destination buffer is too small");
+    }
+  }
+}  // namespace
+
+LIBFREENECT2_MAYBE_UNUSED void libfreenect2_ffi::convert_pixels(
+    rust::Slice<const uint8_t> src, PixelLayout src_layout,
+    rust::Slice<uint8_t> dst, PixelLayout dst_layout) {
+  const Shuffle shuffle = make_shuffle(src_layout, dst_layout);
+  if (src.size() % shuffle.src_bpp != 0) {
+    throw std::runtime_error("The source buffer holds a partial pixel");
+  }
+
+  const size_t n = src.size() / shuffle.src_bpp;
+  check_dst_size(dst.size(), n * shuffle.dst_bpp);
+
+  const uint8_t *in = src.data();
+  uint8_t *out = dst.data();
+  for (size_t i = shuffle_simd(in, out, n, shuffle); i < n; i++) {
+    for (size_t byte = 0; byte < shuffle.dst_bpp; byte++) {
+      const uint8_t index = shuffle.index[byte];
+      out[i * shuffle.dst_bpp + byte] =
+          index == alpha_byte ? 0xFF : in[i * shuffle.src_bpp + index];
+    }
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED void libfreenect2_ffi::depth_to_millimeters(
+    rust::Slice<const uint8_t> depth, rust::Slice<uint16_t> dst) {
+  const size_t n = float_count(depth);
+  check_dst_size(dst.size(), n);
+
+  const auto *values = reinterpret_cast<const float *>(depth.data());
+  for (size_t i = millimeters_simd(values, dst.data(), n); i < n; i++) {
+    float value;
+    std::memcpy(&value, depth.data() + i * sizeof(float), sizeof(float));
+    dst[i] = value > 0.f
+                 ? static_cast<uint16_t>(std::lrint(std::min(value, 65535.f)))
+                 : 0;
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED void libfreenect2_ffi::depth_to_colormap(
+    rust::Slice<const uint8_t> depth, float min_depth, float max_depth,
+    Colormap colormap, rust::Slice<uint8_t> dst) {
+  if (!(max_depth > min_depth)) {
+    throw std::runtime_error(
+        "The maximum depth must be greater than the minimum depth");
+  }
+
+  const Palette &palette = get_palette(colormap);
+  const size_t n = float_count(depth);
+  check_dst_size(dst.size(), n * 3);
+
+  const Quantizer q{min_depth, 254.f / (max_depth - min_depth), 254.f, true};
+  uint8_t indices[256];
+  for (size_t begin = 0; begin < n; begin += sizeof(indices)) {
+    const size_t count = std::min(sizeof(indices), n - begin);
+    quantize(depth.data() + begin * sizeof(float), indices, count, q);
+
+    uint8_t *out = dst.data() + begin * 3;
+    for (size_t i = 0; i < count; i++) {
+      std::memcpy(out + i * 3, palette[indices[i]].data(), 3);
+    }
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED void libfreenect2_ffi::normalize_ir(
+    rust::Slice<const uint8_t> ir, float max_value, rust::Slice<uint8_t> dst) {
+  if (!(max_value > 0.f)) {
+    throw std::runtime_error("The maximum IR value must be positive");
+  }
+
+  const size_t n = float_count(ir);
+  check_dst_size(dst.size(), n);
+
+  quantize(ir.data(), dst.data(), n, {0.f, 255.f / max_value, 255.f, false});
+}
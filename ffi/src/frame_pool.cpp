@@ -0,0 +1,99 @@
+#include "frame_pool.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace libfreenect2_ffi;
+
+FramePool::FramePool(uint64_t capacity)
+    : capacity_(capacity), exhausted(0), mutex(), rings() {
+  if (capacity == 0) {
+    throw std::runtime_error("The frame pool capacity must be at least 1");
+  }
+}
+
+FramePool::~FramePool() {
+  for (auto &[_, ring] : rings) {
+    for (auto *frame : ring.free) {
+      delete frame;
+    }
+  }
+}
+
+libfreenect2::Frame *FramePool::acquire(libfreenect2::Frame::Type type,
+                                        const libfreenect2::Frame &source) {
+  std::lock_guard lock(mutex);
+  Ring &ring = rings[type];
+
+  if (ring.width != source.width || ring.height != source.height ||
+      ring.bytes_per_pixel != source.bytes_per_pixel) {
+    reset_ring(ring, source);
+  }
+
+  if (ring.free.empty()) {
+    exhausted.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  libfreenect2::Frame *frame = ring.free.back();
+  ring.free.pop_back();
+
+  return frame;
+}
+
+void FramePool::release(libfreenect2::Frame::Type type,
+                        libfreenect2::Frame *frame) {
+  std::lock_guard lock(mutex);
+  Ring &ring = rings[type];
+
+  // The ring may have been resized while this frame was in use
+  if (ring.width != frame->width || ring.height != frame->height ||
+      ring.bytes_per_pixel != frame->bytes_per_pixel) {
+    delete frame;
+  } else {
+    ring.free.push_back(frame);
+  }
+}
+
+void FramePool::reset_ring(Ring &ring,
+                           const libfreenect2::Frame &source) const {
+  for (auto *frame : ring.free) {
+    delete frame;
+  }
+
+  ring.free.clear();
+  ring.width = source.width;
+  ring.height = source.height;
+  ring.bytes_per_pixel = source.bytes_per_pixel;
+
+  const size_t size = source.width * source.height * source.bytes_per_pixel;
+  ring.free.reserve(capacity_);
+  for (uint64_t i = 0; i < capacity_; i++) {
+    auto *frame = new libfreenect2::Frame(source.width, source.height,
+                                          source.bytes_per_pixel);
+
+    // Touch every page now so the first capture doesn't page-fault
+    std::memset(frame->data, 0, size);
+    ring.free.push_back(frame);
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t FramePool::capacity() const noexcept {
+  return capacity_;
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t FramePool::exhausted_count() const noexcept {
+  return exhausted.load(std::memory_order_relaxed);
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t FramePool::available(FrameType type) const {
+  std::lock_guard lock(mutex);
+  auto it = rings.find(static_cast<libfreenect2::Frame::Type>(type));
+
+  return it == rings.end() ? capacity_ : it->second.free.size();
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::shared_ptr<FramePool>
+libfreenect2_ffi::create_frame_pool(uint64_t capacity) {
+  return std::make_shared<FramePool>(capacity);
+}
@@ -6,11 +6,59 @@
 
 using namespace libfreenect2_ffi;
 
+DepthStreamFilter::DepthStreamFilter()
+    : listener(nullptr),
+      streams(static_cast<uint8_t>(DepthStreams::IrAndDepth)),
+      post_processor(nullptr),
+      counter(nullptr) {}
+
+bool DepthStreamFilter::onNewFrame(libfreenect2::Frame::Type type,
+                                   libfreenect2::Frame* frame) {
+  if (counter) {
+    counter->record(type, frame->sequence);
+  }
+
+  // Raw depth packets are neither IR nor depth frames
+  if (frame->format != libfreenect2::Frame::Raw &&
+      (streams.load(std::memory_order_relaxed) &
+       static_cast<uint8_t>(type)) == 0) {
+    return false;
+  }
+
+  if (type != libfreenect2::Frame::Depth ||
+      frame->format != libfreenect2::Frame::Float) {
+    return listener->onNewFrame(type, frame);
+  }
+
+  // Keeps the post-processor alive if it is replaced concurrently
+  const std::shared_ptr<DepthPostProcessor> processor =
+      std::atomic_load(&post_processor);
+  if (!processor) {
+    return listener->onNewFrame(type, frame);
+  }
+
+  const size_t width = frame->width;
+  const size_t height = frame->height;
+  processor->apply(*frame);
+
+  // The depth processor writes full frames into the frames it gets back
+  const bool taken = listener->onNewFrame(type, frame);
+  if (!taken) {
+    frame->width = width;
+    frame->height = height;
+  }
+
+  return taken;
+}
+
 Freenect2Device::Freenect2Device(libfreenect2::Freenect2Device* device)
     : device(device) {
   if (device == nullptr) {
     throw std::runtime_error("Failed to open device");
   }
+
+  color_counter.counter = &packets;
+  depth_filter.counter = &packets;
 }
 
 LIBFREENECT2_MAYBE_UNUSED rust::String Freenect2Device::get_serial_number() {
@@ -40,17 +88,21 @@ LIBFREENECT2_MAYBE_UNUSED bool Freenect2Device::close() {
 
 LIBFREENECT2_MAYBE_UNUSED void Freenect2Device::set_color_frame_listener(
     const std::unique_ptr<libfreenect2::FrameListener>& listener) {
-  device->setColorFrameListener(listener.get());
+  color_counter.listener = listener.get();
+  device->setColorFrameListener(&color_counter);
 }
 
 LIBFREENECT2_MAYBE_UNUSED void Freenect2Device::set_ir_and_depth_frame_listener(
     const std::unique_ptr<libfreenect2::FrameListener>& listener) {
-  device->setIrAndDepthFrameListener(listener.get());
+  depth_filter.listener = listener.get();
+  device->setIrAndDepthFrameListener(&depth_filter);
 }
 
 LIBFREENECT2_MAYBE_UNUSED void Freenect2Device::set_config(
     const std::unique_ptr<Config>& config) {
   device->setConfiguration(config->config);
+  depth_filter.streams.store(static_cast<uint8_t>(config->depth_streams),
+                             std::memory_order_relaxed);
 }
 
 LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Registration>
@@ -58,6 +110,29 @@ Freenect2Device::get_registration() {
   return std::make_unique<Registration>(device);
 }
 
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Registration>
+Freenect2Device::get_registration_with_engine(RegistrationEngine engine,
+                                              uint64_t threads) {
+  return std::make_unique<Registration>(device, engine, threads);
+}
+
+LIBFREENECT2_MAYBE_UNUSED CameraParams Freenect2Device::get_camera_params() {
+  return to_camera_params(device->getIrCameraParams(),
+                          device->getColorCameraParams());
+}
+
+LIBFREENECT2_MAYBE_UNUSED void Freenect2Device::set_depth_post_processing(
+    const DepthPostProcessingParams& params) {
+  std::atomic_store(&depth_filter.post_processor,
+                    std::make_shared<DepthPostProcessor>(params));
+}
+
+LIBFREENECT2_MAYBE_UNUSED void
+Freenect2Device::clear_depth_post_processing() noexcept {
+  std::atomic_store(&depth_filter.post_processor,
+                    std::shared_ptr<DepthPostProcessor>());
+}
+
 void Freenect2Device::set_led_settings(const LedSettings& settings) {
   libfreenect2::LedSettings led_settings = {
       settings.id,          static_cast<uint16_t>(settings.mode),
@@ -68,6 +143,15 @@ void Freenect2Device::set_led_settings(const LedSettings& settings) {
   device->setLedStatus(led_settings);
 }
 
+LIBFREENECT2_MAYBE_UNUSED PacketStats
+Freenect2Device::get_packet_stats() const noexcept {
+  return packets.stats();
+}
+
+LIBFREENECT2_MAYBE_UNUSED void Freenect2Device::reset_packet_stats() noexcept {
+  packets.reset();
+}
+
 Freenect2Device::~Freenect2Device() {
   delete device;
 }
@@ -0,0 +1,121 @@
+#include "gpu_devices.hpp"
+
+#include <string>
+#include <vector>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+#if defined(LIBFREENECT2_RS_WITH_OPENCL)
+#if __has_include(<CL/cl.h>)
+#include <CL/cl.h>
+#define LIBFREENECT2_RS_HAS_OPENCL_HEADERS
+#elif __has_include(<OpenCL/cl.h>)
+#include <OpenCL/cl.h>
+#define LIBFREENECT2_RS_HAS_OPENCL_HEADERS
+#endif
+#endif  // LIBFREENECT2_RS_WITH_OPENCL
+
+#if defined(LIBFREENECT2_RS_WITH_CUDA) && __has_include(<cuda_runtime_api.h>)
+#include <cuda_runtime_api.h>
+#define LIBFREENECT2_RS_HAS_CUDA_HEADERS
+#endif
+
+using namespace libfreenect2_ffi;
+
+namespace {
+#ifdef LIBFREENECT2_RS_HAS_OPENCL_HEADERS
+  template <class T, class F>
+  std::string get_info(T handle, uint32_t param, F get) {
+    size_t size = 0;
+    if (get(handle, param, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+      return {};
+    }
+
+    std::string res(size, '\0');
+    if (get(handle, param, size, res.data(), nullptr) != CL_SUCCESS) {
+      return {};
+    }
+
+    // Drop the null terminator
+    res.resize(size - 1);
+    return res;
+  }
+
+  void list_opencl_devices(rust::Vec<GpuDevice> &res) {
+    cl_uint num_platforms = 0;
+    if (clGetPlatformIDs(0, nullptr, &num_platforms) != CL_SUCCESS ||
+        num_platforms == 0) {
+      return;
+    }
+
+    std::vector<cl_platform_id> platforms(num_platforms);
+    if (clGetPlatformIDs(num_platforms, platforms.data(), nullptr) !=
+        CL_SUCCESS) {
+      return;
+    }
+
+    // libfreenect2 numbers all devices of all platforms in this order
+    int32_t index = 0;
+    for (auto platform : platforms) {
+      cl_uint num_devices = 0;
+      if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, nullptr,
+                         &num_devices) != CL_SUCCESS) {
+        continue;
+      }
+
+      std::vector<cl_device_id> devices(num_devices);
+      if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, num_devices,
+                         devices.data(), nullptr) != CL_SUCCESS) {
+        continue;
+      }
+
+      const auto platform_name =
+          get_info(platform, CL_PLATFORM_NAME, clGetPlatformInfo);
+      for (auto device : devices) {
+        cl_device_type type = 0;
+        clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(type), &type, nullptr);
+
+        res.push_back(GpuDevice{
+            GpuApi::OpenCL,
+            index++,
+            get_info(device, CL_DEVICE_NAME, clGetDeviceInfo),
+            platform_name,
+            (type & CL_DEVICE_TYPE_GPU) != 0,
+        });
+      }
+    }
+  }
+#endif  // LIBFREENECT2_RS_HAS_OPENCL_HEADERS
+
+#ifdef LIBFREENECT2_RS_HAS_CUDA_HEADERS
+  void list_cuda_devices(rust::Vec<GpuDevice> &res) {
+    int count = 0;
+    if (cudaGetDeviceCount(&count) != cudaSuccess) {
+      return;
+    }
+
+    for (int i = 0; i < count; i++) {
+      cudaDeviceProp properties{};
+      if (cudaGetDeviceProperties(&properties, i) != cudaSuccess) {
+        continue;
+      }
+
+      res.push_back(GpuDevice{GpuApi::CUDA, i, properties.name, "CUDA", true});
+    }
+  }
+#endif  // LIBFREENECT2_RS_HAS_CUDA_HEADERS
+}  // namespace
+
+LIBFREENECT2_MAYBE_UNUSED rust::Vec<GpuDevice>
+libfreenect2_ffi::list_gpu_devices() {
+  rust::Vec<GpuDevice> res;
+
+#ifdef LIBFREENECT2_RS_HAS_OPENCL_HEADERS
+  list_opencl_devices(res);
+#endif
+#ifdef LIBFREENECT2_RS_HAS_CUDA_HEADERS
+  list_cuda_devices(res);
+#endif
+
+  return res;
+}
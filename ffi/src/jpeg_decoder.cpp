@@ -0,0 +1,227 @@
+#include "jpeg_decoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+#if defined(LIBFREENECT2_RS_WITH_TURBOJPEG) && __has_include(<turbojpeg.h>)
+#include <turbojpeg.h>
+#define LIBFREENECT2_RS_HAS_TURBOJPEG_HEADERS
+#endif
+
+using namespace libfreenect2_ffi;
+
+namespace {
+#ifdef LIBFREENECT2_RS_HAS_TURBOJPEG_HEADERS
+  struct TjBuffer {
+    unsigned char *data = nullptr;
+    unsigned long size = 0;
+
+    ~TjBuffer() {
+      if (data != nullptr) {
+        tjFree(data);
+      }
+    }
+  };
+
+  [[noreturn]] void throw_tj_error(void *handle, const char *what) {
+    throw std::runtime_error(std::string(what) + ": " +
+                             tjGetErrorStr2(handle));
+  }
+
+  int get_pixel_format(DecodeFormat format) {
+    switch (format) {
+      case DecodeFormat::RGB:
+        return TJPF_RGB;
+      case DecodeFormat::BGRX:
+        return TJPF_BGRX;
+      case DecodeFormat::RGBX:
+        return TJPF_RGBX;
+      case DecodeFormat::Gray:
+        return TJPF_GRAY;
+      default:
+        throw std::runtime_error("Invalid decode format");
+    }
+  }
+
+  libfreenect2::Frame::Format get_frame_format(DecodeFormat format) {
+    switch (format) {
+      case DecodeFormat::BGRX:
+        return libfreenect2::Frame::BGRX;
+      case DecodeFormat::RGBX:
+        return libfreenect2::Frame::RGBX;
+      case DecodeFormat::Gray:
+        return libfreenect2::Frame::Gray;
+      default:
+        // libfreenect2 has no format for packed 3 byte pixels
+        return libfreenect2::Frame::Raw;
+    }
+  }
+
+  int get_scale_denom(DecodeScale scale) {
+    switch (scale) {
+      case DecodeScale::Full:
+      case DecodeScale::Half:
+      case DecodeScale::Quarter:
+      case DecodeScale::Eighth:
+        return static_cast<int>(scale);
+      default:
+        throw std::runtime_error("Invalid decode scale");
+    }
+  }
+
+  int scaled(int size, int denom) { return (size + denom - 1) / denom; }
+#endif  // LIBFREENECT2_RS_HAS_TURBOJPEG_HEADERS
+}  // namespace
+
+#ifdef LIBFREENECT2_RS_HAS_TURBOJPEG_HEADERS
+JpegDecoder::JpegDecoder()
+    : decompressor(tjInitDecompress()),
+      transformer(tjInitTransform()),
+      scratch() {
+  if (decompressor == nullptr || transformer == nullptr) {
+    if (decompressor != nullptr) tjDestroy(decompressor);
+    if (transformer != nullptr) tjDestroy(transformer);
+
+    throw std::runtime_error("Failed to initialize the JPEG decoder");
+  }
+}
+
+JpegDecoder::~JpegDecoder() {
+  tjDestroy(decompressor);
+  tjDestroy(transformer);
+}
+
+LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> JpegDecoder::decode(
+    rust::Slice<const uint8_t> jpeg, const ColorDecodeParams &params,
+    uint32_t timestamp, uint32_t sequence, float exposure, float gain,
+    float gamma, uint32_t status) {
+  const int pixel_format = get_pixel_format(params.format);
+  const int denom = get_scale_denom(params.scale);
+
+  const unsigned char *src = jpeg.data();
+  unsigned long src_size = jpeg.size();
+
+  int width = 0, height = 0, subsamp = 0, colorspace = 0;
+  if (tjDecompressHeader3(decompressor, src, src_size, &width, &height,
+                          &subsamp, &colorspace) != 0) {
+    throw_tj_error(decompressor, "Failed to read the JPEG header");
+  }
+
+  // The region to output, in pixels of the full resolution image
+  int x = 0, y = 0, region_width = width, region_height = height;
+  if (params.crop) {
+    if (params.region.width == 0 || params.region.height == 0 ||
+        uint64_t(params.region.x) + params.region.width > uint64_t(width) ||
+        uint64_t(params.region.y) + params.region.height > uint64_t(height)) {
+      throw std::runtime_error("The decode region must be inside the image");
+    }
+
+    x = static_cast<int>(params.region.x);
+    y = static_cast<int>(params.region.y);
+    region_width = static_cast<int>(params.region.width);
+    region_height = static_cast<int>(params.region.height);
+  }
+
+  TjBuffer cropped;
+  if (region_width != width || region_height != height) {
+    if (subsamp < 0 || subsamp >= TJ_NUMSAMP) {
+      throw std::runtime_error("Unsupported JPEG chroma subsampling");
+    }
+
+    // Lossless crops must start on an MCU boundary
+    const int mcu_x = x - x % tjMCUWidth[subsamp];
+    const int mcu_y = y - y % tjMCUHeight[subsamp];
+
+    tjtransform transform{};
+    transform.r = {mcu_x, mcu_y, x + region_width - mcu_x,
+                   y + region_height - mcu_y};
+    transform.op = TJXOP_NONE;
+    transform.options = TJXOPT_CROP;
+
+    if (tjTransform(transformer, src, src_size, 1, &cropped.data,
+                    &cropped.size, &transform, 0) != 0) {
+      throw_tj_error(transformer, "Failed to crop the JPEG image");
+    }
+
+    src = cropped.data;
+    src_size = cropped.size;
+    width = transform.r.w;
+    height = transform.r.h;
+    x -= mcu_x;
+    y -= mcu_y;
+  }
+
+  const int bpp = tjPixelSize[pixel_format];
+  const int decoded_width = scaled(width, denom);
+  const int decoded_height = scaled(height, denom);
+  const int out_x = x / denom;
+  const int out_y = y / denom;
+  const int out_width =
+      std::min(scaled(region_width, denom), decoded_width - out_x);
+  const int out_height =
+      std::min(scaled(region_height, denom), decoded_height - out_y);
+
+  auto frame = std::make_unique<libfreenect2::Frame>(out_width, out_height,
+                                                     bpp);
+  frame->timestamp = timestamp;
+  frame->sequence = sequence;
+  frame->exposure = exposure;
+  frame->gain = gain;
+  frame->gamma = gamma;
+  frame->status = status;
+  frame->format = get_frame_format(params.format);
+
+  if (out_width == decoded_width && out_height == decoded_height) {
+    if (tjDecompress2(decompressor, src, src_size, frame->data, out_width,
+                      out_width * bpp, out_height, pixel_format, 0) != 0) {
+      throw_tj_error(decompressor, "Failed to decode the JPEG image");
+    }
+  } else {
+    // The crop was widened to the MCU grid, decode it and copy the region
+    const size_t pitch = size_t(decoded_width) * bpp;
+    scratch.resize(pitch * decoded_height);
+    if (tjDecompress2(decompressor, src, src_size, scratch.data(),
+                      decoded_width, static_cast<int>(pitch), decoded_height,
+                      pixel_format, 0) != 0) {
+      throw_tj_error(decompressor, "Failed to decode the JPEG image");
+    }
+
+    const size_t row = size_t(out_width) * bpp;
+    for (int i = 0; i < out_height; i++) {
+      std::memcpy(frame->data + i * row,
+                  scratch.data() + (out_y + i) * pitch + out_x * bpp, row);
+    }
+  }
+
+  return std::make_unique<Frame>(frame.release());
+}
+
+LIBFREENECT2_RS_FUNC bool libfreenect2_ffi::jpeg_decoder_available() noexcept {
+  return true;
+}
+#else
+JpegDecoder::JpegDecoder() : decompressor(nullptr), transformer(nullptr) {
+  throw std::runtime_error("This library was built without a JPEG decoder");
+}
+
+JpegDecoder::~JpegDecoder() = default;
+
+LIBFREENECT2_RS_FUNC std::unique_ptr<Frame> JpegDecoder::decode(
+    rust::Slice<const uint8_t>, const ColorDecodeParams &, uint32_t, uint32_t,
+    float, float, float, uint32_t) {
+  throw std::runtime_error("This library was built without a JPEG decoder");
+}
+
+LIBFREENECT2_RS_FUNC bool libfreenect2_ffi::jpeg_decoder_available() noexcept {
+  return false;
+}
+#endif  // LIBFREENECT2_RS_HAS_TURBOJPEG_HEADERS
+
+LIBFREENECT2_RS_FUNC std::unique_ptr<JpegDecoder>
+libfreenect2_ffi::create_jpeg_decoder() {
+  return std::make_unique<JpegDecoder>();
+}
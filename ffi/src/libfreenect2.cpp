@@ -1,5 +1,7 @@
 #include "libfreenect2.hpp"
 
+#include <stdexcept>
+
 #include "libfreenect2-rs/src/ffi.rs.h"
 #include "libfreenect2/packet_pipeline.h"
 
@@ -9,23 +11,95 @@ Freenect2::Freenect2() : freenect2() {}
 
 Freenect2::~Freenect2() = default;
 
-libfreenect2::PacketPipeline *get_pipeline(PacketPipeline pipeline) {
+libfreenect2::PacketPipeline *get_decoding_pipeline(
+    PacketPipeline pipeline, LIBFREENECT2_MAYBE_UNUSED int32_t device_id) {
   switch (pipeline) {
 #ifdef LIBFREENECT2_RS_WITH_OPENCL
     case PacketPipeline::OpenCL:
-      return new libfreenect2::OpenCLPacketPipeline();
+      return new libfreenect2::OpenCLPacketPipeline(device_id);
     case PacketPipeline::OpenCLKDE:
-      return new libfreenect2::OpenCLKdePacketPipeline();
+      return new libfreenect2::OpenCLKdePacketPipeline(device_id);
 #endif  // LIBFREENECT2_RS_WITH_OPENCL
 #ifdef LIBFREENECT2_RS_WITH_OPENGL
     case PacketPipeline::OpenGL:
       return new libfreenect2::OpenGLPacketPipeline();
 #endif  // LIBFREENECT2_RS_WITH_OPENGL
+#ifdef LIBFREENECT2_RS_WITH_CUDA
+    case PacketPipeline::CUDA:
+      return new libfreenect2::CudaPacketPipeline(device_id);
+    case PacketPipeline::CUDAKDE:
+      return new libfreenect2::CudaKdePacketPipeline(device_id);
+#endif  // LIBFREENECT2_RS_WITH_CUDA
     default:
       return new libfreenect2::CpuPacketPipeline();
   }
 }
 
+namespace {
+  /**
+   * A packet pipeline taking the color and the depth stages from two
+   * different pipelines, so one stream can be delivered undecoded by
+   * libfreenect2's dump pipeline while the other one is decoded.
+   * The device only accesses pipelines through these getters.
+   */
+  class MixedPacketPipeline : public libfreenect2::PacketPipeline {
+   public:
+    MixedPacketPipeline(libfreenect2::PacketPipeline *decoding, bool raw_color)
+        : decoding(decoding),
+          dump(new libfreenect2::DumpPacketPipeline()),
+          color(raw_color ? dump.get() : this->decoding.get()),
+          depth(raw_color ? this->decoding.get() : dump.get()) {
+      // Only set by initialize(), which is never called for this pipeline
+      comp_ = nullptr;
+    }
+
+    PacketParser *getRgbPacketParser() const override {
+      return color->getRgbPacketParser();
+    }
+
+    PacketParser *getIrPacketParser() const override {
+      return depth->getIrPacketParser();
+    }
+
+    libfreenect2::RgbPacketProcessor *getRgbPacketProcessor() const override {
+      return color->getRgbPacketProcessor();
+    }
+
+    libfreenect2::DepthPacketProcessor *getDepthPacketProcessor()
+        const override {
+      return depth->getDepthPacketProcessor();
+    }
+
+   protected:
+    libfreenect2::DepthPacketProcessor *createDepthPacketProcessor() override {
+      return nullptr;
+    }
+
+   private:
+    const std::unique_ptr<libfreenect2::PacketPipeline> decoding;
+    const std::unique_ptr<libfreenect2::PacketPipeline> dump;
+    libfreenect2::PacketPipeline *const color;
+    libfreenect2::PacketPipeline *const depth;
+  };
+}  // namespace
+
+libfreenect2::PacketPipeline *get_pipeline(PacketPipeline pipeline,
+                                           int32_t device_id,
+                                           RawPackets raw) {
+  switch (raw) {
+    case RawPackets::Color:
+      return new MixedPacketPipeline(get_decoding_pipeline(pipeline, device_id),
+                                     true);
+    case RawPackets::Depth:
+      return new MixedPacketPipeline(get_decoding_pipeline(pipeline, device_id),
+                                     false);
+    case RawPackets::All:
+      return new libfreenect2::DumpPacketPipeline();
+    default:
+      return get_decoding_pipeline(pipeline, device_id);
+  }
+}
+
 LIBFREENECT2_MAYBE_UNUSED int32_t Freenect2::enumerate_devices() {
   return freenect2.enumerateDevices();
 }
@@ -37,8 +111,13 @@ LIBFREENECT2_MAYBE_UNUSED rust::String Freenect2::get_device_serial_number(
 
 LIBFREENECT2_MAYBE_UNUSED rust::String
 Freenect2::get_default_device_serial_number() {
-  freenect2.openDefaultDevice();
-  return freenect2.getDefaultDeviceSerialNumber();
+  // The serial is known after enumerating, no need to open the device
+  std::string serial = freenect2.getDefaultDeviceSerialNumber();
+  if (serial.empty()) {
+    throw std::runtime_error("No default device found");
+  }
+
+  return serial;
 }
 
 LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Freenect2Device>
@@ -48,9 +127,11 @@ Freenect2::open_device_by_id(int32_t idx) {
 
 LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device>
 Freenect2::open_device_by_id_with_packet_pipeline(int32_t idx,
-                                                  PacketPipeline pipeline) {
+                                                  PacketPipeline pipeline,
+                                                  int32_t device_id,
+                                                  RawPackets raw) {
   return std::make_unique<Freenect2Device>(
-      freenect2.openDevice(idx, get_pipeline(pipeline)));
+      freenect2.openDevice(idx, get_pipeline(pipeline, device_id, raw)));
 }
 
 LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Freenect2Device>
@@ -61,9 +142,12 @@ Freenect2::open_device_by_serial(rust::Str serial) {
 
 LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device>
 Freenect2::open_device_by_serial_with_packet_pipeline(rust::Str serial,
-                                                      PacketPipeline pipeline) {
-  return std::make_unique<Freenect2Device>(freenect2.openDevice(
-      serial.operator std::string(), get_pipeline(pipeline)));
+                                                      PacketPipeline pipeline,
+                                                      int32_t device_id,
+                                                      RawPackets raw) {
+  return std::make_unique<Freenect2Device>(
+      freenect2.openDevice(serial.operator std::string(),
+                           get_pipeline(pipeline, device_id, raw)));
 }
 
 LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Freenect2Device>
@@ -72,9 +156,11 @@ Freenect2::open_default_device() {
 }
 
 LIBFREENECT2_RS_FUNC std::unique_ptr<Freenect2Device>
-Freenect2::open_default_device_with_packet_pipeline(PacketPipeline pipeline) {
+Freenect2::open_default_device_with_packet_pipeline(PacketPipeline pipeline,
+                                                    int32_t device_id,
+                                                    RawPackets raw) {
   return std::make_unique<Freenect2Device>(
-      freenect2.openDefaultDevice(get_pipeline(pipeline)));
+      freenect2.openDefaultDevice(get_pipeline(pipeline, device_id, raw)));
 }
 
 LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Freenect2>
@@ -1,24 +1,169 @@
 #include "logger.hpp"
 
-class Logger : public libfreenect2::Logger {
- public:
-  explicit Logger(rust::Fn<void(LogLevel, const rust::String &)> log_fn)
-      : log_fn(log_fn) {}
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
-  Level level() const override {
-    return Level::Debug;
-  }
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+namespace {
+  // Must be a power of two
+  constexpr size_t ring_capacity = 256;
+  constexpr size_t max_message_length = 1000;
+  // Bounds the delay of level changes and of messages
+  // pushed while the drain thread goes to sleep
+  constexpr auto drain_interval = std::chrono::milliseconds(100);
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    LogLevel level;
+    size_t length;
+    char message[max_message_length];
+  };
 
-  void log(Level level, const std::string &message) override {
-    log_fn(static_cast<LogLevel>(level), message);
+  // Truncate to a whole UTF-8 character
+  size_t truncated_length(const std::string &message) {
+    if (message.size() <= max_message_length) return message.size();
+
+    size_t length = max_message_length;
+    while (length > 0 && (message[length] & 0xC0) == 0x80) {
+      length--;
+    }
+
+    return length;
   }
 
- private:
-  rust::Fn<void(LogLevel, const rust::String &)> log_fn;
-};
+  class Logger : public libfreenect2::Logger {
+   public:
+    Logger(rust::Fn<void(LogLevel, rust::Str)> log_fn,
+           rust::Fn<LogLevel()> level_fn)
+        : log_fn(log_fn),
+          level_fn(level_fn),
+          current_level(static_cast<uint8_t>(level_fn())) {
+      for (size_t i = 0; i < ring_capacity; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+      }
+
+      // The global logger is never destroyed
+      std::thread(&Logger::drain, this).detach();
+    }
+
+    Level level() const override {
+      return static_cast<Level>(current_level.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Push a message to the ring, a bounded multi-producer queue, see
+     * https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+     */
+    void log(Level level, const std::string &message) override {
+      if (level > this->level()) return;
+
+      size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+      Slot *slot = nullptr;
+      for (;;) {
+        slot = &slots[pos & (ring_capacity - 1)];
+        const size_t sequence =
+            slot->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+        if (diff == 0) {
+          if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+            break;
+          }
+        } else if (diff < 0) {
+          // The ring is full
+          dropped.fetch_add(1, std::memory_order_relaxed);
+          return;
+        } else {
+          pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+      }
+
+      slot->level = static_cast<LogLevel>(level);
+      slot->length = truncated_length(message);
+      std::memcpy(slot->message, message.data(), slot->length);
+      slot->sequence.store(pos + 1, std::memory_order_release);
+
+      wake.notify_one();
+    }
+
+   private:
+    void drain() {
+      size_t reported_dropped = 0;
+      for (;;) {
+        current_level.store(static_cast<uint8_t>(level_fn()),
+                            std::memory_order_relaxed);
+
+        while (pop()) {
+        }
+
+        const size_t dropped_now = dropped.load(std::memory_order_relaxed);
+        if (dropped_now != reported_dropped) {
+          const std::string message =
+              "Dropped " + std::to_string(dropped_now - reported_dropped) +
+              " libfreenect2 log messages, the log ring is full";
+          log_fn(LogLevel::Warning, rust::Str(message));
+          reported_dropped = dropped_now;
+        }
+
+        std::unique_lock lock(mutex);
+        wake.wait_for(lock, drain_interval);
+      }
+    }
+
+    bool pop() {
+      Slot &slot = slots[dequeue_pos & (ring_capacity - 1)];
+      if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) {
+        return false;
+      }
+
+      write(slot.level, slot.message, slot.length);
+      slot.sequence.store(dequeue_pos + ring_capacity,
+                          std::memory_order_release);
+      dequeue_pos++;
+
+      return true;
+    }
+
+    void write(LogLevel level, char *message, size_t length) {
+      try {
+        log_fn(level, rust::Str(message, length));
+      } catch (const std::invalid_argument &) {
+        // Not valid UTF-8, which rust::Str requires
+        std::replace_if(
+            message, message + length,
+            [](char c) { return (c & 0x80) != 0; }, '?');
+        log_fn(level, rust::Str(message, length));
+      }
+    }
+
+    rust::Fn<void(LogLevel, rust::Str)> log_fn;
+    rust::Fn<LogLevel()> level_fn;
+    std::atomic<uint8_t> current_level;
+
+    std::array<Slot, ring_capacity> slots;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) size_t dequeue_pos = 0;
+    std::atomic<size_t> dropped{0};
+
+    std::mutex mutex;
+    std::condition_variable wake;
+  };
+}  // namespace
 
 LIBFREENECT2_MAYBE_UNUSED void libfreenect2_ffi::create_logger(
-    rust::Fn<void(LogLevel, const rust::String &)> log_fn) {
-  auto logger = new Logger(log_fn);
+    rust::Fn<void(LogLevel, rust::Str)> log_fn,
+    rust::Fn<LogLevel()> level_fn) {
+  auto logger = new Logger(log_fn, level_fn);
   libfreenect2::setGlobalLogger(logger);
-}
\ No newline at end of file
+}
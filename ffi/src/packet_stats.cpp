@@ -0,0 +1,92 @@
+#include "packet_stats.hpp"
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+using namespace libfreenect2_ffi;
+
+PacketCounter::PacketCounter() : color(), ir(), depth() {
+  reset();
+}
+
+void PacketCounter::record(libfreenect2::Frame::Type type,
+                           uint32_t sequence) noexcept {
+  Stream* stream;
+  switch (type) {
+    case libfreenect2::Frame::Color:
+      stream = &color;
+      break;
+    case libfreenect2::Frame::Ir:
+      stream = &ir;
+      break;
+    case libfreenect2::Frame::Depth:
+      stream = &depth;
+      break;
+    default:
+      return;
+  }
+
+  const uint64_t next = stream->next.load(std::memory_order_relaxed);
+  // The sequence starts over if the stream is restarted
+  if (next != 0 && sequence >= next) {
+    const uint64_t lost = sequence - next;
+    if (lost > 0) {
+      stream->lost.fetch_add(lost, std::memory_order_relaxed);
+      stream->gaps.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  stream->next.store(static_cast<uint64_t>(sequence) + 1,
+                     std::memory_order_relaxed);
+  stream->frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+PacketStats PacketCounter::stats() const noexcept {
+  return {color.stats(), ir.stats(), depth.stats()};
+}
+
+void PacketCounter::reset() noexcept {
+  color.reset();
+  ir.reset();
+  depth.reset();
+}
+
+StreamStats PacketCounter::Stream::stats() const noexcept {
+  return {frames.load(std::memory_order_relaxed),
+          lost.load(std::memory_order_relaxed),
+          gaps.load(std::memory_order_relaxed)};
+}
+
+void PacketCounter::Stream::reset() noexcept {
+  frames.store(0, std::memory_order_relaxed);
+  lost.store(0, std::memory_order_relaxed);
+  gaps.store(0, std::memory_order_relaxed);
+  next.store(0, std::memory_order_relaxed);
+}
+
+ColorStreamCounter::ColorStreamCounter()
+    : listener(nullptr), counter(nullptr) {}
+
+bool ColorStreamCounter::onNewFrame(libfreenect2::Frame::Type type,
+                                    libfreenect2::Frame* frame) {
+  if (counter) {
+    counter->record(type, frame->sequence);
+  }
+
+  return listener != nullptr && listener->onNewFrame(type, frame);
+}
+
+#if !defined(NDEBUG) || defined(LIBFREENECT2_RS_BENCH)
+namespace libfreenect2_ffi {
+  namespace test {
+    LIBFREENECT2_MAYBE_UNUSED StreamStats
+    count_packets(rust::Slice<const uint32_t> sequences) {
+      PacketCounter counter;
+      for (size_t i = 0; i < sequences.size(); i++) {
+        counter.record(libfreenect2::Frame::Color, sequences[i]);
+      }
+
+      return counter.stats().color;
+    }
+  }  // namespace test
+}  // namespace libfreenect2_ffi
+#endif
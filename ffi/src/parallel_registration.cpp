@@ -0,0 +1,328 @@
+#include "parallel_registration.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+using namespace libfreenect2_ffi;
+
+namespace {
+  constexpr int depth_width = 512;
+  constexpr int depth_height = 424;
+  constexpr int depth_size = depth_width * depth_height;
+  constexpr int color_width = 1920;
+  constexpr int color_height = 1080;
+  constexpr int color_size = color_width * color_height;
+
+  // Constants used by libfreenect2::Registration
+  constexpr int filter_width_half = 2;
+  constexpr int filter_height_half = 1;
+  constexpr float filter_tolerance = 0.01f;
+
+  // The filter map has a border of filter_height_half rows
+  // on the top and on the bottom, this equals the big depth frame
+  constexpr int filter_map_offset = color_width * filter_height_half;
+  constexpr int filter_map_size = color_size + 2 * filter_map_offset;
+  constexpr int filter_window_reach =
+      filter_height_half * color_width + filter_width_half;
+
+  // Number of depth rows processed by a single task
+  constexpr int rows_per_task = 16;
+  constexpr size_t row_tasks =
+      (depth_height + rows_per_task - 1) / rows_per_task;
+
+  bool has_size(const libfreenect2::Frame *frame, size_t width,
+                size_t height) {
+    return frame != nullptr && frame->width == width &&
+           frame->height == height && frame->bytes_per_pixel == 4;
+  }
+
+  int block_begin(size_t block) {
+    return static_cast<int>(block) * rows_per_task * depth_width;
+  }
+
+  int block_end(size_t block) {
+    return std::min(block_begin(block) + rows_per_task * depth_width,
+                    depth_size);
+  }
+
+  template <class F>
+  void for_each_row_block(WorkerPool &pool, F &&f) {
+    pool.run(row_tasks, [&f](size_t block) {
+      f(block, block_begin(block), block_end(block));
+    });
+  }
+
+  /**
+   * Call f with the range of pixel indices of every row of rect
+   * within the rows from pixel index begin to end.
+   */
+  template <class Rect, class F>
+  void for_each_rect_row(const Rect &rect, int begin, int end, F &&f) {
+    const int first = std::max(begin / depth_width, rect.y);
+    const int last = std::min(end / depth_width, rect.y + rect.height);
+
+    for (int row = first; row < last; row++) {
+      const int row_begin = row * depth_width + rect.x;
+      f(row_begin, row_begin + rect.width);
+    }
+  }
+}  // namespace
+
+ParallelRegistration::ParallelRegistration(
+    std::shared_ptr<const RegistrationTables> tables, size_t threads)
+    : tables(std::move(tables)),
+      mutex(),
+      color_offsets(depth_size),
+      block_ranges(row_tasks),
+      rect_ranges(row_tasks),
+      filter_map(filter_map_size),
+      pool(threads) {}
+
+void ParallelRegistration::apply(const libfreenect2::Frame *rgb,
+                                 const libfreenect2::Frame *depth_frame,
+                                 libfreenect2::Frame *undistorted,
+                                 libfreenect2::Frame *registered,
+                                 bool enable_filter,
+                                 libfreenect2::Frame *bigdepth) const {
+  apply(rgb, depth_frame, undistorted, registered, enable_filter, bigdepth,
+        Rect{0, 0, depth_width, depth_height});
+}
+
+void ParallelRegistration::apply(const libfreenect2::Frame *rgb,
+                                 const libfreenect2::Frame *depth_frame,
+                                 libfreenect2::Frame *undistorted,
+                                 libfreenect2::Frame *registered,
+                                 bool enable_filter,
+                                 const Region &region) const {
+  if (region.width == 0 || region.height == 0 ||
+      static_cast<uint64_t>(region.x) + region.width > depth_width ||
+      static_cast<uint64_t>(region.y) + region.height > depth_height) {
+    throw std::runtime_error("The region must be within the depth frame");
+  }
+
+  apply(rgb, depth_frame, undistorted, registered, enable_filter, nullptr,
+        Rect{static_cast<int>(region.x), static_cast<int>(region.y),
+               static_cast<int>(region.width),
+               static_cast<int>(region.height)});
+}
+
+void ParallelRegistration::apply(const libfreenect2::Frame *rgb,
+                                 const libfreenect2::Frame *depth_frame,
+                                 libfreenect2::Frame *undistorted,
+                                 libfreenect2::Frame *registered,
+                                 bool enable_filter,
+                                 libfreenect2::Frame *bigdepth,
+                                 const Rect &rect) const {
+  if (!has_size(rgb, color_width, color_height) ||
+      !has_size(depth_frame, depth_width, depth_height) ||
+      !has_size(undistorted, depth_width, depth_height) ||
+      !has_size(registered, depth_width, depth_height)) {
+    return;
+  }
+
+  std::lock_guard lock(mutex);
+
+  const auto *depth_data = reinterpret_cast<const float *>(depth_frame->data);
+  const auto *rgb_data = reinterpret_cast<const uint32_t *>(rgb->data);
+  auto *undistorted_data = reinterpret_cast<float *>(undistorted->data);
+  auto *registered_data = reinterpret_cast<uint32_t *>(registered->data);
+  int *c_offsets = color_offsets.data();
+
+  const auto &color = tables->color_params();
+  const int *distort_map = tables->distort_map().data();
+  const float *depth_to_color_map_x = tables->depth_to_color_map_x().data();
+  const int *depth_to_color_map_yi = tables->depth_to_color_map_yi().data();
+
+  // 0.5f added for later rounding
+  const float color_cx = color.cx + 0.5f;
+
+  // Pixels outside of the rectangle may occlude pixels within it,
+  // so the filter needs the color pixels of all depth pixels
+  const Rect all{0, 0, depth_width, depth_height};
+  const Rect &computed = enable_filter ? all : rect;
+
+  // Undistort the depth and compute the color pixel of every depth pixel.
+  // The range of color pixels of every block is stored so the filter pass
+  // can skip blocks which don't touch the part of the filter map it owns.
+  // The range of the pixels within the rectangle bounds the filter map.
+  for_each_row_block(pool, [&](size_t block, int begin, int end) {
+    int min_offset = color_size;
+    int max_offset = -1;
+    int min_rect_offset = color_size;
+    int max_rect_offset = -1;
+
+    for_each_rect_row(computed, begin, end, [&](int row_begin, int row_end) {
+      const int row = row_begin / depth_width;
+      const bool rect_row = row >= rect.y && row < rect.y + rect.height;
+      const int rect_begin = row * depth_width + rect.x;
+      const int rect_end = rect_begin + rect.width;
+
+      for (int i = row_begin; i < row_end; i++) {
+        const int index = distort_map[i];
+        if (index < 0) {
+          c_offsets[i] = -1;
+          undistorted_data[i] = 0;
+          continue;
+        }
+
+        const float z = depth_data[index];
+        undistorted_data[i] = z;
+        if (z <= 0.0f) {
+          c_offsets[i] = -1;
+          continue;
+        }
+
+        const float rx = (depth_to_color_map_x[i] + (color.shift_m / z)) *
+                             color.fx +
+                         color_cx;
+        const int c_off =
+            static_cast<int>(rx) + depth_to_color_map_yi[i] * color_width;
+
+        if (c_off < 0 || c_off >= color_size) {
+          c_offsets[i] = -1;
+          continue;
+        }
+
+        c_offsets[i] = c_off;
+        min_offset = std::min(min_offset, c_off);
+        max_offset = std::max(max_offset, c_off);
+
+        if (rect_row && i >= rect_begin && i < rect_end) {
+          min_rect_offset = std::min(min_rect_offset, c_off);
+          max_rect_offset = std::max(max_rect_offset, c_off);
+        }
+      }
+    });
+
+    block_ranges[block] = {min_offset, max_offset};
+    rect_ranges[block] = {min_rect_offset, max_rect_offset};
+  });
+
+  if (!enable_filter) {
+    for_each_row_block(pool, [&](size_t, int begin, int end) {
+      for_each_rect_row(rect, begin, end, [&](int row_begin, int row_end) {
+        for (int i = row_begin; i < row_end; i++) {
+          const int c_off = c_offsets[i];
+          registered_data[i] = c_off < 0 ? 0 : rgb_data[c_off];
+        }
+      });
+    });
+
+    return;
+  }
+
+  float *filter_data = bigdepth != nullptr
+                           ? reinterpret_cast<float *>(bigdepth->data)
+                           : filter_map.data();
+  float *p_filter_data = filter_data + filter_map_offset;
+
+  // The big depth frame is the whole filter map, otherwise only
+  // the part read by the pixels of the rectangle is computed
+  int span_begin = 0;
+  int span_end = filter_map_size;
+  if (bigdepth == nullptr) {
+    int min_rect_offset = color_size;
+    int max_rect_offset = -1;
+    for (const auto &[min_offset, max_offset] : rect_ranges) {
+      min_rect_offset = std::min(min_rect_offset, min_offset);
+      max_rect_offset = std::max(max_rect_offset, max_offset);
+    }
+
+    // Nothing is read if no pixel maps onto the color frame
+    span_begin = filter_map_offset + min_rect_offset;
+    span_end = filter_map_offset + max_rect_offset + 1;
+    span_begin = std::min(span_begin, span_end);
+  }
+
+  // Every task owns a contiguous range of the filter map and applies
+  // the window of every depth pixel that overlaps with it
+  const size_t filter_tasks = pool.size();
+  const auto span_size = static_cast<size_t>(span_end - span_begin);
+  pool.run(filter_tasks, [&](size_t task) {
+    const int lo =
+        span_begin + static_cast<int>(span_size * task / filter_tasks);
+    const int hi =
+        span_begin + static_cast<int>(span_size * (task + 1) / filter_tasks);
+
+    std::fill(filter_data + lo, filter_data + hi,
+              std::numeric_limits<float>::infinity());
+
+    for (size_t block = 0; block < row_tasks; block++) {
+      // Skip blocks whose windows can't reach the owned range
+      const auto [min_offset, max_offset] = block_ranges[block];
+      if (lo >= hi || max_offset < 0 ||
+          min_offset - filter_window_reach + filter_map_offset >= hi ||
+          max_offset + filter_window_reach + filter_map_offset < lo) {
+        continue;
+      }
+
+      for (int i = block_begin(block), end = block_end(block); i < end; i++) {
+        const int c_off = c_offsets[i];
+        if (c_off < 0) {
+          continue;
+        }
+
+        const float z = undistorted_data[i];
+
+        // Index of the first pixel of the window in the filter map
+        int start = c_off - filter_window_reach + filter_map_offset;
+        for (int r = -filter_height_half; r <= filter_height_half;
+             r++, start += color_width) {
+          const int first = std::max(start, lo);
+          const int last = std::min(start + 2 * filter_width_half + 1, hi);
+
+          for (int j = first; j < last; j++) {
+            if (z < filter_data[j]) {
+              filter_data[j] = z;
+            }
+          }
+        }
+      }
+    }
+  });
+
+  // Drop pixels occluded from the perspective of the color camera
+  for_each_row_block(pool, [&](size_t, int begin, int end) {
+    for_each_rect_row(rect, begin, end, [&](int row_begin, int row_end) {
+      for (int i = row_begin; i < row_end; i++) {
+        const int c_off = c_offsets[i];
+        if (c_off < 0) {
+          registered_data[i] = 0;
+          continue;
+        }
+
+        const float min_z = p_filter_data[c_off];
+        const float z = undistorted_data[i];
+        registered_data[i] =
+            (z - min_z) / z > filter_tolerance ? 0 : rgb_data[c_off];
+      }
+    });
+  });
+}
+
+void ParallelRegistration::undistort_depth(
+    const libfreenect2::Frame *depth_frame,
+    libfreenect2::Frame *undistorted) const {
+  if (!has_size(depth_frame, depth_width, depth_height) ||
+      !has_size(undistorted, depth_width, depth_height)) {
+    return;
+  }
+
+  std::lock_guard lock(mutex);
+
+  const auto *depth_data = reinterpret_cast<const float *>(depth_frame->data);
+  auto *undistorted_data = reinterpret_cast<float *>(undistorted->data);
+  const int *distort_map = tables->distort_map().data();
+
+  for_each_row_block(pool, [&](size_t, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      const int index = distort_map[i];
+      undistorted_data[i] = index < 0 ? 0 : depth_data[index];
+    }
+  });
+}
@@ -1,18 +1,71 @@
 #include "registration.hpp"
 
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
 using namespace libfreenect2_ffi;
 
 Registration::Registration(libfreenect2::Freenect2Device *device)
-    : registration(device->getIrCameraParams(),
-                   device->getColorCameraParams()) {}
+    : Registration(device, RegistrationEngine::Libfreenect2, 0) {}
+
+Registration::Registration(libfreenect2::Freenect2Device *device,
+                           RegistrationEngine engine, uint64_t threads)
+    : Registration(device->getIrCameraParams(),
+                   device->getColorCameraParams(), engine, threads) {}
+
+Registration::Registration(
+    const libfreenect2::Freenect2Device::IrCameraParams &depth_p,
+    const libfreenect2::Freenect2Device::ColorCameraParams &rgb_p,
+    RegistrationEngine engine, uint64_t threads)
+    : Registration(std::make_shared<RegistrationTables>(depth_p, rgb_p),
+                   engine, threads) {}
+
+Registration::Registration(std::shared_ptr<const RegistrationTables> tables,
+                           RegistrationEngine engine, uint64_t threads)
+    : tables(std::move(tables)), registration(nullptr), parallel(nullptr) {
+  switch (engine) {
+    case RegistrationEngine::Libfreenect2:
+      registration = std::make_unique<libfreenect2::Registration>(
+          this->tables->depth_params(), this->tables->color_params());
+      break;
+    case RegistrationEngine::Parallel:
+      parallel = std::make_unique<ParallelRegistration>(this->tables, threads);
+      break;
+    default:
+      throw std::runtime_error("Invalid registration engine");
+  }
+}
 
 LIBFREENECT2_MAYBE_UNUSED void Registration::map_depth_to_color(
     const libfreenect2_ffi::Frame &depth, const libfreenect2_ffi::Frame &color,
     Frame &undistorted_depth, Frame &color_depth_image,
     bool enable_filter) const {
   color_depth_image.frame->format = color.frame->format;
-  registration.apply(color.frame, depth.frame, undistorted_depth.frame,
-                     color_depth_image.frame, enable_filter);
+  if (parallel) {
+    parallel->apply(color.frame, depth.frame, undistorted_depth.frame,
+                    color_depth_image.frame, enable_filter, nullptr);
+  } else {
+    registration->apply(color.frame, depth.frame, undistorted_depth.frame,
+                        color_depth_image.frame, enable_filter);
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED void Registration::map_depth_to_color_region(
+    const libfreenect2_ffi::Frame &depth, const libfreenect2_ffi::Frame &color,
+    Frame &undistorted_depth, Frame &color_depth_image, bool enable_filter,
+    const Region &region) const {
+  color_depth_image.frame->format = color.frame->format;
+  if (parallel) {
+    parallel->apply(color.frame, depth.frame, undistorted_depth.frame,
+                    color_depth_image.frame, enable_filter, region);
+  } else {
+    registration->apply(color.frame, depth.frame, undistorted_depth.frame,
+                        color_depth_image.frame, enable_filter);
+  }
 }
 
 LIBFREENECT2_MAYBE_UNUSED void Registration::map_depth_to_full_color(
@@ -22,12 +75,159 @@ LIBFREENECT2_MAYBE_UNUSED void Registration::map_depth_to_full_color(
     libfreenect2_ffi::Frame &big_depth) const {
   color_depth_image.frame->format = color.frame->format;
 
-  registration.apply(color.frame, depth.frame, undistorted_depth.frame,
-                     color_depth_image.frame, enable_filter, big_depth.frame);
+  if (parallel) {
+    parallel->apply(color.frame, depth.frame, undistorted_depth.frame,
+                    color_depth_image.frame, enable_filter, big_depth.frame);
+  } else {
+    registration->apply(color.frame, depth.frame, undistorted_depth.frame,
+                        color_depth_image.frame, enable_filter,
+                        big_depth.frame);
+  }
 }
 
 LIBFREENECT2_MAYBE_UNUSED void Registration::undistort_depth(
     const libfreenect2_ffi::Frame &depth,
     libfreenect2_ffi::Frame &undistorted_depth) const {
-  registration.undistortDepth(depth.frame, undistorted_depth.frame);
+  if (parallel) {
+    parallel->undistort_depth(depth.frame, undistorted_depth.frame);
+  } else {
+    registration->undistortDepth(depth.frame, undistorted_depth.frame);
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t Registration::get_points_xyz(
+    const Frame &undistorted_depth, rust::Slice<float> points,
+    bool skip_invalid) const {
+  return get_points<3>(undistorted_depth, nullptr, nullptr, points,
+                       skip_invalid);
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t Registration::get_points_xyzrgb(
+    const Frame &undistorted_depth, const Frame &color_depth_image,
+    rust::Slice<float> points, bool skip_invalid) const {
+  return get_points<4>(undistorted_depth, &color_depth_image, nullptr, points,
+                       skip_invalid);
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t Registration::get_points_xyz_region(
+    const Frame &undistorted_depth, const Region &region,
+    rust::Slice<float> points, bool skip_invalid) const {
+  return get_points<3>(undistorted_depth, nullptr, &region, points,
+                       skip_invalid);
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t Registration::get_points_xyzrgb_region(
+    const Frame &undistorted_depth, const Frame &color_depth_image,
+    const Region &region, rust::Slice<float> points,
+    bool skip_invalid) const {
+  return get_points<4>(undistorted_depth, &color_depth_image, &region, points,
+                       skip_invalid);
 }
+
+template <size_t Stride>
+uint64_t Registration::get_points(const Frame &undistorted_depth,
+                                  const Frame *color_depth_image,
+                                  const Region *region,
+                                  rust::Slice<float> points,
+                                  bool skip_invalid) const {
+  const std::vector<float> &ray_x = tables->ray_x();
+  const std::vector<float> &ray_y = tables->ray_y();
+  const size_t width = ray_x.size();
+  const size_t height = ray_y.size();
+
+  if (undistorted_depth.width() != width ||
+      undistorted_depth.height() != height ||
+      (color_depth_image != nullptr &&
+       (color_depth_image->width() != width ||
+        color_depth_image->height() != height))) {
+    throw std::runtime_error("Invalid frame size for point cloud");
+  }
+
+  // Without a region, all pixels are converted
+  size_t x0 = 0, y0 = 0, region_width = width, region_height = height;
+  if (region != nullptr) {
+    if (region->width == 0 || region->height == 0 ||
+        static_cast<uint64_t>(region->x) + region->width > width ||
+        static_cast<uint64_t>(region->y) + region->height > height) {
+      throw std::runtime_error("The region must be within the depth frame");
+    }
+
+    x0 = region->x;
+    y0 = region->y;
+    region_width = region->width;
+    region_height = region->height;
+  }
+
+  if (points.size() < region_width * region_height * Stride) {
+    throw std::runtime_error("The point buffer is too small");
+  }
+
+  const auto *depth_data =
+      reinterpret_cast<const float *>(undistorted_depth.frame->data);
+  const auto *color_data =
+      color_depth_image != nullptr
+          ? reinterpret_cast<const uint32_t *>(color_depth_image->frame->data)
+          : nullptr;
+  const float bad_point = std::numeric_limits<float>::quiet_NaN();
+  float *out = points.data();
+
+  for (size_t r = y0; r < y0 + region_height; r++) {
+    const float ry = ray_y[r];
+
+    for (size_t c = x0, i = r * width + x0; c < x0 + region_width; c++, i++) {
+      // Scale to meters, the same threshold as Registration::getPointXYZ
+      const float z = depth_data[i] / 1000.0f;
+      const bool valid = !std::isnan(z) && z > 0.001f;
+      if (!valid && skip_invalid) {
+        continue;
+      }
+
+      out[0] = valid ? ray_x[c] * z : bad_point;
+      out[1] = valid ? ry * z : bad_point;
+      out[2] = valid ? z : bad_point;
+      if constexpr (Stride == 4) {
+        const uint32_t rgb = valid ? color_data[i] : 0;
+        std::memcpy(&out[3], &rgb, sizeof(rgb));
+      }
+
+      out += Stride;
+    }
+  }
+
+  return (out - points.data()) / Stride;
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Registration>
+libfreenect2_ffi::create_registration_from_tables(
+    const std::shared_ptr<RegistrationTables> &tables,
+    RegistrationEngine engine, uint64_t threads) {
+  if (!tables) {
+    throw std::runtime_error("The registration tables are not initialized");
+  }
+
+  return std::make_unique<Registration>(tables, engine, threads);
+}
+
+#if !defined(NDEBUG) || defined(LIBFREENECT2_RS_BENCH)
+namespace libfreenect2_ffi {
+  namespace test {
+    LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<Registration>
+    create_registration(RegistrationEngine engine, uint64_t threads) {
+      // Factory calibration of a Kinect v2
+      libfreenect2::Freenect2Device::IrCameraParams depth_p{
+          365.481f, 365.481f, 257.346f, 210.347f, 0.089026f,
+          -0.271706f, 0.0982151f, 0.0f, 0.0f};
+      libfreenect2::Freenect2Device::ColorCameraParams rgb_p{
+          1081.37f,     1081.37f,     959.5f,        539.5f,
+          863.0f,       52.0f,        0.000449294f,  0.000212355f,
+          -7.81315e-05f, 0.000120644f, 0.000629924f,  0.000195935f,
+          -0.000177962f, 0.635754f,    0.00164808f,   0.0860757f,
+          0.00011546f,  0.000337897f, -5.18717e-05f, 0.000178651f,
+          -4.59245e-05f, -0.000617467f, 0.000577111f, 0.00168652f,
+          0.633103f,    0.086348f};
+
+      return std::make_unique<Registration>(depth_p, rgb_p, engine, threads);
+    }
+  }  // namespace test
+}  // namespace libfreenect2_ffi
+#endif
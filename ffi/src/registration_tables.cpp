@@ -0,0 +1,297 @@
+#include "registration_tables.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+using namespace libfreenect2_ffi;
+
+namespace {
+  constexpr int depth_width = 512;
+  constexpr int depth_height = 424;
+  constexpr size_t depth_size = depth_width * depth_height;
+
+  // Constants used by libfreenect2::Registration
+  constexpr float depth_q = 0.01f;
+  constexpr float color_q = 0.002199f;
+
+  constexpr char magic[8] = {'L', 'F', '2', 'R', 'S', 'R', 'E', 'G'};
+  constexpr uint32_t version = 1;
+  // Read back differently on a machine with another byte order
+  constexpr uint32_t byte_order = 0x01020304;
+  constexpr size_t ir_param_count = 9;
+  constexpr size_t color_param_count = 26;
+  constexpr size_t header_size =
+      sizeof(magic) + 4 * sizeof(uint32_t) +
+      (ir_param_count + color_param_count) * sizeof(float);
+
+  static_assert(sizeof(int) == sizeof(uint32_t));
+  static_assert(sizeof(libfreenect2::Freenect2Device::IrCameraParams) ==
+                ir_param_count * sizeof(float));
+  static_assert(sizeof(libfreenect2::Freenect2Device::ColorCameraParams) ==
+                color_param_count * sizeof(float));
+
+  libfreenect2::Freenect2Device::IrCameraParams to_libfreenect2(
+      const IrCameraParams &p) {
+    return {p.fx, p.fy, p.cx, p.cy, p.k1, p.k2, p.k3, p.p1, p.p2};
+  }
+
+  libfreenect2::Freenect2Device::ColorCameraParams to_libfreenect2(
+      const ColorCameraParams &p) {
+    return {p.fx,      p.fy,      p.cx,      p.cy,      p.shift_d,
+            p.shift_m, p.mx_x3y0, p.mx_x0y3, p.mx_x2y1, p.mx_x1y2,
+            p.mx_x2y0, p.mx_x0y2, p.mx_x1y1, p.mx_x1y0, p.mx_x0y1,
+            p.mx_x0y0, p.my_x3y0, p.my_x0y3, p.my_x2y1, p.my_x1y2,
+            p.my_x2y0, p.my_x0y2, p.my_x1y1, p.my_x1y0, p.my_x0y1,
+            p.my_x0y0};
+  }
+
+  void distort_point(
+      const libfreenect2::Freenect2Device::IrCameraParams &depth, int mx,
+      int my, float &x, float &y) {
+    const float dx = (static_cast<float>(mx) - depth.cx) / depth.fx;
+    const float dy = (static_cast<float>(my) - depth.cy) / depth.fy;
+    const float dx2 = dx * dx;
+    const float dy2 = dy * dy;
+    const float r2 = dx2 + dy2;
+    const float dxdy2 = 2 * dx * dy;
+    const float kr = 1 + ((depth.k3 * r2 + depth.k2) * r2 + depth.k1) * r2;
+
+    x = depth.fx * (dx * kr + depth.p2 * (r2 + 2 * dx2) + depth.p1 * dxdy2) +
+        depth.cx;
+    y = depth.fy * (dy * kr + depth.p1 * (r2 + 2 * dy2) + depth.p2 * dxdy2) +
+        depth.cy;
+  }
+
+  void depth_to_color(
+      const libfreenect2::Freenect2Device::IrCameraParams &depth,
+      const libfreenect2::Freenect2Device::ColorCameraParams &color, float mx,
+      float my, float &rx, float &ry) {
+    mx = (mx - depth.cx) * depth_q;
+    my = (my - depth.cy) * depth_q;
+
+    const float wx =
+        (mx * mx * mx * color.mx_x3y0) + (my * my * my * color.mx_x0y3) +
+        (mx * mx * my * color.mx_x2y1) + (my * my * mx * color.mx_x1y2) +
+        (mx * mx * color.mx_x2y0) + (my * my * color.mx_x0y2) +
+        (mx * my * color.mx_x1y1) + (mx * color.mx_x1y0) +
+        (my * color.mx_x0y1) + (color.mx_x0y0);
+
+    const float wy =
+        (mx * mx * mx * color.my_x3y0) + (my * my * my * color.my_x0y3) +
+        (mx * mx * my * color.my_x2y1) + (my * my * mx * color.my_x1y2) +
+        (mx * mx * color.my_x2y0) + (my * my * color.my_x0y2) +
+        (mx * my * color.my_x1y1) + (mx * color.my_x1y0) +
+        (my * color.my_x0y1) + (color.my_x0y0);
+
+    rx = (wx / (color.fx * color_q)) - (color.shift_m / color.shift_d);
+    ry = (wy / color_q) + color.cy;
+  }
+
+  template <class T>
+  uint8_t *write(uint8_t *dst, const T *values, size_t count) {
+    std::memcpy(dst, values, count * sizeof(T));
+    return dst + count * sizeof(T);
+  }
+
+  template <class T>
+  const uint8_t *read(const uint8_t *src, T *values, size_t count) {
+    std::memcpy(values, src, count * sizeof(T));
+    return src + count * sizeof(T);
+  }
+
+  uint32_t read_u32(const uint8_t *&src) {
+    uint32_t value;
+    src = read(src, &value, 1);
+    return value;
+  }
+
+  size_t serialized_size_of(size_t width, size_t height) {
+    return header_size + width * height * 3 * sizeof(uint32_t) +
+           (width + height) * sizeof(float);
+  }
+}  // namespace
+
+CameraParams libfreenect2_ffi::to_camera_params(
+    const libfreenect2::Freenect2Device::IrCameraParams &depth_p,
+    const libfreenect2::Freenect2Device::ColorCameraParams &rgb_p) {
+  const auto &d = depth_p;
+  const auto &c = rgb_p;
+
+  return {
+      {d.fx, d.fy, d.cx, d.cy, d.k1, d.k2, d.k3, d.p1, d.p2},
+      {c.fx,      c.fy,      c.cx,      c.cy,      c.shift_d,
+       c.shift_m, c.mx_x3y0, c.mx_x0y3, c.mx_x2y1, c.mx_x1y2,
+       c.mx_x2y0, c.mx_x0y2, c.mx_x1y1, c.mx_x1y0, c.mx_x0y1,
+       c.mx_x0y0, c.my_x3y0, c.my_x0y3, c.my_x2y1, c.my_x1y2,
+       c.my_x2y0, c.my_x0y2, c.my_x1y1, c.my_x1y0, c.my_x0y1,
+       c.my_x0y0},
+  };
+}
+
+RegistrationTables::RegistrationTables(
+    const libfreenect2::Freenect2Device::IrCameraParams &depth_p,
+    const libfreenect2::Freenect2Device::ColorCameraParams &rgb_p)
+    : depth(depth_p),
+      color(rgb_p),
+      distort(depth_size),
+      color_x(depth_size),
+      color_yi(depth_size),
+      rays_x(depth_width),
+      rays_y(depth_height) {
+  for (int y = 0, i = 0; y < depth_height; y++) {
+    for (int x = 0; x < depth_width; x++, i++) {
+      float mx, my;
+      distort_point(depth, x, y, mx, my);
+
+      const int ix = static_cast<int>(mx + 0.5f);
+      const int iy = static_cast<int>(my + 0.5f);
+      if (ix < 0 || ix >= depth_width || iy < 0 || iy >= depth_height) {
+        distort[i] = -1;
+      } else {
+        distort[i] = iy * depth_width + ix;
+      }
+
+      float rx, ry;
+      depth_to_color(depth, color, static_cast<float>(x),
+                     static_cast<float>(y), rx, ry);
+      color_x[i] = rx;
+      color_yi[i] = static_cast<int>(ry + 0.5f);
+    }
+  }
+
+  // The undistorted depth frame has no distortion left, so the
+  // ray of every pixel is the product of a column and a row term
+  for (size_t c = 0; c < rays_x.size(); c++) {
+    rays_x[c] = static_cast<float>((c + 0.5 - depth.cx) / depth.fx);
+  }
+  for (size_t r = 0; r < rays_y.size(); r++) {
+    rays_y[r] = static_cast<float>((r + 0.5 - depth.cy) / depth.fy);
+  }
+}
+
+std::shared_ptr<RegistrationTables> RegistrationTables::deserialize(
+    rust::Slice<const uint8_t> data) {
+  if (data.size() < header_size ||
+      std::memcmp(data.data(), magic, sizeof(magic)) != 0) {
+    throw std::runtime_error("The data is not a serialized registration");
+  }
+
+  const uint8_t *src = data.data() + sizeof(magic);
+  if (read_u32(src) != version) {
+    throw std::runtime_error("Unsupported serialized registration version");
+  }
+  if (read_u32(src) != byte_order) {
+    throw std::runtime_error(
+        "The registration was serialized with a different byte order");
+  }
+
+  const uint32_t width = read_u32(src);
+  const uint32_t height = read_u32(src);
+  if (width != depth_width || height != depth_height ||
+      data.size() != serialized_size_of(width, height)) {
+    throw std::runtime_error("The serialized registration is corrupted");
+  }
+
+  std::shared_ptr<RegistrationTables> tables(new RegistrationTables());
+  src = read(src, &tables->depth, 1);
+  src = read(src, &tables->color, 1);
+
+  tables->distort.resize(depth_size);
+  tables->color_x.resize(depth_size);
+  tables->color_yi.resize(depth_size);
+  tables->rays_x.resize(depth_width);
+  tables->rays_y.resize(depth_height);
+
+  src = read(src, tables->distort.data(), depth_size);
+  src = read(src, tables->color_x.data(), depth_size);
+  src = read(src, tables->color_yi.data(), depth_size);
+  src = read(src, tables->rays_x.data(), depth_width);
+  read(src, tables->rays_y.data(), depth_height);
+
+  // The distort map is used as an index, every other value is
+  // bounds checked by the registration
+  for (const int index : tables->distort) {
+    if (index < -1 || index >= static_cast<int>(depth_size)) {
+      throw std::runtime_error("The serialized registration is corrupted");
+    }
+  }
+
+  return tables;
+}
+
+LIBFREENECT2_MAYBE_UNUSED CameraParams
+RegistrationTables::camera_params() const noexcept {
+  return to_camera_params(depth, color);
+}
+
+LIBFREENECT2_MAYBE_UNUSED uint64_t
+RegistrationTables::serialized_size() const noexcept {
+  return serialized_size_of(rays_x.size(), rays_y.size());
+}
+
+LIBFREENECT2_MAYBE_UNUSED void RegistrationTables::serialize(
+    rust::Slice<uint8_t> dst) const {
+  if (dst.size() != serialized_size()) {
+    throw std::runtime_error("Invalid buffer size for the registration");
+  }
+
+  const uint32_t fields[] = {version, byte_order,
+                             static_cast<uint32_t>(rays_x.size()),
+                             static_cast<uint32_t>(rays_y.size())};
+
+  uint8_t *out = write(dst.data(), magic, sizeof(magic));
+  out = write(out, fields, 4);
+  out = write(out, &depth, 1);
+  out = write(out, &color, 1);
+  out = write(out, distort.data(), distort.size());
+  out = write(out, color_x.data(), color_x.size());
+  out = write(out, color_yi.data(), color_yi.size());
+  out = write(out, rays_x.data(), rays_x.size());
+  write(out, rays_y.data(), rays_y.size());
+}
+
+const libfreenect2::Freenect2Device::IrCameraParams &
+RegistrationTables::depth_params() const noexcept {
+  return depth;
+}
+
+const libfreenect2::Freenect2Device::ColorCameraParams &
+RegistrationTables::color_params() const noexcept {
+  return color;
+}
+
+const std::vector<int> &RegistrationTables::distort_map() const noexcept {
+  return distort;
+}
+
+const std::vector<float> &RegistrationTables::depth_to_color_map_x()
+    const noexcept {
+  return color_x;
+}
+
+const std::vector<int> &RegistrationTables::depth_to_color_map_yi()
+    const noexcept {
+  return color_yi;
+}
+
+const std::vector<float> &RegistrationTables::ray_x() const noexcept {
+  return rays_x;
+}
+
+const std::vector<float> &RegistrationTables::ray_y() const noexcept {
+  return rays_y;
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::shared_ptr<RegistrationTables>
+libfreenect2_ffi::create_registration_tables(const CameraParams &params) {
+  return std::make_shared<RegistrationTables>(to_libfreenect2(params.ir),
+                                              to_libfreenect2(params.color));
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::shared_ptr<RegistrationTables>
+libfreenect2_ffi::deserialize_registration_tables(
+    rust::Slice<const uint8_t> data) {
+  return RegistrationTables::deserialize(data);
+}
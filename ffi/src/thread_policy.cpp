@@ -0,0 +1,307 @@
+#include "thread_policy.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+using namespace libfreenect2_ffi;
+
+namespace {
+  [[maybe_unused]] bool is_default(const ThreadPolicy &policy) {
+    return policy.cpus.empty() &&
+           policy.scheduling == SchedulingPolicy::Inherit &&
+           policy.numa_node < 0;
+  }
+
+  /**
+   * Parse a list of CPUs as used by sysfs, like "0-3,8,10-11".
+   */
+  [[maybe_unused]] std::vector<uint32_t> parse_cpu_list(
+      const std::string &list) {
+    std::vector<uint32_t> cpus;
+    size_t pos = 0;
+
+    while (pos < list.size() && list[pos] != '\n') {
+      size_t end;
+      const unsigned long first = std::stoul(list.substr(pos), &end);
+      unsigned long last = first;
+      pos += end;
+
+      if (pos < list.size() && list[pos] == '-') {
+        last = std::stoul(list.substr(++pos), &end);
+        pos += end;
+      }
+      if (pos < list.size() && list[pos] == ',') {
+        pos++;
+      }
+
+      for (unsigned long cpu = first; cpu <= last; cpu++) {
+        cpus.push_back(static_cast<uint32_t>(cpu));
+      }
+    }
+
+    return cpus;
+  }
+
+#ifdef __linux__
+  // Modes of set_mempolicy, see <linux/mempolicy.h>
+  constexpr int mpol_default = 0;
+  constexpr int mpol_preferred = 1;
+  constexpr size_t max_nodes = 1024;
+  constexpr size_t bits_per_word = 8 * sizeof(unsigned long);
+
+  [[noreturn]] void throw_error(const std::string &what, int error) {
+    throw std::runtime_error(what + ": " + std::strerror(error));
+  }
+
+  std::vector<uint32_t> get_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+      throw_error("Failed to get the CPU affinity of the thread", errno);
+    }
+
+    std::vector<uint32_t> cpus;
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+
+    return cpus;
+  }
+
+  void set_cpus(const std::vector<uint32_t> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const uint32_t cpu : cpus) {
+      if (cpu >= CPU_SETSIZE) {
+        throw std::runtime_error("Invalid CPU index " + std::to_string(cpu));
+      }
+
+      CPU_SET(cpu, &set);
+    }
+
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      throw_error("Failed to set the CPU affinity of the thread", errno);
+    }
+  }
+
+  int to_native(SchedulingPolicy scheduling) {
+    switch (scheduling) {
+      case SchedulingPolicy::Fifo:
+        return SCHED_FIFO;
+      case SchedulingPolicy::RoundRobin:
+        return SCHED_RR;
+      default:
+        return SCHED_OTHER;
+    }
+  }
+
+  id_t thread_id() {
+    return static_cast<id_t>(syscall(SYS_gettid));
+  }
+#endif  // __linux__
+}  // namespace
+
+ThreadPolicyScope::ThreadPolicyScope(const ThreadPolicy &policy)
+    : restore_cpus(false),
+      restore_scheduler(false),
+      restore_nice(false),
+      restore_memory(false),
+      previous_cpus(),
+      previous_scheduler(0),
+      previous_priority(0),
+      previous_nice(0),
+      previous_memory_mode(0),
+      previous_nodes() {
+#ifdef __linux__
+  try {
+    std::vector<uint32_t> cpus(policy.cpus.begin(), policy.cpus.end());
+    if (policy.numa_node >= 0) {
+      const rust::Vec<uint32_t> node_cpus =
+          numa_node_cpus(static_cast<uint32_t>(policy.numa_node));
+      if (cpus.empty()) {
+        cpus.assign(node_cpus.begin(), node_cpus.end());
+      }
+    }
+
+    if (!cpus.empty()) {
+      previous_cpus = get_cpus();
+      set_cpus(cpus);
+      restore_cpus = true;
+    }
+
+    if (policy.numa_node >= 0) {
+      const auto node = static_cast<size_t>(policy.numa_node);
+      if (node >= max_nodes) {
+        throw std::runtime_error("Invalid NUMA node " + std::to_string(node));
+      }
+
+      previous_nodes.assign(max_nodes / bits_per_word, 0);
+      if (syscall(SYS_get_mempolicy, &previous_memory_mode,
+                  previous_nodes.data(), max_nodes, nullptr, 0) != 0) {
+        throw_error("Failed to get the memory policy of the thread", errno);
+      }
+
+      // Preferred instead of bound, so allocations still succeed
+      // if the node runs out of memory
+      std::vector<unsigned long> nodes(previous_nodes.size(), 0);
+      nodes[node / bits_per_word] = 1ul << (node % bits_per_word);
+      if (syscall(SYS_set_mempolicy, mpol_preferred, nodes.data(),
+                  max_nodes + 1) != 0) {
+        throw_error("Failed to set the memory policy of the thread", errno);
+      }
+      restore_memory = true;
+    }
+
+    if (policy.scheduling != SchedulingPolicy::Inherit) {
+      sched_param param{};
+      int error = pthread_getschedparam(pthread_self(), &previous_scheduler,
+                                        &param);
+      if (error != 0) {
+        throw_error("Failed to get the scheduling policy of the thread",
+                    error);
+      }
+      previous_priority = param.sched_priority;
+
+      const int scheduler = to_native(policy.scheduling);
+      const bool realtime = scheduler != SCHED_OTHER;
+      const int min = realtime ? sched_get_priority_min(scheduler) : -20;
+      const int max = realtime ? sched_get_priority_max(scheduler) : 19;
+      if (policy.priority < min || policy.priority > max) {
+        throw std::runtime_error(
+            "The thread priority must be between " + std::to_string(min) +
+            " and " + std::to_string(max));
+      }
+
+      param.sched_priority = realtime ? policy.priority : 0;
+      error = pthread_setschedparam(pthread_self(), scheduler, &param);
+      if (error != 0) {
+        throw_error("Failed to set the scheduling policy of the thread",
+                    error);
+      }
+      restore_scheduler = true;
+
+      // The priority of normal threads is their nice value,
+      // which Linux applies per thread
+      if (!realtime) {
+        errno = 0;
+        previous_nice = getpriority(PRIO_PROCESS, thread_id());
+        if (errno != 0) {
+          throw_error("Failed to get the nice value of the thread", errno);
+        }
+        if (setpriority(PRIO_PROCESS, thread_id(), policy.priority) != 0) {
+          throw_error("Failed to set the nice value of the thread", errno);
+        }
+        restore_nice = true;
+      }
+    }
+  } catch (...) {
+    restore();
+    throw;
+  }
+#else
+  if (!is_default(policy)) {
+    throw std::runtime_error("Thread policies are only supported on Linux");
+  }
+#endif  // __linux__
+}
+
+ThreadPolicyScope::~ThreadPolicyScope() {
+  restore();
+}
+
+LIBFREENECT2_MAYBE_UNUSED void ThreadPolicyScope::keep() noexcept {
+  restore_cpus = false;
+  restore_scheduler = false;
+  restore_nice = false;
+  restore_memory = false;
+}
+
+void ThreadPolicyScope::restore() noexcept {
+#ifdef __linux__
+  // Restoring may fail if lowering the priority was not
+  // permitted, which leaves the thread with the policy
+  if (restore_nice) {
+    setpriority(PRIO_PROCESS, thread_id(), previous_nice);
+  }
+  if (restore_scheduler) {
+    sched_param param{};
+    param.sched_priority = previous_priority;
+    pthread_setschedparam(pthread_self(), previous_scheduler, &param);
+  }
+  if (restore_memory) {
+    syscall(SYS_set_mempolicy, previous_memory_mode,
+            previous_memory_mode == mpol_default ? nullptr
+                                                 : previous_nodes.data(),
+            max_nodes + 1);
+  }
+  if (restore_cpus) {
+    try {
+      set_cpus(previous_cpus);
+    } catch (...) {
+    }
+  }
+#endif  // __linux__
+
+  keep();
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<ThreadPolicyScope>
+libfreenect2_ffi::enter_thread_policy(const ThreadPolicy &policy) {
+  return std::make_unique<ThreadPolicyScope>(policy);
+}
+
+LIBFREENECT2_MAYBE_UNUSED rust::Vec<uint32_t>
+libfreenect2_ffi::current_thread_cpus() {
+  rust::Vec<uint32_t> res;
+#ifdef __linux__
+  for (const uint32_t cpu : get_cpus()) {
+    res.push_back(cpu);
+  }
+#else
+  for (uint32_t cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+    res.push_back(cpu);
+  }
+#endif  // __linux__
+
+  return res;
+}
+
+LIBFREENECT2_MAYBE_UNUSED rust::Vec<uint32_t> libfreenect2_ffi::numa_node_cpus(
+    uint32_t node) {
+  const std::string path =
+      "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+  std::ifstream file(path);
+  std::string list;
+  if (!file || !std::getline(file, list)) {
+    throw std::runtime_error("NUMA node " + std::to_string(node) +
+                             " does not exist");
+  }
+
+  rust::Vec<uint32_t> res;
+  try {
+    for (const uint32_t cpu : parse_cpu_list(list)) {
+      res.push_back(cpu);
+    }
+  } catch (const std::logic_error &) {
+    throw std::runtime_error("Invalid CPU list of NUMA node " +
+                             std::to_string(node));
+  }
+
+  return res;
+}
@@ -0,0 +1,64 @@
+#include "usb_transfers.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#include "libfreenect2-rs/src/ffi.rs.h"
+
+using namespace libfreenect2_ffi;
+
+namespace {
+  std::recursive_mutex env_mutex;
+
+  void set_env(const char* name, const std::optional<std::string>& value) {
+#ifdef _WIN32
+    // libfreenect2 reads the C runtime environment using getenv
+    _putenv_s(name, value ? value->c_str() : "");
+#else
+    if (value) {
+      setenv(name, value->c_str(), 1);
+    } else {
+      unsetenv(name);
+    }
+#endif  // _WIN32
+  }
+}  // namespace
+
+UsbTransferScope::UsbTransferScope(const UsbTransferConfig& config)
+    : lock(env_mutex), previous() {
+  // Read by Freenect2DeviceImpl::open, parsed using atoi
+  const std::pair<const char*, uint32_t> settings[] = {
+      {"LIBFREENECT2_RGB_TRANSFER_SIZE", config.rgb_transfer_size},
+      {"LIBFREENECT2_RGB_TRANSFERS", config.rgb_transfers},
+      {"LIBFREENECT2_IR_PACKETS", config.ir_packets_per_transfer},
+      {"LIBFREENECT2_IR_TRANSFERS", config.ir_transfers},
+  };
+
+  for (const auto& [name, value] : settings) {
+    if (value > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+      throw std::runtime_error(std::string("Invalid value for ") + name);
+    }
+  }
+
+  for (const auto& [name, value] : settings) {
+    if (value == 0) continue;
+
+    const char* current = std::getenv(name);
+    previous.emplace_back(name, current ? std::optional<std::string>(current)
+                                        : std::nullopt);
+    set_env(name, std::to_string(value));
+  }
+}
+
+UsbTransferScope::~UsbTransferScope() {
+  for (const auto& [name, value] : previous) {
+    set_env(name, value);
+  }
+}
+
+LIBFREENECT2_MAYBE_UNUSED std::unique_ptr<UsbTransferScope>
+libfreenect2_ffi::enter_usb_transfer_config(const UsbTransferConfig& config) {
+  return std::make_unique<UsbTransferScope>(config);
+}
@@ -0,0 +1,105 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+using namespace libfreenect2_ffi;
+
+WorkerPool::WorkerPool(size_t threads)
+    : workers(),
+      run_mutex(),
+      mutex(),
+      start_cv(),
+      done_cv(),
+      job(nullptr),
+      job_tasks(0),
+      next(0),
+      active(0),
+      generation(0),
+      stopping(false) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  workers.reserve(threads - 1);
+  for (size_t i = 1; i < threads; i++) {
+    workers.emplace_back(&WorkerPool::work, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+
+  start_cv.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+size_t WorkerPool::size() const noexcept { return workers.size() + 1; }
+
+void WorkerPool::run(size_t tasks, const std::function<void(size_t)>& task) {
+  std::lock_guard run_lock(run_mutex);
+  if (workers.empty() || tasks <= 1) {
+    for (size_t i = 0; i < tasks; i++) {
+      task(i);
+    }
+
+    return;
+  }
+
+  {
+    std::lock_guard lock(mutex);
+    job = &task;
+    job_tasks = tasks;
+    next.store(0, std::memory_order_relaxed);
+    active = workers.size();
+    generation++;
+  }
+
+  start_cv.notify_all();
+  execute(task, tasks);
+
+  std::unique_lock lock(mutex);
+  done_cv.wait(lock, [this] { return active == 0; });
+  job = nullptr;
+}
+
+void WorkerPool::work() {
+  uint64_t seen = 0;
+
+  while (true) {
+    const std::function<void(size_t)>* task;
+    size_t tasks;
+
+    {
+      std::unique_lock lock(mutex);
+      start_cv.wait(lock,
+                    [this, seen] { return stopping || generation != seen; });
+      if (stopping) {
+        return;
+      }
+
+      seen = generation;
+      task = job;
+      tasks = job_tasks;
+    }
+
+    execute(*task, tasks);
+
+    std::lock_guard lock(mutex);
+    if (--active == 0) {
+      done_cv.notify_one();
+    }
+  }
+}
+
+void WorkerPool::execute(const std::function<void(size_t)>& task,
+                         size_t tasks) {
+  size_t i;
+  while ((i = next.fetch_add(1, std::memory_order_relaxed)) < tasks) {
+    task(i);
+  }
+}
@@ -0,0 +1,122 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use libfreenect2_rs::bench::{call_frame_listener, create_frame};
+use libfreenect2_rs::frame::{FrameFormat, Freenect2Frame};
+use libfreenect2_rs::frame_listener::{
+  FrameListener, MultiFrameListenerOptions, NativeFramesMultiFrameListener,
+  OwnedFramesMultiFrameListener, SharedFramesMultiFrameListener,
+};
+use libfreenect2_rs::frame_pool::FramePool;
+use libfreenect2_rs::frame_type::FrameType;
+
+/// The frame types and resolutions sent by a Kinect v2.
+const FRAMES: [(&str, FrameType, usize, usize); 2] = [
+  ("depth_512x424", FrameType::Depth, 512, 424),
+  ("color_1920x1080", FrameType::Color, 1920, 1080),
+];
+
+fn frame_data(width: usize, height: usize) -> Vec<u8> {
+  (0..width * height * 4).map(|i| i as u8).collect()
+}
+
+fn bench_on_new_frame(c: &mut Criterion) {
+  let mut group = c.benchmark_group("on_new_frame");
+  let pool = FramePool::new(4).unwrap();
+
+  for (name, ty, width, height) in FRAMES {
+    let mut data = frame_data(width, height);
+    group.throughput(Throughput::Bytes(data.len() as u64));
+
+    let listener = FrameListener::new(|_, _| Ok(())).unwrap();
+    group.bench_function(BenchmarkId::new("native", name), |b| {
+      b.iter(|| call_frame_listener(&listener, ty, width, height, 4, &mut data).unwrap())
+    });
+
+    let listener = FrameListener::new(|_, frame| {
+      std::hint::black_box(frame.to_owned());
+      Ok(())
+    })
+    .unwrap();
+    group.bench_function(BenchmarkId::new("owned", name), |b| {
+      b.iter(|| call_frame_listener(&listener, ty, width, height, 4, &mut data).unwrap())
+    });
+
+    let listener = FrameListener::new_pooled(&pool, |_, _| Ok(())).unwrap();
+    group.bench_function(BenchmarkId::new("pooled", name), |b| {
+      b.iter(|| call_frame_listener(&listener, ty, width, height, 4, &mut data).unwrap())
+    });
+  }
+
+  group.finish();
+}
+
+fn bench_to_owned(c: &mut Criterion) {
+  let mut group = c.benchmark_group("frame_to_owned");
+
+  for (name, _, width, height) in FRAMES {
+    let frame = create_frame(width, height, 4, FrameFormat::Float, |i| i as u8);
+    group.throughput(Throughput::Bytes(frame.raw_data().len() as u64));
+    group.bench_function(name, |b| b.iter(|| frame.to_owned()));
+  }
+
+  group.finish();
+}
+
+fn bench_multi_frame_listener(c: &mut Criterion) {
+  let mut group = c.benchmark_group("multi_frame_listener");
+  group.throughput(Throughput::Elements(1));
+
+  let mut color = frame_data(1920, 1080);
+  let mut depth = frame_data(512, 424);
+  let frame_types = [FrameType::Color, FrameType::Depth];
+
+  macro_rules! bench_listener {
+    ($name: expr, $listener: expr) => {
+      let listener = $listener;
+      group.bench_function($name, |b| {
+        b.iter(|| {
+          call_frame_listener(&listener, FrameType::Color, 1920, 1080, 4, &mut color).unwrap();
+          call_frame_listener(&listener, FrameType::Depth, 512, 424, 4, &mut depth).unwrap();
+          listener.get_frames().unwrap()
+        })
+      });
+    };
+  }
+
+  bench_listener!(
+    "owned",
+    OwnedFramesMultiFrameListener::new(&frame_types).unwrap()
+  );
+  bench_listener!(
+    "owned_bounded",
+    OwnedFramesMultiFrameListener::with_options(
+      &frame_types,
+      MultiFrameListenerOptions {
+        queue_capacity: Some(2),
+        ..Default::default()
+      },
+    )
+    .unwrap()
+  );
+
+  // Native and shared frames reference the pipeline's buffer, which is only
+  // valid during the call, so they are benchmarked using a frame pool.
+  let pool = FramePool::new(4).unwrap();
+  bench_listener!(
+    "native_pooled",
+    NativeFramesMultiFrameListener::new_pooled(&frame_types, &pool).unwrap()
+  );
+  bench_listener!(
+    "shared_pooled",
+    SharedFramesMultiFrameListener::new_pooled(&frame_types, &pool).unwrap()
+  );
+
+  group.finish();
+}
+
+criterion_group!(
+  benches,
+  bench_on_new_frame,
+  bench_to_owned,
+  bench_multi_frame_listener
+);
+criterion_main!(benches);
@@ -0,0 +1,48 @@
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use libfreenect2_rs::bench::create_frame;
+use libfreenect2_rs::frame::{FrameFormat, Freenect2Frame};
+use libfreenect2_rs::frame_convert::{
+  convert_color, depth_to_colormap, depth_to_millimeters, Colormap, PixelLayout,
+};
+
+fn bench_as_image(c: &mut Criterion) {
+  let mut group = c.benchmark_group("as_image");
+
+  for (name, width, height, bytes_per_pixel, format) in [
+    ("depth_512x424", 512, 424, 4, FrameFormat::Float),
+    ("color_1920x1080", 1920, 1080, 4, FrameFormat::BGRX),
+    ("gray_1920x1080", 1920, 1080, 1, FrameFormat::Gray),
+  ] {
+    let frame = create_frame(width, height, bytes_per_pixel, format, |i| i as u8);
+    group.throughput(Throughput::Elements((width * height) as u64));
+    group.bench_function(name, |b| b.iter(|| frame.as_image()));
+  }
+
+  group.finish();
+}
+
+fn bench_convert(c: &mut Criterion) {
+  let mut group = c.benchmark_group("convert");
+
+  let color = create_frame(1920, 1080, 4, FrameFormat::BGRX, |i| i as u8);
+  let mut rgb = vec![0; 1920 * 1080 * 3];
+  group.throughput(Throughput::Elements(1920 * 1080));
+  group.bench_function("bgrx_to_rgb_1920x1080", |b| {
+    b.iter(|| convert_color(&color, PixelLayout::RGB, &mut rgb).unwrap())
+  });
+
+  let depth = create_frame(512, 424, 4, FrameFormat::Float, |i| (i % 7) as u8 + 0x40);
+  let mut millimeters = vec![0; 512 * 424];
+  group.throughput(Throughput::Elements(512 * 424));
+  group.bench_function("depth_to_millimeters_512x424", |b| {
+    b.iter(|| depth_to_millimeters(&depth, &mut millimeters).unwrap())
+  });
+  group.bench_function("depth_to_colormap_512x424", |b| {
+    b.iter(|| depth_to_colormap(&depth, 500.0, 4500.0, Colormap::Jet, &mut rgb).unwrap())
+  });
+
+  group.finish();
+}
+
+criterion_group!(benches, bench_as_image, bench_convert);
+criterion_main!(benches);
@@ -0,0 +1,120 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+use libfreenect2_rs::bench::{create_frame, create_registration};
+use libfreenect2_rs::frame::{Frame, FrameFormat};
+use libfreenect2_rs::registration::{RegistrationEngine, MAX_POINTS};
+
+const ENGINES: [(&str, RegistrationEngine); 2] = [
+  ("libfreenect2", RegistrationEngine::Libfreenect2),
+  ("parallel", RegistrationEngine::Parallel),
+];
+
+/// A plane 2m away with a closer box in front of it and a few invalid pixels.
+fn depth_frame() -> Frame<'static> {
+  let depth = (0..512u32 * 424)
+    .flat_map(|i| {
+      let (x, y) = (i % 512, i / 512);
+      let z: f32 = if i % 13 == 0 {
+        0.0
+      } else if (200..300).contains(&x) && (150..250).contains(&y) {
+        900.0
+      } else {
+        2000.0
+      };
+
+      z.to_ne_bytes()
+    })
+    .collect::<Vec<_>>();
+
+  create_frame(512, 424, 4, FrameFormat::Float, |i| depth[i])
+}
+
+fn color_frame() -> Frame<'static> {
+  create_frame(1920, 1080, 4, FrameFormat::BGRX, |i| {
+    (i as u32).wrapping_mul(2654435761) as u8
+  })
+}
+
+fn bench_map_depth_to_color(c: &mut Criterion) {
+  let mut group = c.benchmark_group("map_depth_to_color");
+  let depth = depth_frame();
+  let color = color_frame();
+
+  for (name, engine) in ENGINES {
+    let registration = create_registration(engine, 0).unwrap();
+    let mut undistorted = Frame::depth();
+    let mut registered = Frame::color_for_depth();
+
+    group.bench_function(BenchmarkId::new(name, "filtered"), |b| {
+      b.iter(|| {
+        registration
+          .map_depth_to_color(&depth, &color, &mut undistorted, &mut registered, true)
+          .unwrap()
+      })
+    });
+    group.bench_function(BenchmarkId::new(name, "unfiltered"), |b| {
+      b.iter(|| {
+        registration
+          .map_depth_to_color(&depth, &color, &mut undistorted, &mut registered, false)
+          .unwrap()
+      })
+    });
+  }
+
+  group.finish();
+}
+
+fn bench_map_depth_to_full_color(c: &mut Criterion) {
+  let mut group = c.benchmark_group("map_depth_to_full_color");
+  let depth = depth_frame();
+  let color = color_frame();
+
+  for (name, engine) in ENGINES {
+    let registration = create_registration(engine, 0).unwrap();
+    let mut undistorted = Frame::depth();
+    let mut registered = Frame::color_for_depth();
+    let mut big_depth = Frame::depth_full_color();
+
+    group.bench_function(name, |b| {
+      b.iter(|| {
+        registration
+          .map_depth_to_full_color(
+            &depth,
+            &color,
+            &mut undistorted,
+            &mut registered,
+            true,
+            &mut big_depth,
+          )
+          .unwrap()
+      })
+    });
+  }
+
+  group.finish();
+}
+
+fn bench_point_cloud(c: &mut Criterion) {
+  let mut group = c.benchmark_group("point_cloud");
+  let registration = create_registration(RegistrationEngine::Libfreenect2, 1).unwrap();
+
+  let mut context = registration.create_context(false, true);
+  context.process(&depth_frame(), &color_frame()).unwrap();
+
+  let mut points = vec![0.0; 4 * MAX_POINTS];
+  group.bench_function("xyz", |b| {
+    b.iter(|| context.get_points_xyz(&mut points, true).unwrap())
+  });
+  group.bench_function("xyzrgb", |b| {
+    b.iter(|| context.get_points_xyzrgb(&mut points, true).unwrap())
+  });
+
+  group.finish();
+}
+
+criterion_group!(
+  benches,
+  bench_map_depth_to_color,
+  bench_map_depth_to_full_color,
+  bench_point_cloud
+);
+criterion_main!(benches);
@@ -2,7 +2,7 @@ mod build_util;
 
 use crate::build_util::libs::link_os_libs;
 use crate::build_util::target_dir::TargetDir;
-use crate::build_util::zipped_library::ZippedLibrary;
+use crate::build_util::zipped_library::{TargetOS, ZippedLibrary};
 use std::path::Path;
 use std::{env, io};
 
@@ -21,14 +21,27 @@ fn main() -> anyhow::Result<()> {
   }
 
   println!("cargo:rerun-if-changed=src/ffi.rs");
+  println!("cargo:rerun-if-env-changed=CUDA_PATH");
   build(
     &[
       "libfreenect2",
       "frame",
+      "frame_pool",
       "freenect2_device",
       "config",
       "registration",
+      "registration_tables",
+      "parallel_registration",
+      "worker_pool",
+      "gpu_devices",
       "logger",
+      "jpeg_decoder",
+      "frame_convert",
+      "depth_post_processor",
+      "depth_codec",
+      "thread_policy",
+      "usb_transfers",
+      "packet_stats",
     ],
     &downloaded_file.include_path,
   );
@@ -72,6 +85,19 @@ fn build<P: AsRef<Path>>(files: &[&str], include_path: P) {
   if cfg!(feature = "opengl") {
     build.define("LIBFREENECT2_RS_WITH_OPENGL", None);
   }
+  if cfg!(feature = "bench") {
+    build.define("LIBFREENECT2_RS_BENCH", None);
+  }
+  // Only Linux links turbojpeg and has its headers installed
+  if TargetOS::new().is_ok_and(|os| os == TargetOS::Linux) {
+    build.define("LIBFREENECT2_RS_WITH_TURBOJPEG", None);
+  }
+  if cfg!(feature = "cuda") {
+    build.define("LIBFREENECT2_RS_WITH_CUDA", None);
+    if let Some(cuda_path) = env::var_os("CUDA_PATH") {
+      build.include(Path::new(&cuda_path).join("include"));
+    }
+  }
 
   build.compile("libfreenect2_ffi");
 }
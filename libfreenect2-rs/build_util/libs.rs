@@ -1,10 +1,23 @@
 use crate::build_util::zipped_library::TargetOS;
+use std::env;
+use std::path::Path;
 
 pub fn link_os_libs() -> anyhow::Result<()> {
   for lib in get_os_libs()? {
     println!("cargo:rustc-link-lib={}", lib);
   }
 
+  if cfg!(feature = "cuda") {
+    if let Some(cuda_path) = env::var_os("CUDA_PATH") {
+      let lib_dir = match TargetOS::new()? {
+        TargetOS::Windows => Path::new(&cuda_path).join("lib").join("x64"),
+        _ => Path::new(&cuda_path).join("lib64"),
+      };
+
+      println!("cargo:rustc-link-search=native={}", lib_dir.display());
+    }
+  }
+
   Ok(())
 }
 
@@ -40,6 +53,9 @@ fn get_os_libs() -> anyhow::Result<Vec<&'static str>> {
       if cfg!(feature = "opencl") {
         libs.push("OpenCL");
       }
+      if cfg!(feature = "cuda") {
+        libs.push("cudart");
+      }
 
       libs
     }
@@ -48,6 +64,9 @@ fn get_os_libs() -> anyhow::Result<Vec<&'static str>> {
       if cfg!(feature = "opengl") {
         libs.push("opengl32");
       }
+      if cfg!(feature = "cuda") {
+        libs.push("cudart");
+      }
 
       libs
     }
@@ -238,6 +238,13 @@ impl ZippedLibrary {
       println!("cargo:rerun-if-changed={}", path_from_env);
       PathBuf::from(path_from_env)
     } else {
+      if cfg!(feature = "cuda") {
+        panic!(
+          "The 'cuda' feature requires {} to point to a libfreenect2 build with CUDA support",
+          self.local_path
+        );
+      }
+
       let features = if cfg!(feature = "opencl") && cfg!(feature = "opengl") {
         "all"
       } else if cfg!(feature = "opencl") {
@@ -0,0 +1,103 @@
+//! Hooks used by the benchmarks in `benches/` to drive frame listeners
+//! and registrations without a device. Only available with the `bench` feature,
+//! this module is not part of the public API.
+
+use crate::ffi;
+use crate::frame::{Frame, FrameFormat};
+use crate::frame_listener::AsFrameListener;
+use crate::frame_type::FrameType;
+use crate::registration::{Registration, RegistrationEngine};
+
+/// Create a frame owning its data, filled with `fill(i)` for every byte `i`.
+pub fn create_frame(
+  width: usize,
+  height: usize,
+  bytes_per_pixel: usize,
+  format: FrameFormat,
+  fill: impl Fn(usize) -> u8,
+) -> Frame<'static> {
+  let frame = Frame::new(unsafe {
+    ffi::libfreenect2::create_frame(
+      width as _,
+      height as _,
+      bytes_per_pixel as _,
+      std::ptr::null_mut(),
+      0,
+      0,
+      0.0,
+      0.0,
+      0.0,
+      0,
+      format.into(),
+    )
+  });
+
+  let data =
+    unsafe { std::slice::from_raw_parts_mut(frame.inner.data(), width * height * bytes_per_pixel) };
+  for (i, value) in data.iter_mut().enumerate() {
+    *value = fill(i);
+  }
+
+  frame
+}
+
+/// Pass `data` to the native frame listener as if it was received from a device.
+/// The listener may not keep the frame after returning, frames referencing
+/// `data` are only valid during the call.
+///
+/// # Errors
+/// Returns an error if `data` is too small or the listener returned an error.
+pub fn call_frame_listener<'a, L: AsFrameListener<'a>>(
+  listener: &L,
+  ty: FrameType,
+  width: usize,
+  height: usize,
+  bytes_per_pixel: usize,
+  data: &mut [u8],
+) -> anyhow::Result<()> {
+  anyhow::ensure!(
+    data.len() >= width * height * bytes_per_pixel,
+    "The frame data must hold at least {} bytes, got {}",
+    width * height * bytes_per_pixel,
+    data.len()
+  );
+
+  let listener = listener.as_frame_listener();
+  let errors = listener.error_count();
+  unsafe {
+    ffi::libfreenect2::call_frame_listener(
+      &listener.0,
+      ty.into(),
+      width as _,
+      height as _,
+      bytes_per_pixel as _,
+      data.as_mut_ptr(),
+    )?;
+  }
+
+  // Listener errors are recorded instead of being passed
+  // through the native listener
+  if listener.error_count() != errors {
+    return Err(
+      listener
+        .take_last_error()
+        .unwrap_or_else(|| anyhow::anyhow!("The frame listener returned an error")),
+    );
+  }
+
+  Ok(())
+}
+
+/// Create a registration using the factory calibration of a Kinect v2.
+///
+/// # Errors
+/// Returns an error if the registration could not be created.
+pub fn create_registration(
+  engine: RegistrationEngine,
+  threads: usize,
+) -> anyhow::Result<Registration> {
+  Ok(Registration::new(ffi::libfreenect2::create_registration(
+    engine,
+    threads as u64,
+  )?))
+}
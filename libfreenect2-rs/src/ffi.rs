@@ -11,6 +11,8 @@ pub(crate) struct CallContext<'a> {
       ) -> anyhow::Result<()>
       + 'a,
   >,
+  pub(crate) errors: std::sync::Arc<crate::types::frame_listener::ListenerErrors>,
+  pub(crate) catch_unwind: bool,
 }
 
 #[cxx::bridge]
@@ -96,6 +98,333 @@ pub(crate) mod libfreenect2 {
     /// http://www.cvl.isy.liu.se/research/datasets/kinect2-dataset/.
     /// Requires the `opencl` feature.
     OpenCLKDE = 3,
+    #[cfg(feature = "cuda")]
+    /// CUDA packet pipeline.
+    /// Requires the `cuda` feature.
+    CUDA = 4,
+    #[cfg(feature = "cuda")]
+    /// CUDA packet pipeline with the phase
+    /// unwrapping algorithm described in
+    /// http://www.cvl.isy.liu.se/research/datasets/kinect2-dataset/.
+    /// Requires the `cuda` feature.
+    CUDAKDE = 5,
+  }
+
+  /// The streams delivered as undecoded packets instead of decoded frames.
+  /// Packets are passed to the frame listeners as [`FrameFormat::Raw`] frames
+  /// holding the packet payload, see [`crate::raw_packet`].
+  #[derive(Debug)]
+  pub enum RawPackets {
+    /// Decode all streams using the packet pipeline.
+    None = 0,
+    /// Deliver the JPEG payload of color packets without decoding it.
+    /// Depth is still decoded using the packet pipeline.
+    Color = 1,
+    /// Deliver raw depth packets without decoding them.
+    /// No IR or depth frames are produced, color is still decoded.
+    Depth = 2,
+    /// Deliver both color and depth as undecoded packets.
+    /// The packet pipeline is not used at all.
+    All = 3,
+  }
+
+  /// The frames of the depth stream passed to the IR and depth frame listener.
+  /// Frames which are not selected are handed back to the depth packet
+  /// processor, so the listener isn't called and the frames aren't
+  /// copied or reallocated.
+  /// Raw depth packets are always passed to the listener.
+  #[derive(Debug)]
+  pub enum DepthStreams {
+    /// Deliver IR frames only.
+    Ir = 2,
+    /// Deliver depth frames only.
+    Depth = 4,
+    /// Deliver both IR and depth frames.
+    IrAndDepth = 6,
+  }
+
+  /// The API a GPU device is accessed with.
+  #[derive(Debug)]
+  pub enum GpuApi {
+    /// An OpenCL device.
+    /// Used by the OpenCL packet pipelines.
+    OpenCL = 0,
+    /// A CUDA device.
+    /// Used by the CUDA packet pipelines.
+    CUDA = 1,
+  }
+
+  /// A device a packet pipeline can run on.
+  #[derive(Debug, Clone)]
+  pub struct GpuDevice {
+    /// The API the device is accessed with.
+    api: GpuApi,
+    /// The device id to pass to packet pipelines using `api`.
+    index: i32,
+    /// The name of the device.
+    name: String,
+    /// The name of the platform the device belongs to.
+    platform: String,
+    /// Whether this is a GPU. OpenCL may also list CPUs and accelerators.
+    is_gpu: bool,
+  }
+
+  /// Registration engine.
+  ///
+  /// All engines run on the host. The OpenCL and OpenGL packet pipelines
+  /// decode depth on the GPU, but libfreenect2 delivers the decoded frames
+  /// in host memory and does not expose the device context of the pipeline,
+  /// so there is no device-side depth buffer registration could run on.
+  /// Use `Parallel` to reduce the registration latency instead. It still
+  /// blocks the calling thread, but splits every frame across worker threads.
+  pub enum RegistrationEngine {
+    /// The implementation provided by libfreenect2.
+    /// Runs single-threaded on the calling thread.
+    /// This is the default engine.
+    Libfreenect2 = 0,
+    /// A multi-threaded implementation which splits
+    /// every frame across a pool of worker threads.
+    /// Produces the same output as `Libfreenect2`.
+    Parallel = 1,
+  }
+
+  /// The scale color frames are decoded at.
+  /// Scaling is done while decoding, by skipping DCT coefficients,
+  /// so smaller scales decode faster.
+  #[derive(Debug)]
+  pub enum DecodeScale {
+    /// Decode at full resolution, 1920x1080.
+    Full = 1,
+    /// Decode at half resolution, 960x540.
+    Half = 2,
+    /// Decode at a quarter of the resolution, 480x270.
+    Quarter = 4,
+    /// Decode at an eighth of the resolution, 240x135.
+    Eighth = 8,
+  }
+
+  /// The pixel format color frames are decoded to.
+  #[derive(Debug)]
+  pub enum DecodeFormat {
+    /// 3 bytes per pixel, red, green and blue.
+    /// Frames have no format for 3 byte pixels, so this is only
+    /// supported by `ColorDecoder::decode_rgb_image`.
+    RGB = 0,
+    /// 4 bytes per pixel, blue, green, red and an unused byte.
+    /// This is the format the packet pipelines decode to.
+    BGRX = 1,
+    /// 4 bytes per pixel, red, green, blue and an unused byte.
+    RGBX = 2,
+    /// 1 byte per pixel, the luminance.
+    Gray = 3,
+  }
+
+  /// A rectangle in pixels of a frame.
+  #[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+  pub struct Region {
+    /// The column of the top left corner.
+    x: u32,
+    /// The row of the top left corner.
+    y: u32,
+    /// The width of the region.
+    width: u32,
+    /// The height of the region.
+    height: u32,
+  }
+
+  /// The order of the channels of packed 8 bit color pixels.
+  #[derive(Debug)]
+  pub enum PixelLayout {
+    /// 3 bytes per pixel, red, green and blue.
+    RGB = 0,
+    /// 3 bytes per pixel, blue, green and red.
+    BGR = 1,
+    /// 4 bytes per pixel, red, green, blue and alpha.
+    /// Also the layout of [`FrameFormat::RGBX`] frames.
+    RGBA = 2,
+    /// 4 bytes per pixel, blue, green, red and alpha.
+    /// Also the layout of [`FrameFormat::BGRX`] frames.
+    BGRA = 3,
+  }
+
+  /// A colormap depth values are mapped to colors with.
+  #[derive(Debug)]
+  pub enum Colormap {
+    /// From black at the minimum depth to white at the maximum depth.
+    Gray = 0,
+    /// From blue at the minimum depth over cyan,
+    /// yellow to red at the maximum depth.
+    Jet = 1,
+  }
+
+  pub struct ColorDecodeParams {
+    scale: DecodeScale,
+    format: DecodeFormat,
+    crop: bool,
+    region: Region,
+  }
+
+  /// The factor depth frames are downscaled by in both dimensions.
+  /// Decimated frames are 256x212 or 128x106 pixels instead of 512x424,
+  /// so they can no longer be passed to a registration.
+  #[derive(Debug)]
+  pub enum DepthDecimation {
+    /// Keep the full resolution.
+    Full = 1,
+    /// Average 2x2 blocks into one pixel.
+    Half = 2,
+    /// Average 4x4 blocks into one pixel.
+    Quarter = 4,
+  }
+
+  pub struct DepthPostProcessingParams {
+    clip_range: bool,
+    min_depth: f32,
+    max_depth: f32,
+    decimation: DepthDecimation,
+    hole_fill_radius: u32,
+    temporal: bool,
+    temporal_alpha: f32,
+    temporal_threshold: f32,
+  }
+
+  /// The intrinsic parameters of the IR camera,
+  /// see `libfreenect2::Freenect2Device::IrCameraParams`.
+  #[derive(Debug, Copy, Clone, PartialEq)]
+  pub struct IrCameraParams {
+    /// The focal length in x direction in pixels.
+    fx: f32,
+    /// The focal length in y direction in pixels.
+    fy: f32,
+    /// The principal point in x direction in pixels.
+    cx: f32,
+    /// The principal point in y direction in pixels.
+    cy: f32,
+    /// The radial distortion coefficients.
+    k1: f32,
+    k2: f32,
+    k3: f32,
+    /// The tangential distortion coefficients.
+    p1: f32,
+    p2: f32,
+  }
+
+  /// The intrinsic parameters of the color camera and the coefficients
+  /// mapping depth pixels to color pixels,
+  /// see `libfreenect2::Freenect2Device::ColorCameraParams`.
+  #[derive(Debug, Copy, Clone, PartialEq)]
+  pub struct ColorCameraParams {
+    /// The focal length in x direction in pixels.
+    fx: f32,
+    /// The focal length in y direction in pixels.
+    fy: f32,
+    /// The principal point in x direction in pixels.
+    cx: f32,
+    /// The principal point in y direction in pixels.
+    cy: f32,
+    shift_d: f32,
+    shift_m: f32,
+
+    mx_x3y0: f32,
+    mx_x0y3: f32,
+    mx_x2y1: f32,
+    mx_x1y2: f32,
+    mx_x2y0: f32,
+    mx_x0y2: f32,
+    mx_x1y1: f32,
+    mx_x1y0: f32,
+    mx_x0y1: f32,
+    mx_x0y0: f32,
+
+    my_x3y0: f32,
+    my_x0y3: f32,
+    my_x2y1: f32,
+    my_x1y2: f32,
+    my_x2y0: f32,
+    my_x0y2: f32,
+    my_x1y1: f32,
+    my_x1y0: f32,
+    my_x0y1: f32,
+    my_x0y0: f32,
+  }
+
+  /// The factory calibration of a device, which the registration is computed from.
+  #[derive(Debug, Copy, Clone, PartialEq)]
+  pub struct CameraParams {
+    /// The parameters of the IR and depth camera.
+    ir: IrCameraParams,
+    /// The parameters of the color camera.
+    color: ColorCameraParams,
+  }
+
+  /// The scheduling policy of a thread, see `sched(7)`.
+  #[derive(Debug)]
+  pub enum SchedulingPolicy {
+    /// Keep the scheduling policy and priority of the thread.
+    Inherit = 0,
+    /// The default time-sharing policy.
+    /// The priority is the nice value of the thread, from -20 to 19.
+    Other = 1,
+    /// A first in, first out real-time policy.
+    /// The priority is from 1 to 99.
+    Fifo = 2,
+    /// A round-robin real-time policy.
+    /// The priority is from 1 to 99.
+    RoundRobin = 3,
+  }
+
+  /// The CPU affinity, scheduling and NUMA memory policy of threads.
+  #[derive(Debug, Clone, PartialEq)]
+  pub struct ThreadPolicy {
+    /// The CPUs the threads may run on.
+    /// If empty, the CPUs of `numa_node`, or all CPUs if no node is set.
+    cpus: Vec<u32>,
+    /// The scheduling policy of the threads.
+    scheduling: SchedulingPolicy,
+    /// The priority of the threads, see [`SchedulingPolicy`].
+    priority: i32,
+    /// The NUMA node memory is preferably allocated on, or -1 for none.
+    numa_node: i32,
+  }
+
+  /// The USB transfers a device is opened with.
+  /// Zero values keep the defaults of libfreenect2, which depend on the platform.
+  #[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+  pub struct UsbTransferConfig {
+    /// The size of a color transfer in bytes.
+    /// `LIBFREENECT2_RGB_TRANSFER_SIZE`.
+    rgb_transfer_size: u32,
+    /// The number of color transfers in flight.
+    /// `LIBFREENECT2_RGB_TRANSFERS`.
+    rgb_transfers: u32,
+    /// The number of isochronous packets per IR and depth transfer.
+    /// `LIBFREENECT2_IR_PACKETS`.
+    ir_packets_per_transfer: u32,
+    /// The number of IR and depth transfers in flight.
+    /// `LIBFREENECT2_IR_TRANSFERS`.
+    ir_transfers: u32,
+  }
+
+  /// The number of frames received and packets lost of a stream.
+  #[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+  pub struct StreamStats {
+    /// The number of frames delivered by libfreenect2.
+    frames: u64,
+    /// The number of packets which did not result in a frame.
+    lost: u64,
+    /// The number of times one or more consecutive packets were lost.
+    gaps: u64,
+  }
+
+  /// The number of frames received and packets lost per stream of a device.
+  #[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+  pub struct PacketStats {
+    /// The color stream.
+    color: StreamStats,
+    /// The IR stream.
+    ir: StreamStats,
+    /// The depth stream.
+    depth: StreamStats,
   }
 
   extern "Rust" {
@@ -113,16 +442,44 @@ pub(crate) mod libfreenect2 {
   #[namespace = "libfreenect2_ffi"]
   unsafe extern "C++" {
     include!("frame.hpp");
+    include!("frame_pool.hpp");
     include!("libfreenect2.hpp");
     include!("registration.hpp");
+    include!("registration_tables.hpp");
     include!("freenect2_device.hpp");
     include!("config.hpp");
     include!("logger.hpp");
+    include!("gpu_devices.hpp");
+    include!("jpeg_decoder.hpp");
+    include!("frame_convert.hpp");
+    include!("depth_post_processor.hpp");
+    include!("depth_codec.hpp");
+    include!("thread_policy.hpp");
+    include!("usb_transfers.hpp");
+    include!("packet_stats.hpp");
 
     fn create_frame_listener<'a>(
       ctx: Box<CallContext<'a>>,
-      on_new_frame: fn(FrameType, UniquePtr<Frame<'static>>, &Box<CallContext<'a>>) -> String,
+      on_new_frame: fn(FrameType, UniquePtr<Frame<'static>>, &Box<CallContext<'a>>),
+    ) -> Result<UniquePtr<FrameListener<'a>>>;
+    fn create_pooled_frame_listener<'a>(
+      ctx: Box<CallContext<'a>>,
+      on_new_frame: fn(FrameType, UniquePtr<Frame<'static>>, &Box<CallContext<'a>>),
+      pool: &SharedPtr<FramePool>,
     ) -> Result<UniquePtr<FrameListener<'a>>>;
+    unsafe fn replay_frame(
+      listener: &UniquePtr<FrameListener>,
+      frame_type: FrameType,
+      frame: &Frame,
+    ) -> Result<()>;
+
+    pub type FramePool;
+
+    fn capacity(self: &FramePool) -> u64;
+    fn exhausted_count(self: &FramePool) -> u64;
+    fn available(self: &FramePool, frame_type: FrameType) -> Result<u64>;
+
+    fn create_frame_pool(capacity: u64) -> Result<SharedPtr<FramePool>>;
 
     pub type Freenect2;
 
@@ -138,6 +495,8 @@ pub(crate) mod libfreenect2 {
       self: Pin<&mut Freenect2>,
       idx: i32,
       pipeline: PacketPipeline,
+      device_id: i32,
+      raw: RawPackets,
     ) -> Result<UniquePtr<Freenect2Device<'a>>>;
 
     unsafe fn open_device_by_serial<'a>(
@@ -148,6 +507,8 @@ pub(crate) mod libfreenect2 {
       self: Pin<&mut Freenect2>,
       serial: &str,
       pipeline: PacketPipeline,
+      device_id: i32,
+      raw: RawPackets,
     ) -> Result<UniquePtr<Freenect2Device<'a>>>;
 
     unsafe fn open_default_device<'a>(
@@ -156,6 +517,8 @@ pub(crate) mod libfreenect2 {
     unsafe fn open_default_device_with_packet_pipeline<'a>(
       self: Pin<&mut Freenect2>,
       pipeline: PacketPipeline,
+      device_id: i32,
+      raw: RawPackets,
     ) -> Result<UniquePtr<Freenect2Device<'a>>>;
 
     /// Create a new Freenect2 instance.
@@ -170,6 +533,12 @@ pub(crate) mod libfreenect2 {
     unsafe fn get_serial_number(self: Pin<&mut Freenect2Device>) -> Result<String>;
     unsafe fn get_firmware_version(self: Pin<&mut Freenect2Device>) -> Result<String>;
     unsafe fn get_registration(self: Pin<&mut Freenect2Device>) -> Result<UniquePtr<Registration>>;
+    unsafe fn get_registration_with_engine(
+      self: Pin<&mut Freenect2Device>,
+      engine: RegistrationEngine,
+      threads: u64,
+    ) -> Result<UniquePtr<Registration>>;
+    unsafe fn get_camera_params(self: Pin<&mut Freenect2Device>) -> Result<CameraParams>;
 
     unsafe fn start(self: Pin<&mut Freenect2Device>) -> Result<bool>;
     unsafe fn start_streams(
@@ -194,10 +563,18 @@ pub(crate) mod libfreenect2 {
       config: &'a UniquePtr<Config>,
     ) -> Result<()>;
 
+    unsafe fn set_depth_post_processing(
+      self: Pin<&mut Freenect2Device>,
+      params: &DepthPostProcessingParams,
+    ) -> Result<()>;
+    unsafe fn clear_depth_post_processing(self: Pin<&mut Freenect2Device>);
+
     unsafe fn set_led_settings(
       self: Pin<&mut Freenect2Device>,
       settings: &LedSettings,
     ) -> Result<()>;
+    fn get_packet_stats(self: &Freenect2Device) -> PacketStats;
+    fn reset_packet_stats(self: Pin<&mut Freenect2Device>);
 
     pub type Frame<'a>;
 
@@ -212,6 +589,9 @@ pub(crate) mod libfreenect2 {
     unsafe fn gamma(self: &Frame) -> f32;
     unsafe fn status(self: &Frame) -> u32;
     unsafe fn format(self: &Frame) -> FrameFormat;
+    unsafe fn received_ns(self: &Frame) -> u64;
+
+    fn steady_clock_ns() -> u64;
 
     #[allow(clippy::too_many_arguments)]
     unsafe fn create_frame(
@@ -234,10 +614,12 @@ pub(crate) mod libfreenect2 {
     fn get_max_depth(self: &Config) -> f32;
     fn get_enable_bilateral_filter(self: &Config) -> bool;
     fn get_enable_edge_aware_filter(self: &Config) -> bool;
+    fn get_depth_streams(self: &Config) -> DepthStreams;
     fn set_min_depth(self: Pin<&mut Config>, min_depth: f32);
     fn set_max_depth(self: Pin<&mut Config>, max_depth: f32);
     fn set_enable_bilateral_filter(self: Pin<&mut Config>, enable: bool);
     fn set_enable_edge_aware_filter(self: Pin<&mut Config>, enable: bool);
+    fn set_depth_streams(self: Pin<&mut Config>, streams: DepthStreams);
 
     fn create_config() -> Result<UniquePtr<Config>>;
 
@@ -250,6 +632,15 @@ pub(crate) mod libfreenect2 {
       color_depth_image: Pin<&mut Frame>,
       enable_filter: bool,
     ) -> Result<()>;
+    unsafe fn map_depth_to_color_region(
+      self: &Registration,
+      depth: &Frame,
+      color: &Frame,
+      undistorted_depth: Pin<&mut Frame>,
+      color_depth_image: Pin<&mut Frame>,
+      enable_filter: bool,
+      region: &Region,
+    ) -> Result<()>;
     unsafe fn map_depth_to_full_color(
       self: &Registration,
       depth: &Frame,
@@ -264,20 +655,162 @@ pub(crate) mod libfreenect2 {
       depth: &Frame,
       undistorted_depth: Pin<&mut Frame>,
     ) -> Result<()>;
+    unsafe fn get_points_xyz(
+      self: &Registration,
+      undistorted_depth: &Frame,
+      points: &mut [f32],
+      skip_invalid: bool,
+    ) -> Result<u64>;
+    unsafe fn get_points_xyzrgb(
+      self: &Registration,
+      undistorted_depth: &Frame,
+      color_depth_image: &Frame,
+      points: &mut [f32],
+      skip_invalid: bool,
+    ) -> Result<u64>;
+
+    unsafe fn get_points_xyz_region(
+      self: &Registration,
+      undistorted_depth: &Frame,
+      region: &Region,
+      points: &mut [f32],
+      skip_invalid: bool,
+    ) -> Result<u64>;
+    unsafe fn get_points_xyzrgb_region(
+      self: &Registration,
+      undistorted_depth: &Frame,
+      color_depth_image: &Frame,
+      region: &Region,
+      points: &mut [f32],
+      skip_invalid: bool,
+    ) -> Result<u64>;
+
+    fn create_registration_from_tables(
+      tables: &SharedPtr<RegistrationTables>,
+      engine: RegistrationEngine,
+      threads: u64,
+    ) -> Result<UniquePtr<Registration>>;
+
+    pub type RegistrationTables;
+
+    fn camera_params(self: &RegistrationTables) -> CameraParams;
+    fn serialized_size(self: &RegistrationTables) -> u64;
+    fn serialize(self: &RegistrationTables, dst: &mut [u8]) -> Result<()>;
+
+    fn create_registration_tables(params: &CameraParams) -> Result<SharedPtr<RegistrationTables>>;
+    fn deserialize_registration_tables(data: &[u8]) -> Result<SharedPtr<RegistrationTables>>;
+
+    fn create_logger(log_fn: fn(LogLevel, &str), level_fn: fn() -> LogLevel) -> Result<()>;
+
+    fn list_gpu_devices() -> Result<Vec<GpuDevice>>;
+
+    pub type JpegDecoder;
+
+    #[allow(clippy::too_many_arguments)]
+    fn decode(
+      self: Pin<&mut JpegDecoder>,
+      jpeg: &[u8],
+      params: &ColorDecodeParams,
+      timestamp: u32,
+      sequence: u32,
+      exposure: f32,
+      gain: f32,
+      gamma: f32,
+      status: u32,
+    ) -> Result<UniquePtr<Frame<'static>>>;
+
+    fn jpeg_decoder_available() -> bool;
+    fn create_jpeg_decoder() -> Result<UniquePtr<JpegDecoder>>;
+
+    fn convert_pixels(
+      src: &[u8],
+      src_layout: PixelLayout,
+      dst: &mut [u8],
+      dst_layout: PixelLayout,
+    ) -> Result<()>;
+    fn depth_to_millimeters(depth: &[u8], dst: &mut [u16]) -> Result<()>;
+    fn depth_to_colormap(
+      depth: &[u8],
+      min_depth: f32,
+      max_depth: f32,
+      colormap: Colormap,
+      dst: &mut [u8],
+    ) -> Result<()>;
+    fn normalize_ir(ir: &[u8], max_value: f32, dst: &mut [u8]) -> Result<()>;
+
+    pub type DepthPostProcessor;
+
+    fn process(
+      self: Pin<&mut DepthPostProcessor>,
+      depth: &[u8],
+      width: u64,
+      height: u64,
+      timestamp: u32,
+      sequence: u32,
+      status: u32,
+    ) -> Result<UniquePtr<Frame<'static>>>;
+    fn reset(self: Pin<&mut DepthPostProcessor>);
+
+    fn create_depth_post_processor(
+      params: &DepthPostProcessingParams,
+    ) -> Result<UniquePtr<DepthPostProcessor>>;
 
-    fn create_logger(log_fn: fn(LogLevel, &String)) -> Result<()>;
+    pub type DepthEncoder;
+
+    #[allow(clippy::too_many_arguments)]
+    fn encode(
+      self: Pin<&mut DepthEncoder>,
+      depth: &[u8],
+      width: u64,
+      height: u64,
+      timestamp: u32,
+      sequence: u32,
+      status: u32,
+      dst: &mut [u8],
+    ) -> Result<u64>;
+    fn force_keyframe(self: Pin<&mut DepthEncoder>);
+
+    pub type DepthDecoder;
+
+    fn decode(self: Pin<&mut DepthDecoder>, data: &[u8]) -> Result<UniquePtr<Frame<'static>>>;
+    fn reset(self: Pin<&mut DepthDecoder>);
+
+    fn max_encoded_depth_size(width: u64, height: u64) -> u64;
+    fn is_depth_keyframe(data: &[u8]) -> Result<bool>;
+    fn create_depth_encoder(keyframe_interval: u32) -> Result<UniquePtr<DepthEncoder>>;
+    fn create_depth_decoder() -> Result<UniquePtr<DepthDecoder>>;
+
+    pub type ThreadPolicyScope;
+
+    fn keep(self: Pin<&mut ThreadPolicyScope>);
+
+    fn enter_thread_policy(policy: &ThreadPolicy) -> Result<UniquePtr<ThreadPolicyScope>>;
+    fn current_thread_cpus() -> Result<Vec<u32>>;
+    fn numa_node_cpus(node: u32) -> Result<Vec<u32>>;
+
+    pub type UsbTransferScope;
+
+    fn enter_usb_transfer_config(config: &UsbTransferConfig)
+      -> Result<UniquePtr<UsbTransferScope>>;
   }
 
-  #[cfg(debug_assertions)]
+  #[cfg(any(debug_assertions, feature = "bench"))]
   #[namespace = "libfreenect2_ffi::test"]
   unsafe extern "C++" {
     unsafe fn call_frame_listener<'a>(
-      listener: &mut UniquePtr<FrameListener<'a>>,
+      listener: &UniquePtr<FrameListener<'a>>,
       frame_type: FrameType,
       width: u64,
       height: u64,
       bytes_per_pixel: u64,
       data: *mut u8,
     ) -> Result<()>;
+
+    fn create_registration(
+      engine: RegistrationEngine,
+      threads: u64,
+    ) -> Result<UniquePtr<Registration>>;
+
+    fn count_packets(sequences: &[u32]) -> StreamStats;
   }
 }
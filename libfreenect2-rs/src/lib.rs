@@ -1,3 +1,6 @@
+#[cfg(feature = "bench")]
+#[doc(hidden)]
+pub mod bench;
 pub mod ffi;
 #[cfg(test)]
 mod test;
@@ -0,0 +1,129 @@
+use crate::async_frame_listener::{AsyncFrameListener, DispatchOptions};
+#[cfg(debug_assertions)]
+use crate::ffi::libfreenect2::call_frame_listener;
+#[cfg(debug_assertions)]
+use crate::frame::Freenect2Frame;
+use crate::frame_type::FrameType;
+#[cfg(debug_assertions)]
+use std::sync::{Arc, Mutex};
+
+#[test]
+fn test_create_async_frame_listener() {
+  AsyncFrameListener::new(DispatchOptions::default(), |_, _| Ok(())).unwrap();
+}
+
+#[test]
+fn test_invalid_dispatch_options() {
+  let options = DispatchOptions {
+    workers: 0,
+    ..Default::default()
+  };
+  assert!(AsyncFrameListener::new(options, |_, _| Ok(())).is_err());
+
+  let options = DispatchOptions::default().with_affinity(FrameType::Ir, 3);
+  assert!(AsyncFrameListener::new(options, |_, _| Ok(())).is_err());
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_dispatch_in_order() {
+  let frames = Arc::new(Mutex::new(Vec::new()));
+  let frames_clone = frames.clone();
+  let options = DispatchOptions {
+    workers: 2,
+    queue_capacity: 64,
+    ..Default::default()
+  }
+  .with_affinity(FrameType::Depth, 1)
+  .with_affinity(FrameType::Ir, 1);
+
+  let mut listener = AsyncFrameListener::new(options, move |ty, frame| {
+    std::thread::sleep(std::time::Duration::from_millis(1));
+    frames_clone.lock().unwrap().push((
+      ty,
+      frame.raw_data()[0],
+      std::thread::current().name().map(ToString::to_string),
+    ));
+
+    Ok(())
+  })
+  .unwrap();
+
+  let statistics = listener.statistics();
+  assert_eq!(statistics.len(), 2);
+  assert_eq!(statistics[0].frame_types, [FrameType::Color]);
+  assert_eq!(statistics[1].frame_types, [FrameType::Depth, FrameType::Ir]);
+
+  for i in 0..16u8 {
+    for ty in [FrameType::Color, FrameType::Ir] {
+      let mut data = vec![i, 0, 0, 0];
+      unsafe {
+        call_frame_listener(
+          &mut listener.listener.as_mut().unwrap().0,
+          ty.into(),
+          1,
+          2,
+          2,
+          data.as_mut_ptr(),
+        )
+        .unwrap();
+      }
+    }
+  }
+
+  // Dropping the listener processes all frames still waiting
+  drop(listener);
+  let frames = frames.lock().unwrap();
+  assert_eq!(frames.len(), 32);
+
+  for ty in [FrameType::Color, FrameType::Ir] {
+    let received = frames
+      .iter()
+      .filter(|(t, _, _)| *t == ty)
+      .collect::<Vec<_>>();
+    assert!(received.iter().map(|(_, i, _)| *i).eq(0..16));
+    assert!(received.iter().all(|(_, _, name)| *name == received[0].2));
+  }
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_dispatch_drops_when_full() {
+  let blocker = Arc::new(Mutex::new(()));
+  let lock = blocker.lock().unwrap();
+  let blocker_clone = blocker.clone();
+  let options = DispatchOptions {
+    workers: 1,
+    queue_capacity: 2,
+    ..Default::default()
+  };
+
+  let mut listener = AsyncFrameListener::new(options, move |_, _| {
+    drop(blocker_clone.lock().unwrap());
+    Ok(())
+  })
+  .unwrap();
+
+  let mut data = vec![1, 2, 3, 4];
+  for _ in 0..8 {
+    unsafe {
+      call_frame_listener(
+        &mut listener.listener.as_mut().unwrap().0,
+        FrameType::Color.into(),
+        1,
+        2,
+        2,
+        data.as_mut_ptr(),
+      )
+      .unwrap();
+    }
+  }
+
+  // The first frame may already be held by the worker
+  assert!(listener.dropped_count() >= 5);
+  assert!(listener.queue_len() <= 2);
+  assert_eq!(listener.statistics()[0].max_queue_len, 2);
+
+  drop(lock);
+  drop(listener);
+}
@@ -0,0 +1,101 @@
+use crate::util::bounded_queue::{BoundedQueue, DropPolicy};
+use std::sync::Arc;
+use std::time::Duration;
+
+#[test]
+fn test_drop_oldest() {
+  let queue = BoundedQueue::new(2, DropPolicy::DropOldest).unwrap();
+  assert!(queue.push(1));
+  assert!(queue.push(2));
+  assert!(!queue.push(3));
+
+  assert_eq!(queue.dropped_count(), 1);
+  assert_eq!(queue.try_pop(), Some(2));
+  assert_eq!(queue.try_pop(), Some(3));
+  assert_eq!(queue.try_pop(), None);
+}
+
+#[test]
+fn test_drop_newest() {
+  let queue = BoundedQueue::new(2, DropPolicy::DropNewest).unwrap();
+  assert!(queue.push(1));
+  assert!(queue.push(2));
+  assert!(!queue.push(3));
+
+  assert_eq!(queue.dropped_count(), 1);
+  assert_eq!(queue.len(), 2);
+  assert_eq!(queue.pop(Some(Duration::from_millis(10))), Some(1));
+  assert_eq!(queue.pop(Some(Duration::from_millis(10))), Some(2));
+  assert_eq!(queue.pop(Some(Duration::from_millis(10))), None);
+}
+
+#[test]
+fn test_block() {
+  let queue = Arc::new(BoundedQueue::new(3, DropPolicy::Block).unwrap());
+  let producer_queue = queue.clone();
+  let producer = std::thread::spawn(move || {
+    for i in 0..10_000u64 {
+      producer_queue.push(i);
+    }
+  });
+
+  let mut sum = 0;
+  for _ in 0..10_000 {
+    sum += queue.pop(None).unwrap();
+  }
+
+  producer.join().unwrap();
+  assert_eq!(sum, 9_999 * 10_000 / 2);
+  assert_eq!(queue.dropped_count(), 0);
+}
+
+#[test]
+fn test_zero_capacity() {
+  assert!(BoundedQueue::<u8>::new(0, DropPolicy::Block).is_err());
+}
+
+#[test]
+fn test_capacity_one() {
+  let queue = BoundedQueue::new(1, DropPolicy::DropNewest).unwrap();
+  assert!(queue.push(1));
+  assert!(!queue.push(2));
+
+  assert_eq!(queue.len(), 1);
+  assert_eq!(queue.try_pop(), Some(1));
+  assert_eq!(queue.try_pop(), None);
+}
+
+#[test]
+fn test_close() {
+  let queue = Arc::new(BoundedQueue::new(1, DropPolicy::Block).unwrap());
+  assert!(queue.push(1));
+
+  let producer_queue = queue.clone();
+  let producer = std::thread::spawn(move || producer_queue.push(2));
+  std::thread::sleep(Duration::from_millis(20));
+  queue.close();
+
+  assert!(!producer.join().unwrap());
+  assert_eq!(queue.pop(None), Some(1));
+  assert_eq!(queue.pop(None), None);
+  assert_eq!(queue.dropped_count(), 1);
+}
+
+#[test]
+fn test_capacity_one_block_stress() {
+  // A lost wakeup would hang the producer or the consumer
+  let queue = Arc::new(BoundedQueue::new(1, DropPolicy::Block).unwrap());
+  let producer_queue = queue.clone();
+  let producer = std::thread::spawn(move || {
+    for i in 0..200_000u64 {
+      assert!(producer_queue.push(i));
+    }
+  });
+
+  for i in 0..200_000u64 {
+    assert_eq!(queue.pop(None), Some(i));
+  }
+
+  producer.join().unwrap();
+  assert_eq!(queue.dropped_count(), 0);
+}
@@ -0,0 +1,269 @@
+use crate::capture::{CaptureOptions, CaptureReader, CaptureRecorder};
+#[cfg(debug_assertions)]
+use crate::ffi::libfreenect2::call_frame_listener;
+use crate::frame::{FrameFormat, Freenect2Frame, OwnedFrame};
+#[cfg(debug_assertions)]
+use crate::frame_listener::AsFrameListener;
+use crate::frame_listener::FrameListener;
+use crate::frame_type::FrameType;
+use crate::replay_device::{ReplayDevice, ReplayOptions, ReplayRate, ReplaySource};
+use crate::test::FrameBuilder;
+use std::path::PathBuf;
+use std::sync::{Arc, Mutex};
+
+struct TempFile(PathBuf);
+
+impl TempFile {
+  fn new(name: &str) -> Self {
+    Self(std::env::temp_dir().join(format!(
+      "libfreenect2-rs-{}-{}.lf2cap",
+      std::process::id(),
+      name
+    )))
+  }
+}
+
+impl Drop for TempFile {
+  fn drop(&mut self) {
+    let _ = std::fs::remove_file(&self.0);
+  }
+}
+
+fn create_frame(width: u64, timestamp: u32, sequence: u32, format: FrameFormat) -> OwnedFrame {
+  FrameBuilder::new(width, format)
+    .timestamp(timestamp)
+    .sequence(sequence)
+    .camera(1.5, 2.0, 2.5)
+    .status(3)
+    .build((0..width * 8).map(|i| i as u8).collect())
+}
+
+fn record(file: &TempFile) -> Vec<(FrameType, OwnedFrame)> {
+  let frames = vec![
+    (FrameType::Color, create_frame(3, 100, 1, FrameFormat::BGRX)),
+    (
+      FrameType::Depth,
+      create_frame(5, 110, 7, FrameFormat::Float),
+    ),
+    (FrameType::Ir, create_frame(5, 110, 7, FrameFormat::Float)),
+    (FrameType::Color, create_frame(3, 366, 2, FrameFormat::BGRX)),
+  ];
+
+  let recorder = CaptureRecorder::create(
+    &file.0,
+    CaptureOptions {
+      extent_size: 4096,
+      ..Default::default()
+    },
+  )
+  .unwrap();
+  for (ty, frame) in &frames {
+    assert!(recorder.record(*ty, frame.clone()).unwrap());
+  }
+
+  let summary = recorder.finish().unwrap();
+  assert_eq!(summary.frames, 4);
+  assert_eq!(summary.dropped, 0);
+  assert_eq!(summary.bytes, std::fs::metadata(&file.0).unwrap().len());
+
+  frames
+}
+
+#[test]
+fn test_capture_round_trip() {
+  let file = TempFile::new("round-trip");
+  let frames = record(&file);
+
+  let reader = CaptureReader::open(&file.0).unwrap();
+  assert!(reader.is_finished());
+  assert_eq!(reader.len(), frames.len());
+
+  for (i, (ty, frame)) in frames.iter().enumerate() {
+    let (read_ty, read) = reader.frame(i).unwrap();
+    assert_eq!(read_ty, *ty);
+    assert_eq!(read.width(), frame.width());
+    assert_eq!(read.height(), frame.height());
+    assert_eq!(read.bytes_per_pixel(), frame.bytes_per_pixel());
+    assert_eq!(read.timestamp(), frame.timestamp());
+    assert_eq!(read.sequence(), frame.sequence());
+    assert_eq!(read.exposure(), frame.exposure());
+    assert_eq!(read.gain(), frame.gain());
+    assert_eq!(read.gamma(), frame.gamma());
+    assert_eq!(read.status(), frame.status());
+    assert_eq!(read.format(), frame.format());
+    assert_eq!(read.raw_data(), frame.raw_data());
+    assert_eq!(read.raw_data().as_ptr() as usize % 64, 0);
+  }
+
+  assert!(reader.frame(frames.len()).is_err());
+  assert_eq!(reader.iter().count(), frames.len());
+}
+
+#[test]
+fn test_capture_find_timestamp() {
+  let file = TempFile::new("find-timestamp");
+  record(&file);
+
+  let reader = CaptureReader::open(&file.0).unwrap();
+  assert_eq!(reader.find_timestamp(0), 0);
+  assert_eq!(reader.find_timestamp(101), 1);
+  assert_eq!(reader.find_timestamp(110), 1);
+  assert_eq!(reader.find_timestamp(366), 3);
+  assert_eq!(reader.find_timestamp(367), 4);
+}
+
+#[test]
+fn test_capture_frames_outlive_reader() {
+  let file = TempFile::new("outlive-reader");
+  let frames = record(&file);
+
+  let reader = CaptureReader::open(&file.0).unwrap();
+  let (_, frame) = reader.frame(3).unwrap();
+  drop(reader);
+
+  assert_eq!(frame.raw_data(), frames[3].1.raw_data());
+}
+
+#[test]
+fn test_capture_unfinished() {
+  let file = TempFile::new("unfinished");
+  let frames = record(&file);
+
+  // Remove the footer and pad the file like an unused extent
+  let len = std::fs::metadata(&file.0).unwrap().len();
+  let handle = std::fs::OpenOptions::new()
+    .write(true)
+    .open(&file.0)
+    .unwrap();
+  handle.set_len(len - 32).unwrap();
+  handle.set_len(len + 4096).unwrap();
+  drop(handle);
+
+  let reader = CaptureReader::open(&file.0).unwrap();
+  assert!(!reader.is_finished());
+  assert_eq!(reader.len(), frames.len());
+  assert_eq!(
+    reader.frame(2).unwrap().1.raw_data(),
+    frames[2].1.raw_data()
+  );
+}
+
+#[test]
+fn test_capture_corrupted_dimensions() {
+  let file = TempFile::new("corrupted-dimensions");
+  record(&file);
+
+  // The width, height and bytes per pixel of the first record,
+  // which follows the 64 byte file header
+  let mut data = std::fs::read(&file.0).unwrap();
+  data[64 + 8..64 + 20].fill(0xFF);
+  std::fs::write(&file.0, data).unwrap();
+
+  let reader = CaptureReader::open(&file.0).unwrap();
+  assert!(reader.frame(0).is_err());
+  assert!(reader.frame(1).is_ok());
+}
+
+#[test]
+fn test_capture_replay() {
+  let file = TempFile::new("replay");
+  let frames = record(&file);
+
+  let received = Arc::new(Mutex::new(Vec::new()));
+  let listener = FrameListener::new({
+    let received = received.clone();
+    move |ty, frame| {
+      received.lock().unwrap().push((ty, frame.to_owned()));
+      Ok(())
+    }
+  })
+  .unwrap();
+
+  let mut reader = CaptureReader::open(&file.0).unwrap();
+  reader.seek(1).unwrap();
+  assert!(reader.seek(5).is_err());
+
+  let mut device = ReplayDevice::new(
+    reader,
+    ReplayOptions {
+      rate: ReplayRate::Unthrottled,
+      looped: false,
+    },
+  );
+  device.set_color_frame_listener(&listener).unwrap();
+  device.set_ir_and_depth_frame_listener(&listener).unwrap();
+  device.start().unwrap();
+  device.wait().unwrap();
+  assert_eq!(device.frames_replayed(), 3);
+  drop(device);
+
+  let received = received.lock().unwrap();
+  assert_eq!(received.len(), 3);
+  for ((ty, frame), (expected_ty, expected)) in received.iter().zip(&frames[1..]) {
+    assert_eq!(ty, expected_ty);
+    assert_eq!(frame.sequence(), expected.sequence());
+    assert_eq!(frame.raw_data(), expected.raw_data());
+  }
+}
+
+#[test]
+fn test_capture_rewind() {
+  let file = TempFile::new("rewind");
+  record(&file);
+
+  let mut reader = CaptureReader::open(&file.0).unwrap();
+  reader.seek(3).unwrap();
+  assert_eq!(reader.next_frame().unwrap().unwrap().1.sequence(), 2);
+  assert!(reader.next_frame().unwrap().is_none());
+
+  reader.rewind().unwrap();
+  assert_eq!(reader.position(), 0);
+  assert_eq!(reader.next_frame().unwrap().unwrap().1.sequence(), 1);
+}
+
+#[test]
+fn test_capture_invalid_file() {
+  let file = TempFile::new("invalid");
+  std::fs::write(&file.0, b"not a capture file").unwrap();
+  assert!(CaptureReader::open(&file.0).is_err());
+
+  assert!(CaptureRecorder::create(
+    &file.0,
+    CaptureOptions {
+      extent_size: 0,
+      ..Default::default()
+    },
+  )
+  .is_err());
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_capture_frame_listener() {
+  let file = TempFile::new("frame-listener");
+  let recorder = CaptureRecorder::create(&file.0, CaptureOptions::default()).unwrap();
+
+  let mut data = vec![1, 2, 3, 4];
+  for ty in [FrameType::Color, FrameType::Depth] {
+    unsafe {
+      call_frame_listener(
+        &recorder.as_frame_listener().0,
+        ty.into(),
+        1,
+        2,
+        2,
+        data.as_mut_ptr(),
+      )
+      .unwrap();
+    }
+  }
+
+  // Dropping the recorder writes the frames still waiting and the index
+  drop(recorder);
+
+  let reader = CaptureReader::open(&file.0).unwrap();
+  assert!(reader.is_finished());
+  assert_eq!(reader.len(), 2);
+  assert_eq!(reader.frame(1).unwrap().0, FrameType::Depth);
+  assert_eq!(reader.frame(1).unwrap().1.raw_data(), [1, 2, 3, 4]);
+}
@@ -0,0 +1,224 @@
+use crate::color_decoder::{
+  decoding_frame_listener, ColorDecoder, DecodeFormat, DecodeOptions, DecodeScale, Region,
+};
+use crate::frame::Frame;
+
+#[test]
+fn test_decode_scale() {
+  assert_eq!(DecodeScale::default(), DecodeScale::Full);
+  assert_eq!(DecodeScale::Quarter.denominator(), 4);
+  assert_eq!(DecodeScale::Full.scaled_size(1920, 1080), (1920, 1080));
+  assert_eq!(DecodeScale::Half.scaled_size(1920, 1080), (960, 540));
+  assert_eq!(DecodeScale::Eighth.scaled_size(1920, 1080), (240, 135));
+  assert_eq!(DecodeScale::Eighth.scaled_size(9, 1), (2, 1));
+}
+
+#[test]
+fn test_decode_options() {
+  let options = DecodeOptions::default();
+  assert_eq!(options.scale, DecodeScale::Full);
+  assert_eq!(options.format, DecodeFormat::BGRX);
+  assert_eq!(options.region, None);
+
+  assert_eq!(DecodeFormat::RGB.bytes_per_pixel(), 3);
+  assert_eq!(DecodeFormat::RGBX.bytes_per_pixel(), 4);
+  assert_eq!(DecodeFormat::Gray.bytes_per_pixel(), 1);
+}
+
+#[test]
+fn test_decoder_rejects_decoded_frames() {
+  if !ColorDecoder::is_available() {
+    assert!(ColorDecoder::new().is_err());
+    return;
+  }
+
+  let mut decoder = ColorDecoder::new().unwrap();
+  assert!(decoder
+    .decode(&Frame::depth(), &DecodeOptions::default())
+    .is_err());
+}
+
+#[test]
+fn test_rgb_frames_are_rejected() {
+  let options = DecodeOptions {
+    format: DecodeFormat::RGB,
+    ..Default::default()
+  };
+  assert!(decoding_frame_listener(options, |_, _| Ok(())).is_err());
+
+  if let Ok(mut decoder) = ColorDecoder::new() {
+    assert!(decoder.decode(&Frame::depth(), &options).is_err());
+  }
+}
+
+#[cfg(feature = "image")]
+mod decode {
+  use super::*;
+  use crate::frame::{FrameFormat, Freenect2Frame, OwnedFrame};
+  use crate::test::FrameBuilder;
+  use image::{ImageFormat, Rgb, RgbImage};
+  use std::io::Cursor;
+
+  const WIDTH: u32 = 64;
+  const HEIGHT: u32 = 32;
+
+  // Red on the left half, blue on the right half
+  fn create_packet() -> OwnedFrame {
+    let image = RgbImage::from_fn(WIDTH, HEIGHT, |x, _| {
+      if x < WIDTH / 2 {
+        Rgb([250, 0, 0])
+      } else {
+        Rgb([0, 0, 250])
+      }
+    });
+
+    let mut data = Vec::new();
+    image
+      .write_to(&mut Cursor::new(&mut data), ImageFormat::Jpeg)
+      .unwrap();
+
+    FrameBuilder::packet(data.len())
+      .timestamp(100)
+      .sequence(7)
+      .camera(1.5, 2.0, 2.5)
+      .build(data)
+  }
+
+  fn assert_close(actual: &[u8], expected: &[u8]) {
+    assert!(
+      actual
+        .iter()
+        .zip(expected)
+        .all(|(a, b)| a.abs_diff(*b) <= 8),
+      "{actual:?} != {expected:?}"
+    );
+  }
+
+  fn create_decoder() -> Option<ColorDecoder> {
+    ColorDecoder::is_available().then(|| ColorDecoder::new().unwrap())
+  }
+
+  #[test]
+  fn test_decode_full() {
+    let Some(mut decoder) = create_decoder() else {
+      return;
+    };
+
+    let packet = create_packet();
+    let frame = decoder.decode(&packet, &DecodeOptions::default()).unwrap();
+    assert_eq!((frame.width(), frame.height()), (64, 32));
+    assert_eq!(frame.bytes_per_pixel(), 4);
+    assert_eq!(frame.format(), FrameFormat::BGRX);
+    assert_eq!(frame.timestamp(), 100);
+    assert_eq!(frame.sequence(), 7);
+    assert_eq!(frame.gamma(), 2.5);
+
+    assert_close(&frame.raw_data()[..3], &[0, 0, 250]);
+    assert_close(&frame.raw_data()[63 * 4..63 * 4 + 3], &[250, 0, 0]);
+  }
+
+  #[test]
+  fn test_decode_scaled() {
+    let Some(mut decoder) = create_decoder() else {
+      return;
+    };
+
+    let frame = decoder
+      .decode(
+        &create_packet(),
+        &DecodeOptions {
+          scale: DecodeScale::Quarter,
+          format: DecodeFormat::RGBX,
+          region: None,
+        },
+      )
+      .unwrap();
+    assert_eq!((frame.width(), frame.height()), (16, 8));
+    assert_eq!(frame.format(), FrameFormat::RGBX);
+    assert_close(&frame.raw_data()[..3], &[250, 0, 0]);
+  }
+
+  #[test]
+  fn test_decode_region() {
+    let Some(mut decoder) = create_decoder() else {
+      return;
+    };
+
+    // Not aligned to the MCU grid, starts on the right half
+    let options = DecodeOptions {
+      scale: DecodeScale::Full,
+      format: DecodeFormat::RGBX,
+      region: Some(Region::new(37, 5, 11, 9)),
+    };
+    let frame = decoder.decode(&create_packet(), &options).unwrap();
+    assert_eq!((frame.width(), frame.height()), (11, 9));
+    assert_eq!(frame.bytes_per_pixel(), 4);
+    assert_eq!(frame.format(), FrameFormat::RGBX);
+    assert!(frame
+      .raw_data()
+      .chunks(4)
+      .all(|pixel| pixel[2] > 200 && pixel[0] < 50));
+
+    let frame = decoder
+      .decode(
+        &create_packet(),
+        &DecodeOptions {
+          scale: DecodeScale::Half,
+          ..options
+        },
+      )
+      .unwrap();
+    assert_eq!((frame.width(), frame.height()), (6, 5));
+
+    for region in [Region::new(60, 0, 8, 8), Region::new(0, 0, 0, 8)] {
+      assert!(decoder
+        .decode(
+          &create_packet(),
+          &DecodeOptions {
+            region: Some(region),
+            ..Default::default()
+          }
+        )
+        .is_err());
+    }
+  }
+
+  #[test]
+  fn test_decode_gray() {
+    let Some(mut decoder) = create_decoder() else {
+      return;
+    };
+
+    let frame = decoder
+      .decode(
+        &create_packet(),
+        &DecodeOptions {
+          format: DecodeFormat::Gray,
+          ..Default::default()
+        },
+      )
+      .unwrap();
+    assert_eq!(frame.bytes_per_pixel(), 1);
+    assert_eq!(frame.format(), FrameFormat::Gray);
+    assert_eq!(frame.raw_data().len(), 64 * 32);
+  }
+
+  #[test]
+  fn test_decode_rgb_image() {
+    let Some(mut decoder) = create_decoder() else {
+      return;
+    };
+
+    let image = decoder
+      .decode_rgb_image(
+        &create_packet(),
+        &DecodeOptions {
+          scale: DecodeScale::Eighth,
+          ..Default::default()
+        },
+      )
+      .unwrap();
+    assert_eq!(image.dimensions(), (8, 4));
+    assert_close(&image.get_pixel(7, 0).0, &[0, 0, 250]);
+  }
+}
@@ -1,4 +1,5 @@
-use crate::types::config::Config;
+use crate::frame_type::FrameType;
+use crate::types::config::{Config, DepthStreams};
 
 #[test]
 fn test_create_config() {
@@ -44,3 +45,29 @@ fn test_set_enable_edge_aware_filter() {
   assert!(config.set_enable_edge_aware_filter(false).is_ok());
   assert!(!config.get_enable_edge_aware_filter());
 }
+
+#[test]
+fn test_set_depth_streams() {
+  let mut config = Config::new().unwrap();
+  assert_eq!(config.get_depth_streams(), DepthStreams::IrAndDepth);
+  assert!(config.set_depth_streams(DepthStreams::Depth).is_ok());
+  assert_eq!(config.get_depth_streams(), DepthStreams::Depth);
+}
+
+#[test]
+fn test_depth_streams() {
+  assert_eq!(
+    DepthStreams::from_frame_types(&[FrameType::Depth, FrameType::Ir]),
+    Some(DepthStreams::IrAndDepth)
+  );
+  assert_eq!(
+    DepthStreams::from_frame_types(&[FrameType::Ir]),
+    Some(DepthStreams::Ir)
+  );
+  assert_eq!(DepthStreams::from_frame_types(&[FrameType::Color]), None);
+
+  assert!(DepthStreams::Depth.contains(FrameType::Depth));
+  assert!(!DepthStreams::Depth.contains(FrameType::Ir));
+  assert!(DepthStreams::IrAndDepth.contains(FrameType::Ir));
+  assert!(!DepthStreams::IrAndDepth.contains(FrameType::Color));
+}
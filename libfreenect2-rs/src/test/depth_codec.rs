@@ -0,0 +1,129 @@
+use crate::frame::{Frame, FrameFormat, Freenect2Frame, OwnedFrame};
+use crate::test::{float_values, FrameBuilder};
+use crate::types::depth_codec::{is_keyframe, max_encoded_size, DepthDecoder, DepthEncoder};
+
+fn create_depth_frame(values: &[f32], width: u64, sequence: u32) -> OwnedFrame {
+  FrameBuilder::new(width, FrameFormat::Float)
+    .timestamp(sequence * 10)
+    .sequence(sequence)
+    .build_floats(values)
+}
+
+fn scene(offset: f32) -> Vec<f32> {
+  (0..64 * 48)
+    .map(|i| {
+      if i % 17 == 0 {
+        0.0
+      } else {
+        1000.0 + (i % 64) as f32 * 3.0 + offset
+      }
+    })
+    .collect()
+}
+
+#[test]
+fn test_round_trip() {
+  let mut encoder = DepthEncoder::new(3).unwrap();
+  let mut decoder = DepthDecoder::new().unwrap();
+  let mut encoded = Vec::new();
+
+  for sequence in 0..7 {
+    let values = scene(sequence as f32);
+    encoder
+      .encode(&create_depth_frame(&values, 64, sequence), &mut encoded)
+      .unwrap();
+
+    assert_eq!(is_keyframe(&encoded).unwrap(), sequence % 3 == 0);
+    assert!(encoded.len() < values.len() * 4 / 2);
+
+    let decoded = decoder.decode(&encoded).unwrap();
+    assert_eq!((decoded.width(), decoded.height()), (64, 48));
+    assert_eq!(decoded.format(), FrameFormat::Float);
+    assert_eq!(decoded.sequence(), sequence);
+    assert_eq!(decoded.timestamp(), sequence * 10);
+    assert_eq!(float_values(&decoded), values);
+  }
+}
+
+#[test]
+fn test_rounds_to_millimeters() {
+  let mut encoder = DepthEncoder::new(1).unwrap();
+  let mut decoder = DepthDecoder::new().unwrap();
+  let mut encoded = Vec::new();
+
+  encoder
+    .encode(
+      &create_depth_frame(&[1000.4, 1000.6, f32::NAN, -5.0], 4, 0),
+      &mut encoded,
+    )
+    .unwrap();
+
+  assert_eq!(
+    float_values(&decoder.decode(&encoded).unwrap()),
+    [1000.0, 1001.0, 0.0, 0.0]
+  );
+}
+
+#[test]
+fn test_missing_frame() {
+  let mut encoder = DepthEncoder::new(3).unwrap();
+  let mut decoder = DepthDecoder::new().unwrap();
+  let mut frames = (0..4)
+    .map(|sequence| {
+      let mut encoded = Vec::new();
+      encoder
+        .encode(
+          &create_depth_frame(&scene(sequence as f32), 64, sequence),
+          &mut encoded,
+        )
+        .unwrap();
+      encoded
+    })
+    .collect::<Vec<_>>();
+
+  // A delta frame can't be decoded without the previous frame
+  assert!(decoder.decode(&frames[1]).is_err());
+  decoder.decode(&frames[0]).unwrap();
+  assert!(decoder.decode(&frames[2]).is_err());
+
+  // The next keyframe recovers
+  assert_eq!(
+    float_values(&decoder.decode(&frames[3]).unwrap()),
+    scene(3.0)
+  );
+
+  decoder.reset();
+  encoder.force_keyframe();
+  encoder
+    .encode(&create_depth_frame(&scene(4.0), 64, 4), &mut frames[0])
+    .unwrap();
+  assert!(is_keyframe(&frames[0]).unwrap());
+  assert_eq!(
+    float_values(&decoder.decode(&frames[0]).unwrap()),
+    scene(4.0)
+  );
+}
+
+#[test]
+fn test_invalid_data() {
+  let mut encoder = DepthEncoder::new(1).unwrap();
+  let mut decoder = DepthDecoder::new().unwrap();
+  let mut encoded = Vec::new();
+
+  encoder
+    .encode(&create_depth_frame(&scene(0.0), 64, 0), &mut encoded)
+    .unwrap();
+
+  assert!(is_keyframe(&[0; 8]).is_err());
+  assert!(decoder.decode(&[0; 64]).is_err());
+  assert!(decoder.decode(&encoded[..encoded.len() / 2]).is_err());
+
+  let mut dst = vec![0; max_encoded_size(64, 48) - 1];
+  assert!(encoder
+    .encode_into(&create_depth_frame(&scene(0.0), 64, 0), &mut dst)
+    .is_err());
+  assert!(encoder
+    .encode(&Frame::color_for_depth(), &mut encoded)
+    .is_err());
+  assert!(DepthEncoder::new(0).is_err());
+}
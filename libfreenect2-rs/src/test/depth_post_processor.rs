@@ -0,0 +1,149 @@
+use crate::frame::{Frame, FrameFormat, Freenect2Frame, OwnedFrame};
+use crate::test::{float_values, FrameBuilder};
+use crate::types::depth_post_processor::{
+  DepthDecimation, DepthPostProcessing, DepthPostProcessor, TemporalFilter,
+};
+
+fn create_depth_frame(values: &[f32], width: u64) -> OwnedFrame {
+  FrameBuilder::new(width, FrameFormat::Float)
+    .timestamp(7)
+    .sequence(3)
+    .build_floats(values)
+}
+
+fn process(options: DepthPostProcessing, values: &[f32], width: u64) -> Vec<f32> {
+  let mut processor = DepthPostProcessor::new(&options).unwrap();
+  float_values(
+    &processor
+      .process(&create_depth_frame(values, width))
+      .unwrap(),
+  )
+}
+
+#[test]
+fn test_clip_range() {
+  let options = DepthPostProcessing {
+    range: Some((500.0, 4500.0)),
+    ..Default::default()
+  };
+
+  assert_eq!(
+    process(
+      options,
+      &[0.0, f32::NAN, 499.0, 500.0, 4500.0, 4501.0, 1000.0],
+      7
+    ),
+    [0.0, 0.0, 0.0, 500.0, 4500.0, 0.0, 1000.0]
+  );
+}
+
+#[test]
+fn test_decimation() {
+  let mut values = (1..=40).map(|i| i as f32).collect::<Vec<_>>();
+  values[0] = 0.0;
+  values[1] = f32::NAN;
+  values[10] = 0.0;
+  values[11] = 0.0;
+
+  let mut processor = DepthPostProcessor::new(&DepthPostProcessing {
+    decimation: DepthDecimation::Half,
+    ..Default::default()
+  })
+  .unwrap();
+  let frame = create_depth_frame(&values, 10);
+  let processed = processor.process(&frame).unwrap();
+
+  assert_eq!((processed.width(), processed.height()), (5, 2));
+  assert_eq!(processed.timestamp(), 7);
+  assert_eq!(processed.sequence(), 3);
+
+  let depths = float_values(&processed);
+  // Invalid depths are ignored
+  assert_eq!(depths[0], 0.0);
+  assert_eq!(depths[1], (3.0 + 4.0 + 13.0 + 14.0) / 4.0);
+  assert_eq!(depths[5], (21.0 + 22.0 + 31.0 + 32.0) / 4.0);
+
+  assert_eq!(
+    DepthDecimation::Quarter.decimated_size(512, 424),
+    (128, 106)
+  );
+}
+
+#[test]
+fn test_hole_filling() {
+  let options = DepthPostProcessing {
+    hole_fill_radius: 1,
+    ..Default::default()
+  };
+
+  #[rustfmt::skip]
+  let values = [
+    0.0, 0.0, 0.0, 0.0, 0.0,
+    0.0, 0.0, 0.0, 0.0, 0.0,
+    0.0, 0.0, 0.0, 0.0, 2000.0,
+    1500.0, 0.0, 0.0, 0.0, 0.0,
+  ];
+  let depths = process(options, &values, 5);
+
+  assert_eq!(depths[0], 0.0);
+  assert_eq!(depths[9], 2000.0);
+  // The nearest depth wins
+  assert_eq!(depths[10], 1500.0);
+  assert_eq!(depths[16], 1500.0);
+  assert_eq!(depths[17], 0.0);
+}
+
+#[test]
+fn test_temporal_filter() {
+  let mut processor = DepthPostProcessor::new(&DepthPostProcessing {
+    temporal: Some(TemporalFilter {
+      alpha: 0.5,
+      threshold: 100.0,
+    }),
+    ..Default::default()
+  })
+  .unwrap();
+
+  let first = create_depth_frame(&[1000.0, 1000.0, 0.0, 1000.0, 1000.0], 5);
+  let second = create_depth_frame(&[1050.0, 1200.0, 1000.0, 0.0, 980.0], 5);
+
+  assert_eq!(
+    float_values(&processor.process(&first).unwrap()),
+    [1000.0, 1000.0, 0.0, 1000.0, 1000.0]
+  );
+  assert_eq!(
+    float_values(&processor.process(&second).unwrap()),
+    [1025.0, 1200.0, 1000.0, 0.0, 990.0]
+  );
+
+  processor.reset();
+  assert_eq!(
+    float_values(&processor.process(&second).unwrap()),
+    [1050.0, 1200.0, 1000.0, 0.0, 980.0]
+  );
+}
+
+#[test]
+fn test_invalid_options() {
+  assert!(DepthPostProcessor::new(&DepthPostProcessing {
+    range: Some((1000.0, 500.0)),
+    ..Default::default()
+  })
+  .is_err());
+  assert!(DepthPostProcessor::new(&DepthPostProcessing {
+    hole_fill_radius: 9,
+    ..Default::default()
+  })
+  .is_err());
+  assert!(DepthPostProcessor::new(&DepthPostProcessing {
+    temporal: Some(TemporalFilter {
+      alpha: 0.0,
+      threshold: 50.0,
+    }),
+    ..Default::default()
+  })
+  .is_err());
+
+  let mut processor = DepthPostProcessor::new(&DepthPostProcessing::default()).unwrap();
+  assert!(processor.process(&Frame::color_for_depth()).is_err());
+}
@@ -0,0 +1,100 @@
+use crate::device_group::{DeviceGroup, DeviceGroupOptions, HostClock};
+use crate::frame::SharedFrame;
+use crate::frame_type::FrameType;
+use crate::types::frame_synchronizer::Matcher;
+use std::time::{Duration, Instant};
+
+#[test]
+fn test_host_clock_aligns_devices() {
+  let epoch = Instant::now();
+  let first = HostClock::new(epoch);
+  let second = HostClock::new(epoch);
+
+  // Both devices capture a frame every 33ms, but their clocks started at different times.
+  // Arrival is delayed by a varying latency of up to 4ms.
+  let mut keys = Vec::new();
+  for i in 0..10u32 {
+    let capture = Duration::from_millis(100 + 33 * i as u64);
+    let first_key = first.map(
+      1_000 + i * 264,
+      epoch + capture + Duration::from_millis((i % 3) as u64),
+    );
+    let second_key = second.map(
+      500_000 + i * 264,
+      epoch + capture + Duration::from_millis(((i + 1) % 5) as u64),
+    );
+
+    keys.push((first_key, second_key));
+  }
+
+  // Once the smallest latency of both devices was seen, the keys are close
+  for (first_key, second_key) in &keys[5..] {
+    assert!(first_key.abs_diff(*second_key) <= 8);
+  }
+}
+
+#[test]
+fn test_host_clock_follows_drift() {
+  let epoch = Instant::now();
+  let first = HostClock::new(epoch);
+  let second = HostClock::new(epoch);
+
+  // The crystal of the second device runs 100ppm slow. Over 30 minutes its
+  // timestamps fall 1440 ticks behind, far beyond the default tolerance.
+  let mut max_diff = 0;
+  for i in 0..30 * 60 * 30u64 {
+    let capture = Duration::from_millis(100 + 33 * i);
+    let ticks = capture.as_secs_f64() * 8000.0;
+    let first_key = first.map(
+      1_000 + ticks as u32,
+      epoch + capture + Duration::from_millis(i % 3),
+    );
+    let second_key = second.map(
+      500_000 + (ticks * (1.0 - 100e-6)) as u32,
+      epoch + capture + Duration::from_millis((i + 1) % 5),
+    );
+
+    if capture > HostClock::WINDOW {
+      max_diff = max_diff.max(first_key.abs_diff(second_key));
+    }
+  }
+
+  assert!(max_diff <= 16, "max_diff: {}", max_diff);
+}
+
+#[test]
+fn test_match_devices() {
+  let mut matcher = Matcher::new(&[0usize, 1, 2], 10, 4);
+  assert!(matcher.push(0, 100, "a").is_empty());
+  assert!(matcher.push(1, 104, "b").is_empty());
+
+  let matched = matcher.push(2, 98, "c");
+  assert_eq!(matched.len(), 1);
+  assert_eq!(matched[0].delta, 6);
+  assert_eq!(
+    matched[0]
+      .frames
+      .iter()
+      .map(|(i, _)| *i)
+      .collect::<Vec<_>>(),
+    [0, 1, 2]
+  );
+}
+
+#[test]
+fn test_open_missing_device() {
+  let res = DeviceGroup::<SharedFrame>::open(DeviceGroupOptions {
+    serials: Some(vec!["missing".to_string()]),
+    ..Default::default()
+  });
+  assert!(res.is_err());
+}
+
+#[test]
+fn test_invalid_group_options() {
+  let res = DeviceGroup::<SharedFrame>::open(DeviceGroupOptions {
+    frame_types: Vec::<FrameType>::new(),
+    ..Default::default()
+  });
+  assert!(res.is_err());
+}
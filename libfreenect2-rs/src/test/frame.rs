@@ -0,0 +1,18 @@
+use crate::types::frame::{Frame, Freenect2Frame};
+
+#[test]
+fn test_shared_frame_does_not_copy() {
+  let frame = Frame::depth();
+  let ptr = frame.raw_data().as_ptr();
+
+  let shared = frame.into_shared();
+  let clone = shared.clone();
+  assert_eq!(shared.ref_count(), 2);
+  assert_eq!(clone.raw_data().as_ptr(), ptr);
+
+  let handle = std::thread::spawn(move || clone.raw_data().as_ptr() as usize);
+  assert_eq!(handle.join().unwrap(), ptr as usize);
+
+  let native = shared.try_unwrap().ok().unwrap();
+  assert_eq!(native.raw_data().as_ptr(), ptr);
+}
@@ -0,0 +1,141 @@
+use crate::frame::{FrameFormat, Freenect2Frame, OwnedFrame};
+use crate::frame_convert::{
+  convert_color, convert_pixels, depth_to_colormap, depth_to_millimeters, normalize_ir, Colormap,
+  PixelLayout, MAX_IR_VALUE,
+};
+use crate::test::FrameBuilder;
+
+fn create_float_frame(values: &[f32]) -> OwnedFrame {
+  FrameBuilder::new(values.len() as _, FrameFormat::Float).build_floats(values)
+}
+
+#[test]
+fn test_convert_pixels() {
+  // Enough pixels for the vectorized and the scalar path
+  let rgb = (0..37 * 3).map(|i| i as u8).collect::<Vec<_>>();
+
+  let mut bgra = vec![0; 37 * 4];
+  convert_pixels(&rgb, PixelLayout::RGB, &mut bgra, PixelLayout::BGRA).unwrap();
+  for (src, dst) in rgb.chunks(3).zip(bgra.chunks(4)) {
+    assert_eq!(dst, [src[2], src[1], src[0], 255]);
+  }
+
+  let mut back = vec![0; 37 * 3];
+  convert_pixels(&bgra, PixelLayout::BGRA, &mut back, PixelLayout::RGB).unwrap();
+  assert_eq!(back, rgb);
+
+  let mut bgr = vec![0; 37 * 3];
+  convert_pixels(&rgb, PixelLayout::RGB, &mut bgr, PixelLayout::BGR).unwrap();
+  assert_eq!(bgr[..6], [2, 1, 0, 5, 4, 3]);
+
+  assert!(convert_pixels(&rgb[..4], PixelLayout::RGB, &mut bgra, PixelLayout::BGRA).is_err());
+  assert!(convert_pixels(&rgb, PixelLayout::RGB, &mut bgr[..3], PixelLayout::BGR).is_err());
+}
+
+#[test]
+fn test_convert_color() {
+  let data = (0..19 * 2 * 4).map(|i| i as u8).collect::<Vec<_>>();
+  let bgrx = FrameBuilder::new(19, FrameFormat::BGRX).build(data.clone());
+  let rgbx = FrameBuilder::new(19, FrameFormat::RGBX).build(data.clone());
+
+  let mut rgb = vec![0; 19 * 2 * 3];
+  convert_color(&bgrx, PixelLayout::RGB, &mut rgb).unwrap();
+  for (src, dst) in data.chunks(4).zip(rgb.chunks(3)) {
+    assert_eq!(dst, [src[2], src[1], src[0]]);
+  }
+
+  let mut rgba = vec![0; 19 * 2 * 4];
+  convert_color(&rgbx, PixelLayout::RGBA, &mut rgba).unwrap();
+  for (src, dst) in data.chunks(4).zip(rgba.chunks(4)) {
+    assert_eq!(dst, [src[0], src[1], src[2], 255]);
+  }
+
+  assert!(convert_color(&bgrx, PixelLayout::RGB, &mut rgb[..3]).is_err());
+  assert!(convert_color(&create_float_frame(&[0.0]), PixelLayout::RGB, &mut rgb).is_err());
+}
+
+#[test]
+fn test_depth_to_millimeters() {
+  let mut values = vec![0.0, -1.0, f32::NAN, f32::INFINITY, 0.4, 1.5, 499.6, 70000.0];
+  values.extend((0..13).map(|i| i as f32 * 100.0));
+  let frame = create_float_frame(&values);
+
+  let mut depth = vec![0; values.len()];
+  depth_to_millimeters(&frame, &mut depth).unwrap();
+  assert_eq!(depth[..8], [0, 0, 0, 65535, 0, 2, 500, 65535]);
+  assert!(depth[8..]
+    .iter()
+    .enumerate()
+    .all(|(i, value)| *value == i as u16 * 100));
+
+  assert!(depth_to_millimeters(&frame, &mut depth[..1]).is_err());
+}
+
+#[test]
+fn test_depth_to_colormap() {
+  let frame = create_float_frame(&[0.0, f32::NAN, 500.0, 100.0, 4500.0, 9000.0]);
+
+  let mut gray = vec![0; 6 * 3];
+  depth_to_colormap(&frame, 500.0, 4500.0, Colormap::Gray, &mut gray).unwrap();
+  assert_eq!(gray[..6], [0; 6]);
+  assert_eq!(gray[6..9], [1; 3]);
+  assert_eq!(gray[9..12], [1; 3]);
+  assert_eq!(gray[12..], [255; 6]);
+
+  let mut jet = vec![0; 6 * 3];
+  depth_to_colormap(&frame, 500.0, 4500.0, Colormap::Jet, &mut jet).unwrap();
+  assert_eq!(jet[..3], [0; 3]);
+  // Blue for near and red for far depths
+  assert!(jet[8] > 100 && jet[6] == 0);
+  assert!(jet[12] > 100 && jet[14] == 0);
+
+  assert!(depth_to_colormap(&frame, 500.0, 500.0, Colormap::Gray, &mut gray).is_err());
+  assert!(depth_to_colormap(&frame, 500.0, 4500.0, Colormap::Gray, &mut gray[..3]).is_err());
+}
+
+#[test]
+fn test_normalize_ir() {
+  let values = (0..20).map(|i| i as f32 * 1000.0).collect::<Vec<_>>();
+  let frame = create_float_frame(&values);
+
+  let mut gray = vec![0; values.len()];
+  normalize_ir(&frame, 8000.0, &mut gray).unwrap();
+  assert_eq!(gray[..3], [0, 32, 64]);
+  assert!(gray[8..].iter().all(|value| *value == 255));
+
+  normalize_ir(&frame, MAX_IR_VALUE, &mut gray).unwrap();
+  assert_eq!(gray[19], 74);
+
+  assert!(normalize_ir(&frame, 0.0, &mut gray).is_err());
+}
+
+#[test]
+#[cfg(feature = "image")]
+fn test_convert_images() {
+  use crate::frame::FrameImage;
+  use crate::frame_convert::{depth_to_millimeters_image, to_rgb_image, to_rgba_image};
+
+  let frame =
+    FrameBuilder::new(8, FrameFormat::BGRX).build((0..8 * 4 * 4).map(|i| i as u8).collect());
+  let rgb = to_rgb_image(&frame).unwrap();
+  assert_eq!(rgb.dimensions(), (8, 4));
+  assert_eq!(rgb.get_pixel(1, 0).0, [6, 5, 4]);
+  assert_eq!(
+    to_rgba_image(&frame).unwrap().get_pixel(1, 0).0,
+    [6, 5, 4, 255]
+  );
+
+  match frame.as_image() {
+    FrameImage::RGB(image) => assert_eq!(image, rgb),
+    _ => panic!("Expected an RGB image"),
+  }
+
+  let depth = create_float_frame(&[1.0, 2.0, 3.0]);
+  let image = depth_to_millimeters_image(&depth).unwrap();
+  assert_eq!(image.into_raw(), [1, 2, 3]);
+
+  match depth.as_image() {
+    FrameImage::Float(image) => assert_eq!(image.into_raw(), [1.0, 2.0, 3.0]),
+    _ => panic!("Expected a float image"),
+  }
+}
@@ -3,6 +3,10 @@ use crate::ffi::libfreenect2::{call_frame_listener, FrameType};
 #[cfg(debug_assertions)]
 use crate::types::frame::Freenect2Frame;
 use crate::types::frame_listener::FrameListener;
+#[cfg(debug_assertions)]
+use crate::types::frame_pool::FramePool;
+#[cfg(debug_assertions)]
+use std::sync::{Arc, Mutex};
 
 #[test]
 fn test_create_frame_listener() {
@@ -54,6 +58,87 @@ fn test_call_throwing_frame_listener() {
     )
   };
 
-  assert!(res.is_err());
-  assert!(res.unwrap_err().to_string().contains("Test"))
+  // The error is recorded instead of being thrown into the pipeline
+  assert!(res.is_ok());
+  assert_eq!(listener.error_count(), 1);
+  assert_eq!(listener.panic_count(), 0);
+  assert!(listener
+    .take_last_error()
+    .unwrap()
+    .to_string()
+    .contains("Test"));
+  assert!(listener.take_last_error().is_none());
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_call_panicking_frame_listener() {
+  let calls = Arc::new(Mutex::new(0));
+  let calls_clone = calls.clone();
+  let mut listener = FrameListener::new(move |_, _| {
+    *calls_clone.lock().unwrap() += 1;
+    panic!("Test panic");
+  })
+  .unwrap();
+
+  let mut data = vec![1, 2, 3, 4];
+  for _ in 0..2 {
+    unsafe {
+      call_frame_listener(
+        &mut listener.0,
+        FrameType::Color,
+        1,
+        2,
+        2,
+        data.as_mut_ptr(),
+      )
+      .unwrap();
+    }
+  }
+
+  // The same closure is called again after it panicked
+  assert_eq!(*calls.lock().unwrap(), 2);
+  assert_eq!(listener.error_count(), 2);
+  assert_eq!(listener.panic_count(), 2);
+  assert!(listener
+    .take_last_error()
+    .unwrap()
+    .to_string()
+    .contains("Test panic"));
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_call_pooled_frame_listener() {
+  let pool = FramePool::new(1).unwrap();
+  let frames = Arc::new(Mutex::new(Vec::new()));
+  let frames_clone = frames.clone();
+  let mut listener = FrameListener::new_pooled(&pool, move |_, frame| {
+    assert_eq!(frame.raw_data(), [1, 2, 3, 4]);
+    frames_clone.lock().unwrap().push(frame);
+
+    Ok(())
+  })
+  .unwrap();
+
+  let mut data = vec![1, 2, 3, 4];
+  for _ in 0..2 {
+    unsafe {
+      call_frame_listener(
+        &mut listener.0,
+        FrameType::Color,
+        1,
+        2,
+        2,
+        data.as_mut_ptr(),
+      )
+      .unwrap();
+    }
+  }
+
+  assert_eq!(pool.exhausted_count(), 1);
+  assert_eq!(pool.available(FrameType::Color.into()).unwrap(), 0);
+
+  frames.lock().unwrap().clear();
+  assert_eq!(pool.available(FrameType::Color.into()).unwrap(), 1);
 }
@@ -0,0 +1,131 @@
+#![cfg(feature = "stream")]
+
+#[cfg(debug_assertions)]
+use crate::ffi::libfreenect2::call_frame_listener;
+#[cfg(debug_assertions)]
+use crate::frame::Freenect2Frame;
+use crate::frame::SharedFrame;
+use crate::frame_stream::{FrameSetStream, FrameStreamOptions, SharedFrameStream};
+use crate::frame_type::FrameType;
+#[cfg(debug_assertions)]
+use futures_core::Stream;
+#[cfg(debug_assertions)]
+use std::pin::Pin;
+#[cfg(debug_assertions)]
+use std::sync::atomic::{AtomicUsize, Ordering};
+#[cfg(debug_assertions)]
+use std::sync::Arc;
+#[cfg(debug_assertions)]
+use std::task::{Context, Poll, Wake, Waker};
+
+#[cfg(debug_assertions)]
+#[derive(Default)]
+struct CountingWaker(AtomicUsize);
+
+#[cfg(debug_assertions)]
+impl Wake for CountingWaker {
+  fn wake(self: Arc<Self>) {
+    self.0.fetch_add(1, Ordering::SeqCst);
+  }
+}
+
+#[test]
+fn test_create_frame_stream() {
+  SharedFrameStream::new(FrameStreamOptions::default()).unwrap();
+  FrameSetStream::<SharedFrame>::new(&[FrameType::Color], FrameStreamOptions::default()).unwrap();
+
+  assert!(FrameSetStream::<SharedFrame>::new(&[], FrameStreamOptions::default()).is_err());
+  assert!(SharedFrameStream::new(FrameStreamOptions {
+    capacity: 0,
+    ..Default::default()
+  })
+  .is_err());
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_poll_frame_stream() {
+  let mut stream = SharedFrameStream::new(FrameStreamOptions {
+    capacity: 2,
+    ..Default::default()
+  })
+  .unwrap();
+
+  let counter = Arc::new(CountingWaker::default());
+  let waker = Waker::from(counter.clone());
+  let mut cx = Context::from_waker(&waker);
+  assert!(Pin::new(&mut stream).poll_next(&mut cx).is_pending());
+
+  for i in 0..3u8 {
+    let mut data = vec![i, 0, 0, 0];
+    unsafe {
+      call_frame_listener(
+        &mut stream.listener.0,
+        FrameType::Color.into(),
+        1,
+        2,
+        2,
+        data.as_mut_ptr(),
+      )
+      .unwrap();
+    }
+  }
+
+  // Only the first frame wakes the task, the waker is used up until the next poll
+  assert_eq!(counter.0.load(Ordering::SeqCst), 1);
+  assert_eq!(stream.queue_len(), 2);
+  assert_eq!(stream.dropped_count(), 1);
+
+  for i in 1..3u8 {
+    match Pin::new(&mut stream).poll_next(&mut cx) {
+      Poll::Ready(Some((ty, frame))) => {
+        assert_eq!(ty, FrameType::Color);
+        assert_eq!(frame.raw_data()[0], i);
+      }
+      _ => panic!("Expected a frame"),
+    }
+  }
+
+  assert!(Pin::new(&mut stream).poll_next(&mut cx).is_pending());
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_poll_frame_set_stream() {
+  let mut stream = FrameSetStream::<SharedFrame>::new(
+    &[FrameType::Ir, FrameType::Depth],
+    FrameStreamOptions::default(),
+  )
+  .unwrap();
+
+  let counter = Arc::new(CountingWaker::default());
+  let waker = Waker::from(counter.clone());
+  let mut cx = Context::from_waker(&waker);
+  assert!(Pin::new(&mut stream).poll_next(&mut cx).is_pending());
+
+  let mut data = vec![1, 2, 3, 4];
+  for ty in [FrameType::Ir, FrameType::Depth] {
+    assert_eq!(counter.0.load(Ordering::SeqCst), 0);
+    unsafe {
+      call_frame_listener(
+        &mut stream.listener.0,
+        ty.into(),
+        1,
+        2,
+        2,
+        data.as_mut_ptr(),
+      )
+      .unwrap();
+    }
+  }
+
+  assert_eq!(counter.0.load(Ordering::SeqCst), 1);
+  match Pin::new(&mut stream).poll_next(&mut cx) {
+    Poll::Ready(Some(frames)) => {
+      assert!(frames.ir().is_some());
+      assert!(frames.depth().is_some());
+      assert!(frames.color().is_none());
+    }
+    _ => panic!("Expected a frame set"),
+  }
+}
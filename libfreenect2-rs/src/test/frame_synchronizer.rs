@@ -0,0 +1,59 @@
+use crate::frame_type::FrameType;
+use crate::types::frame_synchronizer::Matcher;
+
+#[test]
+fn test_match_within_tolerance() {
+  let mut matcher = Matcher::new(&[FrameType::Color, FrameType::Depth], 10, 4);
+
+  assert!(matcher.push(FrameType::Color, 100, 'a').is_empty());
+  let matched = matcher.push(FrameType::Depth, 105, 'b');
+
+  assert_eq!(matched.len(), 1);
+  assert_eq!(matched[0].delta, 5);
+  assert_eq!(
+    matched[0].frames,
+    vec![(FrameType::Color, 'a'), (FrameType::Depth, 'b')]
+  );
+  assert_eq!(matcher.discarded, 0);
+}
+
+#[test]
+fn test_discard_unpairable() {
+  let mut matcher = Matcher::new(&[FrameType::Color, FrameType::Depth], 10, 4);
+
+  // Depth lags behind by two frames
+  assert!(matcher.push(FrameType::Color, 100, 1).is_empty());
+  assert!(matcher.push(FrameType::Color, 366, 2).is_empty());
+  assert!(matcher.push(FrameType::Color, 632, 3).is_empty());
+
+  let matched = matcher.push(FrameType::Depth, 630, 4);
+  assert_eq!(matched.len(), 1);
+  assert_eq!(matched[0].delta, 2);
+  assert_eq!(
+    matched[0].frames,
+    vec![(FrameType::Color, 3), (FrameType::Depth, 4)]
+  );
+  assert_eq!(matcher.discarded, 2);
+}
+
+#[test]
+fn test_timestamp_wrap_around() {
+  let mut matcher = Matcher::new(&[FrameType::Color, FrameType::Depth], 10, 4);
+
+  assert!(matcher.push(FrameType::Color, u32::MAX - 2, ()).is_empty());
+  let matched = matcher.push(FrameType::Depth, 3, ());
+
+  assert_eq!(matched.len(), 1);
+  assert_eq!(matched[0].delta, 6);
+}
+
+#[test]
+fn test_max_pending() {
+  let mut matcher = Matcher::new(&[FrameType::Color, FrameType::Depth], 10, 2);
+
+  for i in 0..5 {
+    assert!(matcher.push(FrameType::Color, i * 266, i).is_empty());
+  }
+
+  assert_eq!(matcher.discarded, 3);
+}
@@ -0,0 +1,86 @@
+use crate::frame::{FrameFormat, Freenect2Frame, OwnedFrame};
+use crate::frame_convert::{convert_color, depth_to_millimeters, PixelLayout};
+use crate::frame_view::Region;
+use crate::test::{float_values, FrameBuilder};
+
+fn create_depth_frame(width: usize, height: usize) -> OwnedFrame {
+  let values = (0..width * height).map(|i| i as f32).collect::<Vec<_>>();
+  FrameBuilder::new(width as _, FrameFormat::Float).build_floats(&values)
+}
+
+#[test]
+fn test_view_does_not_copy() {
+  let frame = create_depth_frame(16, 8);
+  let view = frame.view(Region::new(3, 2, 5, 4)).unwrap();
+
+  assert_eq!((view.width(), view.height()), (5, 4));
+  assert_eq!(view.row_pitch(), 16 * 4);
+  assert!(!view.is_contiguous());
+  assert_eq!(
+    view.raw_data().as_ptr(),
+    frame.raw_data()[(2 * 16 + 3) * 4..].as_ptr()
+  );
+  assert_eq!(view.raw_data().len(), 3 * 16 * 4 + 5 * 4);
+
+  for y in 0..4 {
+    for x in 0..5 {
+      assert_eq!(view.get_pixel(x, y), frame.get_pixel(x + 3, y + 2));
+    }
+  }
+
+  // A view of full rows is contiguous
+  assert!(frame
+    .view(Region::new(0, 2, 16, 4))
+    .unwrap()
+    .is_contiguous());
+}
+
+#[test]
+fn test_view_to_owned() {
+  let frame = create_depth_frame(16, 8);
+  let owned = frame.view(Region::new(3, 2, 5, 4)).unwrap().to_owned();
+
+  assert_eq!((owned.width(), owned.height()), (5, 4));
+  assert!(owned.is_contiguous());
+  let values = float_values(&owned);
+  let expected = (2..6)
+    .flat_map(|y| (3..8).map(move |x| (y * 16 + x) as f32))
+    .collect::<Vec<_>>();
+  assert_eq!(values, expected);
+}
+
+#[test]
+fn test_view_out_of_bounds() {
+  let frame = create_depth_frame(16, 8);
+
+  assert!(frame.view(Region::new(0, 0, 16, 8)).is_ok());
+  assert!(frame.view(Region::new(12, 0, 5, 1)).is_err());
+  assert!(frame.view(Region::new(0, 7, 1, 2)).is_err());
+  assert!(frame.view(Region::new(0, 0, 0, 8)).is_err());
+}
+
+#[test]
+fn test_convert_view() {
+  let frame = create_depth_frame(16, 8);
+  let region = Region::new(3, 2, 5, 4);
+  let view = frame.view(region).unwrap();
+
+  let mut depth = vec![0; 5 * 4];
+  depth_to_millimeters(&view, &mut depth).unwrap();
+  let mut expected = vec![0; 5 * 4];
+  depth_to_millimeters(&view.to_owned(), &mut expected).unwrap();
+  assert_eq!(depth, expected);
+  assert!(depth_to_millimeters(&view, &mut depth[..19]).is_err());
+
+  let data = (0..16 * 8 * 4).map(|i| i as u8).collect::<Vec<_>>();
+  let color = FrameBuilder::new(16, FrameFormat::BGRX).build(data);
+  let view = color.view(region).unwrap();
+
+  let mut rgb = vec![0; 5 * 4 * 3];
+  convert_color(&view, PixelLayout::RGB, &mut rgb).unwrap();
+  for (i, dst) in rgb.chunks(3).enumerate() {
+    let src = view.row(i / 5);
+    let src = &src[(i % 5) * 4..];
+    assert_eq!(dst, [src[2], src[1], src[0]]);
+  }
+}
@@ -0,0 +1,33 @@
+use crate::freenect2::PacketPipeline;
+use crate::gpu_device::DevicePlacement;
+
+#[test]
+fn test_device_placement_from_device_id() {
+  assert_eq!(DevicePlacement::from(-1), DevicePlacement::Default);
+  assert_eq!(DevicePlacement::from(1), DevicePlacement::Device(1));
+}
+
+#[test]
+fn test_device_placement_ignored_by_cpu_pipeline() {
+  assert_eq!(
+    DevicePlacement::Device(1).device_id(PacketPipeline::CPU),
+    -1
+  );
+  assert_eq!(
+    DevicePlacement::RoundRobin.device_id(PacketPipeline::CPU),
+    -1
+  );
+}
+
+#[test]
+#[cfg(feature = "opencl")]
+fn test_device_placement_device_id() {
+  assert_eq!(
+    DevicePlacement::Default.device_id(PacketPipeline::OpenCL),
+    -1
+  );
+  assert_eq!(
+    DevicePlacement::Device(2).device_id(PacketPipeline::OpenCL),
+    2
+  );
+}
@@ -0,0 +1,13 @@
+use crate::ffi::libfreenect2::LogLevel;
+use crate::util::logger::to_log_level;
+use log::LevelFilter;
+
+#[test]
+fn test_to_log_level() {
+  assert_eq!(to_log_level(LevelFilter::Off), LogLevel::None);
+  assert_eq!(to_log_level(LevelFilter::Error), LogLevel::Error);
+  assert_eq!(to_log_level(LevelFilter::Warn), LogLevel::Warning);
+  assert_eq!(to_log_level(LevelFilter::Info), LogLevel::Info);
+  assert_eq!(to_log_level(LevelFilter::Debug), LogLevel::Debug);
+  assert_eq!(to_log_level(LevelFilter::Trace), LogLevel::Debug);
+}
@@ -0,0 +1,193 @@
+#[cfg(debug_assertions)]
+use crate::async_frame_listener::{AsyncFrameListener, DispatchOptions};
+#[cfg(debug_assertions)]
+use crate::ffi;
+#[cfg(debug_assertions)]
+use crate::ffi::libfreenect2::call_frame_listener;
+#[cfg(debug_assertions)]
+use crate::frame::Frame;
+#[cfg(debug_assertions)]
+use crate::frame_type::FrameType;
+use crate::metrics::{DropReason, Histogram, HistogramSnapshot, Metrics, HISTOGRAM_BUCKETS};
+#[cfg(debug_assertions)]
+use crate::registration::{Registration, RegistrationEngine};
+use crate::types::frame_listener::FrameListener;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::time::Duration;
+
+#[test]
+fn test_histogram_buckets() {
+  let histogram = Histogram::default();
+  histogram.record(Duration::from_nanos(500));
+  histogram.record(Duration::from_micros(1));
+  histogram.record(Duration::from_micros(3));
+  histogram.record(Duration::from_micros(3));
+  histogram.record(Duration::from_secs(3600));
+
+  let snapshot = histogram.snapshot();
+  assert_eq!(snapshot.count, 5);
+  assert_eq!(snapshot.buckets[0], 1);
+  assert_eq!(snapshot.buckets[1], 1);
+  assert_eq!(snapshot.buckets[2], 2);
+  assert_eq!(snapshot.buckets[HISTOGRAM_BUCKETS - 1], 1);
+  assert_eq!(snapshot.buckets.iter().sum::<u64>(), 5);
+  assert_eq!(snapshot.max, Duration::from_secs(3600));
+
+  assert_eq!(
+    HistogramSnapshot::upper_bound(2),
+    Some(Duration::from_micros(4))
+  );
+  assert_eq!(HistogramSnapshot::upper_bound(HISTOGRAM_BUCKETS - 1), None);
+}
+
+#[test]
+fn test_histogram_quantile() {
+  let histogram = Histogram::default();
+  assert_eq!(histogram.snapshot().quantile(0.5), Duration::ZERO);
+  assert_eq!(histogram.snapshot().mean(), Duration::ZERO);
+
+  for _ in 0..99 {
+    histogram.record(Duration::from_micros(10));
+  }
+  histogram.record(Duration::from_millis(5));
+
+  let snapshot = histogram.snapshot();
+  assert_eq!(snapshot.quantile(0.5), Duration::from_micros(16));
+  assert_eq!(snapshot.quantile(0.99), Duration::from_micros(16));
+  assert_eq!(snapshot.quantile(1.0), Duration::from_millis(5));
+  assert_eq!(
+    snapshot.mean(),
+    (Duration::from_micros(990) + Duration::from_millis(5)) / 100
+  );
+}
+
+#[test]
+fn test_metrics_prometheus() {
+  let metrics = Metrics::new();
+  metrics.record_callback(Duration::from_micros(3), false);
+  metrics.record_callback(Duration::from_micros(3), true);
+  metrics.record_drops(DropReason::QueueFull, 2);
+
+  let snapshot = metrics.snapshot();
+  assert_eq!(snapshot.callback.count, 2);
+  assert_eq!(snapshot.failed, 1);
+  assert_eq!(snapshot.dropped(DropReason::QueueFull), 2);
+  assert_eq!(snapshot.dropped(DropReason::Coalesced), 0);
+
+  let text = snapshot.to_prometheus("test");
+  assert!(text.contains("# TYPE test_callback_seconds histogram\n"));
+  assert!(text.contains("test_callback_seconds_bucket{le=\"0.000002\"} 0\n"));
+  assert!(text.contains("test_callback_seconds_bucket{le=\"0.000004\"} 2\n"));
+  assert!(text.contains("test_callback_seconds_bucket{le=\"+Inf\"} 2\n"));
+  assert!(text.contains("test_callback_seconds_count 2\n"));
+  assert!(text.contains("test_failed_total 1\n"));
+  assert!(text.contains("test_dropped_total{reason=\"queue_full\"} 2\n"));
+  assert!(text.contains("test_frames_total{type=\"color\"} 0\n"));
+}
+
+#[test]
+fn test_metrics_instrument_without_frames() {
+  let metrics = Metrics::new();
+  FrameListener::new(metrics.instrument(|_, _| Ok(()))).unwrap();
+
+  let snapshot = metrics.snapshot();
+  assert_eq!(snapshot.callback.count, 0);
+  assert_eq!(snapshot.color_frames + snapshot.depth_frames, 0);
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_metrics_instrument() {
+  let metrics = Metrics::new();
+  let mut listener = FrameListener::new(metrics.instrument(|ty, _| match ty {
+    FrameType::Color => Ok(()),
+    _ => anyhow::bail!("Test"),
+  }))
+  .unwrap();
+
+  let mut data = vec![1, 2, 3, 4];
+  for ty in [FrameType::Color, FrameType::Color, FrameType::Depth] {
+    let _ = unsafe { call_frame_listener(&mut listener.0, ty.into(), 1, 2, 2, data.as_mut_ptr()) };
+  }
+
+  let snapshot = metrics.snapshot();
+  assert_eq!(snapshot.color_frames, 2);
+  assert_eq!(snapshot.depth_frames, 1);
+  assert_eq!(snapshot.ir_frames, 0);
+  assert_eq!(snapshot.failed, 1);
+  assert_eq!(snapshot.callback.count, 3);
+  assert_eq!(snapshot.decode_to_callback.count, 3);
+  assert_eq!(snapshot.queue_wait.count, 0);
+}
+
+#[test]
+fn test_metrics_instrument_without_clone() {
+  // Owns a value which is not Clone
+  let calls = AtomicUsize::new(0);
+  FrameListener::new(Metrics::new().instrument(move |_, _| {
+    calls.fetch_add(1, Ordering::Relaxed);
+    Ok(())
+  }))
+  .unwrap();
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_metrics_async_frame_listener() {
+  let metrics = Metrics::new();
+  let options = DispatchOptions {
+    queue_capacity: 16,
+    metrics: Some(metrics.clone()),
+    ..Default::default()
+  };
+
+  let mut listener = AsyncFrameListener::new(options, |_, _| Ok(())).unwrap();
+
+  let mut data = vec![1, 2, 3, 4];
+  for _ in 0..4 {
+    unsafe {
+      call_frame_listener(
+        &mut listener.listener.as_mut().unwrap().0,
+        FrameType::Ir.into(),
+        1,
+        2,
+        2,
+        data.as_mut_ptr(),
+      )
+      .unwrap();
+    }
+  }
+
+  // Dropping the listener processes all frames still waiting
+  drop(listener);
+  let snapshot = metrics.snapshot();
+  assert_eq!(snapshot.ir_frames, 4);
+  assert_eq!(snapshot.queue_wait.count, 4);
+  assert_eq!(snapshot.callback.count, 4);
+  assert_eq!(snapshot.dropped(DropReason::QueueFull), 0);
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_metrics_registration() {
+  let metrics = Metrics::new();
+  let mut registration = Registration::new(
+    ffi::libfreenect2::create_registration(RegistrationEngine::Libfreenect2, 1).unwrap(),
+  );
+
+  let depth = Frame::depth();
+  let mut undistorted = Frame::depth();
+  registration
+    .undistort_depth(&depth, &mut undistorted)
+    .unwrap();
+  assert_eq!(metrics.snapshot().registration.count, 0);
+
+  registration.set_metrics(Some(metrics.clone()));
+  registration
+    .undistort_depth(&depth, &mut undistorted)
+    .unwrap();
+  registration
+    .undistort_depth(&depth, &mut undistorted)
+    .unwrap();
+  assert_eq!(metrics.snapshot().registration.count, 2);
+}
@@ -1,3 +1,133 @@
+mod async_frame_listener;
+mod bounded_queue;
+mod capture;
+mod color_decoder;
 mod config;
+mod depth_codec;
+mod depth_post_processor;
+mod device_group;
+mod frame;
+mod frame_convert;
 mod frame_listener;
+mod frame_stream;
+mod frame_synchronizer;
+mod frame_view;
 mod freenect2;
+mod gpu_device;
+mod logger;
+mod metrics;
+mod raw_packet;
+mod registration;
+mod registration_tables;
+mod replay_device;
+mod shared_memory;
+mod thread_policy;
+mod usb_transfers;
+
+use crate::ffi;
+use crate::frame::{Frame, FrameFormat, Freenect2Frame, OwnedFrame};
+
+/// Builds [`OwnedFrame`]s for tests.
+/// The metadata is zeroed unless set and the height is derived from the data.
+#[derive(Clone, Copy)]
+pub(crate) struct FrameBuilder {
+  width: u64,
+  bytes_per_pixel: u64,
+  timestamp: u32,
+  sequence: u32,
+  exposure: f32,
+  gain: f32,
+  gamma: f32,
+  status: u32,
+  format: FrameFormat,
+}
+
+impl FrameBuilder {
+  /// Create a builder for frames with 4 bytes per pixel.
+  pub(crate) fn new(width: u64, format: FrameFormat) -> Self {
+    Self {
+      width,
+      bytes_per_pixel: 4,
+      timestamp: 0,
+      sequence: 0,
+      exposure: 0.0,
+      gain: 0.0,
+      gamma: 0.0,
+      status: 0,
+      format,
+    }
+  }
+
+  /// Create a builder for raw packets, which are a single row of bytes.
+  pub(crate) fn packet(len: usize) -> Self {
+    Self {
+      bytes_per_pixel: 1,
+      ..Self::new(len as _, FrameFormat::Raw)
+    }
+  }
+
+  pub(crate) fn timestamp(self, timestamp: u32) -> Self {
+    Self { timestamp, ..self }
+  }
+
+  pub(crate) fn sequence(self, sequence: u32) -> Self {
+    Self { sequence, ..self }
+  }
+
+  /// Set the exposure, gain and gamma of the color camera.
+  pub(crate) fn camera(self, exposure: f32, gain: f32, gamma: f32) -> Self {
+    Self {
+      exposure,
+      gain,
+      gamma,
+      ..self
+    }
+  }
+
+  pub(crate) fn status(self, status: u32) -> Self {
+    Self { status, ..self }
+  }
+
+  /// Build a frame holding a copy of `data`.
+  pub(crate) fn build(self, mut data: Vec<u8>) -> OwnedFrame {
+    self.build_borrowed(&mut data).to_owned()
+  }
+
+  /// Build a native frame referencing `data`, without copying it.
+  pub(crate) fn build_borrowed(self, data: &mut [u8]) -> Frame<'_> {
+    Frame::new(unsafe {
+      ffi::libfreenect2::create_frame(
+        self.width,
+        data.len() as u64 / self.width / self.bytes_per_pixel,
+        self.bytes_per_pixel,
+        data.as_mut_ptr(),
+        self.timestamp,
+        self.sequence,
+        self.exposure,
+        self.gain,
+        self.gamma,
+        self.status,
+        self.format.into(),
+      )
+    })
+  }
+
+  /// Build a frame holding `values` in native byte order.
+  pub(crate) fn build_floats(self, values: &[f32]) -> OwnedFrame {
+    self.build(
+      values
+        .iter()
+        .flat_map(|value| value.to_ne_bytes())
+        .collect(),
+    )
+  }
+}
+
+/// Get the values of a [`FrameFormat::Float`] frame.
+pub(crate) fn float_values<F: Freenect2Frame>(frame: &F) -> Vec<f32> {
+  frame
+    .raw_data()
+    .chunks_exact(4)
+    .map(|bytes| f32::from_ne_bytes(bytes.try_into().unwrap()))
+    .collect()
+}
@@ -0,0 +1,62 @@
+use crate::frame::{Frame, OwnedFrame};
+use crate::freenect2::RawPackets;
+use crate::raw_packet::{is_raw_packet, jpeg_data};
+use crate::test::FrameBuilder;
+
+fn create_packet(data: Vec<u8>) -> OwnedFrame {
+  FrameBuilder::packet(data.len()).build(data)
+}
+
+#[test]
+fn test_raw_packets() {
+  assert_eq!(RawPackets::default(), RawPackets::None);
+  assert!(!RawPackets::None.includes_color());
+  assert!(RawPackets::Color.includes_color());
+  assert!(!RawPackets::Color.includes_depth());
+  assert!(RawPackets::Depth.includes_depth());
+  assert!(RawPackets::All.includes_color() && RawPackets::All.includes_depth());
+}
+
+#[test]
+fn test_jpeg_data() {
+  let packet = create_packet(vec![0xFF, 0xD8, 0xFF, 0xE0]);
+  assert!(is_raw_packet(&packet));
+  assert_eq!(jpeg_data(&packet).unwrap(), [0xFF, 0xD8, 0xFF, 0xE0]);
+
+  assert!(jpeg_data(&create_packet(vec![1, 2, 3, 4])).is_err());
+
+  let depth = Frame::depth();
+  assert!(!is_raw_packet(&depth));
+  assert!(jpeg_data(&depth).is_err());
+}
+
+#[test]
+#[cfg(feature = "image")]
+fn test_decode_color() {
+  use crate::frame::Freenect2Frame;
+  use crate::raw_packet::decode_color;
+  use image::{ImageFormat, Rgb, RgbImage};
+  use std::io::Cursor;
+
+  let image = RgbImage::from_pixel(16, 8, Rgb([200, 100, 50]));
+  let mut jpeg = Vec::new();
+  image
+    .write_to(&mut Cursor::new(&mut jpeg), ImageFormat::Jpeg)
+    .unwrap();
+
+  // The device pads packets after the end of the image
+  jpeg.extend_from_slice(&[0; 16]);
+  let packet = create_packet(jpeg);
+  assert_eq!(packet.raw_data_len(), packet.raw_data().len());
+
+  let decoded = decode_color(&packet).unwrap();
+  assert_eq!(decoded.dimensions(), (16, 8));
+  let pixel = decoded.get_pixel(4, 4);
+  assert!(pixel
+    .0
+    .iter()
+    .zip([200, 100, 50])
+    .all(|(a, b)| a.abs_diff(b) <= 4));
+
+  assert!(decode_color(&create_packet(vec![0xFF, 0xD8, 0, 0])).is_err());
+}
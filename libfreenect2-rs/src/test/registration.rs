@@ -0,0 +1,160 @@
+#![cfg(debug_assertions)]
+
+use crate::ffi;
+use crate::frame::{FrameFormat, Freenect2Frame};
+use crate::frame_view::Region;
+use crate::registration::{Registration, RegistrationEngine, MAX_POINTS};
+use crate::test::FrameBuilder;
+
+fn create_registration(engine: RegistrationEngine) -> Registration {
+  Registration::new(ffi::libfreenect2::create_registration(engine, 4).unwrap())
+}
+
+fn create_test_data() -> (Vec<u8>, Vec<u8>) {
+  let color_data = (0..1920u32 * 1080)
+    .flat_map(|i| i.wrapping_mul(2654435761).to_ne_bytes())
+    .collect::<Vec<_>>();
+  // A plane with a closer box in front of it and a few invalid pixels
+  let depth_data = (0..512u32 * 424)
+    .flat_map(|i| {
+      let (x, y) = (i % 512, i / 512);
+      let z = if i % 13 == 0 {
+        0.0
+      } else if (200..300).contains(&x) && (150..250).contains(&y) {
+        800.0
+      } else {
+        2000.0 + x as f32
+      };
+
+      z.to_ne_bytes()
+    })
+    .collect::<Vec<_>>();
+
+  (color_data, depth_data)
+}
+
+#[test]
+fn test_parallel_registration_matches_libfreenect2() {
+  let (mut color_data, mut depth_data) = create_test_data();
+  let color = FrameBuilder::new(1920, FrameFormat::RGBX).build_borrowed(&mut color_data);
+  let depth = FrameBuilder::new(512, FrameFormat::Float).build_borrowed(&mut depth_data);
+
+  let reference = create_registration(RegistrationEngine::Libfreenect2);
+  let parallel = create_registration(RegistrationEngine::Parallel);
+
+  for full_color in [false, true] {
+    for enable_filter in [false, true] {
+      let mut expected = reference.create_context(full_color, enable_filter);
+      let mut actual = parallel.create_context(full_color, enable_filter);
+
+      expected.process(&depth, &color).unwrap();
+      actual.process(&depth, &color).unwrap();
+
+      assert_eq!(
+        expected.undistorted_depth().raw_data(),
+        actual.undistorted_depth().raw_data()
+      );
+      assert_eq!(
+        expected.color_depth_image().raw_data(),
+        actual.color_depth_image().raw_data()
+      );
+      if full_color && enable_filter {
+        assert_eq!(
+          expected.big_depth().unwrap().raw_data(),
+          actual.big_depth().unwrap().raw_data()
+        );
+      }
+    }
+  }
+}
+
+#[test]
+fn test_get_points_xyz() {
+  let mut depth_data = (0..512u32 * 424)
+    .flat_map(|i| if i % 2 == 0 { 0.0f32 } else { 1500.0 }.to_ne_bytes())
+    .collect::<Vec<_>>();
+  let undistorted = FrameBuilder::new(512, FrameFormat::Float).build_borrowed(&mut depth_data);
+  let registration = create_registration(RegistrationEngine::Libfreenect2);
+
+  let mut points = vec![0.0; 3 * MAX_POINTS];
+  let count = registration
+    .get_points_xyz(&undistorted, &mut points, false)
+    .unwrap();
+  assert_eq!(count, MAX_POINTS);
+  assert!(points[0..3].iter().all(|v| v.is_nan()));
+  assert_eq!(points[5], 1.5);
+
+  let count = registration
+    .get_points_xyz(&undistorted, &mut points, true)
+    .unwrap();
+  assert_eq!(count, MAX_POINTS / 2);
+  assert!(points[..3 * count].chunks_exact(3).all(|p| p[2] == 1.5));
+
+  assert!(registration
+    .get_points_xyz(&undistorted, &mut points[1..], true)
+    .is_err());
+}
+
+#[test]
+fn test_map_depth_to_color_region() {
+  let (mut color_data, mut depth_data) = create_test_data();
+  let color = FrameBuilder::new(1920, FrameFormat::RGBX).build_borrowed(&mut color_data);
+  let depth = FrameBuilder::new(512, FrameFormat::Float).build_borrowed(&mut depth_data);
+  // Partially covers the box, which occludes parts of the plane
+  let region = Region::new(180, 120, 160, 90);
+
+  for engine in [
+    RegistrationEngine::Libfreenect2,
+    RegistrationEngine::Parallel,
+  ] {
+    let registration = create_registration(engine);
+
+    for enable_filter in [false, true] {
+      let mut expected = registration.create_context(false, enable_filter);
+      let mut actual = registration.create_context(false, enable_filter);
+
+      expected.process(&depth, &color).unwrap();
+      actual.process_region(&depth, &color, region).unwrap();
+
+      let expected_image = expected.color_depth_image().view(region).unwrap();
+      let actual_image = actual.color_depth_image().view(region).unwrap();
+      let expected_depth = expected.undistorted_depth().view(region).unwrap();
+      let actual_depth = actual.undistorted_depth().view(region).unwrap();
+      for y in 0..region.height as usize {
+        assert_eq!(expected_image.row(y), actual_image.row(y));
+        assert_eq!(expected_depth.row(y), actual_depth.row(y));
+      }
+
+      let mut expected_points = vec![0.0; 4 * MAX_POINTS];
+      let mut actual_points = vec![0.0; 4 * 160 * 90];
+      expected
+        .get_points_xyzrgb(&mut expected_points, false)
+        .unwrap();
+      let count = actual
+        .get_points_xyzrgb_region(region, &mut actual_points, false)
+        .unwrap();
+      assert_eq!(count, 160 * 90);
+      for (i, point) in actual_points.chunks_exact(4).enumerate() {
+        let (x, y) = (180 + i % 160, 120 + i / 160);
+        let reference = &expected_points[4 * (y * 512 + x)..][..4];
+        assert_eq!(
+          point.iter().map(|v| v.to_bits()).collect::<Vec<_>>(),
+          reference.iter().map(|v| v.to_bits()).collect::<Vec<_>>()
+        );
+      }
+    }
+  }
+
+  let registration = create_registration(RegistrationEngine::Parallel);
+  let mut context = registration.create_context(false, true);
+  assert!(context
+    .process_region(&depth, &color, Region::new(500, 0, 13, 1))
+    .is_err());
+  assert!(context
+    .get_points_xyz_region(region, &mut vec![0.0; 3 * 160 * 90 - 1], true)
+    .is_err());
+  assert!(registration
+    .create_context(true, true)
+    .process_region(&depth, &color, region)
+    .is_err());
+}
@@ -0,0 +1,166 @@
+#![cfg(debug_assertions)]
+
+use crate::ffi;
+use crate::frame::{FrameFormat, Freenect2Frame};
+use crate::registration::{Registration, RegistrationEngine};
+use crate::registration_tables::{
+  CameraParams, ColorCameraParams, IrCameraParams, RegistrationCache, RegistrationTables,
+};
+use crate::test::FrameBuilder;
+
+// The same factory calibration as the registrations created in test/registration.rs
+fn camera_params() -> CameraParams {
+  CameraParams {
+    ir: IrCameraParams {
+      fx: 365.481,
+      fy: 365.481,
+      cx: 257.346,
+      cy: 210.347,
+      k1: 0.089026,
+      k2: -0.271706,
+      k3: 0.0982151,
+      p1: 0.0,
+      p2: 0.0,
+    },
+    color: ColorCameraParams {
+      fx: 1081.37,
+      fy: 1081.37,
+      cx: 959.5,
+      cy: 539.5,
+      shift_d: 863.0,
+      shift_m: 52.0,
+      mx_x3y0: 0.000449294,
+      mx_x0y3: 0.000212355,
+      mx_x2y1: -7.81315e-05,
+      mx_x1y2: 0.000120644,
+      mx_x2y0: 0.000629924,
+      mx_x0y2: 0.000195935,
+      mx_x1y1: -0.000177962,
+      mx_x1y0: 0.635754,
+      mx_x0y1: 0.00164808,
+      mx_x0y0: 0.0860757,
+      my_x3y0: 0.00011546,
+      my_x0y3: 0.000337897,
+      my_x2y1: -5.18717e-05,
+      my_x1y2: 0.000178651,
+      my_x2y0: -4.59245e-05,
+      my_x0y2: -0.000617467,
+      my_x1y1: 0.000577111,
+      my_x1y0: 0.00168652,
+      my_x0y1: 0.633103,
+      my_x0y0: 0.086348,
+    },
+  }
+}
+
+fn cache_dir(name: &str) -> std::path::PathBuf {
+  std::env::temp_dir().join(format!(
+    "libfreenect2-rs-registration-{}-{}",
+    std::process::id(),
+    name
+  ))
+}
+
+#[test]
+fn test_serialize_registration_tables() {
+  let tables = RegistrationTables::new(&camera_params()).unwrap();
+  assert_eq!(tables.camera_params(), camera_params());
+
+  let data = tables.to_bytes();
+  let loaded = RegistrationTables::from_bytes(&data).unwrap();
+  assert_eq!(loaded.camera_params(), camera_params());
+  assert_eq!(loaded.to_bytes(), data);
+
+  assert!(RegistrationTables::from_bytes(&[]).is_err());
+  assert!(RegistrationTables::from_bytes(&data[..data.len() - 1]).is_err());
+
+  let mut corrupted = data.clone();
+  corrupted[0] ^= 0xFF;
+  assert!(RegistrationTables::from_bytes(&corrupted).is_err());
+
+  // An index outside of the depth frame in the distort map
+  let mut corrupted = data;
+  corrupted[164..168].copy_from_slice(&(512 * 424).to_ne_bytes());
+  assert!(RegistrationTables::from_bytes(&corrupted).is_err());
+}
+
+#[test]
+fn test_registration_from_tables_matches_libfreenect2() {
+  let mut color_data = (0..1920u32 * 1080)
+    .flat_map(|i| i.wrapping_mul(2654435761).to_ne_bytes())
+    .collect::<Vec<_>>();
+  let mut depth_data = (0..512u32 * 424)
+    .flat_map(|i| {
+      if i % 7 == 0 {
+        0.0
+      } else {
+        1000.0 + (i % 512) as f32
+      }
+      .to_ne_bytes()
+    })
+    .collect::<Vec<_>>();
+
+  let color = FrameBuilder::new(1920, FrameFormat::RGBX).build_borrowed(&mut color_data);
+  let depth = FrameBuilder::new(512, FrameFormat::Float).build_borrowed(&mut depth_data);
+
+  let reference = Registration::new(
+    ffi::libfreenect2::create_registration(RegistrationEngine::Libfreenect2, 1).unwrap(),
+  );
+  let tables = RegistrationTables::from_bytes(
+    &RegistrationTables::new(&camera_params())
+      .unwrap()
+      .to_bytes(),
+  )
+  .unwrap();
+
+  for engine in [
+    RegistrationEngine::Libfreenect2,
+    RegistrationEngine::Parallel,
+  ] {
+    let registration = tables.create_registration(engine, 4).unwrap();
+
+    let mut expected = reference.create_context(true, true);
+    let mut actual = registration.create_context(true, true);
+    expected.process(&depth, &color).unwrap();
+    actual.process(&depth, &color).unwrap();
+
+    assert_eq!(
+      expected.undistorted_depth().raw_data(),
+      actual.undistorted_depth().raw_data()
+    );
+    assert_eq!(
+      expected.color_depth_image().raw_data(),
+      actual.color_depth_image().raw_data()
+    );
+    assert_eq!(
+      expected.big_depth().unwrap().raw_data(),
+      actual.big_depth().unwrap().raw_data()
+    );
+  }
+}
+
+#[test]
+fn test_registration_cache() {
+  let dir = cache_dir("cache");
+  let cache = RegistrationCache::new(&dir);
+  assert!(cache.load("012345678912").unwrap().is_none());
+
+  let tables = RegistrationTables::new(&camera_params()).unwrap();
+  cache.store("012345678912", &tables).unwrap();
+  assert!(cache.path("012345678912").unwrap().exists());
+
+  let loaded = cache.load("012345678912").unwrap().unwrap();
+  assert_eq!(loaded.to_bytes(), tables.to_bytes());
+  assert!(cache.load("other").unwrap().is_none());
+
+  // A corrupted entry is an error and not silently recomputed
+  std::fs::write(cache.path("corrupted").unwrap(), [0; 16]).unwrap();
+  assert!(cache.load("corrupted").is_err());
+
+  for invalid in ["", "..", "a/b", "a\\b", "a.b"] {
+    assert!(cache.load(invalid).is_err());
+    assert!(cache.store(invalid, &tables).is_err());
+  }
+
+  std::fs::remove_dir_all(dir).unwrap();
+}
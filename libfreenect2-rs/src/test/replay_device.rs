@@ -0,0 +1,219 @@
+use crate::frame::{FrameFormat, Freenect2Frame, OwnedFrame};
+use crate::frame_listener::FrameListener;
+use crate::frame_type::FrameType;
+use crate::replay_device::{FrameRecording, ReplayDevice, ReplayOptions, ReplayRate};
+use crate::test::FrameBuilder;
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+fn create_frame(timestamp: u32, sequence: u32, value: u8) -> OwnedFrame {
+  FrameBuilder::new(2, FrameFormat::Float)
+    .timestamp(timestamp)
+    .sequence(sequence)
+    .build(vec![value; 4 * 2 * 2])
+}
+
+type Received = Arc<Mutex<Vec<(FrameType, u32, u32, u8)>>>;
+
+fn create_listener() -> (FrameListener<'static>, Received) {
+  let received = Received::default();
+  let listener = FrameListener::new({
+    let received = received.clone();
+    move |ty, frame| {
+      received
+        .lock()
+        .unwrap()
+        .push((ty, frame.timestamp(), frame.sequence(), frame.raw_data()[0]));
+      Ok(())
+    }
+  })
+  .unwrap();
+
+  (listener, received)
+}
+
+fn recording() -> FrameRecording<OwnedFrame> {
+  FrameRecording::new(vec![
+    (FrameType::Color, create_frame(100, 1, 1)),
+    (FrameType::Depth, create_frame(110, 7, 2)),
+    (FrameType::Ir, create_frame(110, 7, 3)),
+    (FrameType::Color, create_frame(366, 2, 4)),
+  ])
+}
+
+const UNTHROTTLED: ReplayOptions = ReplayOptions {
+  rate: ReplayRate::Unthrottled,
+  looped: false,
+};
+
+#[test]
+fn test_replay_frames_in_order() {
+  let (color, color_frames) = create_listener();
+  let (depth, depth_frames) = create_listener();
+
+  let mut device = ReplayDevice::new(recording(), UNTHROTTLED);
+  device.set_color_frame_listener(&color).unwrap();
+  device.set_ir_and_depth_frame_listener(&depth).unwrap();
+
+  device.start().unwrap();
+  device.wait().unwrap();
+  assert!(!device.is_started());
+  assert_eq!(device.frames_replayed(), 4);
+
+  assert_eq!(
+    *color_frames.lock().unwrap(),
+    [(FrameType::Color, 100, 1, 1), (FrameType::Color, 366, 2, 4)]
+  );
+  assert_eq!(
+    *depth_frames.lock().unwrap(),
+    [(FrameType::Depth, 110, 7, 2), (FrameType::Ir, 110, 7, 3)]
+  );
+}
+
+#[test]
+fn test_replay_keeps_frames() {
+  let frames = Arc::new(Mutex::new(Vec::new()));
+  let listener = FrameListener::new({
+    let frames = frames.clone();
+    move |_, frame| {
+      frames.lock().unwrap().push(frame);
+      Ok(())
+    }
+  })
+  .unwrap();
+
+  let mut device = ReplayDevice::new(recording(), UNTHROTTLED);
+  device.set_color_frame_listener(&listener).unwrap();
+  device.start().unwrap();
+  device.wait().unwrap();
+  drop(device);
+
+  let frames = frames.lock().unwrap();
+  assert_eq!(frames.len(), 2);
+  assert_eq!(frames[1].raw_data(), [4; 16]);
+}
+
+#[test]
+fn test_replay_streams() {
+  let (listener, received) = create_listener();
+
+  let mut device = ReplayDevice::new(recording(), UNTHROTTLED);
+  device.set_color_frame_listener(&listener).unwrap();
+  device.set_ir_and_depth_frame_listener(&listener).unwrap();
+
+  device.start_streams(false, true).unwrap();
+  device.wait().unwrap();
+
+  let received = received.lock().unwrap();
+  assert!(received.iter().all(|(ty, ..)| *ty != FrameType::Color));
+  assert_eq!(received.len(), 2);
+  assert!(device.start_streams(false, false).is_err());
+}
+
+#[test]
+fn test_replay_real_time() {
+  let (listener, received) = create_listener();
+  let mut device = ReplayDevice::new(recording(), ReplayOptions::default());
+  device.set_color_frame_listener(&listener).unwrap();
+
+  // The last frame is 266 ticks, about 33ms, after the first one
+  let start = Instant::now();
+  device.start().unwrap();
+  device.wait().unwrap();
+
+  assert!(start.elapsed() >= Duration::from_millis(33));
+  assert_eq!(received.lock().unwrap().len(), 2);
+}
+
+#[test]
+fn test_replay_looped() {
+  let (listener, received) = create_listener();
+  let mut device = ReplayDevice::new(
+    recording(),
+    ReplayOptions {
+      rate: ReplayRate::Speed(10.0),
+      looped: true,
+    },
+  );
+  device.set_ir_and_depth_frame_listener(&listener).unwrap();
+
+  device.start().unwrap();
+  std::thread::sleep(Duration::from_millis(50));
+  assert!(!device.is_finished());
+  device.stop().unwrap();
+
+  assert!(device.frames_replayed() > 4);
+  assert!(received.lock().unwrap().len() > 2);
+}
+
+#[test]
+fn test_replay_resumes_after_stop() {
+  let (listener, received) = create_listener();
+  // 80 ticks are 10ms, so stopping interrupts the wait for a frame
+  let frames = (0..20)
+    .map(|i| (FrameType::Depth, create_frame(i * 80, i, i as u8)))
+    .collect::<Vec<_>>();
+  let mut device = ReplayDevice::new(FrameRecording::new(frames), ReplayOptions::default());
+  device.set_ir_and_depth_frame_listener(&listener).unwrap();
+
+  for _ in 0..3 {
+    device.start().unwrap();
+    std::thread::sleep(Duration::from_millis(35));
+    device.stop().unwrap();
+  }
+  device.start().unwrap();
+  device.wait().unwrap();
+
+  let sequences = received
+    .lock()
+    .unwrap()
+    .iter()
+    .map(|(_, _, sequence, _)| *sequence)
+    .collect::<Vec<_>>();
+  assert_eq!(sequences, (0..20).collect::<Vec<_>>());
+  assert_eq!(device.frames_replayed(), 20);
+}
+
+#[test]
+fn test_replay_empty_looped() {
+  let mut device = ReplayDevice::new(
+    FrameRecording::<OwnedFrame>::default(),
+    ReplayOptions {
+      rate: ReplayRate::Unthrottled,
+      looped: true,
+    },
+  );
+
+  device.start().unwrap();
+  device.wait().unwrap();
+  assert_eq!(device.frames_replayed(), 0);
+}
+
+#[test]
+fn test_replay_invalid_state() {
+  let (listener, _) = create_listener();
+  let mut device = ReplayDevice::new(
+    recording(),
+    ReplayOptions {
+      rate: ReplayRate::Speed(0.0),
+      looped: false,
+    },
+  );
+  assert!(device.start().is_err());
+  assert!(device.stop().is_err());
+
+  let mut device = ReplayDevice::new(
+    recording(),
+    ReplayOptions {
+      rate: ReplayRate::RealTime,
+      looped: true,
+    },
+  );
+  device.start().unwrap();
+  assert!(device.start().is_err());
+  assert!(device.set_color_frame_listener(&listener).is_err());
+  assert!(device.rewind().is_err());
+
+  device.stop().unwrap();
+  device.rewind().unwrap();
+}
@@ -0,0 +1,205 @@
+#[cfg(debug_assertions)]
+use crate::ffi::libfreenect2::call_frame_listener;
+use crate::frame::{FrameFormat, Freenect2Frame, OwnedFrame};
+#[cfg(debug_assertions)]
+use crate::frame_listener::AsFrameListener;
+use crate::frame_type::FrameType;
+use crate::shared_memory::{SharedMemoryOptions, SharedMemoryPublisher, SharedMemorySubscriber};
+use crate::test::FrameBuilder;
+use std::time::{Duration, Instant};
+
+fn ring_name(name: &str) -> String {
+  format!("libfreenect2-rs-{}-{}", std::process::id(), name)
+}
+
+fn options(slot_count: usize) -> SharedMemoryOptions {
+  SharedMemoryOptions {
+    slot_count,
+    max_frame_len: 256,
+  }
+}
+
+fn create_frame(width: u64, sequence: u32, format: FrameFormat) -> OwnedFrame {
+  FrameBuilder::new(width, format)
+    .timestamp(sequence * 266)
+    .sequence(sequence)
+    .camera(1.5, 2.0, 2.5)
+    .status(3)
+    .build(
+      (0..width * 8)
+        .map(|i| (i as u32 + sequence) as u8)
+        .collect(),
+    )
+}
+
+fn assert_frame_eq<F: Freenect2Frame>(frame: &F, expected: &OwnedFrame) {
+  assert_eq!(frame.width(), expected.width());
+  assert_eq!(frame.height(), expected.height());
+  assert_eq!(frame.bytes_per_pixel(), expected.bytes_per_pixel());
+  assert_eq!(frame.timestamp(), expected.timestamp());
+  assert_eq!(frame.sequence(), expected.sequence());
+  assert_eq!(frame.exposure(), expected.exposure());
+  assert_eq!(frame.gain(), expected.gain());
+  assert_eq!(frame.gamma(), expected.gamma());
+  assert_eq!(frame.status(), expected.status());
+  assert_eq!(frame.format(), expected.format());
+  assert_eq!(frame.raw_data(), expected.raw_data());
+}
+
+#[test]
+fn test_publish_and_subscribe() {
+  let name = ring_name("publish");
+  let publisher = SharedMemoryPublisher::create(&name, options(4)).unwrap();
+  let mut subscribers = [
+    SharedMemorySubscriber::open(&name).unwrap(),
+    SharedMemorySubscriber::open(&name).unwrap(),
+  ];
+
+  let frames = vec![
+    (FrameType::Color, create_frame(3, 1, FrameFormat::BGRX)),
+    (FrameType::Depth, create_frame(5, 2, FrameFormat::Float)),
+    (FrameType::Ir, create_frame(5, 2, FrameFormat::Float)),
+  ];
+  for (ty, frame) in &frames {
+    publisher.publish(*ty, frame).unwrap();
+  }
+  assert_eq!(publisher.frames_published(), 3);
+
+  for subscriber in &mut subscribers {
+    for (ty, expected) in &frames {
+      let (received_ty, frame) = subscriber.try_next().unwrap();
+      assert_eq!(received_ty, *ty);
+      assert_frame_eq(&frame, expected);
+      assert!(frame.is_valid());
+    }
+
+    assert!(subscriber.try_next().is_none());
+    assert_eq!(subscriber.skipped_count(), 0);
+    assert_eq!(subscriber.slot_count(), 4);
+  }
+
+  // Only frames published after opening are returned, except for the latest one
+  let mut late = SharedMemorySubscriber::open(&name).unwrap();
+  assert!(late.try_next().is_none());
+  let (ty, frame) = late.latest().unwrap();
+  assert_eq!(ty, FrameType::Ir);
+  assert_frame_eq(&frame, &frames[2].1);
+}
+
+#[test]
+fn test_slow_subscriber() {
+  let name = ring_name("slow");
+  let publisher = SharedMemoryPublisher::create(&name, options(2)).unwrap();
+  let mut subscriber = SharedMemorySubscriber::open(&name).unwrap();
+
+  for sequence in 0..5 {
+    publisher
+      .publish(
+        FrameType::Depth,
+        &create_frame(4, sequence, FrameFormat::Float),
+      )
+      .unwrap();
+  }
+
+  // The frames which were overwritten are skipped
+  let (_, oldest) = subscriber.try_next().unwrap();
+  assert_eq!(oldest.sequence(), 3);
+  let (_, newest) = subscriber.try_next().unwrap();
+  assert_eq!(newest.sequence(), 4);
+  assert!(subscriber.try_next().is_none());
+  assert_eq!(subscriber.skipped_count(), 3);
+
+  // Frames which are still referenced are overwritten too
+  publisher
+    .publish(FrameType::Depth, &create_frame(4, 5, FrameFormat::Float))
+    .unwrap();
+  assert!(!oldest.is_valid());
+  assert!(newest.is_valid());
+
+  let mut data = Vec::new();
+  assert!(!oldest.read_into(&mut data));
+  assert!(oldest.to_owned_checked().is_none());
+  assert!(newest.read_into(&mut data));
+  assert_eq!(data, create_frame(4, 4, FrameFormat::Float).raw_data());
+  assert_frame_eq(
+    &newest.to_owned_checked().unwrap(),
+    &create_frame(4, 4, FrameFormat::Float),
+  );
+  assert_eq!(subscriber.try_next().unwrap().1.sequence(), 5);
+}
+
+#[test]
+fn test_closed_publisher() {
+  let name = ring_name("closed");
+  let publisher = SharedMemoryPublisher::create(&name, options(2)).unwrap();
+  let mut subscriber = SharedMemorySubscriber::open(&name).unwrap();
+
+  let expected = create_frame(2, 1, FrameFormat::Gray);
+  publisher.publish(FrameType::Color, &expected).unwrap();
+  let (_, frame) = subscriber.try_next().unwrap();
+  assert!(!subscriber.is_closed());
+
+  drop(publisher);
+  assert!(subscriber.is_closed());
+  assert!(SharedMemorySubscriber::open(&name).is_err());
+
+  // The mapping stays valid after the ring was removed
+  assert_frame_eq(&frame, &expected);
+  assert!(frame.is_valid());
+
+  let start = Instant::now();
+  assert!(subscriber.next_timeout(Duration::from_secs(10)).is_none());
+  assert!(start.elapsed() < Duration::from_secs(5));
+}
+
+#[test]
+fn test_invalid_options() {
+  let name = ring_name("invalid");
+  assert!(SharedMemoryPublisher::create(&name, options(0)).is_err());
+  assert!(SharedMemoryPublisher::create(
+    &name,
+    SharedMemoryOptions {
+      max_frame_len: 0,
+      ..Default::default()
+    }
+  )
+  .is_err());
+
+  for invalid in ["", "..", "a/b", "a\\b"] {
+    assert!(SharedMemoryPublisher::create(invalid, options(1)).is_err());
+    assert!(SharedMemorySubscriber::open(invalid).is_err());
+  }
+  assert!(SharedMemorySubscriber::open(&name).is_err());
+
+  // Frames larger than a slot are rejected
+  let publisher = SharedMemoryPublisher::create(&name, options(1)).unwrap();
+  assert!(publisher
+    .publish(FrameType::Color, &create_frame(40, 0, FrameFormat::BGRX))
+    .is_err());
+  assert_eq!(publisher.frames_published(), 0);
+}
+
+#[test]
+#[cfg(debug_assertions)]
+fn test_shared_memory_frame_listener() {
+  let name = ring_name("frame-listener");
+  let publisher = SharedMemoryPublisher::create(&name, options(2)).unwrap();
+  let mut subscriber = SharedMemorySubscriber::open(&name).unwrap();
+
+  let mut data = vec![1, 2, 3, 4];
+  unsafe {
+    call_frame_listener(
+      &publisher.as_frame_listener().0,
+      FrameType::Color.into(),
+      1,
+      2,
+      2,
+      data.as_mut_ptr(),
+    )
+    .unwrap();
+  }
+
+  let (ty, frame) = subscriber.try_next().unwrap();
+  assert_eq!(ty, FrameType::Color);
+  assert_eq!(frame.raw_data(), [1, 2, 3, 4]);
+}
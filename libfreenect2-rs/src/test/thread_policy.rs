@@ -0,0 +1,101 @@
+#![cfg(target_os = "linux")]
+
+use crate::thread_policy::{current_thread_cpus, numa_node_cpus, SchedulingPolicy, ThreadPolicy};
+use std::path::Path;
+
+#[test]
+fn test_default_thread_policy() {
+  let cpus = current_thread_cpus().unwrap();
+  assert!(!cpus.is_empty());
+
+  let guard = ThreadPolicy::default().enter().unwrap();
+  assert_eq!(current_thread_cpus().unwrap(), cpus);
+  drop(guard);
+  assert_eq!(current_thread_cpus().unwrap(), cpus);
+}
+
+#[test]
+fn test_pinned_thread_policy() {
+  let cpus = current_thread_cpus().unwrap();
+  let pinned = vec![cpus[cpus.len() - 1]];
+
+  let guard = ThreadPolicy::pinned(&pinned).enter().unwrap();
+  assert_eq!(current_thread_cpus().unwrap(), pinned);
+
+  // Threads started while the policy is entered keep it
+  let child = std::thread::spawn(current_thread_cpus);
+  assert_eq!(child.join().unwrap().unwrap(), pinned);
+
+  drop(guard);
+  assert_eq!(current_thread_cpus().unwrap(), cpus);
+}
+
+#[test]
+fn test_apply_thread_policy_to_current_thread() {
+  let cpus = current_thread_cpus().unwrap();
+  let pinned = vec![cpus[0]];
+
+  let actual = std::thread::spawn(move || {
+    ThreadPolicy {
+      cpus: pinned,
+      scheduling: SchedulingPolicy::Other,
+      priority: 1,
+      numa_node: -1,
+    }
+    .apply_to_current_thread()
+    .unwrap();
+
+    current_thread_cpus().unwrap()
+  });
+
+  assert_eq!(actual.join().unwrap(), vec![cpus[0]]);
+  assert_eq!(current_thread_cpus().unwrap(), cpus);
+}
+
+#[test]
+fn test_invalid_thread_policy() {
+  let cpus = current_thread_cpus().unwrap();
+
+  let invalid = [
+    ThreadPolicy::pinned(&[1 << 20]),
+    ThreadPolicy::numa_local(1 << 20),
+    ThreadPolicy {
+      cpus: vec![cpus[0]],
+      scheduling: SchedulingPolicy::Other,
+      priority: 20,
+      numa_node: -1,
+    },
+    ThreadPolicy {
+      scheduling: SchedulingPolicy::Fifo,
+      priority: 0,
+      ..Default::default()
+    },
+  ];
+
+  // Failing to apply a policy leaves the thread unchanged
+  for policy in invalid {
+    assert!(policy.enter().is_err());
+    assert_eq!(current_thread_cpus().unwrap(), cpus);
+  }
+}
+
+#[test]
+fn test_numa_local_thread_policy() {
+  if !Path::new("/sys/devices/system/node/node0").exists() {
+    return;
+  }
+
+  let cpus = current_thread_cpus().unwrap();
+  let node_cpus = numa_node_cpus(0).unwrap();
+  assert!(numa_node_cpus(1 << 20).is_err());
+
+  let guard = ThreadPolicy::numa_local(0).enter().unwrap();
+  // The kernel drops the CPUs outside of the cpuset of the process
+  assert!(current_thread_cpus()
+    .unwrap()
+    .iter()
+    .all(|cpu| node_cpus.is_empty() || node_cpus.contains(cpu)));
+
+  drop(guard);
+  assert_eq!(current_thread_cpus().unwrap(), cpus);
+}
@@ -0,0 +1,84 @@
+#![cfg(debug_assertions)]
+
+use crate::ffi;
+use crate::usb_transfers::{PacketStats, StreamStats, UsbTransferConfig};
+
+#[test]
+fn test_count_lost_packets() {
+  let stats = ffi::libfreenect2::count_packets(&[5, 6, 9, 10, 14]);
+  assert_eq!(
+    stats,
+    StreamStats {
+      frames: 5,
+      lost: 5,
+      gaps: 2,
+    }
+  );
+  assert_eq!(stats.loss_ratio(), 0.5);
+
+  // The sequence starts over when the stream is restarted
+  let stats = ffi::libfreenect2::count_packets(&[100, 101, 0, 1, 3]);
+  assert_eq!(stats.frames, 5);
+  assert_eq!(stats.lost, 1);
+  assert_eq!(stats.gaps, 1);
+
+  let stats = ffi::libfreenect2::count_packets(&[]);
+  assert_eq!(stats, StreamStats::default());
+  assert_eq!(stats.loss_ratio(), 0.0);
+}
+
+#[test]
+fn test_total_lost_packets() {
+  let stats = PacketStats {
+    color: ffi::libfreenect2::count_packets(&[0, 2]),
+    ir: ffi::libfreenect2::count_packets(&[0, 1, 4]),
+    depth: ffi::libfreenect2::count_packets(&[0, 1, 4]),
+  };
+  assert_eq!(stats.total_lost(), 1 + 2 + 2);
+}
+
+#[test]
+fn test_usb_transfer_config() {
+  let config = UsbTransferConfig {
+    rgb_transfer_size: 0x8000,
+    ir_transfers: 120,
+    ..Default::default()
+  };
+
+  let previous = [
+    "LIBFREENECT2_RGB_TRANSFER_SIZE",
+    "LIBFREENECT2_RGB_TRANSFERS",
+    "LIBFREENECT2_IR_TRANSFERS",
+  ]
+  .map(|name| std::env::var(name).ok());
+  {
+    let _scope = config.enter().unwrap();
+    assert_eq!(
+      std::env::var("LIBFREENECT2_RGB_TRANSFER_SIZE").unwrap(),
+      "32768"
+    );
+    assert_eq!(std::env::var("LIBFREENECT2_IR_TRANSFERS").unwrap(), "120");
+    assert_eq!(
+      std::env::var("LIBFREENECT2_RGB_TRANSFERS").ok(),
+      previous[1]
+    );
+  }
+
+  // The previous values are restored
+  assert_eq!(
+    [
+      "LIBFREENECT2_RGB_TRANSFER_SIZE",
+      "LIBFREENECT2_RGB_TRANSFERS",
+      "LIBFREENECT2_IR_TRANSFERS"
+    ]
+    .map(|name| std::env::var(name).ok()),
+    previous
+  );
+
+  assert!(UsbTransferConfig {
+    ir_packets_per_transfer: u32::MAX,
+    ..Default::default()
+  }
+  .enter()
+  .is_err());
+}
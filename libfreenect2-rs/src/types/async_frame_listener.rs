@@ -0,0 +1,305 @@
+use crate::frame_listener::{AsFrameListener, FrameListener};
+use crate::frame_pool::FramePool;
+use crate::metrics::{DropReason, Metrics};
+use crate::types::frame::Frame;
+use crate::types::frame_type::FrameType;
+use crate::util::bounded_queue::{BoundedQueue, DropPolicy};
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::Arc;
+use std::thread::JoinHandle;
+use std::time::Instant;
+
+const FRAME_TYPES: [FrameType; 3] = [FrameType::Color, FrameType::Depth, FrameType::Ir];
+
+/// Options for creating an [`AsyncFrameListener`].
+#[derive(Clone)]
+pub struct DispatchOptions {
+  /// The number of worker threads.
+  /// The default is 3, one worker per frame type.
+  pub workers: usize,
+  /// The worker each frame type is dispatched to.
+  /// Frame types not listed are assigned round-robin in the order
+  /// color, depth, IR. Frames of one type are always handled
+  /// by the same worker, so they are processed in order.
+  pub affinity: Vec<(FrameType, usize)>,
+  /// The maximum number of frames waiting per worker.
+  /// The default is 4.
+  pub queue_capacity: usize,
+  /// What to do if a frame is received while the queue of its worker is full.
+  /// [`DropPolicy::Block`] stalls the libfreenect2 processing thread,
+  /// which may cause packet loss. The default is [`DropPolicy::DropOldest`].
+  pub drop_policy: DropPolicy,
+  /// The pool to take frames from.
+  /// If set, frames waiting in a queue hold on to a pool frame.
+  pub pool: Option<FramePool>,
+  /// Record frame, queue wait, callback and drop metrics into this handle.
+  /// See [`Metrics`] for details. If [`None`], nothing is measured.
+  pub metrics: Option<Metrics>,
+}
+
+impl Default for DispatchOptions {
+  fn default() -> Self {
+    Self {
+      workers: FRAME_TYPES.len(),
+      affinity: Vec::new(),
+      queue_capacity: 4,
+      drop_policy: DropPolicy::default(),
+      pool: None,
+      metrics: None,
+    }
+  }
+}
+
+impl DispatchOptions {
+  /// Dispatch all frames of `frame_type` to `worker`.
+  pub fn with_affinity(mut self, frame_type: FrameType, worker: usize) -> Self {
+    self.affinity.retain(|(ty, _)| *ty != frame_type);
+    self.affinity.push((frame_type, worker));
+    self
+  }
+
+  fn worker_for(&self, frame_type: FrameType) -> usize {
+    self
+      .affinity
+      .iter()
+      .find(|(ty, _)| *ty == frame_type)
+      .map(|(_, worker)| *worker)
+      .unwrap_or_else(|| {
+        FRAME_TYPES.iter().position(|ty| *ty == frame_type).unwrap() % self.workers
+      })
+  }
+}
+
+/// Statistics of a single worker of an [`AsyncFrameListener`].
+/// Retrieved using [`AsyncFrameListener::statistics`].
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct WorkerStatistics {
+  /// The frame types dispatched to this worker.
+  pub frame_types: Vec<FrameType>,
+  /// The number of frames currently waiting.
+  pub queue_len: usize,
+  /// The largest number of frames that were waiting at once.
+  pub max_queue_len: usize,
+  /// The maximum number of frames that may be waiting.
+  pub queue_capacity: usize,
+  /// The number of frames passed to the closure.
+  pub processed: u64,
+  /// The number of frames for which the closure returned an error or panicked.
+  pub failed: u64,
+  /// The number of frames dropped because the queue was full.
+  pub dropped: u64,
+}
+
+struct Worker {
+  queue: BoundedQueue<(FrameType, Frame<'static>, Option<Instant>)>,
+  metrics: Option<Metrics>,
+  frame_types: Vec<FrameType>,
+  max_queue_len: AtomicUsize,
+  processed: AtomicU64,
+  failed: AtomicU64,
+}
+
+impl Worker {
+  fn run<F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()>>(&self, f: &F) {
+    while let Some((ty, frame, enqueued)) = self.queue.pop(None) {
+      let start = self.metrics.as_ref().map(|metrics| {
+        metrics.record_queue_wait(enqueued);
+        metrics.record_frame(ty, &frame);
+        Instant::now()
+      });
+
+      let res = catch_unwind(AssertUnwindSafe(|| f(ty, frame))).unwrap_or_else(|e| {
+        log::error!("Frame listener closure panicked: {:?}", e);
+        Err(anyhow::anyhow!("{:?}", e))
+      });
+
+      if let (Some(metrics), Some(start)) = (&self.metrics, start) {
+        metrics.record_callback(start.elapsed(), res.is_err());
+      }
+
+      if let Err(e) = res {
+        log::error!("Failed to process {:?} frame: {}", ty, e);
+        self.failed.fetch_add(1, Ordering::Relaxed);
+      }
+
+      self.processed.fetch_add(1, Ordering::Relaxed);
+    }
+  }
+
+  fn statistics(&self) -> WorkerStatistics {
+    WorkerStatistics {
+      frame_types: self.frame_types.clone(),
+      queue_len: self.queue.len(),
+      max_queue_len: self.max_queue_len.load(Ordering::Relaxed),
+      queue_capacity: self.queue.capacity(),
+      processed: self.processed.load(Ordering::Relaxed),
+      failed: self.failed.load(Ordering::Relaxed),
+      dropped: self.queue.dropped_count(),
+    }
+  }
+}
+
+/// A frame listener that runs its closure on a pool of worker threads.
+/// The native callback only hands the frame to a worker queue and returns,
+/// so a slow closure does not stall libfreenect2's packet processing.
+/// Frames of one type are always processed by the same worker, in order.
+/// If a worker falls behind, frames are dropped according to
+/// [`DispatchOptions::drop_policy`].
+///
+/// The workers are stopped and joined when the listener is dropped.
+/// Frames still waiting at this point are processed first.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::async_frame_listener::{AsyncFrameListener, DispatchOptions};
+/// use libfreenect2_rs::frame_type::FrameType;
+///
+/// let options = DispatchOptions {
+///   workers: 2,
+///   ..Default::default()
+/// }
+/// .with_affinity(FrameType::Ir, 1)
+/// .with_affinity(FrameType::Depth, 1);
+///
+/// let listener = AsyncFrameListener::new(options, |ty, frame| {
+///   println!("Processing frame of type {:?}", ty);
+///   Ok(())
+/// }).unwrap();
+///
+/// /// Set the listener and start the device
+///
+/// println!("Worker statistics: {:?}", listener.statistics());
+/// ```
+pub struct AsyncFrameListener {
+  pub(crate) listener: Option<FrameListener<'static>>,
+  workers: Arc<Vec<Worker>>,
+  threads: Vec<JoinHandle<()>>,
+}
+
+impl AsyncFrameListener {
+  /// Create a new [`AsyncFrameListener`].
+  ///
+  /// # Arguments
+  /// * `options` - The options for the listener.
+  /// * `f` - The closure to call on a worker thread when a new frame is received.
+  ///   If the closure panics, the panic is caught and logged.
+  ///
+  /// # Errors
+  /// Returns an error if the options are invalid, a worker thread
+  /// could not be spawned or the underlying frame listener could not be created.
+  pub fn new<F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + Send + Sync + 'static>(
+    options: DispatchOptions,
+    f: F,
+  ) -> anyhow::Result<Self> {
+    anyhow::ensure!(options.workers > 0, "At least one worker is required");
+    for (ty, worker) in &options.affinity {
+      anyhow::ensure!(
+        *worker < options.workers,
+        "Frame type {:?} is assigned to worker {}, but only {} workers exist",
+        ty,
+        worker,
+        options.workers
+      );
+    }
+
+    let workers = Arc::new(
+      (0..options.workers)
+        .map(|i| {
+          Ok(Worker {
+            queue: BoundedQueue::new(options.queue_capacity, options.drop_policy)?,
+            metrics: options.metrics.clone(),
+            frame_types: FRAME_TYPES
+              .iter()
+              .copied()
+              .filter(|ty| options.worker_for(*ty) == i)
+              .collect(),
+            max_queue_len: AtomicUsize::new(0),
+            processed: AtomicU64::new(0),
+            failed: AtomicU64::new(0),
+          })
+        })
+        .collect::<anyhow::Result<Vec<_>>>()?,
+    );
+
+    let mut res = Self {
+      listener: None,
+      workers: workers.clone(),
+      threads: Vec::with_capacity(options.workers),
+    };
+
+    let f = Arc::new(f);
+    for i in 0..options.workers {
+      let workers = workers.clone();
+      let f = f.clone();
+
+      res.threads.push(
+        std::thread::Builder::new()
+          .name(format!("freenect2-dispatch-{i}"))
+          .spawn(move || workers[i].run(f.as_ref()))?,
+      );
+    }
+
+    let lanes = FRAME_TYPES.map(|ty| options.worker_for(ty));
+    let on_new_frame = move |ty: FrameType, frame: Frame<'static>| {
+      let worker = &workers[lanes[FRAME_TYPES.iter().position(|t| *t == ty).unwrap()]];
+      let enqueued = worker.metrics.as_ref().map(|_| Instant::now());
+      if !worker.queue.push((ty, frame, enqueued)) {
+        if let Some(metrics) = &worker.metrics {
+          metrics.record_drops(DropReason::QueueFull, 1);
+        }
+      }
+      worker
+        .max_queue_len
+        .fetch_max(worker.queue.len(), Ordering::Relaxed);
+
+      Ok(())
+    };
+
+    res.listener = Some(match &options.pool {
+      Some(pool) => FrameListener::new_pooled(pool, on_new_frame)?,
+      None => FrameListener::new(on_new_frame)?,
+    });
+
+    Ok(res)
+  }
+
+  /// Get the current statistics of all workers, ordered by worker index.
+  pub fn statistics(&self) -> Vec<WorkerStatistics> {
+    self.workers.iter().map(Worker::statistics).collect()
+  }
+
+  /// Get the total number of frames waiting in all worker queues.
+  pub fn queue_len(&self) -> usize {
+    self.workers.iter().map(|w| w.queue.len()).sum()
+  }
+
+  /// Get the total number of frames dropped because a worker queue was full.
+  pub fn dropped_count(&self) -> u64 {
+    self.workers.iter().map(|w| w.queue.dropped_count()).sum()
+  }
+}
+
+impl AsFrameListener<'static> for AsyncFrameListener {
+  fn as_frame_listener(&self) -> &FrameListener<'static> {
+    self
+      .listener
+      .as_ref()
+      .expect("The frame listener is only unset while dropping")
+  }
+}
+
+impl Drop for AsyncFrameListener {
+  fn drop(&mut self) {
+    self.listener.take();
+    for worker in self.workers.iter() {
+      worker.queue.close();
+    }
+
+    for thread in self.threads.drain(..) {
+      if thread.join().is_err() {
+        log::error!("Frame dispatch worker panicked");
+      }
+    }
+  }
+}
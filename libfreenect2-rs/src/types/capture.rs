@@ -0,0 +1,810 @@
+//! An append-only file format for recording frames and reading them back
+//! without copying.
+//!
+//! A capture file starts with a 64 byte file header, followed by one record per
+//! frame. Each record is a 64 byte record header followed by the frame data, padded
+//! to a multiple of 64 bytes, so the frame data in a memory-mapped file is always
+//! 64 byte aligned. [`CaptureRecorder::finish`] appends an index with the offset,
+//! timestamp and sequence of every record and a footer pointing to the index.
+//! If the footer is missing, e.g. because the recording process crashed,
+//! [`CaptureReader`] rebuilds the index by scanning the records.
+//!
+//! All values are stored in little-endian byte order.
+//! The frame data is stored as received from libfreenect2.
+
+use crate::frame::{packed_data, FrameFormat, Freenect2Frame};
+use crate::frame_listener::{AsFrameListener, FrameListener};
+use crate::frame_pool::FramePool;
+use crate::frame_type::FrameType;
+use crate::replay_device::ReplaySource;
+use crate::util::bounded_queue::{BoundedQueue, DropPolicy};
+use memmap2::Mmap;
+use std::fs::File;
+use std::io::{BufWriter, Write};
+use std::path::Path;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::thread::JoinHandle;
+
+const FILE_MAGIC: [u8; 8] = *b"LF2RSCAP";
+const FOOTER_MAGIC: [u8; 8] = *b"LF2RSIDX";
+const RECORD_MAGIC: u32 = u32::from_le_bytes(*b"FRME");
+const VERSION: u32 = 1;
+
+/// The alignment of records and frame data.
+const ALIGNMENT: usize = 64;
+const FILE_HEADER_LEN: usize = 64;
+const RECORD_HEADER_LEN: usize = 64;
+const INDEX_ENTRY_LEN: usize = 24;
+const FOOTER_LEN: usize = 32;
+
+/// The buffer size of the writer. Frame data larger than this
+/// is written directly from the frame.
+const WRITE_BUFFER_LEN: usize = 1 << 20;
+
+fn align(len: usize) -> usize {
+  len.div_ceil(ALIGNMENT) * ALIGNMENT
+}
+
+pub(crate) fn read_u32(data: &[u8], offset: usize) -> u32 {
+  u32::from_le_bytes(data[offset..offset + 4].try_into().unwrap())
+}
+
+pub(crate) fn read_u64(data: &[u8], offset: usize) -> u64 {
+  u64::from_le_bytes(data[offset..offset + 8].try_into().unwrap())
+}
+
+pub(crate) fn read_f32(data: &[u8], offset: usize) -> f32 {
+  f32::from_le_bytes(data[offset..offset + 4].try_into().unwrap())
+}
+
+pub(crate) fn frame_type_code(ty: FrameType) -> u8 {
+  match ty {
+    FrameType::Color => 1,
+    FrameType::Ir => 2,
+    FrameType::Depth => 4,
+  }
+}
+
+pub(crate) fn frame_type_from_code(code: u8) -> Option<FrameType> {
+  match code {
+    1 => Some(FrameType::Color),
+    2 => Some(FrameType::Ir),
+    4 => Some(FrameType::Depth),
+    _ => None,
+  }
+}
+
+pub(crate) fn format_code(format: FrameFormat) -> u8 {
+  match format {
+    FrameFormat::Invalid => 0,
+    FrameFormat::Raw => 1,
+    FrameFormat::Float => 2,
+    FrameFormat::BGRX => 4,
+    FrameFormat::RGBX => 5,
+    FrameFormat::Gray => 6,
+  }
+}
+
+pub(crate) fn format_from_code(code: u8) -> FrameFormat {
+  match code {
+    1 => FrameFormat::Raw,
+    2 => FrameFormat::Float,
+    4 => FrameFormat::BGRX,
+    5 => FrameFormat::RGBX,
+    6 => FrameFormat::Gray,
+    _ => FrameFormat::Invalid,
+  }
+}
+
+/// An entry of the capture index.
+#[derive(Debug, Copy, Clone, Eq, PartialEq)]
+struct IndexEntry {
+  offset: u64,
+  timestamp: u32,
+  sequence: u32,
+  frame_type: u8,
+}
+
+impl IndexEntry {
+  fn encode(&self) -> [u8; INDEX_ENTRY_LEN] {
+    let mut buf = [0; INDEX_ENTRY_LEN];
+    buf[0..8].copy_from_slice(&self.offset.to_le_bytes());
+    buf[8..12].copy_from_slice(&self.timestamp.to_le_bytes());
+    buf[12..16].copy_from_slice(&self.sequence.to_le_bytes());
+    buf[16] = self.frame_type;
+    buf
+  }
+
+  fn decode(data: &[u8]) -> Self {
+    Self {
+      offset: read_u64(data, 0),
+      timestamp: read_u32(data, 8),
+      sequence: read_u32(data, 12),
+      frame_type: data[16],
+    }
+  }
+}
+
+fn encode_record_header(ty: FrameType, frame: &dyn Freenect2Frame) -> [u8; RECORD_HEADER_LEN] {
+  let mut buf = [0; RECORD_HEADER_LEN];
+  buf[0..4].copy_from_slice(&RECORD_MAGIC.to_le_bytes());
+  buf[4] = frame_type_code(ty);
+  buf[5] = format_code(frame.format());
+  buf[8..12].copy_from_slice(&(frame.width() as u32).to_le_bytes());
+  buf[12..16].copy_from_slice(&(frame.height() as u32).to_le_bytes());
+  buf[16..20].copy_from_slice(&(frame.bytes_per_pixel() as u32).to_le_bytes());
+  buf[20..24].copy_from_slice(&frame.timestamp().to_le_bytes());
+  buf[24..28].copy_from_slice(&frame.sequence().to_le_bytes());
+  buf[28..32].copy_from_slice(&frame.exposure().to_le_bytes());
+  buf[32..36].copy_from_slice(&frame.gain().to_le_bytes());
+  buf[36..40].copy_from_slice(&frame.gamma().to_le_bytes());
+  buf[40..44].copy_from_slice(&frame.status().to_le_bytes());
+  buf[48..56].copy_from_slice(&(frame.raw_data_len() as u64).to_le_bytes());
+  buf
+}
+
+/// Options for creating a [`CaptureRecorder`].
+#[derive(Clone)]
+pub struct CaptureOptions {
+  /// The maximum number of frames waiting to be written.
+  /// The default is 16.
+  pub queue_capacity: usize,
+  /// What to do if a frame is received while the queue is full.
+  /// [`DropPolicy::Block`] stalls the libfreenect2 processing thread,
+  /// which may cause packet loss. The default is [`DropPolicy::DropOldest`].
+  pub drop_policy: DropPolicy,
+  /// The file is grown in steps of this many bytes, so it is not
+  /// resized for every frame. The default is 256 MiB.
+  pub extent_size: u64,
+  /// The pool to take frames from.
+  /// If set, frames waiting to be written hold on to a pool frame.
+  pub pool: Option<FramePool>,
+}
+
+impl Default for CaptureOptions {
+  fn default() -> Self {
+    Self {
+      queue_capacity: 16,
+      drop_policy: DropPolicy::default(),
+      extent_size: 256 << 20,
+      pool: None,
+    }
+  }
+}
+
+/// The result of a finished recording.
+/// Returned by [`CaptureRecorder::finish`].
+#[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+pub struct CaptureSummary {
+  /// The number of frames written.
+  pub frames: u64,
+  /// The size of the capture file in bytes.
+  pub bytes: u64,
+  /// The number of frames dropped because the queue was full.
+  pub dropped: u64,
+}
+
+type QueuedFrame = (FrameType, Box<dyn Freenect2Frame>);
+
+struct CaptureWriter {
+  file: BufWriter<File>,
+  offset: u64,
+  allocated: u64,
+  extent_size: u64,
+  index: Vec<IndexEntry>,
+}
+
+impl CaptureWriter {
+  fn create(path: &Path, extent_size: u64) -> anyhow::Result<Self> {
+    let mut res = Self {
+      file: BufWriter::with_capacity(WRITE_BUFFER_LEN, File::create(path)?),
+      offset: 0,
+      allocated: 0,
+      extent_size,
+      index: Vec::new(),
+    };
+
+    let mut header = [0; FILE_HEADER_LEN];
+    header[0..8].copy_from_slice(&FILE_MAGIC);
+    header[8..12].copy_from_slice(&VERSION.to_le_bytes());
+    header[12..16].copy_from_slice(&(ALIGNMENT as u32).to_le_bytes());
+    res.write(&header)?;
+
+    Ok(res)
+  }
+
+  /// Grow the file by whole extents until `len` more bytes fit.
+  fn reserve(&mut self, len: u64) -> std::io::Result<()> {
+    let end = self.offset + len;
+    if end > self.allocated {
+      self.allocated = end.div_ceil(self.extent_size) * self.extent_size;
+      self.file.get_ref().set_len(self.allocated)?;
+    }
+
+    Ok(())
+  }
+
+  fn write(&mut self, data: &[u8]) -> std::io::Result<()> {
+    self.reserve(data.len() as u64)?;
+    self.file.write_all(data)?;
+    self.offset += data.len() as u64;
+
+    Ok(())
+  }
+
+  fn write_frame(&mut self, ty: FrameType, frame: &dyn Freenect2Frame) -> std::io::Result<()> {
+    let data = packed_data(frame);
+    let padding = align(data.len()) - data.len();
+    let entry = IndexEntry {
+      offset: self.offset,
+      timestamp: frame.timestamp(),
+      sequence: frame.sequence(),
+      frame_type: frame_type_code(ty),
+    };
+
+    self.reserve((RECORD_HEADER_LEN + data.len() + padding) as u64)?;
+    self.write(&encode_record_header(ty, frame))?;
+    self.write(&data)?;
+    self.write(&[0; ALIGNMENT][..padding])?;
+    self.index.push(entry);
+
+    Ok(())
+  }
+
+  /// Write the index and the footer and cut off the unused part of the last extent.
+  fn finish(mut self) -> std::io::Result<u64> {
+    let index_offset = self.offset;
+    for entry in std::mem::take(&mut self.index) {
+      self.write(&entry.encode())?;
+    }
+
+    let mut footer = [0; FOOTER_LEN];
+    footer[0..8].copy_from_slice(&FOOTER_MAGIC);
+    footer[8..16].copy_from_slice(&index_offset.to_le_bytes());
+    footer[16..24]
+      .copy_from_slice(&((self.offset - index_offset) / INDEX_ENTRY_LEN as u64).to_le_bytes());
+    self.write(&footer)?;
+
+    self.file.flush()?;
+    let file = self.file.get_ref();
+    file.set_len(self.offset)?;
+    file.sync_data()?;
+
+    Ok(self.offset)
+  }
+}
+
+struct RecorderState {
+  queue: BoundedQueue<QueuedFrame>,
+  written: AtomicU64,
+  error: Mutex<Option<String>>,
+}
+
+impl RecorderState {
+  fn run(&self, mut writer: CaptureWriter) -> anyhow::Result<u64> {
+    while let Some((ty, frame)) = self.queue.pop(None) {
+      if let Err(e) = writer.write_frame(ty, frame.as_ref()) {
+        log::error!("Failed to write {:?} frame to the capture file: {}", ty, e);
+        *self.error.lock().unwrap() = Some(e.to_string());
+        self.queue.close();
+
+        return Err(e.into());
+      }
+
+      self.written.fetch_add(1, Ordering::Relaxed);
+    }
+
+    writer.finish().map_err(Into::into)
+  }
+
+  fn push(&self, ty: FrameType, frame: Box<dyn Freenect2Frame>) -> anyhow::Result<bool> {
+    if let Some(e) = self.error.lock().unwrap().as_ref() {
+      anyhow::bail!("The capture file could not be written: {}", e);
+    }
+    anyhow::ensure!(!self.queue.is_closed(), "The recording was finished");
+
+    Ok(self.queue.push((ty, frame)))
+  }
+}
+
+/// Records frames into a capture file, which can be read using [`CaptureReader`].
+///
+/// The native callback only moves the received frame into a queue.
+/// A background thread writes the frame straight from its native buffer into
+/// the file, so frames are not copied before they are written. Small writes are
+/// buffered, and the file is grown in steps of [`CaptureOptions::extent_size`].
+/// If the writer falls behind, frames are dropped according to
+/// [`CaptureOptions::drop_policy`].
+///
+/// The recording must be finished using [`Self::finish`] to write the index.
+/// Dropping the recorder finishes it too, but only logs errors.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::capture::{CaptureOptions, CaptureRecorder};
+/// use libfreenect2_rs::freenect2::Freenect2;
+///
+/// let mut freenect2 = Freenect2::new().unwrap();
+/// let mut device = freenect2.open_default_device().unwrap();
+///
+/// let recorder = CaptureRecorder::create("session.lf2cap", CaptureOptions::default()).unwrap();
+/// device.set_color_frame_listener(&recorder).unwrap();
+/// device.set_ir_and_depth_frame_listener(&recorder).unwrap();
+/// device.start().unwrap();
+///
+/// std::thread::sleep(std::time::Duration::from_secs(10));
+/// device.stop().unwrap();
+/// drop(device);
+///
+/// let summary = recorder.finish().unwrap();
+/// println!("Recorded {} frames", summary.frames);
+/// ```
+pub struct CaptureRecorder {
+  listener: Option<FrameListener<'static>>,
+  state: Arc<RecorderState>,
+  thread: Option<JoinHandle<anyhow::Result<u64>>>,
+}
+
+impl CaptureRecorder {
+  /// Create a new capture file at `path` and start the writer thread.
+  /// An existing file is overwritten.
+  ///
+  /// # Arguments
+  /// * `path` - The path of the capture file.
+  /// * `options` - The options for the recorder.
+  ///
+  /// # Errors
+  /// Returns an error if the options are invalid, the file could not be created,
+  /// the writer thread could not be spawned or the underlying
+  /// frame listener could not be created.
+  pub fn create<P: AsRef<Path>>(path: P, options: CaptureOptions) -> anyhow::Result<Self> {
+    anyhow::ensure!(
+      options.extent_size > 0,
+      "The extent size must be greater than zero"
+    );
+
+    let writer = CaptureWriter::create(path.as_ref(), options.extent_size)?;
+    let state = Arc::new(RecorderState {
+      queue: BoundedQueue::new(options.queue_capacity, options.drop_policy)?,
+      written: AtomicU64::new(0),
+      error: Mutex::new(None),
+    });
+
+    let thread = std::thread::Builder::new()
+      .name("freenect2-capture".to_string())
+      .spawn({
+        let state = state.clone();
+        move || state.run(writer)
+      })?;
+
+    let on_new_frame = {
+      let state = state.clone();
+      move |ty: FrameType, frame| state.push(ty, Box::new(frame)).map(|_| ())
+    };
+
+    Ok(Self {
+      listener: Some(match &options.pool {
+        Some(pool) => FrameListener::new_pooled(pool, on_new_frame)?,
+        None => FrameListener::new(on_new_frame)?,
+      }),
+      state,
+      thread: Some(thread),
+    })
+  }
+
+  /// Queue a frame for writing, in addition to the frames received by the listener.
+  /// Returns `false` if a frame was dropped because the queue was full.
+  ///
+  /// # Errors
+  /// Returns an error if writing a previous frame failed.
+  pub fn record<F: Freenect2Frame + 'static>(
+    &self,
+    ty: FrameType,
+    frame: F,
+  ) -> anyhow::Result<bool> {
+    self.state.push(ty, Box::new(frame))
+  }
+
+  /// Get the number of frames written so far.
+  pub fn frames_written(&self) -> u64 {
+    self.state.written.load(Ordering::Relaxed)
+  }
+
+  /// Get the number of frames waiting to be written.
+  pub fn queue_len(&self) -> usize {
+    self.state.queue.len()
+  }
+
+  /// Get the number of frames dropped because the queue was full.
+  pub fn dropped_count(&self) -> u64 {
+    self.state.queue.dropped_count()
+  }
+
+  /// Write all frames still waiting, then write the index and close the file.
+  ///
+  /// # Errors
+  /// Returns an error if a frame or the index could not be written.
+  pub fn finish(mut self) -> anyhow::Result<CaptureSummary> {
+    self.stop()
+  }
+
+  fn stop(&mut self) -> anyhow::Result<CaptureSummary> {
+    self.listener.take();
+    self.state.queue.close();
+
+    let bytes = self
+      .thread
+      .take()
+      .ok_or_else(|| anyhow::anyhow!("The recording was already finished"))?
+      .join()
+      .map_err(|_| anyhow::anyhow!("The capture writer panicked"))??;
+
+    Ok(CaptureSummary {
+      frames: self.frames_written(),
+      bytes,
+      dropped: self.dropped_count(),
+    })
+  }
+}
+
+impl AsFrameListener<'static> for CaptureRecorder {
+  fn as_frame_listener(&self) -> &FrameListener<'static> {
+    self
+      .listener
+      .as_ref()
+      .expect("The frame listener is only unset after finishing")
+  }
+}
+
+impl Drop for CaptureRecorder {
+  fn drop(&mut self) {
+    if self.thread.is_some() {
+      if let Err(e) = self.stop() {
+        log::error!("Failed to finish the capture file: {}", e);
+      }
+    }
+  }
+}
+
+/// A frame in a memory-mapped capture file.
+/// The frame data is not copied, it is read from the mapping directly.
+/// The mapping stays valid as long as a frame referencing it exists,
+/// even if the [`CaptureReader`] is dropped.
+#[derive(Clone)]
+pub struct CaptureFrame {
+  map: Arc<Mmap>,
+  data_offset: usize,
+  width: usize,
+  height: usize,
+  bytes_per_pixel: usize,
+  timestamp: u32,
+  sequence: u32,
+  exposure: f32,
+  gain: f32,
+  gamma: f32,
+  status: u32,
+  format: FrameFormat,
+}
+
+impl Freenect2Frame for CaptureFrame {
+  fn width(&self) -> usize {
+    self.width
+  }
+
+  fn height(&self) -> usize {
+    self.height
+  }
+
+  fn bytes_per_pixel(&self) -> usize {
+    self.bytes_per_pixel
+  }
+
+  fn timestamp(&self) -> u32 {
+    self.timestamp
+  }
+
+  fn raw_data(&self) -> &[u8] {
+    &self.map[self.data_offset..self.data_offset + self.raw_data_len()]
+  }
+
+  fn sequence(&self) -> u32 {
+    self.sequence
+  }
+
+  fn exposure(&self) -> f32 {
+    self.exposure
+  }
+
+  fn gain(&self) -> f32 {
+    self.gain
+  }
+
+  fn gamma(&self) -> f32 {
+    self.gamma
+  }
+
+  fn status(&self) -> u32 {
+    self.status
+  }
+
+  fn format(&self) -> FrameFormat {
+    self.format
+  }
+}
+
+enum CaptureIndex {
+  /// The index written by [`CaptureRecorder::finish`],
+  /// as offset into the mapping and number of entries.
+  Mapped(usize, usize),
+  /// An index rebuilt by scanning the records.
+  Scanned(Vec<IndexEntry>),
+}
+
+/// Reads a capture file written by [`CaptureRecorder`].
+///
+/// The file is memory-mapped, so opening it is cheap and frames are returned
+/// as views into the mapping. Getting a frame by its position is O(1), finding
+/// a frame by its timestamp is a binary search over the index.
+///
+/// The reader is a [`ReplaySource`], so a capture can be replayed into
+/// frame listeners using a [`crate::replay_device::ReplayDevice`].
+///
+/// The file must not be modified while it is open.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::capture::CaptureReader;
+/// use libfreenect2_rs::frame::Freenect2Frame;
+///
+/// let reader = CaptureReader::open("session.lf2cap").unwrap();
+/// let start = reader.find_timestamp(8000);
+///
+/// for i in start..reader.len() {
+///   let (ty, frame) = reader.frame(i).unwrap();
+///   println!("{:?} frame {}", ty, frame.sequence());
+/// }
+/// ```
+pub struct CaptureReader {
+  map: Arc<Mmap>,
+  index: CaptureIndex,
+  position: usize,
+  current: Option<CaptureFrame>,
+}
+
+impl CaptureReader {
+  /// Open and map a capture file.
+  ///
+  /// # Arguments
+  /// * `path` - The path of the capture file.
+  ///
+  /// # Errors
+  /// Returns an error if the file could not be opened or mapped,
+  /// or if it is not a capture file.
+  pub fn open<P: AsRef<Path>>(path: P) -> anyhow::Result<Self> {
+    let file = File::open(path)?;
+    // Safety: the file must not be modified while it is mapped, see the type docs
+    let map = unsafe { Mmap::map(&file)? };
+
+    anyhow::ensure!(
+      map.len() >= FILE_HEADER_LEN && map[0..8] == FILE_MAGIC,
+      "The file is not a capture file"
+    );
+    let version = read_u32(&map, 8);
+    anyhow::ensure!(
+      version == VERSION,
+      "Unsupported capture file version {}",
+      version
+    );
+
+    let index = Self::read_index(&map).unwrap_or_else(|| {
+      log::warn!("The capture file has no index, it was probably not finished");
+      CaptureIndex::Scanned(Self::scan(&map))
+    });
+
+    Ok(Self {
+      map: Arc::new(map),
+      index,
+      position: 0,
+      current: None,
+    })
+  }
+
+  fn read_index(map: &[u8]) -> Option<CaptureIndex> {
+    let footer = map.len().checked_sub(FOOTER_LEN)?;
+    if footer < FILE_HEADER_LEN || map[footer..footer + 8] != FOOTER_MAGIC {
+      return None;
+    }
+
+    let offset = usize::try_from(read_u64(map, footer + 8)).ok()?;
+    let len = usize::try_from(read_u64(map, footer + 16)).ok()?;
+    if offset.checked_add(len.checked_mul(INDEX_ENTRY_LEN)?)? != footer {
+      return None;
+    }
+
+    Some(CaptureIndex::Mapped(offset, len))
+  }
+
+  /// Collect all complete records following the file header.
+  fn scan(map: &[u8]) -> Vec<IndexEntry> {
+    let mut entries = Vec::new();
+    let mut offset = FILE_HEADER_LEN;
+
+    while offset + RECORD_HEADER_LEN <= map.len() && read_u32(map, offset) == RECORD_MAGIC {
+      let end = usize::try_from(read_u64(map, offset + 48))
+        .ok()
+        .and_then(|len| (offset + RECORD_HEADER_LEN).checked_add(align(len)));
+      match end {
+        Some(end) if end <= map.len() => {
+          entries.push(IndexEntry {
+            offset: offset as u64,
+            timestamp: read_u32(map, offset + 20),
+            sequence: read_u32(map, offset + 24),
+            frame_type: map[offset + 4],
+          });
+          offset = end;
+        }
+        _ => break,
+      }
+    }
+
+    entries
+  }
+
+  fn entry(&self, index: usize) -> IndexEntry {
+    match &self.index {
+      CaptureIndex::Mapped(offset, _) => {
+        let offset = offset + index * INDEX_ENTRY_LEN;
+        IndexEntry::decode(&self.map[offset..offset + INDEX_ENTRY_LEN])
+      }
+      CaptureIndex::Scanned(entries) => entries[index],
+    }
+  }
+
+  /// Get the number of frames in the capture.
+  pub fn len(&self) -> usize {
+    match &self.index {
+      CaptureIndex::Mapped(_, len) => *len,
+      CaptureIndex::Scanned(entries) => entries.len(),
+    }
+  }
+
+  /// Check if the capture contains no frames.
+  pub fn is_empty(&self) -> bool {
+    self.len() == 0
+  }
+
+  /// Check if the capture was finished and contains an index.
+  /// Unfinished captures are still readable,
+  /// but their last frame may be incomplete.
+  pub fn is_finished(&self) -> bool {
+    matches!(self.index, CaptureIndex::Mapped(..))
+  }
+
+  /// Get the frame at `index`, in the order the frames were recorded.
+  ///
+  /// # Arguments
+  /// * `index` - The position of the frame, must be less than [`Self::len`].
+  ///
+  /// # Errors
+  /// Returns an error if `index` is out of bounds or the record is corrupted.
+  pub fn frame(&self, index: usize) -> anyhow::Result<(FrameType, CaptureFrame)> {
+    anyhow::ensure!(
+      index < self.len(),
+      "Frame index {} is out of bounds for a capture of {} frames",
+      index,
+      self.len()
+    );
+
+    let entry = self.entry(index);
+    let offset = usize::try_from(entry.offset)?;
+    let map = self.map.as_ref();
+    anyhow::ensure!(
+      offset
+        .checked_add(RECORD_HEADER_LEN)
+        .is_some_and(|end| end <= map.len())
+        && read_u32(map, offset) == RECORD_MAGIC,
+      "The record of frame {} is corrupted",
+      index
+    );
+
+    let frame = CaptureFrame {
+      map: self.map.clone(),
+      data_offset: offset + RECORD_HEADER_LEN,
+      width: read_u32(map, offset + 8) as usize,
+      height: read_u32(map, offset + 12) as usize,
+      bytes_per_pixel: read_u32(map, offset + 16) as usize,
+      timestamp: read_u32(map, offset + 20),
+      sequence: read_u32(map, offset + 24),
+      exposure: read_f32(map, offset + 28),
+      gain: read_f32(map, offset + 32),
+      gamma: read_f32(map, offset + 36),
+      status: read_u32(map, offset + 40),
+      format: format_from_code(map[offset + 5]),
+    };
+
+    // The dimensions are untrusted, an overflowing length is a corrupted record
+    let data_end = frame
+      .width
+      .checked_mul(frame.height)
+      .and_then(|len| len.checked_mul(frame.bytes_per_pixel))
+      .filter(|&len| read_u64(map, offset + 48) == len as u64)
+      .and_then(|len| frame.data_offset.checked_add(len));
+
+    let ty = frame_type_from_code(map[offset + 4]);
+    anyhow::ensure!(
+      ty.is_some()
+        && map[offset + 4] == entry.frame_type
+        && data_end.is_some_and(|end| end <= map.len()),
+      "The record of frame {} is corrupted",
+      index
+    );
+
+    Ok((ty.unwrap(), frame))
+  }
+
+  /// Get the position of the first frame with a timestamp of at least `timestamp`,
+  /// or [`Self::len`] if there is none.
+  /// Expects the timestamps to be increasing in recording order,
+  /// as they are for frames received from a device.
+  pub fn find_timestamp(&self, timestamp: u32) -> usize {
+    let (mut low, mut high) = (0, self.len());
+    while low < high {
+      let mid = low + (high - low) / 2;
+      if self.entry(mid).timestamp < timestamp {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+
+    low
+  }
+
+  /// Iterate over all frames in recording order.
+  pub fn iter(&self) -> impl Iterator<Item = anyhow::Result<(FrameType, CaptureFrame)>> + '_ {
+    (0..self.len()).map(|i| self.frame(i))
+  }
+
+  /// Get the position of the next frame returned by [`ReplaySource::next_frame`].
+  pub fn position(&self) -> usize {
+    self.position
+  }
+
+  /// Set the position of the next frame returned by [`ReplaySource::next_frame`].
+  ///
+  /// # Errors
+  /// Returns an error if `position` is greater than [`Self::len`].
+  pub fn seek(&mut self, position: usize) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      position <= self.len(),
+      "Position {} is out of bounds for a capture of {} frames",
+      position,
+      self.len()
+    );
+
+    self.position = position;
+    Ok(())
+  }
+}
+
+impl ReplaySource for CaptureReader {
+  fn next_frame(&mut self) -> anyhow::Result<Option<(FrameType, &dyn Freenect2Frame)>> {
+    if self.position >= self.len() {
+      return Ok(None);
+    }
+
+    let (ty, frame) = self.frame(self.position)?;
+    self.position += 1;
+
+    Ok(Some((
+      ty,
+      self.current.insert(frame) as &dyn Freenect2Frame,
+    )))
+  }
+
+  fn rewind(&mut self) -> anyhow::Result<()> {
+    self.position = 0;
+    Ok(())
+  }
+}
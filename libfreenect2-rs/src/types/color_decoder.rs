@@ -0,0 +1,289 @@
+//! Decoding of undecoded color frames with a scale,
+//! a region of interest and an output format,
+//! see [`crate::freenect2::RawPackets::Color`].
+//!
+//! Open a device with [`crate::freenect2::RawPackets::Color`] and decode
+//! the frames that are needed, or wrap the color frame listener using
+//! [`decoding_frame_listener`] to decode every frame.
+//! Hardware JPEG decoders (VA-API on Linux, Tegra) are only used by
+//! the packet pipelines of libfreenect2, if it was built with them.
+//! The decoder in this module uses the SIMD paths of libjpeg-turbo
+//! and is only available on Linux, see [`ColorDecoder::is_available`].
+
+use crate::ffi;
+use crate::frame::{Frame, Freenect2Frame};
+use crate::frame_listener::FrameListener;
+use crate::frame_type::FrameType;
+use crate::raw_packet::jpeg_data;
+use cxx::UniquePtr;
+use std::panic::UnwindSafe;
+use std::sync::{Arc, Mutex};
+
+pub use crate::ffi::libfreenect2::{DecodeFormat, DecodeScale, Region};
+
+impl Default for DecodeScale {
+  fn default() -> Self {
+    DecodeScale::Full
+  }
+}
+
+impl DecodeScale {
+  /// Get the denominator of the scale, e.g. 4 for [`DecodeScale::Quarter`].
+  pub fn denominator(&self) -> u32 {
+    match *self {
+      DecodeScale::Half => 2,
+      DecodeScale::Quarter => 4,
+      DecodeScale::Eighth => 8,
+      _ => 1,
+    }
+  }
+
+  /// Get the size of an image of `width` x `height` pixels decoded at this scale.
+  /// Partial pixels are rounded up.
+  pub fn scaled_size(&self, width: u32, height: u32) -> (u32, u32) {
+    let denominator = self.denominator();
+    (width.div_ceil(denominator), height.div_ceil(denominator))
+  }
+}
+
+impl Default for DecodeFormat {
+  fn default() -> Self {
+    DecodeFormat::BGRX
+  }
+}
+
+impl DecodeFormat {
+  /// Get the number of bytes per pixel of frames decoded to this format.
+  pub fn bytes_per_pixel(&self) -> usize {
+    match *self {
+      DecodeFormat::RGB => 3,
+      DecodeFormat::Gray => 1,
+      _ => 4,
+    }
+  }
+}
+
+/// Options for decoding color frames.
+/// The default options decode full frames to [`DecodeFormat::BGRX`],
+/// which is the output of the packet pipelines.
+#[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+pub struct DecodeOptions {
+  /// The scale to decode at.
+  pub scale: DecodeScale,
+  /// The pixel format to decode to.
+  pub format: DecodeFormat,
+  /// The region to decode, in pixels of the full resolution frame.
+  /// The region is cropped before decoding, so smaller regions
+  /// decode faster. Decodes the whole frame if [`None`].
+  pub region: Option<Region>,
+}
+
+impl DecodeOptions {
+  fn to_params(self) -> ffi::libfreenect2::ColorDecodeParams {
+    ffi::libfreenect2::ColorDecodeParams {
+      scale: self.scale,
+      format: self.format,
+      crop: self.region.is_some(),
+      region: self.region.unwrap_or_default(),
+    }
+  }
+}
+
+/// A decoder for undecoded color frames.
+/// Keeps its buffers between calls, reuse it for every frame.
+pub struct ColorDecoder(UniquePtr<ffi::libfreenect2::JpegDecoder>);
+
+impl ColorDecoder {
+  /// Create a new decoder.
+  ///
+  /// # Errors
+  /// Returns an error if the library was built without
+  /// a decoder, see [`Self::is_available`].
+  pub fn new() -> anyhow::Result<Self> {
+    ffi::libfreenect2::create_jpeg_decoder()
+      .map(Self)
+      .map_err(Into::into)
+  }
+
+  /// Check if the library was built with a decoder.
+  /// Only true on Linux, where libjpeg-turbo is linked.
+  pub fn is_available() -> bool {
+    ffi::libfreenect2::jpeg_decoder_available()
+  }
+
+  /// Decode an undecoded color frame.
+  /// The metadata of `frame` is copied to the decoded frame.
+  ///
+  /// # Arguments
+  /// * `frame` - The undecoded color frame.
+  /// * `options` - The options to decode with.
+  ///
+  /// # Errors
+  /// Returns an error if `frame` is not an undecoded color frame,
+  /// the region is not inside the frame or decoding fails.
+  /// Also returns an error for [`DecodeFormat::RGB`], since frames have
+  /// no format for 3 byte pixels. Use [`Self::decode_rgb_image`] instead.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::color_decoder::{ColorDecoder, DecodeOptions, DecodeScale, Region};
+  /// use libfreenect2_rs::frame::Freenect2Frame;
+  /// # use libfreenect2_rs::frame::OwnedFrame;
+  /// # let frame: OwnedFrame = unimplemented!();
+  ///
+  /// let mut decoder = ColorDecoder::new().unwrap();
+  /// let preview = decoder.decode(&frame, &DecodeOptions {
+  ///   scale: DecodeScale::Quarter,
+  ///   region: Some(Region::new(480, 270, 960, 540)),
+  ///   ..Default::default()
+  /// }).unwrap();
+  /// assert_eq!((preview.width(), preview.height()), (240, 135));
+  /// ```
+  pub fn decode<F: Freenect2Frame>(
+    &mut self,
+    frame: &F,
+    options: &DecodeOptions,
+  ) -> anyhow::Result<Frame<'static>> {
+    ensure_frame_format(options.format)?;
+    self.decode_frame(frame, options)
+  }
+
+  /// Decode a frame without checking the format.
+  /// Frames decoded to [`DecodeFormat::RGB`] are tagged [`crate::frame::FrameFormat::Raw`],
+  /// the format of undecoded packets, so they must not leave this module.
+  fn decode_frame<F: Freenect2Frame>(
+    &mut self,
+    frame: &F,
+    options: &DecodeOptions,
+  ) -> anyhow::Result<Frame<'static>> {
+    let jpeg = jpeg_data(frame)?;
+    let decoder = self
+      .0
+      .as_mut()
+      .ok_or(anyhow::anyhow!("The decoder is not initialized"))?;
+
+    decoder
+      .decode(
+        jpeg,
+        &options.to_params(),
+        frame.timestamp(),
+        frame.sequence(),
+        frame.exposure(),
+        frame.gain(),
+        frame.gamma(),
+        frame.status(),
+      )
+      .map(Frame::new)
+      .map_err(Into::into)
+  }
+
+  #[cfg(feature = "image")]
+  /// Decode an undecoded color frame to an [`image::RgbImage`].
+  /// Decodes straight to RGB, the format of `options` is ignored.
+  /// Only available when the `image` feature is enabled.
+  ///
+  /// # Errors
+  /// Returns an error if decoding fails, see [`Self::decode`].
+  pub fn decode_rgb_image<F: Freenect2Frame>(
+    &mut self,
+    frame: &F,
+    options: &DecodeOptions,
+  ) -> anyhow::Result<image::RgbImage> {
+    let decoded = self.decode_frame(
+      frame,
+      &DecodeOptions {
+        format: DecodeFormat::RGB,
+        ..*options
+      },
+    )?;
+
+    image::RgbImage::from_raw(
+      decoded.width() as u32,
+      decoded.height() as u32,
+      decoded.raw_data().to_vec(),
+    )
+    .ok_or(anyhow::anyhow!("The decoded frame has an invalid size"))
+  }
+}
+
+unsafe impl Send for ColorDecoder {}
+
+fn ensure_frame_format(format: DecodeFormat) -> anyhow::Result<()> {
+  anyhow::ensure!(
+    format != DecodeFormat::RGB,
+    "Frames can't be decoded to RGB, use ColorDecoder::decode_rgb_image instead"
+  );
+
+  Ok(())
+}
+
+/// Create a frame listener which decodes undecoded color frames
+/// using `options` before passing them to `f`.
+/// All other frames are passed to `f` unchanged.
+/// Set it as the color frame listener of a device opened
+/// with [`crate::freenect2::RawPackets::Color`].
+///
+/// # Arguments
+/// * `options` - The options to decode with.
+/// * `f` - The closure to call with the decoded frames.
+///
+/// # Errors
+/// Returns an error if the decoder could not be created
+/// or the format of `options` is [`DecodeFormat::RGB`].
+/// Errors decoding a frame are returned from the listener, which logs them.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::color_decoder::{decoding_frame_listener, DecodeFormat, DecodeOptions, DecodeScale};
+/// use libfreenect2_rs::freenect2::{Freenect2, PacketPipeline, RawPackets};
+/// use libfreenect2_rs::frame::Freenect2Frame;
+/// use libfreenect2_rs::gpu_device::DevicePlacement;
+///
+/// let listener = decoding_frame_listener(
+///   DecodeOptions {
+///     scale: DecodeScale::Half,
+///     format: DecodeFormat::Gray,
+///     region: None,
+///   },
+///   |_, frame| {
+///     println!("Decoded {}x{} color frame", frame.width(), frame.height());
+///     Ok(())
+///   },
+/// )
+/// .unwrap();
+///
+/// let mut freenect2 = Freenect2::new().unwrap();
+/// let mut device = freenect2
+///   .open_default_device_with_raw_packets(
+///     PacketPipeline::CPU,
+///     DevicePlacement::Default,
+///     RawPackets::Color,
+///   )
+///   .unwrap();
+///
+/// device.set_color_frame_listener(&listener).unwrap();
+/// device.start().unwrap();
+/// ```
+pub fn decoding_frame_listener<
+  F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + UnwindSafe + 'static,
+>(
+  options: DecodeOptions,
+  f: F,
+) -> anyhow::Result<FrameListener<'static>> {
+  ensure_frame_format(options.format)?;
+  let decoder = Arc::new(Mutex::new(ColorDecoder::new()?));
+
+  FrameListener::new(move |ty, frame| {
+    if ty != FrameType::Color || !crate::raw_packet::is_raw_packet(&frame) {
+      return f(ty, frame);
+    }
+
+    let decoded = decoder
+      .lock()
+      .map_err(|_| anyhow::anyhow!("The decoder is poisoned"))?
+      .decode(&frame, &options)?;
+    drop(frame);
+
+    f(ty, decoded)
+  })
+}
@@ -2,6 +2,50 @@ use anyhow::anyhow;
 use cxx::UniquePtr;
 
 use crate::ffi;
+use crate::frame_type::FrameType;
+
+pub use crate::ffi::libfreenect2::DepthStreams;
+
+impl Default for DepthStreams {
+  fn default() -> Self {
+    DepthStreams::IrAndDepth
+  }
+}
+
+impl DepthStreams {
+  /// Get the streams delivering the IR and depth frames of `types`.
+  /// Returns [`None`] if `types` contains neither IR nor depth frames.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::config::DepthStreams;
+  /// use libfreenect2_rs::frame_type::FrameType;
+  ///
+  /// let streams = DepthStreams::from_frame_types(&[FrameType::Color, FrameType::Depth]);
+  /// assert_eq!(streams, Some(DepthStreams::Depth));
+  /// ```
+  pub fn from_frame_types(types: &[FrameType]) -> Option<Self> {
+    match (
+      types.contains(&FrameType::Ir),
+      types.contains(&FrameType::Depth),
+    ) {
+      (true, true) => Some(DepthStreams::IrAndDepth),
+      (true, false) => Some(DepthStreams::Ir),
+      (false, true) => Some(DepthStreams::Depth),
+      (false, false) => None,
+    }
+  }
+
+  /// Whether frames of type `ty` are delivered.
+  /// Color frames are never part of the depth streams.
+  pub fn contains(&self, ty: FrameType) -> bool {
+    match ty {
+      FrameType::Ir => matches!(*self, DepthStreams::Ir | DepthStreams::IrAndDepth),
+      FrameType::Depth => matches!(*self, DepthStreams::Depth | DepthStreams::IrAndDepth),
+      FrameType::Color => false,
+    }
+  }
+}
 
 /// Configuration for the Kinect.
 /// The config can be passed to [`crate::freenect2_device::Freenect2Device::set_config`]
@@ -9,18 +53,20 @@ use crate::ffi;
 ///
 /// # Example
 /// ```
-/// use libfreenect2_rs::config::Config;
+/// use libfreenect2_rs::config::{Config, DepthStreams};
 ///
 /// let mut config = Config::new().unwrap();
 /// config.set_min_depth(0.5).unwrap();
 /// config.set_max_depth(5.0).unwrap();
 /// config.set_enable_bilateral_filter(true).unwrap();
 /// config.set_enable_edge_aware_filter(true).unwrap();
+/// config.set_depth_streams(DepthStreams::Depth).unwrap();
 ///
 /// assert_eq!(config.get_min_depth(), 0.5);
 /// assert_eq!(config.get_max_depth(), 5.0);
 /// assert_eq!(config.get_enable_bilateral_filter(), true);
 /// assert_eq!(config.get_enable_edge_aware_filter(), true);
+/// assert_eq!(config.get_depth_streams(), DepthStreams::Depth);
 /// ```
 pub struct Config(pub(crate) UniquePtr<ffi::libfreenect2::Config>);
 
@@ -32,6 +78,7 @@ impl Config {
   /// - Max depth: 4.5
   /// - Enable bilateral filter: true
   /// - Enable edge aware filter: true
+  /// - Depth streams: IR and depth
   pub fn new() -> anyhow::Result<Self> {
     ffi::libfreenect2::create_config()
       .map(Self)
@@ -110,6 +157,24 @@ impl Config {
       .set_enable_edge_aware_filter(enable);
     Ok(self)
   }
+
+  /// Get the frames of the depth stream passed to the listener.
+  pub fn get_depth_streams(&self) -> DepthStreams {
+    self.0.get_depth_streams()
+  }
+
+  /// Set the frames of the depth stream passed to the listener.
+  /// Use [`DepthStreams::Depth`] if no IR frames are needed, which saves
+  /// copying them and calling the listener for them.
+  /// The depth packet processor still computes both frames.
+  pub fn set_depth_streams(&mut self, streams: DepthStreams) -> anyhow::Result<&mut Self> {
+    self
+      .0
+      .as_mut()
+      .ok_or(anyhow!("Failed to get config as mutable"))?
+      .set_depth_streams(streams);
+    Ok(self)
+  }
 }
 
 unsafe impl Send for Config {}
@@ -0,0 +1,189 @@
+//! Compression of depth frames for sending them over the network.
+//!
+//! Depths are rounded to millimeters, so decoded frames differ from the
+//! original frames by up to 0.5mm. Keyframes store the depths, the frames
+//! in between only the difference to the previous frame, which is mostly
+//! zero for a static scene. Both are compressed using RVL, a fast
+//! run-length and variable-length delta coding for depth images, see
+//! <https://www.microsoft.com/en-us/research/publication/fast-lossless-depth-image-compression/>.
+//!
+//! Frames must be decoded in the order they were encoded in. If a frame
+//! is lost, decoding fails until the next keyframe, see
+//! [`DepthEncoder::new`] for the keyframe interval.
+
+use crate::ffi;
+use crate::frame::{packed_data, Frame, FrameFormat, Freenect2Frame};
+use cxx::UniquePtr;
+
+/// Get the maximum size of an encoded depth frame of `width` x `height` pixels.
+/// Encoded frames are never larger than the float frame plus 36 bytes.
+pub fn max_encoded_size(width: usize, height: usize) -> usize {
+  ffi::libfreenect2::max_encoded_depth_size(width as _, height as _) as _
+}
+
+/// Check whether an encoded depth frame is a keyframe,
+/// which can be decoded without the previous frames.
+///
+/// # Arguments
+/// * `data` - The encoded frame.
+///
+/// # Errors
+/// Returns an error if `data` is not an encoded depth frame.
+pub fn is_keyframe(data: &[u8]) -> anyhow::Result<bool> {
+  ffi::libfreenect2::is_depth_keyframe(data).map_err(Into::into)
+}
+
+/// An encoder for the depth frames of a single stream.
+/// Keeps the previous frame to encode the differences,
+/// use a separate encoder for every stream.
+pub struct DepthEncoder(UniquePtr<ffi::libfreenect2::DepthEncoder>);
+
+impl DepthEncoder {
+  /// Create a new encoder.
+  ///
+  /// # Arguments
+  /// * `keyframe_interval` - Encode every `keyframe_interval`th frame as a keyframe.
+  ///   Lower values recover faster from lost frames, higher values compress better.
+  ///   Use 1 to only encode keyframes.
+  ///
+  /// # Errors
+  /// Returns an error if `keyframe_interval` is 0.
+  pub fn new(keyframe_interval: u32) -> anyhow::Result<Self> {
+    ffi::libfreenect2::create_depth_encoder(keyframe_interval)
+      .map(Self)
+      .map_err(Into::into)
+  }
+
+  /// Encode a depth frame into `dst`.
+  /// The metadata of `frame` is stored in the encoded frame.
+  ///
+  /// # Arguments
+  /// * `frame` - The [`FrameFormat::Float`] depth frame to encode.
+  /// * `dst` - The buffer to write to, must hold at least
+  ///   [`max_encoded_size`] bytes for the size of `frame`.
+  ///
+  /// # Errors
+  /// Returns an error if `frame` is not a float frame or `dst` is too small.
+  ///
+  /// # Returns
+  /// The number of bytes written to `dst`.
+  pub fn encode_into<F: Freenect2Frame>(
+    &mut self,
+    frame: &F,
+    dst: &mut [u8],
+  ) -> anyhow::Result<usize> {
+    anyhow::ensure!(
+      frame.format() == FrameFormat::Float && frame.bytes_per_pixel() == 4,
+      "Expected a frame with format Float, got a frame with format {:?}",
+      frame.format()
+    );
+
+    self
+      .0
+      .as_mut()
+      .ok_or(anyhow::anyhow!("The encoder is not initialized"))?
+      .encode(
+        &packed_data(frame),
+        frame.width() as _,
+        frame.height() as _,
+        frame.timestamp(),
+        frame.sequence(),
+        frame.status(),
+        dst,
+      )
+      .map(|size| size as _)
+      .map_err(Into::into)
+  }
+
+  /// Encode a depth frame into `out`, replacing its contents.
+  /// Reuse `out` between frames to avoid allocating.
+  ///
+  /// # Arguments
+  /// * `frame` - The [`FrameFormat::Float`] depth frame to encode.
+  /// * `out` - The buffer to store the encoded frame in.
+  ///
+  /// # Errors
+  /// Returns an error if `frame` is not a float frame.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::depth_codec::{DepthDecoder, DepthEncoder};
+  /// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+  ///
+  /// let mut encoder = DepthEncoder::new(30).unwrap();
+  /// let mut decoder = DepthDecoder::new().unwrap();
+  /// let mut encoded = Vec::new();
+  ///
+  /// encoder.encode(&Frame::depth(), &mut encoded).unwrap();
+  /// let decoded = decoder.decode(&encoded).unwrap();
+  /// assert_eq!((decoded.width(), decoded.height()), (512, 424));
+  /// ```
+  pub fn encode<F: Freenect2Frame>(&mut self, frame: &F, out: &mut Vec<u8>) -> anyhow::Result<()> {
+    // Only reserve the space, zero-filling it on every frame would cost as much as encoding
+    out.clear();
+    out.reserve(max_encoded_size(frame.width(), frame.height()));
+    let spare = out.spare_capacity_mut();
+    // SAFETY: The encoder only writes to the buffer and returns how many bytes it wrote
+    let dst =
+      unsafe { std::slice::from_raw_parts_mut(spare.as_mut_ptr().cast::<u8>(), spare.len()) };
+    let size = self.encode_into(frame, dst)?;
+    // SAFETY: The first `size` bytes were written by the encoder
+    unsafe { out.set_len(size) };
+
+    Ok(())
+  }
+
+  /// Encode the next frame as a keyframe, e.g. when a new client connects.
+  pub fn force_keyframe(&mut self) {
+    if let Some(encoder) = self.0.as_mut() {
+      encoder.force_keyframe();
+    }
+  }
+}
+
+unsafe impl Send for DepthEncoder {}
+
+/// A decoder for the frames of a [`DepthEncoder`].
+pub struct DepthDecoder(UniquePtr<ffi::libfreenect2::DepthDecoder>);
+
+impl DepthDecoder {
+  /// Create a new decoder, which waits for a keyframe.
+  ///
+  /// # Errors
+  /// Returns an error if the decoder could not be created.
+  pub fn new() -> anyhow::Result<Self> {
+    ffi::libfreenect2::create_depth_decoder()
+      .map(Self)
+      .map_err(Into::into)
+  }
+
+  /// Decode an encoded depth frame to a [`FrameFormat::Float`]
+  /// frame with depths in millimeters and the original metadata.
+  /// The decoded frame can be passed to the registration.
+  ///
+  /// # Arguments
+  /// * `data` - The encoded frame.
+  ///
+  /// # Errors
+  /// Returns an error if `data` is corrupted or is not a keyframe and the
+  /// previous frame was not decoded. Keep decoding, the next keyframe
+  /// will succeed.
+  pub fn decode(&mut self, data: &[u8]) -> anyhow::Result<Frame<'static>> {
+    self
+      .0
+      .as_mut()
+      .ok_or(anyhow::anyhow!("The decoder is not initialized"))?
+      .decode(data)
+      .map(Frame::new)
+      .map_err(Into::into)
+  }
+
+  /// Forget the previous frame, so only a keyframe can be decoded next.
+  pub fn reset(&mut self) {
+    if let Some(decoder) = self.0.as_mut() {
+      decoder.reset();
+    }
+  }
+}
+
+unsafe impl Send for DepthDecoder {}
@@ -0,0 +1,186 @@
+//! Post-processing of depth frames in native code:
+//! range clipping, decimation, hole filling and temporal smoothing.
+//!
+//! Attach the post-processing to a device using
+//! [`crate::freenect2_device::Freenect2Device::set_depth_post_processing`]
+//! to process every depth frame in place before it is passed to the
+//! IR and depth frame listener, or process single frames using a
+//! [`DepthPostProcessor`].
+//! Decimated frames can't be registered, as the registration
+//! requires depth frames with a resolution of 512x424.
+
+use crate::ffi;
+use crate::frame::{packed_data, Frame, FrameFormat, Freenect2Frame};
+use cxx::UniquePtr;
+
+pub use crate::ffi::libfreenect2::DepthDecimation;
+
+impl Default for DepthDecimation {
+  fn default() -> Self {
+    DepthDecimation::Full
+  }
+}
+
+impl DepthDecimation {
+  /// Get the factor the width and height are divided by, e.g. 4 for [`DepthDecimation::Quarter`].
+  pub fn factor(&self) -> usize {
+    match *self {
+      DepthDecimation::Half => 2,
+      DepthDecimation::Quarter => 4,
+      _ => 1,
+    }
+  }
+
+  /// Get the size of a decimated frame of `width` x `height` pixels.
+  /// Pixels which don't fill a whole block are dropped.
+  pub fn decimated_size(&self, width: usize, height: usize) -> (usize, usize) {
+    (width / self.factor(), height / self.factor())
+  }
+}
+
+/// Exponential smoothing of depths between frames.
+/// Every depth is moved towards the current depth by `alpha`, unless the
+/// depth changed by `threshold` or more, in which case the current depth
+/// is used as is, so moving edges don't smear.
+#[derive(Debug, Copy, Clone, PartialEq)]
+pub struct TemporalFilter {
+  /// The weight of the current frame, in (0, 1].
+  /// Lower values smooth more.
+  pub alpha: f32,
+  /// The change between frames in millimeters
+  /// above which depths are not smoothed.
+  pub threshold: f32,
+}
+
+impl Default for TemporalFilter {
+  fn default() -> Self {
+    Self {
+      alpha: 0.4,
+      threshold: 50.0,
+    }
+  }
+}
+
+/// Options for post-processing depth frames.
+/// The enabled stages run in the order of the fields.
+/// The default options disable every stage.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::depth_post_processor::{DepthDecimation, DepthPostProcessing, TemporalFilter};
+///
+/// let options = DepthPostProcessing {
+///   range: Some((500.0, 4500.0)),
+///   decimation: DepthDecimation::Half,
+///   hole_fill_radius: 1,
+///   temporal: Some(TemporalFilter::default()),
+/// };
+/// ```
+#[derive(Debug, Copy, Clone, PartialEq, Default)]
+pub struct DepthPostProcessing {
+  /// The minimum and maximum depth in millimeters.
+  /// Depths outside the range are set to invalid.
+  pub range: Option<(f32, f32)>,
+  /// The factor to decimate by. Every block of pixels is replaced
+  /// with the mean of its valid depths.
+  pub decimation: DepthDecimation,
+  /// Fill invalid pixels with the nearest valid depth in a window
+  /// of `2 * hole_fill_radius + 1` pixels. Disabled if 0, at most 8.
+  pub hole_fill_radius: u32,
+  /// Smooth depths between frames.
+  pub temporal: Option<TemporalFilter>,
+}
+
+impl DepthPostProcessing {
+  pub(crate) fn to_params(self) -> ffi::libfreenect2::DepthPostProcessingParams {
+    let (min_depth, max_depth) = self.range.unwrap_or_default();
+    let temporal = self.temporal.unwrap_or_default();
+
+    ffi::libfreenect2::DepthPostProcessingParams {
+      clip_range: self.range.is_some(),
+      min_depth,
+      max_depth,
+      decimation: self.decimation,
+      hole_fill_radius: self.hole_fill_radius,
+      temporal: self.temporal.is_some(),
+      temporal_alpha: temporal.alpha,
+      temporal_threshold: temporal.threshold,
+    }
+  }
+}
+
+/// A post-processor for the depth frames of a single stream.
+/// Keeps the previous frame for temporal smoothing,
+/// use a separate processor for every stream.
+pub struct DepthPostProcessor(UniquePtr<ffi::libfreenect2::DepthPostProcessor>);
+
+impl DepthPostProcessor {
+  /// Create a new post-processor.
+  ///
+  /// # Arguments
+  /// * `options` - The stages to run.
+  ///
+  /// # Errors
+  /// Returns an error if the options are invalid.
+  pub fn new(options: &DepthPostProcessing) -> anyhow::Result<Self> {
+    ffi::libfreenect2::create_depth_post_processor(&options.to_params())
+      .map(Self)
+      .map_err(Into::into)
+  }
+
+  /// Post-process a copy of a depth frame.
+  /// The metadata of `frame` is copied to the processed frame.
+  ///
+  /// # Arguments
+  /// * `frame` - The [`FrameFormat::Float`] depth frame to process.
+  ///
+  /// # Errors
+  /// Returns an error if `frame` is not a float frame.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::depth_post_processor::{DepthDecimation, DepthPostProcessing, DepthPostProcessor};
+  /// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+  ///
+  /// let mut processor = DepthPostProcessor::new(&DepthPostProcessing {
+  ///   decimation: DepthDecimation::Quarter,
+  ///   ..Default::default()
+  /// })
+  /// .unwrap();
+  ///
+  /// let processed = processor.process(&Frame::depth()).unwrap();
+  /// assert_eq!((processed.width(), processed.height()), (128, 106));
+  /// ```
+  pub fn process<F: Freenect2Frame>(&mut self, frame: &F) -> anyhow::Result<Frame<'static>> {
+    anyhow::ensure!(
+      frame.format() == FrameFormat::Float && frame.bytes_per_pixel() == 4,
+      "Expected a frame with format Float, got a frame with format {:?}",
+      frame.format()
+    );
+
+    self
+      .0
+      .as_mut()
+      .ok_or(anyhow::anyhow!("The post-processor is not initialized"))?
+      .process(
+        &packed_data(frame),
+        frame.width() as _,
+        frame.height() as _,
+        frame.timestamp(),
+        frame.sequence(),
+        frame.status(),
+      )
+      .map(Frame::new)
+      .map_err(Into::into)
+  }
+
+  /// Forget the previous frame, so the next frame isn't smoothed.
+  /// Call this after a gap in the stream.
+  pub fn reset(&mut self) {
+    if let Some(processor) = self.0.as_mut() {
+      processor.reset();
+    }
+  }
+}
+
+unsafe impl Send for DepthPostProcessor {}
@@ -0,0 +1,510 @@
+use crate::frame::Freenect2Frame;
+use crate::frame_listener::{FrameListener, FrameMap, FrameTypes};
+use crate::frame_pool::FramePool;
+use crate::frame_synchronizer::{Matcher, SyncStatistics, SyncStats};
+use crate::types::frame::Frame;
+use crate::types::frame_type::FrameType;
+use crate::types::freenect2::{Freenect2, PacketPipeline, RawPackets};
+use crate::types::freenect2_device::Freenect2Device;
+use crate::types::gpu_device::DevicePlacement;
+use crate::util::bounded_queue::BoundedQueue;
+use anyhow::{anyhow, Context};
+use std::sync::atomic::Ordering;
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+pub use crate::util::bounded_queue::DropPolicy;
+
+/// Options for opening a [`DeviceGroup`].
+#[derive(Clone)]
+pub struct DeviceGroupOptions {
+  /// The serial numbers of the devices to open, in group order.
+  /// If [`None`], all connected devices are opened in enumeration order.
+  pub serials: Option<Vec<String>>,
+  /// The packet pipeline every device is opened with.
+  /// Each device gets its own pipeline instance and processing thread.
+  pub pipeline: PacketPipeline,
+  /// The GPU each pipeline is placed on.
+  /// Use [`DevicePlacement::RoundRobin`] to spread the devices over all GPUs.
+  pub placement: DevicePlacement,
+  /// The streams every device delivers as undecoded packets.
+  /// See [`RawPackets`] for details.
+  pub raw_packets: RawPackets,
+  /// The frame types a set of frames of a single device consists of.
+  /// The streams each device is started with are derived from them.
+  pub frame_types: Vec<FrameType>,
+  /// The maximum difference between the timestamps of
+  /// the frame sets of all devices in a group frame set.
+  /// The default is 133, which is half a frame at 30Hz.
+  pub tolerance: u32,
+  /// The maximum number of unpaired frame sets to keep per device.
+  /// The default is 4.
+  pub max_pending: usize,
+  /// The maximum number of group frame sets to buffer.
+  /// The default is 2.
+  pub queue_capacity: usize,
+  /// What to do with a new group frame set if the queue is full.
+  pub drop_policy: DropPolicy,
+  /// Take frames from this pool instead of allocating new ones.
+  /// Shared by all devices, so it should hold frames for every device.
+  pub pool: Option<FramePool>,
+}
+
+impl Default for DeviceGroupOptions {
+  fn default() -> Self {
+    Self {
+      serials: None,
+      pipeline: PacketPipeline::default(),
+      placement: DevicePlacement::default(),
+      raw_packets: RawPackets::default(),
+      frame_types: vec![FrameType::Color, FrameType::Depth],
+      tolerance: 133,
+      max_pending: 4,
+      queue_capacity: 2,
+      drop_policy: DropPolicy::default(),
+      pool: None,
+    }
+  }
+}
+
+/// How long it took to bring up a device of a [`DeviceGroup`].
+/// Retrieved using [`DeviceGroup::startup`].
+#[derive(Debug, Clone, PartialEq)]
+pub struct DeviceStartup {
+  /// The serial number of the device.
+  pub serial: String,
+  /// The time it took to open the device.
+  /// Includes waiting for other devices to be opened,
+  /// as libfreenect2 opens one device at a time.
+  pub open_duration: Duration,
+  /// The time it took to start the streams of the device.
+  pub start_duration: Duration,
+}
+
+/// A set of frame sets, one per device of a [`DeviceGroup`], in group order.
+pub struct GroupFrameSet<T: From<Frame<'static>>> {
+  /// The frame sets of the devices.
+  pub frames: Vec<FrameMap<T>>,
+  /// The difference between the oldest and the newest
+  /// timestamp in the set, mapped to the host clock.
+  pub delta: u32,
+}
+
+/// Maps device timestamps to the host clock.
+/// Device clocks are unrelated to each other, so timestamps of different devices
+/// can only be compared after subtracting the offset of each device clock.
+/// The offset is the smallest difference between the arrival time and the
+/// timestamp, which filters out the varying USB and decoding latency.
+/// Device clocks drift relative to the host clock, so the minimum is only taken
+/// over the last one to two [`Self::WINDOW`]s instead of the whole capture.
+pub(crate) struct HostClock {
+  epoch: Instant,
+  offsets: Mutex<OffsetWindow>,
+}
+
+/// The smallest offsets of the current and the previous window.
+struct OffsetWindow {
+  start: Instant,
+  current: i64,
+  previous: i64,
+}
+
+impl HostClock {
+  /// Host clock ticks per second, the same unit as [`Freenect2Frame::timestamp`].
+  const TICKS_PER_SECOND: f64 = 8000.0;
+
+  /// How often the offset is re-estimated.
+  /// Long enough to see a frame with the smallest latency,
+  /// short enough for the drift within a window to stay far below the tolerance.
+  pub(crate) const WINDOW: Duration = Duration::from_secs(5);
+
+  pub(crate) fn new(epoch: Instant) -> Self {
+    Self {
+      epoch,
+      offsets: Mutex::new(OffsetWindow {
+        start: epoch,
+        current: i64::MAX,
+        previous: i64::MAX,
+      }),
+    }
+  }
+
+  /// Map a device timestamp that arrived at `now` to the host clock.
+  pub(crate) fn map(&self, timestamp: u32, now: Instant) -> u32 {
+    let host =
+      (now.saturating_duration_since(self.epoch).as_secs_f64() * Self::TICKS_PER_SECOND) as i64;
+    let offset = host - timestamp as i64;
+
+    let mut offsets = self.offsets.lock().unwrap_or_else(|e| e.into_inner());
+    if now.saturating_duration_since(offsets.start) >= Self::WINDOW {
+      offsets.start = now;
+      offsets.previous = offsets.current;
+      offsets.current = offset;
+    } else {
+      offsets.current = offsets.current.min(offset);
+    }
+
+    (timestamp as i64 + offsets.current.min(offsets.previous)) as u32
+  }
+}
+
+/// The frame set of a single device that is currently being collected.
+struct DeviceFrames<T: From<Frame<'static>>> {
+  frames: FrameMap<T>,
+  timestamp: Option<u32>,
+}
+
+/// The state shared between the listeners of all devices.
+struct GroupState<T: From<Frame<'static>>> {
+  matcher: Mutex<Matcher<usize, FrameMap<T>>>,
+  stats: SyncStats,
+  queue: BoundedQueue<GroupFrameSet<T>>,
+}
+
+struct GroupDevice {
+  device: Freenect2Device<'static>,
+  startup: DeviceStartup,
+}
+
+unsafe impl Send for GroupDevice {}
+
+/// A group of devices opened and started together.
+/// The devices are opened one after another, as libfreenect2 does not support
+/// opening devices concurrently, and are started concurrently.
+/// Every device gets its own packet pipeline and listener.
+/// The frame sets of all devices are aligned by their timestamps
+/// and returned as a [`GroupFrameSet`].
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::device_group::{DeviceGroup, DeviceGroupOptions};
+/// use libfreenect2_rs::frame::SharedFrame;
+///
+/// let group = DeviceGroup::<SharedFrame>::open(DeviceGroupOptions::default()).unwrap();
+/// for startup in group.startup() {
+///   println!("{}: opened in {:?}, started in {:?}",
+///     startup.serial, startup.open_duration, startup.start_duration);
+/// }
+///
+/// let set = group.get_frames().unwrap();
+/// println!("Got frames of {} devices, {} apart", set.frames.len(), set.delta);
+/// ```
+pub struct DeviceGroup<T: From<Frame<'static>> + Send + Sync> {
+  // The devices must be dropped before their listeners and the freenect2 instance
+  devices: Vec<GroupDevice>,
+  _listeners: Vec<Box<FrameListener<'static>>>,
+  state: Arc<GroupState<T>>,
+  _freenect2: Freenect2,
+}
+
+impl<T: From<Frame<'static>> + Send + Sync + 'static> DeviceGroup<T> {
+  /// Enumerate the connected devices once, then open and start the selected devices.
+  ///
+  /// # Arguments
+  /// * `options` - The options for the group.
+  ///
+  /// # Errors
+  /// Returns an error if the options are invalid, no device is found,
+  /// a requested device is not connected or any device fails to open or start.
+  /// Devices that were already opened are closed again in this case.
+  pub fn open(options: DeviceGroupOptions) -> anyhow::Result<Self> {
+    anyhow::ensure!(
+      !options.frame_types.is_empty(),
+      "At least one frame type must be specified"
+    );
+    anyhow::ensure!(
+      options.max_pending > 0,
+      "At least one pending frame set must be allowed per device"
+    );
+
+    let mut freenect2 = Freenect2::new()?;
+    let count = freenect2.enumerate_devices()?;
+    let connected = (0..count)
+      .map(|i| freenect2.get_device_serial_number(i))
+      .collect::<anyhow::Result<Vec<_>>>()?;
+
+    let serials = match options.serials.clone() {
+      Some(serials) => {
+        for serial in &serials {
+          anyhow::ensure!(
+            connected.contains(serial),
+            "Device with serial {} is not connected",
+            serial
+          );
+        }
+
+        serials
+      }
+      None => connected,
+    };
+    anyhow::ensure!(!serials.is_empty(), "No devices found");
+
+    let indices = (0..serials.len()).collect::<Vec<_>>();
+    let state = Arc::new(GroupState {
+      matcher: Mutex::new(Matcher::new(
+        &indices,
+        options.tolerance,
+        options.max_pending,
+      )),
+      stats: SyncStats::default(),
+      queue: BoundedQueue::new(options.queue_capacity, options.drop_policy)?,
+    });
+
+    let epoch = Instant::now();
+    let listeners = indices
+      .iter()
+      .map(|&index| Self::create_listener(index, &options, state.clone(), epoch).map(Box::new))
+      .collect::<anyhow::Result<Vec<_>>>()?;
+
+    let color = options.frame_types.contains(&FrameType::Color);
+    let depth = options.frame_types.contains(&FrameType::Depth)
+      || options.frame_types.contains(&FrameType::Ir);
+
+    let results = std::thread::scope(|scope| {
+      let threads = serials
+        .iter()
+        .zip(listeners.iter())
+        .map(|(serial, listener)| {
+          // SAFETY: The listeners are boxed and only dropped after the devices
+          let listener: &'static FrameListener<'static> =
+            unsafe { &*(listener.as_ref() as *const FrameListener<'static>) };
+          let pipeline = options.pipeline;
+          let placement = options.placement;
+          let raw_packets = options.raw_packets;
+
+          scope.spawn(move || {
+            Self::start_device(
+              serial,
+              pipeline,
+              placement,
+              raw_packets,
+              listener,
+              color,
+              depth,
+            )
+            .with_context(|| format!("Failed to start device with serial {serial}"))
+          })
+        })
+        .collect::<Vec<_>>();
+
+      threads
+        .into_iter()
+        .map(|thread| {
+          thread
+            .join()
+            .unwrap_or_else(|_| Err(anyhow!("Device thread panicked")))
+        })
+        .collect::<Vec<_>>()
+    });
+
+    let mut devices = Vec::with_capacity(results.len());
+    let mut error = None;
+    for result in results {
+      match result {
+        Ok(device) => devices.push(device),
+        Err(e) => {
+          error.get_or_insert(e);
+        }
+      }
+    }
+
+    let group = Self {
+      devices,
+      _listeners: listeners,
+      state,
+      _freenect2: freenect2,
+    };
+
+    match error {
+      Some(e) => Err(e),
+      None => Ok(group),
+    }
+  }
+
+  fn create_listener(
+    index: usize,
+    options: &DeviceGroupOptions,
+    state: Arc<GroupState<T>>,
+    epoch: Instant,
+  ) -> anyhow::Result<FrameListener<'static>> {
+    let types = FrameTypes::new(&options.frame_types);
+    let timestamp_from_depth = options.frame_types.iter().any(|ty| *ty != FrameType::Color);
+    let clock = Arc::new(HostClock::new(epoch));
+    let current = Arc::new(Mutex::new(DeviceFrames {
+      frames: FrameMap::default(),
+      timestamp: None,
+    }));
+
+    let on_new_frame = move |ty: FrameType, frame: Frame<'static>| {
+      let arrival = Instant::now();
+      let mut current = current
+        .lock()
+        .map_err(|e| anyhow!("Failed to lock frame map: {e}"))?;
+
+      // IR and depth frames are decoded from the same packet,
+      // use their timestamp if the set contains any
+      if !timestamp_from_depth || ty != FrameType::Color {
+        current.timestamp = Some(clock.map(frame.timestamp(), arrival));
+      }
+      current.frames.insert(ty, T::from(frame));
+
+      if !current.frames.contains_values(&types) {
+        return Ok(());
+      }
+
+      let frames = std::mem::take(&mut current.frames);
+      let key = current.timestamp.take().unwrap_or_default();
+      drop(current);
+
+      let (matched, discarded) = {
+        let mut matcher = state
+          .matcher
+          .lock()
+          .map_err(|e| anyhow!("Failed to lock frame matcher: {e}"))?;
+        let matched = matcher.push(index, key, frames);
+
+        (matched, std::mem::take(&mut matcher.discarded))
+      };
+
+      state
+        .stats
+        .discarded
+        .fetch_add(discarded, Ordering::Relaxed);
+      for set in matched {
+        state.stats.record_match(set.delta);
+        state.queue.push(GroupFrameSet {
+          frames: set.frames.into_iter().map(|(_, frames)| frames).collect(),
+          delta: set.delta,
+        });
+      }
+
+      Ok(())
+    };
+
+    match &options.pool {
+      Some(pool) => FrameListener::new_pooled(pool, on_new_frame),
+      None => FrameListener::new(on_new_frame),
+    }
+  }
+
+  fn start_device(
+    serial: &str,
+    pipeline: PacketPipeline,
+    placement: DevicePlacement,
+    raw_packets: RawPackets,
+    listener: &'static FrameListener<'static>,
+    color: bool,
+    depth: bool,
+  ) -> anyhow::Result<GroupDevice> {
+    let started = Instant::now();
+    let mut freenect2 = Freenect2::new()?;
+
+    // SAFETY: The group keeps a freenect2 instance alive until the device is dropped
+    let mut device = unsafe {
+      freenect2.open_detached_device_by_serial(
+        serial,
+        pipeline,
+        placement.device_id(pipeline),
+        raw_packets,
+      )?
+    };
+    let open_duration = started.elapsed();
+
+    if color {
+      device.set_color_frame_listener(listener)?;
+    }
+    if depth {
+      device.set_ir_and_depth_frame_listener(listener)?;
+    }
+
+    let started = Instant::now();
+    device.start_streams(color, depth)?;
+
+    Ok(GroupDevice {
+      device,
+      startup: DeviceStartup {
+        serial: serial.to_string(),
+        open_duration,
+        start_duration: started.elapsed(),
+      },
+    })
+  }
+
+  /// Get the number of devices in the group.
+  pub fn len(&self) -> usize {
+    self.devices.len()
+  }
+
+  /// Returns `true` if the group contains no devices.
+  pub fn is_empty(&self) -> bool {
+    self.devices.is_empty()
+  }
+
+  /// Get the startup times of all devices, in group order.
+  pub fn startup(&self) -> Vec<DeviceStartup> {
+    self
+      .devices
+      .iter()
+      .map(|device| device.startup.clone())
+      .collect()
+  }
+
+  /// Get a device of the group by its index in group order.
+  pub fn device(&mut self, index: usize) -> Option<&mut Freenect2Device<'static>> {
+    self.devices.get_mut(index).map(|device| &mut device.device)
+  }
+
+  /// Get the next set of aligned frame sets.
+  /// This will block until a frame set of every device has been paired.
+  pub fn get_frames(&self) -> anyhow::Result<GroupFrameSet<T>> {
+    self
+      .state
+      .queue
+      .pop(None)
+      .ok_or_else(|| anyhow!("Failed to receive frames"))
+  }
+
+  /// Get the next set of aligned frame sets with a timeout.
+  ///
+  /// # Arguments
+  /// * `timeout` - The maximum amount of time to wait for the frames.
+  ///
+  /// # Errors
+  /// Returns an error if the frames are not received within the timeout.
+  pub fn get_frames_with_timeout(&self, timeout: Duration) -> anyhow::Result<GroupFrameSet<T>> {
+    self
+      .state
+      .queue
+      .pop(Some(timeout))
+      .ok_or_else(|| anyhow!("Timed out waiting for frames"))
+  }
+
+  /// Get the current pairing statistics.
+  /// The deltas are in the unit of [`Freenect2Frame::timestamp`].
+  pub fn statistics(&self) -> SyncStatistics {
+    self.state.stats.snapshot()
+  }
+
+  /// Get the number of group frame sets dropped because the queue was full.
+  pub fn dropped_count(&self) -> u64 {
+    self.state.queue.dropped_count()
+  }
+
+  /// Stop the streams of all devices.
+  ///
+  /// # Errors
+  /// Returns the first error if any device could not be stopped.
+  /// All devices are stopped regardless.
+  pub fn stop(&mut self) -> anyhow::Result<()> {
+    let mut res = Ok(());
+    for device in &mut self.devices {
+      if let Err(e) = device.device.stop() {
+        if res.is_ok() {
+          res = Err(e.context(format!("Failed to stop device {}", device.startup.serial)));
+        }
+      }
+    }
+
+    res
+  }
+}
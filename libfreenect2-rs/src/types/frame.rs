@@ -1,11 +1,12 @@
+use std::borrow::Cow;
 use std::ops::Deref;
+use std::sync::Arc;
 use std::time::Duration;
 
 use crate::ffi;
-#[cfg(feature = "image")]
-use crate::frame_data::FrameDataValue;
 use crate::frame_data::{FloatData, FrameData, GrayData, RGBXData, RawData, RGBX};
 use crate::frame_value::FrameValue;
+use crate::frame_view::{FrameView, Region};
 
 /// A [`Frame`] or a reference to a [`Frame`].
 pub enum FrameReference<'a, 'b: 'a> {
@@ -46,7 +47,7 @@ impl<'a, 'b: 'a> From<&'a Frame<'b>> for FrameReference<'a, 'b> {
 
 /// A trait for types that can be converted to
 /// a reference to a [`Frame`] or are a [`Frame`].
-/// Currently implemented by [`Frame`] and [`OwnedFrame`].
+/// Currently implemented by [`Frame`], [`OwnedFrame`] and [`SharedFrame`].
 pub trait AsFrame<'a, 'b: 'a> {
   /// Returns a reference to a [`Frame`].
   fn as_frame(&'a self) -> FrameReference<'a, 'b>;
@@ -110,7 +111,8 @@ impl From<FrameFormat> for ffi::libfreenect2::FrameFormat {
 }
 
 /// A trait for frame types.
-/// This trait is implemented for both [`Frame`] and [`OwnedFrame`].
+/// This trait is implemented for [`Frame`], [`OwnedFrame`], [`SharedFrame`]
+/// and [`FrameView`].
 pub trait Freenect2Frame: Send + Sync {
   /// Returns the width of the frame in pixels.
   fn width(&self) -> usize;
@@ -134,17 +136,70 @@ pub trait Freenect2Frame: Send + Sync {
   }
 
   /// Returns the raw data of the frame.
-  /// The data is stored in row-major order.
-  /// The length of the data must be equal to `width * height * bytes_per_pixel`.
-  /// The length can also be retrieved using [`Self::raw_data_len`].
+  /// The data is stored in row-major order, rows start
+  /// every [`Self::row_pitch`] bytes.
+  /// If the frame is contiguous, the length of the data must be equal to
+  /// `width * height * bytes_per_pixel`, which can also be retrieved using
+  /// [`Self::raw_data_len`]. Otherwise, the data ends with the last pixel
+  /// of the last row.
   fn raw_data(&self) -> &[u8];
 
-  /// Returns the length of the raw data.
+  /// Returns the length of the pixel data, without any padding between rows.
   /// The length is equal to `width * height * bytes_per_pixel`.
   fn raw_data_len(&self) -> usize {
     self.width() * self.height() * self.bytes_per_pixel()
   }
 
+  /// Returns the number of bytes from the start of one row to the start of the next one.
+  /// Equal to `width * bytes_per_pixel` unless the frame is a [`FrameView`]
+  /// of a wider frame.
+  fn row_pitch(&self) -> usize {
+    self.width() * self.bytes_per_pixel()
+  }
+
+  /// Returns whether the rows of the frame follow each other without padding,
+  /// in which case [`Self::raw_data`] holds exactly [`Self::raw_data_len`] bytes.
+  fn is_contiguous(&self) -> bool {
+    self.height() <= 1 || self.row_pitch() == self.width() * self.bytes_per_pixel()
+  }
+
+  /// Returns the data of row `y`, without any padding.
+  ///
+  /// # Panics
+  /// Panics if `y >=` [`Self::height`].
+  fn row(&self, y: usize) -> &[u8] {
+    assert!(y < self.height(), "y: {} >= height: {}", y, self.height());
+
+    let start = y * self.row_pitch();
+    &self.raw_data()[start..start + self.width() * self.bytes_per_pixel()]
+  }
+
+  /// Returns a view of `region` of the frame.
+  /// The view borrows the data of the frame, no data is copied.
+  /// See [`FrameView`] for details.
+  ///
+  /// # Errors
+  /// Returns an error if the region is empty or not within the frame,
+  /// or if the frame doesn't hold pixels.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+  /// use libfreenect2_rs::frame_view::Region;
+  ///
+  /// let frame = Frame::depth();
+  /// let view = frame.view(Region::new(100, 50, 64, 32)).unwrap();
+  ///
+  /// assert_eq!((view.width(), view.height()), (64, 32));
+  /// assert_eq!(view.row_pitch(), frame.row_pitch());
+  /// ```
+  fn view(&self, region: Region) -> anyhow::Result<FrameView<'_>>
+  where
+    Self: Sized,
+  {
+    FrameView::new(self, region)
+  }
+
   /// Increasing sequence number
   fn sequence(&self) -> u32;
 
@@ -192,28 +247,18 @@ pub trait Freenect2Frame: Send + Sync {
   {
     match self.format() {
       FrameFormat::BGRX | FrameFormat::RGBX => {
-        let data = self
-          .data()
-          .expect_rgbx()
-          .iter()
-          .flat_map(|row| row.flat_map(|value| value.raw()[..3].to_vec()))
-          .collect::<Vec<_>>();
-
-        image::RgbImage::from_raw(self.width() as _, self.height() as _, data)
-          .map_or(FrameImage::Invalid, FrameImage::RGB)
+        crate::frame_convert::to_rgb_image(self).map_or(FrameImage::Invalid, FrameImage::RGB)
       }
       FrameFormat::Gray => image::GrayImage::from_raw(
         self.width() as _,
         self.height() as _,
-        self.raw_data().to_vec(),
+        packed_data(self).into_owned(),
       )
       .map_or(FrameImage::Invalid, FrameImage::Gray),
       FrameFormat::Float => {
-        let data = self
-          .data()
-          .expect_float()
-          .iter()
-          .flatten()
+        let data = packed_data(self)
+          .chunks_exact(4)
+          .map(|value| f32::from_ne_bytes(value.try_into().unwrap()))
           .collect::<Vec<_>>();
 
         image::ImageBuffer::from_raw(self.width() as _, self.height() as _, data)
@@ -265,7 +310,7 @@ pub trait Freenect2Frame: Send + Sync {
     assert!(x < self.width(), "x: {} >= width: {}", x, self.width());
     assert!(y < self.height(), "y: {} >= height: {}", y, self.height());
 
-    let index = (y * self.width() + x) * self.bytes_per_pixel();
+    let index = y * self.row_pitch() + x * self.bytes_per_pixel();
     let data = self.raw_data();
     match self.format() {
       FrameFormat::RGBX => FrameValue::RGBX(RGBX {
@@ -324,10 +369,26 @@ pub trait Freenect2Frame: Send + Sync {
   }
 }
 
+/// Get the pixel data of a frame without any padding between rows.
+/// Borrows the data of contiguous frames and only copies the rows of other frames.
+pub(crate) fn packed_data(frame: &dyn Freenect2Frame) -> Cow<'_, [u8]> {
+  if frame.is_contiguous() {
+    return Cow::Borrowed(frame.raw_data());
+  }
+
+  let mut data = Vec::with_capacity(frame.raw_data_len());
+  for y in 0..frame.height() {
+    data.extend_from_slice(frame.row(y));
+  }
+
+  Cow::Owned(data)
+}
+
 /// A native libfreenect2 frame.
 /// Contains an owned pointer to a libfreenect2 frame.
-/// Can't be cloned or copied. Use [`OwnedFrame`] for that,
-/// which can be created using [`Frame::to_owned`].
+/// Can't be cloned or copied. Use [`SharedFrame`] to share the
+/// frame without copying it, which can be created using [`Frame::into_shared`],
+/// or [`OwnedFrame`] for a copy, which can be created using [`Frame::to_owned`].
 pub struct Frame<'a> {
   pub(crate) inner: cxx::UniquePtr<ffi::libfreenect2::Frame<'a>>,
   width: usize,
@@ -429,9 +490,16 @@ impl<'a> Frame<'a> {
     })
   }
 
+  /// The steady clock time in nanoseconds at which the native listener
+  /// received the frame, or 0 if it wasn't received from a device.
+  pub(crate) fn received_ns(&self) -> u64 {
+    unsafe { self.inner.received_ns() }
+  }
+
   /// Convert the frame to an owned frame.
   /// The owned frame has the same data as the original frame.
   /// Copies the data of the frame.
+  /// Use [`Self::into_shared`] if you don't need a copy.
   pub fn to_owned(&self) -> OwnedFrame {
     OwnedFrame {
       width: self.width(),
@@ -449,6 +517,25 @@ impl<'a> Frame<'a> {
   }
 }
 
+impl Frame<'static> {
+  /// Convert the frame into a [`SharedFrame`].
+  /// The native frame is moved behind a shared reference count,
+  /// no data is copied.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+  ///
+  /// let shared = Frame::depth().into_shared();
+  /// let clone = shared.clone();
+  ///
+  /// assert_eq!(shared.raw_data().as_ptr(), clone.raw_data().as_ptr());
+  /// ```
+  pub fn into_shared(self) -> SharedFrame {
+    SharedFrame(Arc::new(self))
+  }
+}
+
 impl<'a, 'b: 'a> AsFrame<'a, 'b> for Frame<'b> {
   fn as_frame(&'a self) -> FrameReference<'a, 'b> {
     FrameReference::Borrowed(self)
@@ -523,6 +610,41 @@ pub struct OwnedFrame {
 }
 
 impl OwnedFrame {
+  /// Copy any frame into an owned frame.
+  /// Only the pixels of a [`FrameView`] are copied,
+  /// the rows of the owned frame follow each other without padding.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::frame::{Frame, Freenect2Frame, OwnedFrame};
+  /// use libfreenect2_rs::frame_view::Region;
+  ///
+  /// let frame = Frame::color_for_depth();
+  /// let crop = OwnedFrame::from_frame(&frame.view(Region::new(8, 8, 16, 16)).unwrap());
+  ///
+  /// assert_eq!(crop.raw_data().len(), 16 * 16 * 4);
+  /// ```
+  pub fn from_frame(frame: &dyn Freenect2Frame) -> Self {
+    Self::from_data(frame, packed_data(frame).into_owned())
+  }
+
+  /// Create an owned frame with the metadata of `frame` and the packed pixels in `data`.
+  pub(crate) fn from_data(frame: &dyn Freenect2Frame, data: Vec<u8>) -> Self {
+    Self {
+      width: frame.width(),
+      height: frame.height(),
+      bytes_per_pixel: frame.bytes_per_pixel(),
+      timestamp: frame.timestamp(),
+      data,
+      sequence: frame.sequence(),
+      exposure: frame.exposure(),
+      gain: frame.gain(),
+      gamma: frame.gamma(),
+      status: frame.status(),
+      format: frame.format(),
+    }
+  }
+
   /// Convert the owned frame to a [`Frame`].
   /// The frame has the same data as the owned frame.
   /// The frame is a borrowed reference to the owned frame.
@@ -614,3 +736,97 @@ impl From<Frame<'_>> for OwnedFrame {
     frame.to_owned()
   }
 }
+
+/// A shared native frame.
+/// Wraps a native libfreenect2 frame behind a shared reference count.
+/// Cloning the frame or moving it to another thread does not copy any data.
+/// The native frame is released once the last clone is dropped.
+/// If the frame was taken from a [`crate::frame_pool::FramePool`],
+/// it is returned to the pool at that point.
+///
+/// Can be created using [`Frame::into_shared`].
+#[derive(Clone)]
+pub struct SharedFrame(Arc<Frame<'static>>);
+
+impl SharedFrame {
+  /// Get a reference to the native frame.
+  pub fn as_native(&self) -> &Frame<'static> {
+    &self.0
+  }
+
+  /// Get the number of clones of this frame, including this one.
+  pub fn ref_count(&self) -> usize {
+    Arc::strong_count(&self.0)
+  }
+
+  /// Try to get the native frame back.
+  /// Succeeds if this is the only reference to the frame,
+  /// returns the shared frame otherwise.
+  pub fn try_unwrap(self) -> Result<Frame<'static>, Self> {
+    Arc::try_unwrap(self.0).map_err(Self)
+  }
+
+  /// Convert the frame to an owned frame.
+  /// Copies the data of the frame.
+  pub fn to_owned(&self) -> OwnedFrame {
+    self.0.to_owned()
+  }
+}
+
+impl Freenect2Frame for SharedFrame {
+  fn width(&self) -> usize {
+    self.0.width()
+  }
+
+  fn height(&self) -> usize {
+    self.0.height()
+  }
+
+  fn bytes_per_pixel(&self) -> usize {
+    self.0.bytes_per_pixel()
+  }
+
+  fn timestamp(&self) -> u32 {
+    self.0.timestamp()
+  }
+
+  fn raw_data(&self) -> &[u8] {
+    self.0.raw_data()
+  }
+
+  fn sequence(&self) -> u32 {
+    self.0.sequence()
+  }
+
+  fn exposure(&self) -> f32 {
+    self.0.exposure()
+  }
+
+  fn gain(&self) -> f32 {
+    self.0.gain()
+  }
+
+  fn gamma(&self) -> f32 {
+    self.0.gamma()
+  }
+
+  fn status(&self) -> u32 {
+    self.0.status()
+  }
+
+  fn format(&self) -> FrameFormat {
+    self.0.format()
+  }
+}
+
+impl<'a> AsFrame<'a, 'static> for SharedFrame {
+  fn as_frame(&'a self) -> FrameReference<'a, 'static> {
+    FrameReference::Borrowed(&self.0)
+  }
+}
+
+impl From<Frame<'static>> for SharedFrame {
+  fn from(frame: Frame<'static>) -> Self {
+    frame.into_shared()
+  }
+}
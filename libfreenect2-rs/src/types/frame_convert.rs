@@ -0,0 +1,369 @@
+//! Bulk conversions of whole frames, backed by vectorized kernels.
+//! Prefer these over iterating over [`Freenect2Frame::data`]
+//! when converting every pixel of a frame.
+//!
+//! All conversions write into caller provided buffers, which may be
+//! reused between frames. With the `image` feature enabled, the
+//! `*_image` functions convert straight into newly allocated images.
+//!
+//! Frames with padding between their rows, like a [`crate::frame_view::FrameView`],
+//! are converted row by row, so only the pixels of the view are read.
+
+use crate::ffi;
+use crate::frame::{FrameFormat, Freenect2Frame};
+
+pub use crate::ffi::libfreenect2::{Colormap, PixelLayout};
+
+/// The maximum value of IR frames.
+pub const MAX_IR_VALUE: f32 = 65535.0;
+
+impl PixelLayout {
+  /// Get the number of bytes per pixel of this layout.
+  pub fn bytes_per_pixel(&self) -> usize {
+    match *self {
+      PixelLayout::RGB | PixelLayout::BGR => 3,
+      _ => 4,
+    }
+  }
+
+  /// Get the layout of frames of `format`.
+  /// Returns [`None`] if `format` is not a color format.
+  pub fn of_format(format: FrameFormat) -> Option<Self> {
+    match format {
+      FrameFormat::RGBX => Some(PixelLayout::RGBA),
+      FrameFormat::BGRX => Some(PixelLayout::BGRA),
+      _ => None,
+    }
+  }
+}
+
+fn ensure_format<F: Freenect2Frame>(frame: &F, format: FrameFormat) -> anyhow::Result<()> {
+  anyhow::ensure!(
+    frame.format() == format && has_rows(frame),
+    "Expected a frame with format {:?}, got a frame with format {:?}",
+    format,
+    frame.format()
+  );
+
+  Ok(())
+}
+
+/// Check whether the data of the frame holds all of its rows.
+fn has_rows<F: Freenect2Frame>(frame: &F) -> bool {
+  if frame.is_contiguous() {
+    return frame.raw_data().len() == frame.raw_data_len();
+  }
+
+  frame.raw_data().len()
+    >= (frame.height() - 1) * frame.row_pitch() + frame.width() * frame.bytes_per_pixel()
+}
+
+/// Convert the pixels of `frame` into `dst`, which holds `dst_row_len` values per row.
+/// Contiguous frames are converted in a single call, others row by row.
+fn convert_rows<F: Freenect2Frame, T>(
+  frame: &F,
+  dst: &mut [T],
+  dst_row_len: usize,
+  convert: impl Fn(&[u8], &mut [T]) -> anyhow::Result<()>,
+) -> anyhow::Result<()> {
+  if frame.is_contiguous() {
+    return convert(frame.raw_data(), dst);
+  }
+
+  for (y, dst) in dst
+    .chunks_exact_mut(dst_row_len)
+    .take(frame.height())
+    .enumerate()
+  {
+    convert(frame.row(y), dst)?;
+  }
+
+  Ok(())
+}
+
+fn ensure_len(name: &str, len: usize, required: usize) -> anyhow::Result<()> {
+  anyhow::ensure!(
+    len >= required,
+    "The {} buffer must hold at least {} values, got {}",
+    name,
+    required,
+    len
+  );
+
+  Ok(())
+}
+
+/// Reorder the channels of packed color pixels.
+/// Alpha channels are written as 255. Can be used to convert
+/// [`PixelLayout::RGB`] data back to [`FrameFormat::BGRX`] pixels.
+///
+/// # Arguments
+/// * `src` - The pixels to convert.
+/// * `src_layout` - The layout of `src`.
+/// * `dst` - The buffer to write the converted pixels to.
+///    Must hold at least as many pixels as `src`.
+/// * `dst_layout` - The layout to convert to.
+///
+/// # Errors
+/// Returns an error if `src` holds a partial pixel or `dst` is too small.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame_convert::{convert_pixels, PixelLayout};
+///
+/// let mut bgra = [0; 8];
+/// convert_pixels(&[1, 2, 3, 4, 5, 6], PixelLayout::RGB, &mut bgra, PixelLayout::BGRA).unwrap();
+/// assert_eq!(bgra, [3, 2, 1, 255, 6, 5, 4, 255]);
+/// ```
+pub fn convert_pixels(
+  src: &[u8],
+  src_layout: PixelLayout,
+  dst: &mut [u8],
+  dst_layout: PixelLayout,
+) -> anyhow::Result<()> {
+  anyhow::ensure!(
+    src.len() % src_layout.bytes_per_pixel() == 0,
+    "The source buffer must hold whole {:?} pixels",
+    src_layout
+  );
+  ensure_len(
+    "destination",
+    dst.len(),
+    src.len() / src_layout.bytes_per_pixel() * dst_layout.bytes_per_pixel(),
+  )?;
+
+  ffi::libfreenect2::convert_pixels(src, src_layout, dst, dst_layout).map_err(Into::into)
+}
+
+/// Convert an [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] frame to `layout`.
+///
+/// # Arguments
+/// * `frame` - The color frame to convert.
+/// * `layout` - The layout to convert to.
+/// * `dst` - The buffer to write the pixels to.
+///    Must hold at least `width * height * layout.bytes_per_pixel()` bytes.
+///
+/// # Errors
+/// Returns an error if `frame` is not a color frame or `dst` is too small.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+/// use libfreenect2_rs::frame_convert::{convert_color, PixelLayout};
+///
+/// let frame = Frame::color_for_depth();
+/// let mut rgb = vec![0; frame.width() * frame.height() * 3];
+/// convert_color(&frame, PixelLayout::RGB, &mut rgb).unwrap();
+/// ```
+pub fn convert_color<F: Freenect2Frame>(
+  frame: &F,
+  layout: PixelLayout,
+  dst: &mut [u8],
+) -> anyhow::Result<()> {
+  let src_layout = PixelLayout::of_format(frame.format()).ok_or(anyhow::anyhow!(
+    "Expected a frame with format RGBX or BGRX, got a frame with format {:?}",
+    frame.format()
+  ))?;
+  anyhow::ensure!(
+    frame.bytes_per_pixel() == 4 && has_rows(frame),
+    "The color frame must have 4 bytes per pixel"
+  );
+  ensure_len(
+    "destination",
+    dst.len(),
+    frame.width() * frame.height() * layout.bytes_per_pixel(),
+  )?;
+
+  convert_rows(
+    frame,
+    dst,
+    frame.width() * layout.bytes_per_pixel(),
+    |src, dst| convert_pixels(src, src_layout, dst, layout),
+  )
+}
+
+/// Convert a depth frame to 16 bit depth values in millimeters.
+/// Values are rounded to the nearest millimeter,
+/// invalid values are written as 0.
+///
+/// # Arguments
+/// * `frame` - The [`FrameFormat::Float`] depth frame to convert.
+/// * `dst` - The buffer to write the depth values to.
+///    Must hold at least `width * height` values.
+///
+/// # Errors
+/// Returns an error if `frame` is not a float frame or `dst` is too small.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+/// use libfreenect2_rs::frame_convert::depth_to_millimeters;
+///
+/// let frame = Frame::depth();
+/// let mut depth = vec![0u16; frame.width() * frame.height()];
+/// depth_to_millimeters(&frame, &mut depth).unwrap();
+/// ```
+pub fn depth_to_millimeters<F: Freenect2Frame>(frame: &F, dst: &mut [u16]) -> anyhow::Result<()> {
+  ensure_format(frame, FrameFormat::Float)?;
+  ensure_len("depth", dst.len(), frame.width() * frame.height())?;
+
+  convert_rows(frame, dst, frame.width(), |src, dst| {
+    ffi::libfreenect2::depth_to_millimeters(src, dst).map_err(Into::into)
+  })
+}
+
+/// Map a depth frame to RGB pixels using `colormap`.
+/// Depths outside of `min_depth` and `max_depth` are clamped,
+/// invalid depths are written as black.
+///
+/// # Arguments
+/// * `frame` - The [`FrameFormat::Float`] depth frame to convert.
+/// * `min_depth` - The depth in millimeters mapped to the first color.
+/// * `max_depth` - The depth in millimeters mapped to the last color.
+/// * `colormap` - The colormap to use.
+/// * `dst` - The buffer to write the RGB pixels to.
+///    Must hold at least `width * height * 3` bytes.
+///
+/// # Errors
+/// Returns an error if `frame` is not a float frame, `dst` is too small
+/// or `max_depth` is not greater than `min_depth`.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+/// use libfreenect2_rs::frame_convert::{depth_to_colormap, Colormap};
+///
+/// let frame = Frame::depth();
+/// let mut rgb = vec![0; frame.width() * frame.height() * 3];
+/// depth_to_colormap(&frame, 500.0, 4500.0, Colormap::Jet, &mut rgb).unwrap();
+/// ```
+pub fn depth_to_colormap<F: Freenect2Frame>(
+  frame: &F,
+  min_depth: f32,
+  max_depth: f32,
+  colormap: Colormap,
+  dst: &mut [u8],
+) -> anyhow::Result<()> {
+  ensure_format(frame, FrameFormat::Float)?;
+  anyhow::ensure!(
+    max_depth > min_depth,
+    "The maximum depth must be greater than the minimum depth"
+  );
+  ensure_len("color", dst.len(), frame.width() * frame.height() * 3)?;
+
+  convert_rows(frame, dst, frame.width() * 3, |src, dst| {
+    ffi::libfreenect2::depth_to_colormap(src, min_depth, max_depth, colormap, dst)
+      .map_err(Into::into)
+  })
+}
+
+/// Scale an IR frame from `0..=max_value` to 8 bit gray values.
+/// Values above `max_value` are saturated, so values lower than
+/// [`MAX_IR_VALUE`] brighten the image.
+///
+/// # Arguments
+/// * `frame` - The [`FrameFormat::Float`] IR frame to convert.
+/// * `max_value` - The IR value mapped to white.
+/// * `dst` - The buffer to write the gray values to.
+///    Must hold at least `width * height` bytes.
+///
+/// # Errors
+/// Returns an error if `frame` is not a float frame, `dst` is too small
+/// or `max_value` is not positive.
+pub fn normalize_ir<F: Freenect2Frame>(
+  frame: &F,
+  max_value: f32,
+  dst: &mut [u8],
+) -> anyhow::Result<()> {
+  ensure_format(frame, FrameFormat::Float)?;
+  anyhow::ensure!(max_value > 0.0, "The maximum IR value must be positive");
+  ensure_len("gray", dst.len(), frame.width() * frame.height())?;
+
+  convert_rows(frame, dst, frame.width(), |src, dst| {
+    ffi::libfreenect2::normalize_ir(src, max_value, dst).map_err(Into::into)
+  })
+}
+
+#[cfg(feature = "image")]
+/// Convert an [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] frame to an [`image::RgbImage`].
+/// Only available when the `image` feature is enabled.
+///
+/// # Errors
+/// Returns an error if `frame` is not a color frame.
+pub fn to_rgb_image<F: Freenect2Frame>(frame: &F) -> anyhow::Result<image::RgbImage> {
+  let mut data = vec![0; frame.width() * frame.height() * 3];
+  convert_color(frame, PixelLayout::RGB, &mut data)?;
+
+  image::RgbImage::from_raw(frame.width() as _, frame.height() as _, data)
+    .ok_or(anyhow::anyhow!("The frame has an invalid size"))
+}
+
+#[cfg(feature = "image")]
+/// Convert an [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] frame to an [`image::RgbaImage`].
+/// The alpha channel is set to 255.
+/// Only available when the `image` feature is enabled.
+///
+/// # Errors
+/// Returns an error if `frame` is not a color frame.
+pub fn to_rgba_image<F: Freenect2Frame>(frame: &F) -> anyhow::Result<image::RgbaImage> {
+  let mut data = vec![0; frame.width() * frame.height() * 4];
+  convert_color(frame, PixelLayout::RGBA, &mut data)?;
+
+  image::RgbaImage::from_raw(frame.width() as _, frame.height() as _, data)
+    .ok_or(anyhow::anyhow!("The frame has an invalid size"))
+}
+
+#[cfg(feature = "image")]
+/// Convert a depth frame to a 16 bit image in millimeters,
+/// see [`depth_to_millimeters`].
+/// Only available when the `image` feature is enabled.
+///
+/// # Errors
+/// Returns an error if `frame` is not a float frame.
+pub fn depth_to_millimeters_image<F: Freenect2Frame>(
+  frame: &F,
+) -> anyhow::Result<image::ImageBuffer<image::Luma<u16>, Vec<u16>>> {
+  let mut data = vec![0; frame.width() * frame.height()];
+  depth_to_millimeters(frame, &mut data)?;
+
+  image::ImageBuffer::from_raw(frame.width() as _, frame.height() as _, data)
+    .ok_or(anyhow::anyhow!("The frame has an invalid size"))
+}
+
+#[cfg(feature = "image")]
+/// Map a depth frame to an [`image::RgbImage`] using `colormap`,
+/// see [`depth_to_colormap`].
+/// Only available when the `image` feature is enabled.
+///
+/// # Errors
+/// Returns an error if `frame` is not a float frame
+/// or `max_depth` is not greater than `min_depth`.
+pub fn depth_to_colormap_image<F: Freenect2Frame>(
+  frame: &F,
+  min_depth: f32,
+  max_depth: f32,
+  colormap: Colormap,
+) -> anyhow::Result<image::RgbImage> {
+  let mut data = vec![0; frame.width() * frame.height() * 3];
+  depth_to_colormap(frame, min_depth, max_depth, colormap, &mut data)?;
+
+  image::RgbImage::from_raw(frame.width() as _, frame.height() as _, data)
+    .ok_or(anyhow::anyhow!("The frame has an invalid size"))
+}
+
+#[cfg(feature = "image")]
+/// Convert an IR frame to an [`image::GrayImage`], see [`normalize_ir`].
+/// Only available when the `image` feature is enabled.
+///
+/// # Errors
+/// Returns an error if `frame` is not a float frame or `max_value` is not positive.
+pub fn normalize_ir_image<F: Freenect2Frame>(
+  frame: &F,
+  max_value: f32,
+) -> anyhow::Result<image::GrayImage> {
+  let mut data = vec![0; frame.width() * frame.height()];
+  normalize_ir(frame, max_value, &mut data)?;
+
+  image::GrayImage::from_raw(frame.width() as _, frame.height() as _, data)
+    .ok_or(anyhow::anyhow!("The frame has an invalid size"))
+}
@@ -326,7 +326,7 @@ pub trait FrameDataValue<'a> {
   /// Get the index of the pixel at the specified position.
   /// Meant for internal use.
   fn _get_index(&self, x: usize, y: usize) -> usize {
-    (y * self._frame().width() + x) * self._frame().bytes_per_pixel()
+    y * self._frame().row_pitch() + x * self._frame().bytes_per_pixel()
   }
 }
 
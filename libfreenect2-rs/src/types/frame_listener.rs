@@ -1,13 +1,20 @@
 use crate::ffi;
 use crate::ffi::CallContext;
-use crate::frame::OwnedFrame;
+use crate::frame::{OwnedFrame, SharedFrame};
+use crate::frame_pool::FramePool;
+use crate::metrics::{DropReason, Metrics};
 use crate::types::frame::Frame;
 use crate::types::frame_type::FrameType;
+use crate::util::bounded_queue::BoundedQueue;
 use anyhow::anyhow;
 use cxx::UniquePtr;
-use std::panic::{catch_unwind, UnwindSafe};
-use std::sync::mpsc::{channel, Receiver};
+use std::panic::{catch_unwind, AssertUnwindSafe, UnwindSafe};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::mpsc::{channel, Receiver, RecvTimeoutError, Sender};
 use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+pub use crate::util::bounded_queue::DropPolicy;
 
 /// A trait for types that can be converted into a [`FrameListener`].
 pub trait AsFrameListener<'a> {
@@ -22,7 +29,32 @@ pub trait AsFrameListener<'a> {
 /// Must be passed to [`crate::freenect2_device::Freenect2Device::set_color_frame_listener`]
 /// or [`crate::freenect2_device::Freenect2Device::set_ir_and_depth_frame_listener`]
 /// to receive frames.
-pub struct FrameListener<'a>(pub(crate) UniquePtr<ffi::libfreenect2::FrameListener<'a>>);
+///
+/// Errors returned by the closure and panics caught from it are
+/// logged and counted, see [`Self::error_count`] and [`Self::take_last_error`].
+/// They are not passed on to the thread calling the listener.
+pub struct FrameListener<'a>(
+  pub(crate) UniquePtr<ffi::libfreenect2::FrameListener<'a>>,
+  Arc<ListenerErrors>,
+);
+
+/// The errors of the closure of a [`FrameListener`].
+/// Only updated if a call fails.
+#[derive(Default)]
+pub(crate) struct ListenerErrors {
+  errors: AtomicU64,
+  panics: AtomicU64,
+  last: Mutex<Option<anyhow::Error>>,
+}
+
+impl ListenerErrors {
+  fn record(&self, error: anyhow::Error) {
+    self.errors.fetch_add(1, Ordering::Relaxed);
+    if let Ok(mut last) = self.last.lock() {
+      *last = Some(error);
+    }
+  }
+}
 
 impl<'a> FrameListener<'a> {
   /// Create a new [`FrameListener`] with a closure that will be called
@@ -41,21 +73,45 @@ impl<'a> FrameListener<'a> {
   ///   Ok(())
   /// }).unwrap();
   /// ```
-  pub fn new<F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + UnwindSafe + Clone + 'a>(
+  pub fn new<F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + UnwindSafe + 'a>(
     f: F,
   ) -> anyhow::Result<Self> {
-    let ctx = Box::new(CallContext {
-      func: Box::new(move |ty, frame| {
-        let func = f.clone();
-
-        catch_unwind(move || func(ty, frame)).unwrap_or_else(|e| {
-          log::error!("Frame listener closure panicked: {:?}", e);
-          Err(anyhow!("{:?}", e))
-        })
-      }),
-    });
+    Self::create_self(f, true)
+  }
 
-    Self::create_self(ctx)
+  /// Create a new pooled [`FrameListener`] with a closure that will be called
+  /// when a new frame is received.
+  /// Frames are copied into preallocated frames from `pool`, which are
+  /// returned to the pool once the [`Frame`] passed to the closure is dropped.
+  /// If the closure panics, the panic will be caught and logged.
+  ///
+  /// # Arguments
+  /// * `pool` - The pool to take frames from.
+  /// * `f` - The closure to call when a new frame is received.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::frame_listener::FrameListener;
+  /// use libfreenect2_rs::frame_pool::FramePool;
+  ///
+  /// let pool = FramePool::new(2).unwrap();
+  /// let listener = FrameListener::new_pooled(&pool, |ty, frame| {
+  ///   println!("Received frame of type {:?}", ty);
+  ///   Ok(())
+  /// }).unwrap();
+  /// ```
+  pub fn new_pooled<F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + UnwindSafe + 'a>(
+    pool: &FramePool,
+    f: F,
+  ) -> anyhow::Result<Self> {
+    let errors = Arc::new(ListenerErrors::default());
+    let listener = ffi::libfreenect2::create_pooled_frame_listener(
+      Self::context(f, errors.clone(), true),
+      Self::on_new_frame,
+      &pool.0,
+    )?;
+
+    Ok(Self(listener, errors))
   }
 
   /// Create a new [`FrameListener`] with a closure that will be called
@@ -72,23 +128,89 @@ impl<'a> FrameListener<'a> {
   pub unsafe fn new_no_panic<F: Fn(FrameType, Frame) -> anyhow::Result<()> + 'a>(
     f: F,
   ) -> anyhow::Result<Self> {
-    let ctx = Box::new(CallContext { func: Box::new(f) });
+    Self::create_self(f, false)
+  }
 
-    Self::create_self(ctx)
+  /// Get the number of calls for which the closure returned an error or panicked.
+  pub fn error_count(&self) -> u64 {
+    self.1.errors.load(Ordering::Relaxed)
   }
 
-  fn create_self(ctx: Box<CallContext<'a>>) -> anyhow::Result<Self> {
-    ffi::libfreenect2::create_frame_listener(ctx, |frame_type, frame, ctx| {
-      let ctx = ctx.as_ref();
-      let func = ctx.func.as_ref();
+  /// Get the number of calls for which the closure panicked.
+  pub fn panic_count(&self) -> u64 {
+    self.1.panics.load(Ordering::Relaxed)
+  }
 
-      match func(frame_type.into(), Frame::new(frame)) {
-        Err(e) => format!("{:?}", e),
-        Ok(_) => "".to_string(),
-      }
+  /// Take the last error returned by the closure, or the message
+  /// of the last panic caught from it.
+  /// Returns [`None`] if no call failed since the last error was taken.
+  pub fn take_last_error(&self) -> Option<anyhow::Error> {
+    self.1.last.lock().ok()?.take()
+  }
+
+  fn create_self<F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + 'a>(
+    f: F,
+    catch_unwind: bool,
+  ) -> anyhow::Result<Self> {
+    let errors = Arc::new(ListenerErrors::default());
+    let listener = ffi::libfreenect2::create_frame_listener(
+      Self::context(f, errors.clone(), catch_unwind),
+      Self::on_new_frame,
+    )?;
+
+    Ok(Self(listener, errors))
+  }
+
+  fn context<F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + 'a>(
+    f: F,
+    errors: Arc<ListenerErrors>,
+    catch_unwind: bool,
+  ) -> Box<CallContext<'a>> {
+    Box::new(CallContext {
+      func: Box::new(f),
+      errors,
+      catch_unwind,
     })
-    .map(Self)
-    .map_err(Into::into)
+  }
+
+  #[allow(clippy::borrowed_box)]
+  fn on_new_frame(
+    frame_type: ffi::libfreenect2::FrameType,
+    frame: UniquePtr<ffi::libfreenect2::Frame<'static>>,
+    ctx: &Box<CallContext<'a>>,
+  ) {
+    let ctx = ctx.as_ref();
+    let func = ctx.func.as_ref();
+    let call = || func(frame_type.into(), Frame::new(frame));
+
+    // The closure is only called by reference, so it is
+    // neither cloned nor moved for every frame
+    let res = if ctx.catch_unwind {
+      catch_unwind(AssertUnwindSafe(call))
+    } else {
+      Ok(call())
+    };
+
+    match res {
+      Ok(Ok(())) => {}
+      Ok(Err(e)) => {
+        log::error!("Frame listener closure returned an error: {:?}", e);
+        ctx.errors.record(e);
+      }
+      Err(e) => {
+        let message = e
+          .downcast_ref::<&str>()
+          .map(|s| s.to_string())
+          .or_else(|| e.downcast_ref::<String>().cloned())
+          .unwrap_or_else(|| format!("{:?}", e));
+
+        log::error!("Frame listener closure panicked: {}", message);
+        ctx.errors.panics.fetch_add(1, Ordering::Relaxed);
+        ctx
+          .errors
+          .record(anyhow!("Frame listener closure panicked: {}", message));
+      }
+    }
   }
 }
 
@@ -144,8 +266,17 @@ impl<T: From<Frame<'static>>> FrameMap<T> {
     self.depth = Some(frame.into());
   }
 
+  /// Check if a frame of the given type is stored.
+  pub(crate) fn contains(&self, ty: FrameType) -> bool {
+    match ty {
+      FrameType::Color => self.color.is_some(),
+      FrameType::Ir => self.ir.is_some(),
+      FrameType::Depth => self.depth.is_some(),
+    }
+  }
+
   /// Check if the map contains all the frame types.
-  fn contains_values(&self, types: &FrameTypes) -> bool {
+  pub(crate) fn contains_values(&self, types: &FrameTypes) -> bool {
     (!types.color || self.color.is_some())
       && (!types.ir || self.ir.is_some())
       && (!types.depth || self.depth.is_some())
@@ -234,14 +365,14 @@ impl<T: From<Frame<'static>>> FrameMap<T> {
 }
 
 #[derive(Clone)]
-struct FrameTypes {
+pub(crate) struct FrameTypes {
   color: bool,
   ir: bool,
   depth: bool,
 }
 
 impl FrameTypes {
-  fn new(types: &[FrameType]) -> Self {
+  pub(crate) fn new(types: &[FrameType]) -> Self {
     Self {
       color: types.contains(&FrameType::Color),
       ir: types.contains(&FrameType::Ir),
@@ -254,13 +385,229 @@ impl FrameTypes {
 pub type OwnedFramesMultiFrameListener<'a> = MultiFrameListener<'a, OwnedFrame>;
 /// A [`MultiFrameListener`] that returns [`Frame`]s.
 pub type NativeFramesMultiFrameListener<'a> = MultiFrameListener<'a, Frame<'static>>;
+/// A [`MultiFrameListener`] that returns [`SharedFrame`]s.
+/// Unlike [`OwnedFramesMultiFrameListener`], no frame data is copied.
+pub type SharedFramesMultiFrameListener<'a> = MultiFrameListener<'a, SharedFrame>;
+
+/// Options for creating a [`MultiFrameListener`].
+/// Pass to [`MultiFrameListener::with_options`].
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame_listener::{
+///   DropPolicy, MultiFrameListenerOptions, SharedFramesMultiFrameListener
+/// };
+/// use libfreenect2_rs::frame_type::FrameType;
+///
+/// let listener = SharedFramesMultiFrameListener::with_options(
+///   &[FrameType::Color, FrameType::Depth],
+///   MultiFrameListenerOptions {
+///     queue_capacity: Some(2),
+///     drop_policy: DropPolicy::DropOldest,
+///     ..Default::default()
+///   },
+/// ).unwrap();
+///
+/// assert_eq!(listener.dropped_count(), 0);
+/// ```
+#[derive(Clone, Default)]
+pub struct MultiFrameListenerOptions {
+  /// Take frames from this pool instead of allocating new ones.
+  /// See [`FramePool`] for details.
+  pub pool: Option<FramePool>,
+  /// The maximum number of frame sets to buffer.
+  /// If set, frame sets are passed through a bounded lock-free queue
+  /// and `drop_policy` decides what happens if the consumer falls behind.
+  /// If [`None`], frame sets are buffered without limit.
+  pub queue_capacity: Option<usize>,
+  /// What to do with a new frame set if the queue is full.
+  /// Only used if `queue_capacity` is set.
+  pub drop_policy: DropPolicy,
+  /// Record frame, callback, queue wait and drop metrics into this handle.
+  /// See [`Metrics`] for details. If [`None`], nothing is measured.
+  pub metrics: Option<Metrics>,
+}
+
+/// A frame set and the time it was queued at, if metrics are recorded.
+type QueuedFrameSet<T> = (Option<Instant>, FrameMap<T>);
+
+enum FrameSetTx<T: From<Frame<'static>>> {
+  Unbounded(Sender<QueuedFrameSet<T>>),
+  Bounded(Arc<BoundedQueue<QueuedFrameSet<T>>>),
+}
+
+enum FrameSetRx<T: From<Frame<'static>>> {
+  Unbounded(Mutex<Receiver<QueuedFrameSet<T>>>),
+  Bounded(Arc<BoundedQueue<QueuedFrameSet<T>>>),
+}
+
+impl<T: From<Frame<'static>>> Clone for FrameSetTx<T> {
+  fn clone(&self) -> Self {
+    match self {
+      FrameSetTx::Unbounded(tx) => FrameSetTx::Unbounded(tx.clone()),
+      FrameSetTx::Bounded(queue) => FrameSetTx::Bounded(queue.clone()),
+    }
+  }
+}
+
+pub(crate) struct FrameSetSender<T: From<Frame<'static>>> {
+  queue: FrameSetTx<T>,
+  metrics: Option<Metrics>,
+}
+
+impl<T: From<Frame<'static>>> Clone for FrameSetSender<T> {
+  fn clone(&self) -> Self {
+    Self {
+      queue: self.queue.clone(),
+      metrics: self.metrics.clone(),
+    }
+  }
+}
+
+impl<T: From<Frame<'static>>> FrameSetSender<T> {
+  pub(crate) fn send(&self, frames: FrameMap<T>) -> anyhow::Result<()> {
+    let queued = (self.metrics.as_ref().map(|_| Instant::now()), frames);
+
+    match &self.queue {
+      FrameSetTx::Unbounded(tx) => tx
+        .send(queued)
+        .map_err(|_| anyhow!("Failed to send frames, the receiver was dropped")),
+      FrameSetTx::Bounded(queue) => {
+        if !queue.push(queued) {
+          self.record_drops(DropReason::QueueFull, 1);
+        }
+
+        Ok(())
+      }
+    }
+  }
+
+  pub(crate) fn record_drops(&self, reason: DropReason, count: u64) {
+    if let Some(metrics) = &self.metrics {
+      metrics.record_drops(reason, count);
+    }
+  }
+}
+
+pub(crate) struct FrameSetReceiver<T: From<Frame<'static>>> {
+  queue: FrameSetRx<T>,
+  metrics: Option<Metrics>,
+}
+
+impl<T: From<Frame<'static>>> FrameSetReceiver<T> {
+  pub(crate) fn recv(&self) -> anyhow::Result<FrameMap<T>> {
+    let queued = match &self.queue {
+      FrameSetRx::Unbounded(rx) => {
+        let rx = rx.lock().map_err(|_| anyhow!("Failed to lock receiver"))?;
+        rx.recv()?
+      }
+      FrameSetRx::Bounded(queue) => queue
+        .pop(None)
+        .ok_or_else(|| anyhow!("Failed to receive frames"))?,
+    };
+
+    Ok(self.received(queued))
+  }
+
+  pub(crate) fn recv_timeout(&self, timeout: Duration) -> anyhow::Result<FrameMap<T>> {
+    let queued = match &self.queue {
+      FrameSetRx::Unbounded(rx) => {
+        let rx = rx.lock().map_err(|_| anyhow!("Failed to lock receiver"))?;
+        rx.recv_timeout(timeout)?
+      }
+      FrameSetRx::Bounded(queue) => queue.pop(Some(timeout)).ok_or(RecvTimeoutError::Timeout)?,
+    };
+
+    Ok(self.received(queued))
+  }
+
+  fn received(&self, (queued, frames): QueuedFrameSet<T>) -> FrameMap<T> {
+    if let Some(metrics) = &self.metrics {
+      metrics.record_queue_wait(queued);
+    }
+
+    frames
+  }
+
+  pub(crate) fn dropped_count(&self) -> u64 {
+    match &self.queue {
+      FrameSetRx::Unbounded(_) => 0,
+      FrameSetRx::Bounded(queue) => queue.dropped_count(),
+    }
+  }
+
+  pub(crate) fn len(&self) -> Option<usize> {
+    match &self.queue {
+      FrameSetRx::Unbounded(_) => None,
+      FrameSetRx::Bounded(queue) => Some(queue.len()),
+    }
+  }
+
+  pub(crate) fn capacity(&self) -> Option<usize> {
+    match &self.queue {
+      FrameSetRx::Unbounded(_) => None,
+      FrameSetRx::Bounded(queue) => Some(queue.capacity()),
+    }
+  }
+}
+
+/// Create the queue frame sets are passed through from the listener to the consumer.
+pub(crate) fn frame_set_queue<T: From<Frame<'static>>>(
+  options: &MultiFrameListenerOptions,
+) -> anyhow::Result<(FrameSetSender<T>, FrameSetReceiver<T>)> {
+  let (tx, rx) = match options.queue_capacity {
+    Some(capacity) => {
+      let queue = Arc::new(BoundedQueue::new(capacity, options.drop_policy)?);
+      (
+        FrameSetTx::Bounded(queue.clone()),
+        FrameSetRx::Bounded(queue),
+      )
+    }
+    None => {
+      let (tx, rx) = channel();
+      (
+        FrameSetTx::Unbounded(tx),
+        FrameSetRx::Unbounded(Mutex::new(rx)),
+      )
+    }
+  };
+
+  Ok((
+    FrameSetSender {
+      queue: tx,
+      metrics: options.metrics.clone(),
+    },
+    FrameSetReceiver {
+      queue: rx,
+      metrics: options.metrics.clone(),
+    },
+  ))
+}
+
+/// Create a frame listener for the closure, taking frames from `pool` if set
+/// and recording the calls into `metrics` if set.
+pub(crate) fn create_listener<'a, F>(
+  pool: Option<&FramePool>,
+  metrics: Option<&Metrics>,
+  f: F,
+) -> anyhow::Result<FrameListener<'a>>
+where
+  F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + UnwindSafe + 'a,
+{
+  match (pool, metrics) {
+    (Some(pool), Some(metrics)) => FrameListener::new_pooled(pool, metrics.instrument(f)),
+    (Some(pool), None) => FrameListener::new_pooled(pool, f),
+    (None, Some(metrics)) => FrameListener::new(metrics.instrument(f)),
+    (None, None) => FrameListener::new(f),
+  }
+}
 
 /// A listener for multiple frame types.
 /// This listener will wait for all frame types to be received before returning the frames.
 /// If you need to listen for the frames individually, use [`FrameListener`] instead.
 pub struct MultiFrameListener<'a, T: From<Frame<'static>> + Send + Sync> {
   listener: FrameListener<'a>,
-  rx: Mutex<Receiver<FrameMap<T>>>,
+  rx: FrameSetReceiver<T>,
 }
 
 impl<'a, T: From<Frame<'static>> + Send + Sync + 'static> MultiFrameListener<'a, T> {
@@ -286,6 +633,88 @@ impl<'a, T: From<Frame<'static>> + Send + Sync + 'static> MultiFrameListener<'a,
   /// let frames = listener.get_frames().unwrap();
   /// ```
   pub fn new(frame_types: &[FrameType]) -> anyhow::Result<Self> {
+    Self::with_options(frame_types, MultiFrameListenerOptions::default())
+  }
+
+  /// Create a new pooled [`MultiFrameListener`] that listens for the specified frame types.
+  /// Frames are taken from `pool` and returned to it once they are dropped.
+  /// See [`FramePool`] for details.
+  ///
+  /// # Arguments
+  /// * `frame_types` - The frame types to listen for. Must contain at least one element.
+  /// * `pool` - The pool to take frames from.
+  ///
+  /// # Errors
+  /// Returns an error if no frame types are specified
+  /// or the underlying frame listener could not be created.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::frame_listener::NativeFramesMultiFrameListener;
+  /// use libfreenect2_rs::frame_pool::FramePool;
+  /// use libfreenect2_rs::frame_type::FrameType;
+  ///
+  /// let pool = FramePool::new(4).unwrap();
+  /// let listener = NativeFramesMultiFrameListener::new_pooled(
+  ///   &[FrameType::Color, FrameType::Depth],
+  ///   &pool,
+  /// ).unwrap();
+  ///
+  /// /// Set the listener and start the device
+  ///
+  /// let frames = listener.get_frames().unwrap();
+  /// ```
+  pub fn new_pooled(frame_types: &[FrameType], pool: &FramePool) -> anyhow::Result<Self> {
+    Self::with_options(
+      frame_types,
+      MultiFrameListenerOptions {
+        pool: Some(pool.clone()),
+        ..Default::default()
+      },
+    )
+  }
+
+  /// Create a new [`MultiFrameListener`] that buffers at most `capacity` frame sets.
+  /// The frame sets are passed to the consumer through a bounded lock-free queue.
+  /// If the consumer falls behind, `drop_policy` decides which frame sets are dropped.
+  /// Dropped frame sets are counted, see [`Self::dropped_count`].
+  ///
+  /// # Arguments
+  /// * `frame_types` - The frame types to listen for. Must contain at least one element.
+  /// * `capacity` - The maximum number of frame sets to buffer. Must be at least 1.
+  /// * `drop_policy` - What to do with a new frame set if the queue is full.
+  ///
+  /// # Errors
+  /// Returns an error if no frame types are specified, `capacity` is zero
+  /// or the underlying frame listener could not be created.
+  pub fn new_bounded(
+    frame_types: &[FrameType],
+    capacity: usize,
+    drop_policy: DropPolicy,
+  ) -> anyhow::Result<Self> {
+    Self::with_options(
+      frame_types,
+      MultiFrameListenerOptions {
+        queue_capacity: Some(capacity),
+        drop_policy,
+        ..Default::default()
+      },
+    )
+  }
+
+  /// Create a new [`MultiFrameListener`] with the specified options.
+  ///
+  /// # Arguments
+  /// * `frame_types` - The frame types to listen for. Must contain at least one element.
+  /// * `options` - The options for the listener.
+  ///
+  /// # Errors
+  /// Returns an error if no frame types are specified, the options are invalid
+  /// or the underlying frame listener could not be created.
+  pub fn with_options(
+    frame_types: &[FrameType],
+    options: MultiFrameListenerOptions,
+  ) -> anyhow::Result<Self> {
     anyhow::ensure!(
       !frame_types.is_empty(),
       "At least one frame type must be specified"
@@ -293,23 +722,33 @@ impl<'a, T: From<Frame<'static>> + Send + Sync + 'static> MultiFrameListener<'a,
 
     let frames = Arc::new(Mutex::new(FrameMap::default()));
     let types = FrameTypes::new(frame_types);
-    let (tx, rx) = channel();
+    let (tx, rx) = frame_set_queue(&options)?;
+
+    let on_new_frame = move |ty: FrameType, frame: Frame<'static>| {
+      let mut frames = frames
+        .lock()
+        .map_err(|e| anyhow::anyhow!("Failed to lock frame map: {e}"))?;
+      if frames.contains(ty) {
+        tx.record_drops(DropReason::Coalesced, 1);
+      }
+      frames.insert(ty, T::from(frame));
 
-    Ok(Self {
-      listener: FrameListener::new(move |ty, frame| {
-        let mut frames = frames
-          .lock()
-          .map_err(|e| anyhow::anyhow!("Failed to lock frame map: {e}"))?;
-        frames.insert(ty, T::from(frame));
-
-        if frames.contains_values(&types) {
-          let old_frames = std::mem::take(&mut *frames);
-          tx.send(old_frames)?;
-        }
+      if frames.contains_values(&types) {
+        let old_frames = std::mem::take(&mut *frames);
+        drop(frames);
+        tx.send(old_frames)?;
+      }
 
-        Ok(())
-      })?,
-      rx: Mutex::new(rx),
+      Ok(())
+    };
+
+    Ok(Self {
+      listener: create_listener(
+        options.pool.as_ref(),
+        options.metrics.as_ref(),
+        on_new_frame,
+      )?,
+      rx,
     })
   }
 
@@ -317,11 +756,7 @@ impl<'a, T: From<Frame<'static>> + Send + Sync + 'static> MultiFrameListener<'a,
   /// This will block until all frame types have been received.
   /// If you need to wait with a timeout, use [`Self::get_frames_with_timeout`] instead.
   pub fn get_frames(&self) -> anyhow::Result<FrameMap<T>> {
-    let rx = self
-      .rx
-      .lock()
-      .map_err(|_| anyhow!("Failed to lock receiver"))?;
-    rx.recv().map_err(Into::into)
+    self.rx.recv()
   }
 
   /// Get the next set of frames with a timeout.
@@ -333,15 +768,26 @@ impl<'a, T: From<Frame<'static>> + Send + Sync + 'static> MultiFrameListener<'a,
   ///
   /// # Errors
   /// Returns an error if the frames are not received within the timeout.
-  pub fn get_frames_with_timeout(
-    &self,
-    timeout: std::time::Duration,
-  ) -> anyhow::Result<FrameMap<T>> {
-    let rx = self
-      .rx
-      .lock()
-      .map_err(|_| anyhow!("Failed to lock receiver"))?;
-    rx.recv_timeout(timeout).map_err(Into::into)
+  pub fn get_frames_with_timeout(&self, timeout: Duration) -> anyhow::Result<FrameMap<T>> {
+    self.rx.recv_timeout(timeout)
+  }
+
+  /// Get the number of frame sets dropped because the queue was full.
+  /// Always zero if the listener was not created with a queue capacity.
+  pub fn dropped_count(&self) -> u64 {
+    self.rx.dropped_count()
+  }
+
+  /// Get the number of frame sets currently waiting to be received.
+  /// Only available if the listener was created with a queue capacity.
+  pub fn queue_len(&self) -> Option<usize> {
+    self.rx.len()
+  }
+
+  /// Get the maximum number of frame sets that can be buffered.
+  /// Only available if the listener was created with a queue capacity.
+  pub fn queue_capacity(&self) -> Option<usize> {
+    self.rx.capacity()
   }
 }
 
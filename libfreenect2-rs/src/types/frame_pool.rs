@@ -0,0 +1,81 @@
+use crate::ffi;
+use crate::frame_type::FrameType;
+use cxx::SharedPtr;
+
+/// A pool of preallocated native frames.
+///
+/// Listeners created with [`crate::frame_listener::FrameListener::new_pooled`]
+/// copy every frame delivered by the packet pipeline into a free frame from
+/// this pool and let the pipeline reuse its own buffer. Dropping the
+/// [`crate::frame::Frame`] returns its buffer to the pool instead of freeing it,
+/// so no frame buffers are allocated or page-faulted during capture.
+///
+/// The pool keeps `capacity` frames for every [`FrameType`]. The frames for a
+/// type are allocated when the first frame of that type is received, on the
+/// thread delivering it, so they are placed on the NUMA node of the device's
+/// [`crate::thread_policy::ThreadPolicy`].
+/// If all frames of a type are in use, the listener falls back to taking
+/// ownership of the pipeline's frame and [`Self::exhausted_count`] is incremented.
+///
+/// A pool may be shared between multiple listeners and is cheap to clone.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame_listener::FrameListener;
+/// use libfreenect2_rs::frame_pool::FramePool;
+///
+/// let pool = FramePool::new(4).unwrap();
+/// let listener = FrameListener::new_pooled(&pool, |ty, frame| {
+///   println!("Received frame of type {:?}", ty);
+///   Ok(())
+/// }).unwrap();
+///
+/// assert_eq!(pool.exhausted_count(), 0);
+/// ```
+#[derive(Clone)]
+pub struct FramePool(pub(crate) SharedPtr<ffi::libfreenect2::FramePool>);
+
+impl FramePool {
+  /// Create a new frame pool.
+  ///
+  /// # Arguments
+  /// * `capacity` - The number of frames to keep per frame type.
+  ///   Should be at least the number of frames of a single type
+  ///   your code holds on to at the same time.
+  ///
+  /// # Errors
+  /// Returns an error if `capacity` is zero or the pool could not be created.
+  pub fn new(capacity: usize) -> anyhow::Result<Self> {
+    anyhow::ensure!(capacity > 0, "The pool capacity must be at least 1");
+
+    ffi::libfreenect2::create_frame_pool(capacity as _)
+      .map(Self)
+      .map_err(Into::into)
+  }
+
+  /// Get the number of frames kept per frame type.
+  pub fn capacity(&self) -> usize {
+    self.0.capacity() as _
+  }
+
+  /// Get the number of times a frame had to be delivered
+  /// without the pool because all pooled frames were in use.
+  pub fn exhausted_count(&self) -> u64 {
+    self.0.exhausted_count()
+  }
+
+  /// Get the number of free frames for the specified frame type.
+  ///
+  /// # Errors
+  /// Returns an error if the underlying C++ function fails.
+  pub fn available(&self, frame_type: FrameType) -> anyhow::Result<usize> {
+    self
+      .0
+      .available(frame_type.into())
+      .map(|available| available as _)
+      .map_err(Into::into)
+  }
+}
+
+unsafe impl Send for FramePool {}
+unsafe impl Sync for FramePool {}
@@ -0,0 +1,291 @@
+use crate::frame::{OwnedFrame, SharedFrame};
+use crate::frame_listener::{
+  create_listener, AsFrameListener, FrameListener, FrameMap, FrameTypes,
+};
+use crate::frame_pool::FramePool;
+use crate::metrics::{DropReason, Metrics};
+use crate::types::frame::Frame;
+use crate::types::frame_type::FrameType;
+use crate::util::bounded_queue::BoundedQueue;
+use futures_core::Stream;
+use std::pin::Pin;
+use std::sync::{Arc, Mutex};
+use std::task::{Context, Poll, Waker};
+use std::time::Instant;
+
+pub use crate::util::bounded_queue::DropPolicy;
+
+/// Options for creating a [`FrameStream`] or a [`FrameSetStream`].
+#[derive(Clone)]
+pub struct FrameStreamOptions {
+  /// Take frames from this pool instead of allocating new ones.
+  /// See [`FramePool`] for details.
+  pub pool: Option<FramePool>,
+  /// The maximum number of items to buffer until the stream is polled.
+  /// The default is 2.
+  pub capacity: usize,
+  /// What to do with a new item if the buffer is full.
+  /// [`DropPolicy::Block`] applies backpressure by stalling the libfreenect2
+  /// processing thread until the stream is polled again, which may cause packet loss.
+  /// The default is [`DropPolicy::DropOldest`].
+  pub drop_policy: DropPolicy,
+  /// Record frame, callback, queue wait and drop metrics into this handle.
+  /// See [`Metrics`] for details. If [`None`], nothing is measured.
+  pub metrics: Option<Metrics>,
+}
+
+impl Default for FrameStreamOptions {
+  fn default() -> Self {
+    Self {
+      pool: None,
+      capacity: 2,
+      drop_policy: DropPolicy::default(),
+      metrics: None,
+    }
+  }
+}
+
+/// The buffer shared between the native listener and the stream.
+/// Values are stored with the time they were sent at, if metrics are recorded.
+struct StreamQueue<V> {
+  queue: BoundedQueue<(Option<Instant>, V)>,
+  waker: Mutex<Option<Waker>>,
+  metrics: Option<Metrics>,
+}
+
+impl<V> StreamQueue<V> {
+  fn new(options: &FrameStreamOptions) -> anyhow::Result<Arc<Self>> {
+    Ok(Arc::new(Self {
+      queue: BoundedQueue::new(options.capacity, options.drop_policy)?,
+      waker: Mutex::new(None),
+      metrics: options.metrics.clone(),
+    }))
+  }
+
+  fn send(&self, value: V) {
+    let sent = self.metrics.as_ref().map(|_| Instant::now());
+    if !self.queue.push((sent, value)) {
+      self.record_drops(DropReason::QueueFull, 1);
+    }
+
+    let waker = self.waker.lock().unwrap_or_else(|e| e.into_inner()).take();
+    if let Some(waker) = waker {
+      waker.wake();
+    }
+  }
+
+  fn record_drops(&self, reason: DropReason, count: u64) {
+    if let Some(metrics) = &self.metrics {
+      metrics.record_drops(reason, count);
+    }
+  }
+
+  fn received(&self, (sent, value): (Option<Instant>, V)) -> V {
+    if let Some(metrics) = &self.metrics {
+      metrics.record_queue_wait(sent);
+    }
+
+    value
+  }
+
+  fn poll_next(&self, cx: &mut Context<'_>) -> Poll<Option<V>> {
+    if let Some(value) = self.queue.try_pop() {
+      return Poll::Ready(Some(self.received(value)));
+    }
+
+    {
+      let mut waker = self.waker.lock().unwrap_or_else(|e| e.into_inner());
+      match waker.as_ref() {
+        Some(waker) if waker.will_wake(cx.waker()) => {}
+        _ => *waker = Some(cx.waker().clone()),
+      }
+    }
+
+    // Check again in case a value was sent before the waker was registered
+    match self.queue.try_pop() {
+      Some(value) => Poll::Ready(Some(self.received(value))),
+      None => Poll::Pending,
+    }
+  }
+}
+
+/// A [`FrameStream`] that returns [`OwnedFrame`]s.
+pub type OwnedFrameStream = FrameStream<OwnedFrame>;
+/// A [`FrameStream`] that returns [`SharedFrame`]s.
+pub type SharedFrameStream = FrameStream<SharedFrame>;
+/// A [`FrameSetStream`] that returns [`OwnedFrame`]s.
+pub type OwnedFrameSetStream = FrameSetStream<OwnedFrame>;
+/// A [`FrameSetStream`] that returns [`SharedFrame`]s.
+pub type SharedFrameSetStream = FrameSetStream<SharedFrame>;
+
+/// A frame listener that is consumed as a [`Stream`] of frames.
+/// The libfreenect2 processing thread pushes frames into a bounded buffer
+/// and wakes the task polling the stream, no thread is blocked waiting for frames.
+/// The stream never ends on its own.
+///
+/// # Example
+/// ```no_run
+/// use futures::StreamExt;
+/// use libfreenect2_rs::frame_stream::{FrameStreamOptions, SharedFrameStream};
+///
+/// # async fn run() -> anyhow::Result<()> {
+/// let mut stream = SharedFrameStream::new(FrameStreamOptions::default())?;
+///
+/// /// Set the listener and start the device
+///
+/// while let Some((ty, frame)) = stream.next().await {
+///   println!("Received frame of type {:?}", ty);
+/// }
+/// # Ok(())
+/// # }
+/// ```
+pub struct FrameStream<T: From<Frame<'static>> + Send> {
+  pub(crate) listener: FrameListener<'static>,
+  queue: Arc<StreamQueue<(FrameType, T)>>,
+}
+
+impl<T: From<Frame<'static>> + Send + 'static> FrameStream<T> {
+  /// Create a new [`FrameStream`].
+  ///
+  /// # Arguments
+  /// * `options` - The options for the stream.
+  ///
+  /// # Errors
+  /// Returns an error if the options are invalid or the
+  /// underlying frame listener could not be created.
+  pub fn new(options: FrameStreamOptions) -> anyhow::Result<Self> {
+    let queue = StreamQueue::new(&options)?;
+    let listener = create_listener(options.pool.as_ref(), options.metrics.as_ref(), {
+      let queue = queue.clone();
+      move |ty: FrameType, frame: Frame<'static>| {
+        queue.send((ty, T::from(frame)));
+        Ok(())
+      }
+    })?;
+
+    Ok(Self { listener, queue })
+  }
+
+  /// Get the number of frames dropped because the buffer was full.
+  pub fn dropped_count(&self) -> u64 {
+    self.queue.queue.dropped_count()
+  }
+
+  /// Get the number of frames currently buffered.
+  pub fn queue_len(&self) -> usize {
+    self.queue.queue.len()
+  }
+}
+
+impl<T: From<Frame<'static>> + Send> Stream for FrameStream<T> {
+  type Item = (FrameType, T);
+
+  fn poll_next(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Option<Self::Item>> {
+    self.queue.poll_next(cx)
+  }
+}
+
+impl<T: From<Frame<'static>> + Send> AsFrameListener<'static> for FrameStream<T> {
+  fn as_frame_listener(&self) -> &FrameListener<'static> {
+    &self.listener
+  }
+}
+
+/// A listener for multiple frame types that is consumed as a [`Stream`] of frame sets.
+/// Frames are collected like in a [`crate::frame_listener::MultiFrameListener`],
+/// complete sets are pushed into a bounded buffer and wake the task polling the stream.
+/// The stream never ends on its own.
+///
+/// # Example
+/// ```no_run
+/// use futures::StreamExt;
+/// use libfreenect2_rs::frame_stream::{FrameStreamOptions, SharedFrameSetStream};
+/// use libfreenect2_rs::frame_type::FrameType;
+///
+/// # async fn run() -> anyhow::Result<()> {
+/// let mut stream = SharedFrameSetStream::new(
+///   &[FrameType::Color, FrameType::Depth],
+///   FrameStreamOptions::default(),
+/// )?;
+///
+/// /// Set the listener and start the device
+///
+/// while let Some(frames) = stream.next().await {
+///   let depth = frames.expect_depth()?;
+/// }
+/// # Ok(())
+/// # }
+/// ```
+pub struct FrameSetStream<T: From<Frame<'static>> + Send> {
+  pub(crate) listener: FrameListener<'static>,
+  queue: Arc<StreamQueue<FrameMap<T>>>,
+}
+
+impl<T: From<Frame<'static>> + Send + 'static> FrameSetStream<T> {
+  /// Create a new [`FrameSetStream`] that listens for the specified frame types.
+  ///
+  /// # Arguments
+  /// * `frame_types` - The frame types to listen for. Must contain at least one element.
+  /// * `options` - The options for the stream.
+  ///
+  /// # Errors
+  /// Returns an error if no frame types are specified, the options are invalid
+  /// or the underlying frame listener could not be created.
+  pub fn new(frame_types: &[FrameType], options: FrameStreamOptions) -> anyhow::Result<Self> {
+    anyhow::ensure!(
+      !frame_types.is_empty(),
+      "At least one frame type must be specified"
+    );
+
+    let queue = StreamQueue::new(&options)?;
+    let frames = Arc::new(Mutex::new(FrameMap::default()));
+    let types = FrameTypes::new(frame_types);
+
+    let listener = create_listener(options.pool.as_ref(), options.metrics.as_ref(), {
+      let queue = queue.clone();
+      move |ty: FrameType, frame: Frame<'static>| {
+        let mut frames = frames
+          .lock()
+          .map_err(|e| anyhow::anyhow!("Failed to lock frame map: {e}"))?;
+        if frames.contains(ty) {
+          queue.record_drops(DropReason::Coalesced, 1);
+        }
+        frames.insert(ty, T::from(frame));
+
+        if frames.contains_values(&types) {
+          let old_frames = std::mem::take(&mut *frames);
+          drop(frames);
+          queue.send(old_frames);
+        }
+
+        Ok(())
+      }
+    })?;
+
+    Ok(Self { listener, queue })
+  }
+
+  /// Get the number of frame sets dropped because the buffer was full.
+  pub fn dropped_count(&self) -> u64 {
+    self.queue.queue.dropped_count()
+  }
+
+  /// Get the number of frame sets currently buffered.
+  pub fn queue_len(&self) -> usize {
+    self.queue.queue.len()
+  }
+}
+
+impl<T: From<Frame<'static>> + Send> Stream for FrameSetStream<T> {
+  type Item = FrameMap<T>;
+
+  fn poll_next(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Option<Self::Item>> {
+    self.queue.poll_next(cx)
+  }
+}
+
+impl<T: From<Frame<'static>> + Send> AsFrameListener<'static> for FrameSetStream<T> {
+  fn as_frame_listener(&self) -> &FrameListener<'static> {
+    &self.listener
+  }
+}
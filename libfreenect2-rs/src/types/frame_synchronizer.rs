@@ -0,0 +1,336 @@
+use crate::frame::Freenect2Frame;
+use crate::frame_listener::{
+  create_listener, frame_set_queue, AsFrameListener, FrameListener, FrameMap, FrameSetReceiver,
+  MultiFrameListenerOptions,
+};
+use crate::metrics::DropReason;
+use crate::types::frame::Frame;
+use crate::types::frame_type::FrameType;
+use anyhow::anyhow;
+use std::collections::VecDeque;
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+
+/// The value frames are paired by.
+#[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+pub enum SyncKey {
+  /// Pair frames by [`Freenect2Frame::timestamp`].
+  /// Color and depth frames share the device clock,
+  /// so this is usually what you want.
+  #[default]
+  Timestamp,
+  /// Pair frames by [`Freenect2Frame::sequence`].
+  /// IR and depth frames from the same packet share a sequence number,
+  /// color frames are counted separately by the device.
+  Sequence,
+}
+
+impl SyncKey {
+  fn get(&self, frame: &dyn Freenect2Frame) -> u32 {
+    match self {
+      SyncKey::Timestamp => frame.timestamp(),
+      SyncKey::Sequence => frame.sequence(),
+    }
+  }
+}
+
+/// Options for creating a [`SyncFrameListener`].
+#[derive(Clone)]
+pub struct SyncOptions {
+  /// The value frames are paired by.
+  pub key: SyncKey,
+  /// The maximum difference between the keys of the frames in a set.
+  /// The default is 133, which is half a frame at 30Hz using [`SyncKey::Timestamp`].
+  pub tolerance: u32,
+  /// The maximum number of unpaired frames to keep per frame type.
+  /// If more frames are waiting, the oldest one is discarded.
+  /// The default is 4.
+  pub max_pending: usize,
+  /// Options for the frame pool and the queue
+  /// frame sets are passed through to the consumer.
+  pub listener: MultiFrameListenerOptions,
+}
+
+impl Default for SyncOptions {
+  fn default() -> Self {
+    Self {
+      key: SyncKey::Timestamp,
+      tolerance: 133,
+      max_pending: 4,
+      listener: MultiFrameListenerOptions::default(),
+    }
+  }
+}
+
+/// Statistics of a [`SyncFrameListener`].
+/// Retrieved using [`SyncFrameListener::statistics`].
+#[derive(Debug, Copy, Clone, Default, PartialEq)]
+pub struct SyncStatistics {
+  /// The number of frame sets that were paired.
+  pub matched: u64,
+  /// The number of frames that were discarded
+  /// because they could no longer be paired.
+  pub discarded: u64,
+  /// The key difference between the oldest and the newest
+  /// frame of the last paired set.
+  pub last_delta: u32,
+  /// The largest key difference of all paired sets.
+  pub max_delta: u32,
+  /// The mean key difference of all paired sets.
+  pub mean_delta: f64,
+}
+
+#[derive(Default)]
+pub(crate) struct SyncStats {
+  matched: AtomicU64,
+  pub(crate) discarded: AtomicU64,
+  last_delta: AtomicU32,
+  max_delta: AtomicU32,
+  delta_sum: AtomicU64,
+}
+
+impl SyncStats {
+  /// Record a paired set with the given key difference.
+  pub(crate) fn record_match(&self, delta: u32) {
+    self.matched.fetch_add(1, Ordering::Relaxed);
+    self.last_delta.store(delta, Ordering::Relaxed);
+    self.max_delta.fetch_max(delta, Ordering::Relaxed);
+    self.delta_sum.fetch_add(delta as u64, Ordering::Relaxed);
+  }
+
+  pub(crate) fn snapshot(&self) -> SyncStatistics {
+    let matched = self.matched.load(Ordering::Relaxed);
+    let delta_sum = self.delta_sum.load(Ordering::Relaxed);
+
+    SyncStatistics {
+      matched,
+      discarded: self.discarded.load(Ordering::Relaxed),
+      last_delta: self.last_delta.load(Ordering::Relaxed),
+      max_delta: self.max_delta.load(Ordering::Relaxed),
+      mean_delta: if matched == 0 {
+        0.0
+      } else {
+        delta_sum as f64 / matched as f64
+      },
+    }
+  }
+}
+
+/// A set of values paired by a [`Matcher`].
+pub(crate) struct MatchedSet<S, T> {
+  pub(crate) delta: u32,
+  pub(crate) frames: Vec<(S, T)>,
+}
+
+/// Pairs values of multiple sources, usually frame types, by their key.
+/// Keys are expected to increase per source and may wrap around.
+pub(crate) struct Matcher<S, T> {
+  types: Vec<S>,
+  pending: Vec<VecDeque<(u32, T)>>,
+  tolerance: u32,
+  max_pending: usize,
+  pub(crate) discarded: u64,
+}
+
+impl<S: Ord + Copy, T> Matcher<S, T> {
+  pub(crate) fn new(types: &[S], tolerance: u32, max_pending: usize) -> Self {
+    let mut unique = types.to_vec();
+    unique.sort();
+    unique.dedup();
+
+    Self {
+      pending: unique.iter().map(|_| VecDeque::new()).collect(),
+      types: unique,
+      tolerance,
+      max_pending: max_pending.max(1),
+      discarded: 0,
+    }
+  }
+
+  /// Add a value and return all sets that could be paired because of it.
+  pub(crate) fn push(&mut self, ty: S, key: u32, value: T) -> Vec<MatchedSet<S, T>> {
+    let mut res = Vec::new();
+    let Some(index) = self.types.iter().position(|t| *t == ty) else {
+      return res;
+    };
+
+    let pending = &mut self.pending[index];
+    pending.push_back((key, value));
+    if pending.len() > self.max_pending {
+      pending.pop_front();
+      self.discarded += 1;
+    }
+
+    while self.pending.iter().all(|p| !p.is_empty()) {
+      let reference = self.pending[0][0].0;
+      let offsets = self
+        .pending
+        .iter()
+        .map(|p| p[0].0.wrapping_sub(reference) as i32 as i64)
+        .collect::<Vec<_>>();
+
+      let (oldest, min) = offsets
+        .iter()
+        .copied()
+        .enumerate()
+        .min_by_key(|(_, offset)| *offset)
+        .unwrap();
+      let max = offsets.iter().copied().max().unwrap();
+      let delta = (max - min) as u32;
+
+      if delta <= self.tolerance {
+        res.push(MatchedSet {
+          delta,
+          frames: self
+            .types
+            .iter()
+            .zip(self.pending.iter_mut())
+            .map(|(ty, p)| (*ty, p.pop_front().unwrap().1))
+            .collect(),
+        });
+      } else {
+        // Everything else that is waiting is newer than the oldest
+        // frame by more than the tolerance, it can never be paired
+        self.pending[oldest].pop_front();
+        self.discarded += 1;
+      }
+    }
+
+    res
+  }
+}
+
+/// A listener that pairs frames of multiple types by their timestamp or sequence number.
+/// Unlike [`crate::frame_listener::MultiFrameListener`], which pairs frames in order
+/// of arrival, a frame set is only returned if the keys of all frames are within the
+/// configured tolerance. Frames that can no longer be paired are discarded.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::frame::SharedFrame;
+/// use libfreenect2_rs::frame_synchronizer::{SyncFrameListener, SyncOptions};
+/// use libfreenect2_rs::frame_type::FrameType;
+///
+/// let listener = SyncFrameListener::<SharedFrame>::new(
+///   &[FrameType::Color, FrameType::Depth],
+///   SyncOptions::default(),
+/// ).unwrap();
+///
+/// /// Set the listener and start the device
+///
+/// let frames = listener.get_frames().unwrap();
+/// println!("Paired frames: {:?}", listener.statistics());
+/// ```
+pub struct SyncFrameListener<'a, T: From<Frame<'static>> + Send + Sync> {
+  listener: FrameListener<'a>,
+  rx: FrameSetReceiver<T>,
+  stats: Arc<SyncStats>,
+}
+
+impl<'a, T: From<Frame<'static>> + Send + Sync + 'static> SyncFrameListener<'a, T> {
+  /// Create a new [`SyncFrameListener`] that pairs the specified frame types.
+  ///
+  /// # Arguments
+  /// * `frame_types` - The frame types to pair. Must contain at least one element.
+  /// * `options` - The options for the listener.
+  ///
+  /// # Errors
+  /// Returns an error if no frame types are specified, the options are invalid
+  /// or the underlying frame listener could not be created.
+  pub fn new(frame_types: &[FrameType], options: SyncOptions) -> anyhow::Result<Self> {
+    anyhow::ensure!(
+      !frame_types.is_empty(),
+      "At least one frame type must be specified"
+    );
+    anyhow::ensure!(
+      options.max_pending > 0,
+      "At least one pending frame must be allowed per frame type"
+    );
+
+    let matcher = Arc::new(Mutex::new(Matcher::new(
+      frame_types,
+      options.tolerance,
+      options.max_pending,
+    )));
+    let stats = Arc::new(SyncStats::default());
+    let (tx, rx) = frame_set_queue(&options.listener)?;
+    let key = options.key;
+
+    let on_new_frame = {
+      let stats = stats.clone();
+      move |ty: FrameType, frame: Frame<'static>| {
+        let key = key.get(&frame);
+        let (matched, discarded) = {
+          let mut matcher = matcher
+            .lock()
+            .map_err(|e| anyhow!("Failed to lock frame matcher: {e}"))?;
+          let matched = matcher.push(ty, key, T::from(frame));
+
+          (matched, std::mem::take(&mut matcher.discarded))
+        };
+
+        stats.discarded.fetch_add(discarded, Ordering::Relaxed);
+        tx.record_drops(DropReason::Unpaired, discarded);
+        for set in matched {
+          stats.record_match(set.delta);
+
+          let mut frames = FrameMap::default();
+          for (ty, frame) in set.frames {
+            frames.insert(ty, frame);
+          }
+
+          tx.send(frames)?;
+        }
+
+        Ok(())
+      }
+    };
+
+    Ok(Self {
+      listener: create_listener(
+        options.listener.pool.as_ref(),
+        options.listener.metrics.as_ref(),
+        on_new_frame,
+      )?,
+      rx,
+      stats,
+    })
+  }
+
+  /// Get the next set of paired frames.
+  /// This will block until a set of frames has been paired.
+  /// If you need to wait with a timeout, use [`Self::get_frames_with_timeout`] instead.
+  pub fn get_frames(&self) -> anyhow::Result<FrameMap<T>> {
+    self.rx.recv()
+  }
+
+  /// Get the next set of paired frames with a timeout.
+  /// If no frames are paired within the timeout, an error is returned.
+  ///
+  /// # Arguments
+  /// * `timeout` - The maximum amount of time to wait for the frames.
+  ///
+  /// # Errors
+  /// Returns an error if the frames are not received within the timeout.
+  pub fn get_frames_with_timeout(&self, timeout: Duration) -> anyhow::Result<FrameMap<T>> {
+    self.rx.recv_timeout(timeout)
+  }
+
+  /// Get the current pairing statistics.
+  pub fn statistics(&self) -> SyncStatistics {
+    self.stats.snapshot()
+  }
+
+  /// Get the number of paired frame sets dropped because the queue was full.
+  /// Always zero if the listener was not created with a queue capacity.
+  pub fn dropped_count(&self) -> u64 {
+    self.rx.dropped_count()
+  }
+}
+
+impl<'a, T: From<Frame<'static>> + Send + Sync> AsFrameListener<'a> for SyncFrameListener<'a, T> {
+  fn as_frame_listener(&self) -> &FrameListener<'a> {
+    &self.listener
+  }
+}
@@ -21,3 +21,13 @@ impl From<ffi::libfreenect2::FrameType> for FrameType {
     }
   }
 }
+
+impl From<FrameType> for ffi::libfreenect2::FrameType {
+  fn from(t: FrameType) -> Self {
+    match t {
+      FrameType::Color => ffi::libfreenect2::FrameType::Color,
+      FrameType::Ir => ffi::libfreenect2::FrameType::Ir,
+      FrameType::Depth => ffi::libfreenect2::FrameType::Depth,
+    }
+  }
+}
@@ -0,0 +1,188 @@
+//! Borrowed regions of interest of frames.
+//!
+//! A [`FrameView`] is a sub-rectangle of a frame which borrows the data of
+//! the frame instead of copying it. The rows of a view keep the row pitch of
+//! the frame, see [`Freenect2Frame::row_pitch`], so a view implements
+//! [`Freenect2Frame`] and can be passed to the pixel accessors, the
+//! conversions of [`crate::frame_convert`] and the frame writers like
+//! [`crate::capture::CaptureRecorder`] without converting the whole frame first.
+//! Use [`OwnedFrame::from_frame`] to copy only the pixels of a view.
+//!
+//! Registration works on native frames, which can't be views.
+//! Use [`crate::registration::Registration::map_depth_to_color_region`]
+//! to only compute the registered pixels of a region instead.
+
+use crate::frame::{FrameFormat, Freenect2Frame, OwnedFrame};
+
+pub use crate::ffi::libfreenect2::Region;
+
+impl Region {
+  /// Create a new region.
+  pub fn new(x: u32, y: u32, width: u32, height: u32) -> Self {
+    Self {
+      x,
+      y,
+      width,
+      height,
+    }
+  }
+
+  /// Create a region covering a whole frame of `width` x `height` pixels.
+  pub fn full(width: u32, height: u32) -> Self {
+    Self::new(0, 0, width, height)
+  }
+
+  /// Check whether the region is not empty and within a frame of `width` x `height` pixels.
+  pub fn is_within(&self, width: usize, height: usize) -> bool {
+    self.width > 0
+      && self.height > 0
+      && self.x as usize + self.width as usize <= width
+      && self.y as usize + self.height as usize <= height
+  }
+
+  /// Check whether the pixel at `x`, `y` is within the region.
+  pub fn contains(&self, x: usize, y: usize) -> bool {
+    x >= self.x as usize
+      && y >= self.y as usize
+      && x < self.x as usize + self.width as usize
+      && y < self.y as usize + self.height as usize
+  }
+
+  pub(crate) fn ensure_within(&self, width: usize, height: usize) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      self.is_within(width, height),
+      "The region {:?} must not be empty and be within the frame of {}x{} pixels",
+      self,
+      width,
+      height
+    );
+
+    Ok(())
+  }
+}
+
+/// A borrowed region of interest of a frame.
+/// Can be created using [`Freenect2Frame::view`].
+///
+/// The data of the view starts at the top left pixel of the region
+/// and ends with the last pixel of the region, rows start every
+/// [`Freenect2Frame::row_pitch`] bytes of the viewed frame.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+/// use libfreenect2_rs::frame_convert::depth_to_millimeters;
+/// use libfreenect2_rs::frame_view::Region;
+///
+/// let frame = Frame::depth();
+/// let view = frame.view(Region::new(128, 100, 256, 200)).unwrap();
+///
+/// // Only the pixels of the region are converted
+/// let mut depth = vec![0u16; view.width() * view.height()];
+/// depth_to_millimeters(&view, &mut depth).unwrap();
+/// ```
+#[derive(Clone, Copy)]
+pub struct FrameView<'a> {
+  frame: &'a dyn Freenect2Frame,
+  region: Region,
+  data: &'a [u8],
+}
+
+impl<'a> FrameView<'a> {
+  /// Create a view of `region` of `frame`.
+  ///
+  /// # Errors
+  /// Returns an error if the region is empty or not within the frame,
+  /// or if the frame doesn't hold pixels.
+  pub fn new(frame: &'a dyn Freenect2Frame, region: Region) -> anyhow::Result<Self> {
+    anyhow::ensure!(
+      !matches!(frame.format(), FrameFormat::Raw | FrameFormat::Invalid),
+      "Can't create a view of a frame with format {:?}",
+      frame.format()
+    );
+    region.ensure_within(frame.width(), frame.height())?;
+
+    let bytes_per_pixel = frame.bytes_per_pixel();
+    let start = region.y as usize * frame.row_pitch() + region.x as usize * bytes_per_pixel;
+    let len =
+      (region.height as usize - 1) * frame.row_pitch() + region.width as usize * bytes_per_pixel;
+    let data = frame
+      .raw_data()
+      .get(start..start + len)
+      .ok_or(anyhow::anyhow!(
+        "The frame data is too small for its resolution"
+      ))?;
+
+    Ok(Self {
+      frame,
+      region,
+      data,
+    })
+  }
+
+  /// Get the region of the viewed frame this view covers.
+  pub fn region(&self) -> Region {
+    self.region
+  }
+
+  /// Get the viewed frame.
+  pub fn frame(&self) -> &'a dyn Freenect2Frame {
+    self.frame
+  }
+
+  /// Copy the pixels of the view into an owned frame.
+  /// See [`OwnedFrame::from_frame`].
+  pub fn to_owned(&self) -> OwnedFrame {
+    OwnedFrame::from_frame(self)
+  }
+}
+
+impl Freenect2Frame for FrameView<'_> {
+  fn width(&self) -> usize {
+    self.region.width as _
+  }
+
+  fn height(&self) -> usize {
+    self.region.height as _
+  }
+
+  fn bytes_per_pixel(&self) -> usize {
+    self.frame.bytes_per_pixel()
+  }
+
+  fn timestamp(&self) -> u32 {
+    self.frame.timestamp()
+  }
+
+  fn raw_data(&self) -> &[u8] {
+    self.data
+  }
+
+  fn row_pitch(&self) -> usize {
+    self.frame.row_pitch()
+  }
+
+  fn sequence(&self) -> u32 {
+    self.frame.sequence()
+  }
+
+  fn exposure(&self) -> f32 {
+    self.frame.exposure()
+  }
+
+  fn gain(&self) -> f32 {
+    self.frame.gain()
+  }
+
+  fn gamma(&self) -> f32 {
+    self.frame.gamma()
+  }
+
+  fn status(&self) -> u32 {
+    self.frame.status()
+  }
+
+  fn format(&self) -> FrameFormat {
+    self.frame.format()
+  }
+}
@@ -1,9 +1,15 @@
 use crate::ffi;
 use crate::types::freenect2_device::Freenect2Device;
+use crate::types::gpu_device::{DevicePlacement, GpuApi};
+use crate::types::thread_policy::ThreadPolicy;
+use crate::types::usb_transfers::UsbTransferConfig;
 use crate::util::logger::init_logger;
 use anyhow::{anyhow, Context, Error};
 use cxx::UniquePtr;
+use std::cell::Cell;
+use std::ops::{Deref, DerefMut};
 use std::pin::Pin;
+use std::ptr;
 use std::sync::{Arc, LazyLock, Mutex, MutexGuard, Weak};
 
 /// Global static instance of `Freenect2`.
@@ -12,6 +18,50 @@ use std::sync::{Arc, LazyLock, Mutex, MutexGuard, Weak};
 /// Stored in a [`Weak`] to allow for dropping when no longer needed.
 static FREENECT2: LazyLock<Mutex<Weak<Mutex<Freenect2Impl>>>> = LazyLock::new(Mutex::default);
 
+/// An instance and its locked value.
+type HeldInstance = (*const Mutex<Freenect2Impl>, *mut Freenect2Impl);
+
+thread_local! {
+  /// The instance locked by [`Freenect2::open_with_usb_transfers`] on this thread.
+  /// Reused by the methods called by its `open` callback, which would deadlock otherwise.
+  static HELD_INSTANCE: Cell<Option<HeldInstance>> = const { Cell::new(None) };
+}
+
+/// Clears [`HELD_INSTANCE`] once dropped, even if `open` panics.
+struct HeldInstanceReset;
+
+impl Drop for HeldInstanceReset {
+  fn drop(&mut self) {
+    HELD_INSTANCE.with(|held| held.set(None));
+  }
+}
+
+/// Exclusive access to the [`Freenect2Impl`] of an instance.
+enum InstanceGuard<'a> {
+  Locked(MutexGuard<'a, Freenect2Impl>),
+  Held(&'a mut Freenect2Impl),
+}
+
+impl Deref for InstanceGuard<'_> {
+  type Target = Freenect2Impl;
+
+  fn deref(&self) -> &Self::Target {
+    match self {
+      Self::Locked(guard) => guard,
+      Self::Held(instance) => instance,
+    }
+  }
+}
+
+impl DerefMut for InstanceGuard<'_> {
+  fn deref_mut(&mut self) -> &mut Self::Target {
+    match self {
+      Self::Locked(guard) => guard,
+      Self::Held(instance) => instance,
+    }
+  }
+}
+
 struct Freenect2Impl(UniquePtr<ffi::libfreenect2::Freenect2>);
 
 impl Freenect2Impl {
@@ -32,7 +82,7 @@ impl Freenect2Impl {
 unsafe impl Send for Freenect2Impl {}
 unsafe impl Sync for Freenect2Impl {}
 
-pub use crate::ffi::libfreenect2::PacketPipeline;
+pub use crate::ffi::libfreenect2::{PacketPipeline, RawPackets};
 
 impl Default for PacketPipeline {
   fn default() -> Self {
@@ -40,6 +90,80 @@ impl Default for PacketPipeline {
   }
 }
 
+impl Default for RawPackets {
+  fn default() -> Self {
+    RawPackets::None
+  }
+}
+
+impl RawPackets {
+  /// Whether color is delivered as undecoded JPEG packets.
+  pub fn includes_color(&self) -> bool {
+    matches!(*self, RawPackets::Color | RawPackets::All)
+  }
+
+  /// Whether depth is delivered as undecoded packets.
+  pub fn includes_depth(&self) -> bool {
+    matches!(*self, RawPackets::Depth | RawPackets::All)
+  }
+}
+
+impl PacketPipeline {
+  /// Get all packet pipelines this crate was compiled with,
+  /// ordered from the fastest to the slowest.
+  /// [`PacketPipeline::CPU`] is always available.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::freenect2::PacketPipeline;
+  ///
+  /// let pipelines = PacketPipeline::available();
+  /// assert!(pipelines.last() == Some(&PacketPipeline::CPU));
+  /// ```
+  pub fn available() -> Vec<PacketPipeline> {
+    vec![
+      #[cfg(feature = "cuda")]
+      PacketPipeline::CUDA,
+      #[cfg(feature = "cuda")]
+      PacketPipeline::CUDAKDE,
+      #[cfg(feature = "opencl")]
+      PacketPipeline::OpenCL,
+      #[cfg(feature = "opencl")]
+      PacketPipeline::OpenCLKDE,
+      #[cfg(feature = "opengl")]
+      PacketPipeline::OpenGL,
+      PacketPipeline::CPU,
+    ]
+  }
+
+  /// Get the fastest packet pipeline this crate was compiled with.
+  /// Whether the pipeline can actually be used depends on the
+  /// GPUs and drivers installed on the system. Opening a device
+  /// fails if the pipeline can not be initialized.
+  pub fn fastest_available() -> PacketPipeline {
+    Self::available()[0]
+  }
+
+  /// Whether this pipeline runs on a GPU and
+  /// accepts a device index when opening a device.
+  /// The OpenGL pipeline always uses the current OpenGL context.
+  pub fn uses_device_index(&self) -> bool {
+    self.gpu_api().is_some()
+  }
+
+  /// Get the API of the devices this pipeline can be placed on.
+  /// Returns [`None`] if the pipeline does not accept a device index.
+  pub fn gpu_api(&self) -> Option<GpuApi> {
+    match *self {
+      #[cfg(feature = "cuda")]
+      PacketPipeline::CUDA | PacketPipeline::CUDAKDE => Some(GpuApi::CUDA),
+      #[cfg(feature = "opencl")]
+      PacketPipeline::OpenCL | PacketPipeline::OpenCLKDE => Some(GpuApi::OpenCL),
+      _ => None,
+    }
+  }
+}
+
 /// Wrapper around libfreenect2's `Freenect2` class.
 /// Used to manage the connected devices.
 /// The `Freenect2` instance is used to open devices.
@@ -84,6 +208,129 @@ impl Freenect2 {
     Ok(Self(instance))
   }
 
+  /// Create a new `Freenect2` instance, starting its USB event loop thread
+  /// with a [`ThreadPolicy`]. The USB event loop is shared by all devices.
+  ///
+  /// If another instance is already alive, it is returned
+  /// and the policy is not applied, see [`Self::new`].
+  ///
+  /// # Errors
+  /// Returns an error if the policy could not be applied
+  /// or the instance could not be created.
+  pub fn new_with_thread_policy(policy: &ThreadPolicy) -> anyhow::Result<Self> {
+    let _guard = policy.enter()?;
+    Self::new()
+  }
+
+  /// Open a device with a [`ThreadPolicy`].
+  /// The policy is applied to the calling thread while `open` runs, so all threads
+  /// libfreenect2 starts for the device keep it, and to the worker threads of
+  /// registrations created by the device.
+  ///
+  /// # Arguments
+  /// * `policy` - The policy of the threads of the device.
+  /// * `open` - Opens the device, using any of the `open_*` methods.
+  ///
+  /// # Errors
+  /// Returns an error if the policy could not be applied or the device could not be opened.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::freenect2::{Freenect2, PacketPipeline};
+  /// use libfreenect2_rs::thread_policy::ThreadPolicy;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  /// let serial = freenect2.get_default_device_serial_number().unwrap();
+  ///
+  /// // Process the frames of the device on the CPUs of the first NUMA node
+  /// let device = freenect2
+  ///   .open_with_thread_policy(&ThreadPolicy::numa_local(0), |freenect2| {
+  ///     freenect2.open_device_by_serial_with_packet_pipeline(&serial, PacketPipeline::CPU)
+  ///   })
+  ///   .unwrap();
+  /// ```
+  pub fn open_with_thread_policy<'b>(
+    &'b mut self,
+    policy: &ThreadPolicy,
+    open: impl FnOnce(&'b mut Self) -> anyhow::Result<Freenect2Device<'b>>,
+  ) -> anyhow::Result<Freenect2Device<'b>> {
+    let guard = policy.enter()?;
+    let mut device = open(self)?;
+    drop(guard);
+
+    device.set_thread_policy(Some(policy.clone()));
+    Ok(device)
+  }
+
+  /// Open a device with a [`UsbTransferConfig`].
+  /// libfreenect2 reads its transfer settings from environment variables while
+  /// opening a device, so the variables set in `config` are overridden while `open`
+  /// runs and restored afterwards. The [`Freenect2`] instance stays locked until
+  /// `open` returns, so other threads using it, for example to open another device,
+  /// wait for the scope to end. `open` must not call this method again.
+  ///
+  /// # Thread safety
+  /// The environment is shared by the whole process, and changing it is not
+  /// synchronized with reading it. Every concurrent read of the environment races
+  /// with this method, including [`std::env`] and C `getenv` calls of other threads,
+  /// the threads of devices which are already open and the USB event loop thread.
+  /// Only use it while no other thread reads the environment, for example before
+  /// spawning the threads of the application.
+  ///
+  /// # Arguments
+  /// * `config` - The USB transfers of the device.
+  /// * `open` - Opens the device, using any of the `open_*` methods.
+  ///
+  /// # Errors
+  /// Returns an error if a setting is out of range or the device could not be opened.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::freenect2::Freenect2;
+  /// use libfreenect2_rs::usb_transfers::UsbTransferConfig;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  /// let config = UsbTransferConfig {
+  ///   rgb_transfers: 40,
+  ///   ir_transfers: 120,
+  ///   ..Default::default()
+  /// };
+  ///
+  /// let mut device = freenect2
+  ///   .open_with_usb_transfers(&config, |freenect2| freenect2.open_default_device())
+  ///   .unwrap();
+  /// device.start().unwrap();
+  ///
+  /// // Later on
+  /// let stats = device.packet_stats().unwrap();
+  /// if stats.depth.loss_ratio() > 0.01 {
+  ///   println!("Lost {} depth packets", stats.depth.lost);
+  /// }
+  /// ```
+  pub fn open_with_usb_transfers<'b>(
+    &'b mut self,
+    config: &UsbTransferConfig,
+    open: impl FnOnce(&'b mut Self) -> anyhow::Result<Freenect2Device<'b>>,
+  ) -> anyhow::Result<Freenect2Device<'b>> {
+    if Self::held_instance().is_some() {
+      return Err(anyhow!(
+        "Cannot open a device with USB transfers while opening another one"
+      ));
+    }
+
+    let instance = self.0.clone();
+    let mut guard = instance
+      .lock()
+      .map_err(|e| anyhow!(e.to_string()))
+      .context("Failed to get freenect2 as mutable")?;
+    let _scope = config.enter()?;
+
+    let held = (Arc::as_ptr(&instance), &mut *guard as *mut Freenect2Impl);
+    HELD_INSTANCE.with(|instance| instance.set(Some(held)));
+    let _reset = HeldInstanceReset;
+    open(self)
+  }
+
   /// Enumerate the connected devices.
   /// Returns the number of devices found.
   ///
@@ -155,7 +402,85 @@ impl Freenect2 {
     unsafe {
       this
         .get_mut()?
-        .open_default_device_with_packet_pipeline(pipeline)
+        .open_default_device_with_packet_pipeline(pipeline, -1, RawPackets::None)
+        .map(Freenect2Device::new)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Open the default device with the specified packet pipeline
+  /// running on the GPU selected by `placement`.
+  /// Returns a new [`Freenect2Device`] instance.
+  ///
+  /// # Arguments
+  /// * `pipeline` - The packet pipeline to use.
+  /// * `placement` - The GPU to run the pipeline on. Either a [`DevicePlacement`]
+  ///    or the [`crate::gpu_device::GpuDevice::index`] of a device, -1 lets libfreenect2 pick
+  ///    the device. Ignored by pipelines which don't run on a GPU.
+  ///
+  /// # Errors
+  /// Returns an error if no default device is found.
+  pub fn open_default_device_with_packet_pipeline_on_device(
+    &mut self,
+    pipeline: PacketPipeline,
+    placement: impl Into<DevicePlacement>,
+  ) -> anyhow::Result<Freenect2Device> {
+    let device_id = placement.into().device_id(pipeline);
+    let mut this = self.get_mut()?;
+    unsafe {
+      this
+        .get_mut()?
+        .open_default_device_with_packet_pipeline(pipeline, device_id, RawPackets::None)
+        .map(Freenect2Device::new)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Open the default device and deliver the streams selected by `raw`
+  /// as undecoded packets. The remaining streams are decoded
+  /// by `pipeline` running on the GPU selected by `placement`.
+  /// Returns a new [`Freenect2Device`] instance.
+  ///
+  /// Undecoded color frames contain the JPEG payload, which can be decoded on
+  /// demand using [`crate::raw_packet::decode_color`] or stored as is.
+  /// See [`RawPackets`] for the format of the frames.
+  ///
+  /// # Arguments
+  /// * `pipeline` - The packet pipeline decoding the remaining streams.
+  /// * `placement` - The GPU to run the pipeline on. Either a [`DevicePlacement`]
+  ///    or the [`crate::gpu_device::GpuDevice::index`] of a device, -1 lets libfreenect2 pick
+  ///    the device. Ignored by pipelines which don't run on a GPU.
+  /// * `raw` - The streams to deliver as undecoded packets.
+  ///
+  /// # Errors
+  /// Returns an error if no default device is found.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::freenect2::{Freenect2, PacketPipeline, RawPackets};
+  /// use libfreenect2_rs::gpu_device::DevicePlacement;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  ///
+  /// // Store the JPEG payload, decode depth on the GPU
+  /// let device = freenect2.open_default_device_with_raw_packets(
+  ///   PacketPipeline::OpenCL,
+  ///   DevicePlacement::Default,
+  ///   RawPackets::Color,
+  /// ).unwrap();
+  /// ```
+  pub fn open_default_device_with_raw_packets(
+    &mut self,
+    pipeline: PacketPipeline,
+    placement: impl Into<DevicePlacement>,
+    raw: RawPackets,
+  ) -> anyhow::Result<Freenect2Device> {
+    let device_id = placement.into().device_id(pipeline);
+    let mut this = self.get_mut()?;
+    unsafe {
+      this
+        .get_mut()?
+        .open_default_device_with_packet_pipeline(pipeline, device_id, raw)
         .map(Freenect2Device::new)
         .map_err(Into::into)
     }
@@ -198,7 +523,87 @@ impl Freenect2 {
     unsafe {
       this
         .get_mut()?
-        .open_device_by_id_with_packet_pipeline(idx, pipeline)
+        .open_device_by_id_with_packet_pipeline(idx, pipeline, -1, RawPackets::None)
+        .map(Freenect2Device::new)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Open the device at the specified index with the specified packet pipeline
+  /// running on the GPU selected by `placement`.
+  /// Returns a new [`Freenect2Device`] instance.
+  ///
+  /// # Arguments
+  /// * `idx` - The index of the device to open.
+  /// * `pipeline` - The packet pipeline to use.
+  /// * `placement` - The GPU to run the pipeline on. Either a [`DevicePlacement`]
+  ///    or the [`crate::gpu_device::GpuDevice::index`] of a device, -1 lets libfreenect2 pick
+  ///    the device. Ignored by pipelines which don't run on a GPU.
+  ///
+  /// # Errors
+  /// Returns an error if the device at the specified index is not found.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::freenect2::{Freenect2, PacketPipeline};
+  /// use libfreenect2_rs::gpu_device::DevicePlacement;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  /// let mut devices = Vec::new();
+  ///
+  /// // Spread the depth decoding of all devices across all GPUs
+  /// for idx in 0..freenect2.enumerate_devices().unwrap() {
+  ///   devices.push(freenect2.open_device_by_id_with_packet_pipeline_on_device(
+  ///     idx,
+  ///     PacketPipeline::OpenCL,
+  ///     DevicePlacement::RoundRobin,
+  ///   ).unwrap());
+  /// }
+  /// ```
+  pub fn open_device_by_id_with_packet_pipeline_on_device(
+    &mut self,
+    idx: i32,
+    pipeline: PacketPipeline,
+    placement: impl Into<DevicePlacement>,
+  ) -> anyhow::Result<Freenect2Device> {
+    let device_id = placement.into().device_id(pipeline);
+    let mut this = self.get_mut()?;
+    unsafe {
+      this
+        .get_mut()?
+        .open_device_by_id_with_packet_pipeline(idx, pipeline, device_id, RawPackets::None)
+        .map(Freenect2Device::new)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Open the device at the specified index and deliver the streams selected
+  /// by `raw` as undecoded packets. The remaining streams are decoded
+  /// by `pipeline` running on the GPU selected by `placement`.
+  /// Returns a new [`Freenect2Device`] instance.
+  /// See [`Self::open_default_device_with_raw_packets`] for details.
+  ///
+  /// # Arguments
+  /// * `idx` - The index of the device to open.
+  /// * `pipeline` - The packet pipeline decoding the remaining streams.
+  /// * `placement` - The GPU to run the pipeline on. Ignored by pipelines which don't run on a GPU.
+  /// * `raw` - The streams to deliver as undecoded packets.
+  ///
+  /// # Errors
+  /// Returns an error if the device at the specified index is not found.
+  pub fn open_device_by_id_with_raw_packets(
+    &mut self,
+    idx: i32,
+    pipeline: PacketPipeline,
+    placement: impl Into<DevicePlacement>,
+    raw: RawPackets,
+  ) -> anyhow::Result<Freenect2Device> {
+    let device_id = placement.into().device_id(pipeline);
+    let mut this = self.get_mut()?;
+    unsafe {
+      this
+        .get_mut()?
+        .open_device_by_id_with_packet_pipeline(idx, pipeline, device_id, raw)
         .map(Freenect2Device::new)
         .map_err(Into::into)
     }
@@ -240,24 +645,119 @@ impl Freenect2 {
     unsafe {
       this
         .get_mut()?
-        .open_device_by_serial_with_packet_pipeline(serial, pipeline)
+        .open_device_by_serial_with_packet_pipeline(serial, pipeline, -1, RawPackets::None)
         .map(Freenect2Device::new)
         .map_err(Into::into)
     }
   }
 
+  /// Open the device with the specified serial number and packet pipeline
+  /// running on the GPU selected by `placement`.
+  /// Returns a new [`Freenect2Device`] instance.
+  ///
+  /// # Arguments
+  /// * `serial` - The serial number of the device to open.
+  /// * `pipeline` - The packet pipeline to use.
+  /// * `placement` - The GPU to run the pipeline on. Either a [`DevicePlacement`]
+  ///    or the [`crate::gpu_device::GpuDevice::index`] of a device, -1 lets libfreenect2 pick
+  ///    the device. Ignored by pipelines which don't run on a GPU.
+  ///
+  /// # Errors
+  /// Returns an error if the device with the specified serial number is not found.
+  pub fn open_device_by_serial_with_packet_pipeline_on_device(
+    &mut self,
+    serial: &str,
+    pipeline: PacketPipeline,
+    placement: impl Into<DevicePlacement>,
+  ) -> anyhow::Result<Freenect2Device> {
+    let device_id = placement.into().device_id(pipeline);
+    let mut this = self.get_mut()?;
+    unsafe {
+      this
+        .get_mut()?
+        .open_device_by_serial_with_packet_pipeline(serial, pipeline, device_id, RawPackets::None)
+        .map(Freenect2Device::new)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Open the device with the specified serial number and deliver the streams
+  /// selected by `raw` as undecoded packets. The remaining streams are decoded
+  /// by `pipeline` running on the GPU selected by `placement`.
+  /// Returns a new [`Freenect2Device`] instance.
+  /// See [`Self::open_default_device_with_raw_packets`] for details.
+  ///
+  /// # Arguments
+  /// * `serial` - The serial number of the device to open.
+  /// * `pipeline` - The packet pipeline decoding the remaining streams.
+  /// * `placement` - The GPU to run the pipeline on. Ignored by pipelines which don't run on a GPU.
+  /// * `raw` - The streams to deliver as undecoded packets.
+  ///
+  /// # Errors
+  /// Returns an error if the device with the specified serial number is not found.
+  pub fn open_device_by_serial_with_raw_packets(
+    &mut self,
+    serial: &str,
+    pipeline: PacketPipeline,
+    placement: impl Into<DevicePlacement>,
+    raw: RawPackets,
+  ) -> anyhow::Result<Freenect2Device> {
+    let device_id = placement.into().device_id(pipeline);
+    let mut this = self.get_mut()?;
+    unsafe {
+      this
+        .get_mut()?
+        .open_device_by_serial_with_packet_pipeline(serial, pipeline, device_id, raw)
+        .map(Freenect2Device::new)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Open a device by its serial number without borrowing this instance.
+  /// Opening is serialized by the instance lock, as libfreenect2
+  /// doesn't support opening devices concurrently.
+  ///
+  /// # Safety
+  /// The returned device must be dropped while a [`Freenect2`] instance is still alive.
+  pub(crate) unsafe fn open_detached_device_by_serial(
+    &mut self,
+    serial: &str,
+    pipeline: PacketPipeline,
+    device_id: i32,
+    raw: RawPackets,
+  ) -> anyhow::Result<Freenect2Device<'static>> {
+    let mut this = self.get_mut()?;
+    this
+      .get_mut()?
+      .open_device_by_serial_with_packet_pipeline(serial, pipeline, device_id, raw)
+      .map(Freenect2Device::new)
+      .map_err(Into::into)
+  }
+
   #[cfg(test)]
   pub(crate) fn has_instance() -> bool {
     FREENECT2.lock().unwrap().upgrade().is_some()
   }
 
-  fn get_mut(&mut self) -> Result<MutexGuard<'_, Freenect2Impl>, Error> {
+  fn get_mut(&mut self) -> Result<InstanceGuard<'_>, Error> {
+    if let Some((instance, held)) = Self::held_instance() {
+      if ptr::eq(instance, Arc::as_ptr(&self.0)) {
+        // Locked by open_with_usb_transfers on this thread until open returns
+        return Ok(InstanceGuard::Held(unsafe { &mut *held }));
+      }
+    }
+
     self
       .0
       .lock()
+      .map(InstanceGuard::Locked)
       .map_err(|e| anyhow!(e.to_string()))
       .context("Failed to get freenect2 as mutable")
   }
+
+  fn held_instance() -> Option<HeldInstance> {
+    HELD_INSTANCE.with(Cell::get)
+  }
 }
 
 unsafe impl Send for Freenect2 {}
@@ -3,8 +3,13 @@ use cxx::UniquePtr;
 
 use crate::ffi;
 use crate::frame_listener::AsFrameListener;
+use crate::metrics::Metrics;
 use crate::types::config::Config;
-use crate::types::registration::Registration;
+use crate::types::depth_post_processor::DepthPostProcessing;
+use crate::types::registration::{Registration, RegistrationEngine};
+use crate::types::registration_tables::{CameraParams, RegistrationCache, RegistrationTables};
+use crate::types::thread_policy::ThreadPolicy;
+use crate::types::usb_transfers::PacketStats;
 
 pub use ffi::libfreenect2::LedMode;
 pub use ffi::libfreenect2::LedSettings;
@@ -17,6 +22,8 @@ pub struct Freenect2Device<'a> {
   device: UniquePtr<ffi::libfreenect2::Freenect2Device<'a>>,
   started: bool,
   closed: bool,
+  metrics: Option<Metrics>,
+  thread_policy: Option<ThreadPolicy>,
 }
 
 impl<'a> Freenect2Device<'a> {
@@ -25,9 +32,57 @@ impl<'a> Freenect2Device<'a> {
       device,
       started: false,
       closed: false,
+      metrics: None,
+      thread_policy: None,
     }
   }
 
+  /// Set the metrics registrations of this device record into.
+  /// Registrations created after this call using [`Self::get_registration`]
+  /// or [`Self::get_registration_with_engine`] time their calls into `metrics`.
+  /// Pass the same handle to the options of the frame listeners
+  /// to collect the metrics of the whole device in one place.
+  /// If [`None`], new registrations do not measure anything.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::freenect2::Freenect2;
+  /// use libfreenect2_rs::metrics::Metrics;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  /// let mut device = freenect2.open_default_device().unwrap();
+  ///
+  /// device.set_metrics(Some(Metrics::new()));
+  /// device.start().unwrap();
+  ///
+  /// let registration = device.get_registration().unwrap();
+  /// let metrics = device.metrics().unwrap().snapshot();
+  /// ```
+  pub fn set_metrics(&mut self, metrics: Option<Metrics>) {
+    self.metrics = metrics;
+  }
+
+  /// Get the metrics set using [`Self::set_metrics`].
+  pub fn metrics(&self) -> Option<&Metrics> {
+    self.metrics.as_ref()
+  }
+
+  pub(crate) fn set_thread_policy(&mut self, policy: Option<ThreadPolicy>) {
+    self.thread_policy = policy;
+  }
+
+  /// Get the [`ThreadPolicy`] the device was opened with using
+  /// [`crate::freenect2::Freenect2::open_with_thread_policy`].
+  pub fn thread_policy(&self) -> Option<&ThreadPolicy> {
+    self.thread_policy.as_ref()
+  }
+
+  fn create_registration(&self, inner: UniquePtr<ffi::libfreenect2::Registration>) -> Registration {
+    let mut registration = Registration::new(inner);
+    registration.set_metrics(self.metrics.clone());
+    registration
+  }
+
   /// Get the serial number of the device.
   /// This is a unique identifier for the device.
   ///
@@ -243,6 +298,8 @@ impl<'a> Freenect2Device<'a> {
 
   /// Set the configuration for the device.
   /// The configuration specifies the resolution and format of the streams.
+  /// The depth streams of the configuration also apply to the IR and depth
+  /// frame listener, see [`Config::set_depth_streams`].
   ///
   /// # Arguments
   /// * `config` - The configuration to set.
@@ -271,6 +328,72 @@ impl<'a> Freenect2Device<'a> {
     }
   }
 
+  /// Set the post-processing of the depth frames of this device.
+  /// Depth frames are processed in place on the depth processing thread,
+  /// before they are passed to the IR and depth frame listener.
+  /// IR frames are passed on unchanged.
+  ///
+  /// Decimation changes the size of the depth frames, see
+  /// [`crate::depth_post_processor::DepthDecimation`].
+  /// Registrations only accept 512x424 depth frames, so decimated frames
+  /// are rejected by every [`Registration`] and
+  /// [`crate::registration::RegistrationContext`] method.
+  ///
+  /// # Arguments
+  /// * `options` - The post-processing to apply, [`None`] to disable it.
+  ///
+  /// # Errors
+  /// Returns an error if the options are invalid
+  /// or the device is closed or started.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::depth_post_processor::{DepthDecimation, DepthPostProcessing};
+  /// use libfreenect2_rs::freenect2::Freenect2;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  /// let mut device = freenect2.open_default_device().unwrap();
+  ///
+  /// device
+  ///   .set_depth_post_processing(Some(&DepthPostProcessing {
+  ///     range: Some((500.0, 4000.0)),
+  ///     decimation: DepthDecimation::Half,
+  ///     ..Default::default()
+  ///   }))
+  ///   .unwrap();
+  /// device.start_streams(false, true).unwrap();
+  /// ```
+  pub fn set_depth_post_processing(
+    &mut self,
+    options: Option<&DepthPostProcessing>,
+  ) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      !self.closed,
+      "Device must not be closed when setting the depth post-processing"
+    );
+    anyhow::ensure!(
+      !self.started,
+      "Device must not be started when setting the depth post-processing"
+    );
+
+    let device = self
+      .device
+      .as_mut()
+      .ok_or(anyhow!("Could not get freenect2 device as mutable"))?;
+
+    unsafe {
+      match options {
+        Some(options) => device
+          .set_depth_post_processing(&options.to_params())
+          .map_err(Into::into),
+        None => {
+          device.clear_depth_post_processing();
+          Ok(())
+        }
+      }
+    }
+  }
+
   /// Get the registration for the device.
   /// The registration is used to map depth frames to color frames.
   /// The device must be started before getting the registration.
@@ -287,17 +410,163 @@ impl<'a> Freenect2Device<'a> {
       "Device must be started before getting registration"
     );
 
+    let inner = unsafe {
+      self
+        .device
+        .as_mut()
+        .ok_or(anyhow!("Could not get freenect2 device as mutable"))?
+        .get_registration()?
+    };
+
+    Ok(self.create_registration(inner))
+  }
+
+  /// Get the registration for the device using a specific [`RegistrationEngine`].
+  /// All engines produce the same output, so they can be swapped
+  /// or compared against each other.
+  /// The device must be started before getting the registration.
+  ///
+  /// # Arguments
+  /// * `engine` - The engine used to map depth frames to color frames.
+  /// * `threads` - The number of threads used by [`RegistrationEngine::Parallel`],
+  ///    including the calling thread. If 0, the number of hardware threads is used.
+  ///    Ignored by [`RegistrationEngine::Libfreenect2`].
+  ///    The threads keep the [`Self::thread_policy`] of the device.
+  ///
+  /// # Errors
+  /// Returns an error if the registration could not be retrieved or the device is not started.
+  pub fn get_registration_with_engine(
+    &mut self,
+    engine: RegistrationEngine,
+    threads: usize,
+  ) -> anyhow::Result<Registration> {
+    anyhow::ensure!(
+      !self.closed,
+      "Device must not be closed when getting registration"
+    );
+    anyhow::ensure!(
+      self.started,
+      "Device must be started before getting registration"
+    );
+
+    // The worker threads of the registration are started by the calling thread
+    let _guard = self
+      .thread_policy
+      .as_ref()
+      .map(ThreadPolicy::enter)
+      .transpose()?;
+    let inner = unsafe {
+      self
+        .device
+        .as_mut()
+        .ok_or(anyhow!("Could not get freenect2 device as mutable"))?
+        .get_registration_with_engine(engine, threads as u64)?
+    };
+
+    Ok(self.create_registration(inner))
+  }
+
+  /// Get the factory calibrated camera parameters of the device.
+  /// The device must be started before getting the camera parameters.
+  ///
+  /// # Errors
+  /// Returns an error if the device is closed or not started.
+  pub fn get_camera_params(&mut self) -> anyhow::Result<CameraParams> {
+    anyhow::ensure!(
+      !self.closed,
+      "Device must not be closed when getting camera parameters"
+    );
+    anyhow::ensure!(
+      self.started,
+      "Device must be started before getting camera parameters"
+    );
+
     unsafe {
       self
         .device
         .as_mut()
         .ok_or(anyhow!("Could not get freenect2 device as mutable"))?
-        .get_registration()
-        .map(Registration::new)
+        .get_camera_params()
         .map_err(Into::into)
     }
   }
 
+  /// Get the [`RegistrationTables`] of the device.
+  /// If `cache` contains tables for the serial number of the device,
+  /// these are returned and the device does not need to be started.
+  /// Otherwise, the tables are computed from the camera parameters of the
+  /// device, which must be started, and stored in `cache`.
+  ///
+  /// # Arguments
+  /// * `cache` - The cache to load the tables from and store them in.
+  ///
+  /// # Errors
+  /// Returns an error if the device is closed, if the tables are not cached
+  /// and the device is not started, or if the cached tables are invalid.
+  /// Failing to store the tables in the cache is logged, but not an error.
+  pub fn get_registration_tables(
+    &mut self,
+    cache: Option<&RegistrationCache>,
+  ) -> anyhow::Result<RegistrationTables> {
+    let Some(cache) = cache else {
+      return RegistrationTables::new(&self.get_camera_params()?);
+    };
+
+    let serial = self.get_serial_number()?;
+    if let Some(tables) = cache.load(&serial)? {
+      return Ok(tables);
+    }
+
+    let tables = RegistrationTables::new(&self.get_camera_params()?)?;
+    if let Err(e) = cache.store(&serial, &tables) {
+      log::warn!(
+        "Failed to cache the registration of device {}: {}",
+        serial,
+        e
+      );
+    }
+
+    Ok(tables)
+  }
+
+  /// Get the number of frames received and packets lost per stream since the
+  /// device was opened or [`Self::reset_packet_stats`] was last called.
+  /// Only frames of streams with a frame listener are counted.
+  /// See [`crate::usb_transfers`] for what counts as a lost packet.
+  ///
+  /// # Errors
+  /// Returns an error if the device is closed.
+  pub fn packet_stats(&self) -> anyhow::Result<PacketStats> {
+    anyhow::ensure!(
+      !self.closed,
+      "Device must not be closed when getting packet stats"
+    );
+
+    let device = self
+      .device
+      .as_ref()
+      .ok_or(anyhow!("Could not get freenect2 device"))?;
+    Ok(device.get_packet_stats())
+  }
+
+  /// Reset the counters returned by [`Self::packet_stats`].
+  ///
+  /// # Errors
+  /// Returns an error if the device is closed.
+  pub fn reset_packet_stats(&mut self) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      !self.closed,
+      "Device must not be closed when resetting packet stats"
+    );
+
+    self
+      .device
+      .as_mut()
+      .ok_or(anyhow!("Could not get freenect2 device as mutable"))?
+      .reset_packet_stats();
+    Ok(())
+  }
+
   /// Set the LED settings of the device.
   /// The device must be started using [`Self::start`] or
   /// [`Self::start_streams`] before setting the LED settings.
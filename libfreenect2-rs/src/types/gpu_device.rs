@@ -0,0 +1,92 @@
+use crate::ffi;
+use crate::types::freenect2::PacketPipeline;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::LazyLock;
+
+pub use ffi::libfreenect2::{GpuApi, GpuDevice};
+
+/// The devices used by [`DevicePlacement::RoundRobin`].
+/// Listed once, as enumerating OpenCL platforms can be slow.
+static ROUND_ROBIN_DEVICES: LazyLock<Vec<GpuDevice>> =
+  LazyLock::new(|| list_gpu_devices().unwrap_or_default());
+
+/// The next round-robin slot per [`GpuApi`].
+static ROUND_ROBIN_NEXT: [AtomicUsize; 2] = [AtomicUsize::new(0), AtomicUsize::new(0)];
+
+/// List the OpenCL and CUDA devices packet pipelines can run on.
+/// Only the APIs enabled using the `opencl` and `cuda` features are queried.
+/// The [`GpuDevice::index`] of a device can be passed to
+/// [`crate::freenect2::Freenect2::open_device_by_id_with_packet_pipeline_on_device`]
+/// and its siblings.
+///
+/// # Errors
+/// Returns an error if the underlying C++ function fails.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::gpu_device::list_gpu_devices;
+///
+/// for device in list_gpu_devices().unwrap() {
+///   println!("{:?} device {}: {} ({})", device.api, device.index, device.name, device.platform);
+/// }
+/// ```
+pub fn list_gpu_devices() -> anyhow::Result<Vec<GpuDevice>> {
+  ffi::libfreenect2::list_gpu_devices().map_err(Into::into)
+}
+
+/// Which GPU a packet pipeline is placed on when opening a device.
+/// Ignored by pipelines that don't run on a GPU,
+/// see [`PacketPipeline::gpu_api`].
+#[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+pub enum DevicePlacement {
+  /// Let libfreenect2 pick the device.
+  /// OpenCL pipelines use the first GPU, CUDA pipelines use device 0.
+  #[default]
+  Default,
+  /// Use the device with the specified [`GpuDevice::index`].
+  Device(i32),
+  /// Place every device opened with this policy on the next
+  /// GPU of the pipeline's API, cycling through all of them.
+  /// Falls back to [`DevicePlacement::Default`] if no GPU is found.
+  RoundRobin,
+}
+
+impl From<i32> for DevicePlacement {
+  /// -1 maps to [`DevicePlacement::Default`], every other value to [`DevicePlacement::Device`].
+  fn from(device_id: i32) -> Self {
+    if device_id == -1 {
+      DevicePlacement::Default
+    } else {
+      DevicePlacement::Device(device_id)
+    }
+  }
+}
+
+impl DevicePlacement {
+  /// Get the device id to pass to the packet pipeline.
+  pub(crate) fn device_id(&self, pipeline: PacketPipeline) -> i32 {
+    let Some(api) = pipeline.gpu_api() else {
+      return -1;
+    };
+
+    match *self {
+      DevicePlacement::Default => -1,
+      DevicePlacement::Device(device_id) => device_id,
+      DevicePlacement::RoundRobin => {
+        let gpus = ROUND_ROBIN_DEVICES
+          .iter()
+          .filter(|device| device.api == api && device.is_gpu)
+          .collect::<Vec<_>>();
+        if gpus.is_empty() {
+          return -1;
+        }
+
+        let slot = match api {
+          GpuApi::CUDA => &ROUND_ROBIN_NEXT[1],
+          _ => &ROUND_ROBIN_NEXT[0],
+        };
+        gpus[slot.fetch_add(1, Ordering::Relaxed) % gpus.len()].index
+      }
+    }
+  }
+}
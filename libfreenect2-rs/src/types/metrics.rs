@@ -0,0 +1,370 @@
+use crate::ffi;
+use crate::frame::Freenect2Frame;
+use crate::types::frame::Frame;
+use crate::types::frame_type::FrameType;
+use std::fmt::Write;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+/// The number of buckets of a [`Histogram`].
+/// Bucket `i` counts durations of less than `2^i` microseconds,
+/// the last bucket counts everything longer.
+pub const HISTOGRAM_BUCKETS: usize = 28;
+
+/// A lock-free latency histogram with power-of-two microsecond buckets.
+/// Recording a value is a handful of relaxed atomic adds.
+#[derive(Default)]
+pub struct Histogram {
+  buckets: [AtomicU64; HISTOGRAM_BUCKETS],
+  count: AtomicU64,
+  sum_ns: AtomicU64,
+  max_ns: AtomicU64,
+}
+
+impl Histogram {
+  /// Record a duration.
+  pub fn record(&self, duration: Duration) {
+    self.record_ns(duration.as_nanos().min(u64::MAX as u128) as u64);
+  }
+
+  fn record_ns(&self, ns: u64) {
+    let us = ns / 1000;
+    let bucket = ((u64::BITS - us.leading_zeros()) as usize).min(HISTOGRAM_BUCKETS - 1);
+
+    self.buckets[bucket].fetch_add(1, Ordering::Relaxed);
+    self.count.fetch_add(1, Ordering::Relaxed);
+    self.sum_ns.fetch_add(ns, Ordering::Relaxed);
+    self.max_ns.fetch_max(ns, Ordering::Relaxed);
+  }
+
+  /// Get a snapshot of the current values.
+  /// The values are read one after another, a concurrently recorded
+  /// value may be missing from some of them.
+  pub fn snapshot(&self) -> HistogramSnapshot {
+    HistogramSnapshot {
+      buckets: std::array::from_fn(|i| self.buckets[i].load(Ordering::Relaxed)),
+      count: self.count.load(Ordering::Relaxed),
+      sum: Duration::from_nanos(self.sum_ns.load(Ordering::Relaxed)),
+      max: Duration::from_nanos(self.max_ns.load(Ordering::Relaxed)),
+    }
+  }
+}
+
+/// A snapshot of a [`Histogram`].
+#[derive(Debug, Copy, Clone, Default, PartialEq)]
+pub struct HistogramSnapshot {
+  /// The number of values per bucket.
+  /// See [`HistogramSnapshot::upper_bound`] for the range of a bucket.
+  pub buckets: [u64; HISTOGRAM_BUCKETS],
+  /// The number of recorded values.
+  pub count: u64,
+  /// The sum of all recorded values.
+  pub sum: Duration,
+  /// The largest recorded value.
+  pub max: Duration,
+}
+
+impl HistogramSnapshot {
+  /// Get the exclusive upper bound of a bucket.
+  /// Returns [`None`] for the last bucket, which has no upper bound.
+  pub fn upper_bound(bucket: usize) -> Option<Duration> {
+    (bucket < HISTOGRAM_BUCKETS - 1).then(|| Duration::from_micros(1 << bucket))
+  }
+
+  /// Get the mean of all recorded values.
+  pub fn mean(&self) -> Duration {
+    if self.count == 0 {
+      Duration::ZERO
+    } else {
+      Duration::from_nanos((self.sum.as_nanos() / self.count as u128) as u64)
+    }
+  }
+
+  /// Get an upper bound for the `q` quantile, with `q` between 0 and 1.
+  /// The bound is the upper bound of the bucket the quantile falls into,
+  /// capped at the largest recorded value.
+  pub fn quantile(&self, q: f64) -> Duration {
+    let rank = (q.clamp(0.0, 1.0) * self.count as f64).ceil() as u64;
+    let mut seen = 0;
+
+    for (i, count) in self.buckets.iter().enumerate() {
+      seen += count;
+      if seen >= rank.max(1) {
+        return Self::upper_bound(i).map_or(self.max, |bound| bound.min(self.max));
+      }
+    }
+
+    self.max
+  }
+
+  fn write_prometheus(&self, out: &mut String, name: &str) {
+    let _ = writeln!(out, "# TYPE {name} histogram");
+
+    let mut cumulative = 0;
+    for (i, count) in self.buckets.iter().enumerate() {
+      cumulative += count;
+      if let Some(bound) = Self::upper_bound(i) {
+        let _ = writeln!(
+          out,
+          "{name}_bucket{{le=\"{}\"}} {cumulative}",
+          bound.as_secs_f64()
+        );
+      }
+    }
+
+    let _ = writeln!(out, "{name}_bucket{{le=\"+Inf\"}} {}", self.count);
+    let _ = writeln!(out, "{name}_sum {}", self.sum.as_secs_f64());
+    let _ = writeln!(out, "{name}_count {}", self.count);
+  }
+}
+
+/// Why frames were dropped or never reached the consumer.
+#[derive(Debug, Copy, Clone, Eq, PartialEq, Hash)]
+pub enum DropReason {
+  /// A queue was full and its drop policy discarded a frame or frame set.
+  QueueFull,
+  /// A frame was replaced by a newer frame of the same type
+  /// before the frame set it belonged to was complete.
+  Coalesced,
+  /// A frame could not be paired with frames of the other types.
+  Unpaired,
+  /// libfreenect2 reported a non-zero status for the frame.
+  /// The frame is still delivered.
+  Status,
+}
+
+impl DropReason {
+  const ALL: [DropReason; 4] = [
+    DropReason::QueueFull,
+    DropReason::Coalesced,
+    DropReason::Unpaired,
+    DropReason::Status,
+  ];
+
+  fn name(&self) -> &'static str {
+    match self {
+      DropReason::QueueFull => "queue_full",
+      DropReason::Coalesced => "coalesced",
+      DropReason::Unpaired => "unpaired",
+      DropReason::Status => "status",
+    }
+  }
+}
+
+#[derive(Default)]
+struct MetricsInner {
+  decode_to_callback: Histogram,
+  callback: Histogram,
+  queue_wait: Histogram,
+  registration: Histogram,
+  frames: [AtomicU64; 3],
+  failed: AtomicU64,
+  drops: [AtomicU64; 4],
+}
+
+/// Latency histograms and counters of the stages a frame passes through.
+/// Metrics are opt-in: a [`Metrics`] handle is passed to the listeners
+/// and registrations that should record into it, everything else
+/// does not measure anything. Cloning the handle is cheap,
+/// all clones record into the same values.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame_listener::{MultiFrameListenerOptions, SharedFramesMultiFrameListener};
+/// use libfreenect2_rs::frame_type::FrameType;
+/// use libfreenect2_rs::metrics::Metrics;
+///
+/// let metrics = Metrics::new();
+/// let listener = SharedFramesMultiFrameListener::with_options(
+///   &[FrameType::Color, FrameType::Depth],
+///   MultiFrameListenerOptions {
+///     metrics: Some(metrics.clone()),
+///     ..Default::default()
+///   },
+/// ).unwrap();
+///
+/// /// Set the listener and start the device
+///
+/// let snapshot = metrics.snapshot();
+/// println!("p99 callback duration: {:?}", snapshot.callback.quantile(0.99));
+/// print!("{}", snapshot.to_prometheus("freenect2"));
+/// ```
+#[derive(Clone, Default)]
+pub struct Metrics(Arc<MetricsInner>);
+
+impl Metrics {
+  /// Create a new, empty set of metrics.
+  pub fn new() -> Self {
+    Self::default()
+  }
+
+  /// Wrap a frame listener closure so every call is recorded:
+  /// the time from the frame leaving the pipeline until the closure is called,
+  /// the duration of the closure, the number of frames and failed calls
+  /// and frames with a non-zero status.
+  ///
+  /// # Example
+  /// ```
+  /// use libfreenect2_rs::frame_listener::FrameListener;
+  /// use libfreenect2_rs::metrics::Metrics;
+  ///
+  /// let metrics = Metrics::new();
+  /// let listener = FrameListener::new(metrics.instrument(|ty, frame| {
+  ///   println!("Received frame of type {:?}", ty);
+  ///   Ok(())
+  /// })).unwrap();
+  /// ```
+  pub fn instrument<F>(
+    &self,
+    f: F,
+  ) -> impl Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + std::panic::UnwindSafe
+  where
+    F: Fn(FrameType, Frame<'static>) -> anyhow::Result<()> + std::panic::UnwindSafe,
+  {
+    let metrics = self.clone();
+    move |ty, frame| {
+      metrics.record_frame(ty, &frame);
+
+      let start = Instant::now();
+      let res = f(ty, frame);
+      metrics.record_callback(start.elapsed(), res.is_err());
+
+      res
+    }
+  }
+
+  /// Record a frame that is about to be passed to a consumer.
+  pub(crate) fn record_frame(&self, ty: FrameType, frame: &Frame) {
+    let received = frame.received_ns();
+    if received != 0 {
+      let now = ffi::libfreenect2::steady_clock_ns();
+      self
+        .0
+        .decode_to_callback
+        .record_ns(now.saturating_sub(received));
+    }
+
+    let index = match ty {
+      FrameType::Color => 0,
+      FrameType::Depth => 1,
+      FrameType::Ir => 2,
+    };
+    self.0.frames[index].fetch_add(1, Ordering::Relaxed);
+
+    if frame.status() != 0 {
+      self.record_drops(DropReason::Status, 1);
+    }
+  }
+
+  pub(crate) fn record_callback(&self, duration: Duration, failed: bool) {
+    self.0.callback.record(duration);
+    if failed {
+      self.0.failed.fetch_add(1, Ordering::Relaxed);
+    }
+  }
+
+  pub(crate) fn record_queue_wait(&self, enqueued: Option<Instant>) {
+    if let Some(enqueued) = enqueued {
+      self.0.queue_wait.record(enqueued.elapsed());
+    }
+  }
+
+  pub(crate) fn record_registration(&self, duration: Duration) {
+    self.0.registration.record(duration);
+  }
+
+  pub(crate) fn record_drops(&self, reason: DropReason, count: u64) {
+    if count > 0 {
+      let index = DropReason::ALL.iter().position(|r| *r == reason).unwrap();
+      self.0.drops[index].fetch_add(count, Ordering::Relaxed);
+    }
+  }
+
+  /// Get a snapshot of all values.
+  pub fn snapshot(&self) -> MetricsSnapshot {
+    MetricsSnapshot {
+      decode_to_callback: self.0.decode_to_callback.snapshot(),
+      callback: self.0.callback.snapshot(),
+      queue_wait: self.0.queue_wait.snapshot(),
+      registration: self.0.registration.snapshot(),
+      color_frames: self.0.frames[0].load(Ordering::Relaxed),
+      depth_frames: self.0.frames[1].load(Ordering::Relaxed),
+      ir_frames: self.0.frames[2].load(Ordering::Relaxed),
+      failed: self.0.failed.load(Ordering::Relaxed),
+      drops: std::array::from_fn(|i| (DropReason::ALL[i], self.0.drops[i].load(Ordering::Relaxed))),
+    }
+  }
+}
+
+/// A snapshot of [`Metrics`].
+#[derive(Debug, Clone, PartialEq)]
+pub struct MetricsSnapshot {
+  /// The time from a frame leaving the packet pipeline until it is passed to a consumer.
+  pub decode_to_callback: HistogramSnapshot,
+  /// The duration of the listener closures.
+  pub callback: HistogramSnapshot,
+  /// The time frames or frame sets spent in a queue until they were received.
+  pub queue_wait: HistogramSnapshot,
+  /// The duration of registrations.
+  pub registration: HistogramSnapshot,
+  /// The number of color frames received.
+  pub color_frames: u64,
+  /// The number of depth frames received.
+  pub depth_frames: u64,
+  /// The number of IR frames received.
+  pub ir_frames: u64,
+  /// The number of listener calls that returned an error or panicked.
+  pub failed: u64,
+  /// The number of dropped frames and frame sets by reason.
+  pub drops: [(DropReason, u64); 4],
+}
+
+impl MetricsSnapshot {
+  /// Get the number of drops for a reason.
+  pub fn dropped(&self, reason: DropReason) -> u64 {
+    self
+      .drops
+      .iter()
+      .find(|(r, _)| *r == reason)
+      .map_or(0, |(_, count)| *count)
+  }
+
+  /// Format the snapshot in the Prometheus text exposition format.
+  /// Every metric name starts with `prefix`.
+  pub fn to_prometheus(&self, prefix: &str) -> String {
+    let mut out = String::new();
+
+    for (name, histogram) in [
+      ("decode_to_callback_seconds", &self.decode_to_callback),
+      ("callback_seconds", &self.callback),
+      ("queue_wait_seconds", &self.queue_wait),
+      ("registration_seconds", &self.registration),
+    ] {
+      histogram.write_prometheus(&mut out, &format!("{prefix}_{name}"));
+    }
+
+    let _ = writeln!(out, "# TYPE {prefix}_frames_total counter");
+    for (ty, count) in [
+      ("color", self.color_frames),
+      ("depth", self.depth_frames),
+      ("ir", self.ir_frames),
+    ] {
+      let _ = writeln!(out, "{prefix}_frames_total{{type=\"{ty}\"}} {count}");
+    }
+
+    let _ = writeln!(out, "# TYPE {prefix}_failed_total counter");
+    let _ = writeln!(out, "{prefix}_failed_total {}", self.failed);
+
+    let _ = writeln!(out, "# TYPE {prefix}_dropped_total counter");
+    for (reason, count) in &self.drops {
+      let _ = writeln!(
+        out,
+        "{prefix}_dropped_total{{reason=\"{}\"}} {count}",
+        reason.name()
+      );
+    }
+
+    out
+  }
+}
@@ -1,10 +1,30 @@
+pub mod async_frame_listener;
+pub mod capture;
+pub mod color_decoder;
 pub mod config;
+pub mod depth_codec;
+pub mod depth_post_processor;
+pub mod device_group;
 pub mod frame;
+pub mod frame_convert;
 pub mod frame_data;
 pub mod frame_data_iter;
 pub mod frame_listener;
+pub mod frame_pool;
+#[cfg(feature = "stream")]
+pub mod frame_stream;
+pub mod frame_synchronizer;
 pub mod frame_type;
 pub mod frame_value;
+pub mod frame_view;
 pub mod freenect2;
 pub mod freenect2_device;
+pub mod gpu_device;
+pub mod metrics;
+pub mod raw_packet;
 pub mod registration;
+pub mod registration_tables;
+pub mod replay_device;
+pub mod shared_memory;
+pub mod thread_policy;
+pub mod usb_transfers;
@@ -0,0 +1,67 @@
+//! Helpers for frames delivered as undecoded packets,
+//! see [`crate::freenect2::RawPackets`].
+//!
+//! Undecoded color frames hold the JPEG payload sent by the device,
+//! undecoded depth frames the raw depth packet. Both have the format
+//! [`FrameFormat::Raw`] and their size changes with every packet,
+//! the payload length is [`Freenect2Frame::raw_data_len`].
+
+use crate::frame::{FrameFormat, Freenect2Frame};
+
+/// The JPEG start of image marker.
+const JPEG_SOI: [u8; 2] = [0xFF, 0xD8];
+
+/// Check if `frame` is an undecoded packet.
+pub fn is_raw_packet<F: Freenect2Frame>(frame: &F) -> bool {
+  frame.format() == FrameFormat::Raw
+}
+
+/// Get the JPEG payload of an undecoded color frame,
+/// e.g. to store it without decoding it.
+///
+/// # Errors
+/// Returns an error if `frame` is not an undecoded color frame.
+pub fn jpeg_data<F: Freenect2Frame>(frame: &F) -> anyhow::Result<&[u8]> {
+  anyhow::ensure!(
+    is_raw_packet(frame),
+    "Expected an undecoded color frame, got a frame with format {:?}",
+    frame.format()
+  );
+
+  let data = frame.raw_data();
+  anyhow::ensure!(
+    data.starts_with(&JPEG_SOI),
+    "The frame does not contain JPEG data"
+  );
+
+  Ok(data)
+}
+
+#[cfg(feature = "image")]
+/// Decode the JPEG payload of an undecoded color frame.
+/// Only available when the `image` feature is enabled.
+///
+/// # Errors
+/// Returns an error if `frame` is not an undecoded color frame
+/// or its payload could not be decoded.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::frame::Freenect2Frame;
+/// use libfreenect2_rs::frame_listener::FrameListener;
+/// use libfreenect2_rs::frame_type::FrameType;
+/// use libfreenect2_rs::raw_packet::decode_color;
+///
+/// let listener = FrameListener::new(|ty, frame| {
+///   if ty == FrameType::Color && frame.sequence() % 30 == 0 {
+///     // Only decode a preview every 30 frames
+///     let image = decode_color(&frame)?;
+///     println!("Decoded {}x{} color frame", image.width(), image.height());
+///   }
+///
+///   Ok(())
+/// }).unwrap();
+/// ```
+pub fn decode_color<F: Freenect2Frame>(frame: &F) -> anyhow::Result<image::RgbImage> {
+  Ok(image::load_from_memory_with_format(jpeg_data(frame)?, image::ImageFormat::Jpeg)?.into_rgb8())
+}
@@ -1,6 +1,22 @@
 use crate::ffi::libfreenect2;
 use crate::frame::{AsFrame, Frame, FrameFormat, Freenect2Frame};
+use crate::frame_view::Region;
+use crate::metrics::Metrics;
+use crate::registration_tables::RegistrationTables;
 use cxx::UniquePtr;
+use std::time::Instant;
+
+pub use crate::ffi::libfreenect2::RegistrationEngine;
+
+/// The maximum number of points of a point cloud,
+/// one per pixel of an undistorted depth frame.
+pub const MAX_POINTS: usize = 512 * 424;
+
+impl Default for RegistrationEngine {
+  fn default() -> Self {
+    RegistrationEngine::Libfreenect2
+  }
+}
 
 macro_rules! ensure_frame {
   ($val: ident, $($format: ident)|+, $width: expr, $height: expr) => {
@@ -33,12 +49,77 @@ macro_rules! ensure_frame {
 }
 
 /// A registration object that can be used to map depth frames to color frames.
-/// Can be created by calling [`crate::freenect2_device::Freenect2Device::get_registration`].
-pub struct Registration(UniquePtr<libfreenect2::Registration>);
+/// Can be created by calling [`crate::freenect2_device::Freenect2Device::get_registration`]
+/// or [`crate::freenect2_device::Freenect2Device::get_registration_with_engine`].
+pub struct Registration(UniquePtr<libfreenect2::Registration>, Option<Metrics>);
 
 impl Registration {
   pub(crate) fn new(inner: UniquePtr<libfreenect2::Registration>) -> Self {
-    Self(inner)
+    Self(inner, None)
+  }
+
+  /// Create a registration using precomputed [`RegistrationTables`],
+  /// without a device.
+  /// [`RegistrationEngine::Parallel`] uses the tables directly, so any number
+  /// of registrations can share the same tables. [`RegistrationEngine::Libfreenect2`]
+  /// computes its own tables from the camera parameters stored in `tables`.
+  ///
+  /// # Arguments
+  /// * `tables` - The tables of the device the frames were captured with.
+  /// * `engine` - The engine used to map depth frames to color frames.
+  /// * `threads` - The number of threads used by [`RegistrationEngine::Parallel`],
+  ///    including the calling thread. If 0, the number of hardware threads is used.
+  ///    Ignored by [`RegistrationEngine::Libfreenect2`].
+  ///
+  /// # Errors
+  /// Returns an error if the registration could not be created.
+  pub fn from_tables(
+    tables: &RegistrationTables,
+    engine: RegistrationEngine,
+    threads: usize,
+  ) -> anyhow::Result<Self> {
+    Ok(Self::new(libfreenect2::create_registration_from_tables(
+      tables.inner(),
+      engine,
+      threads as u64,
+    )?))
+  }
+
+  /// Record the duration of [`Self::map_depth_to_color`], [`Self::map_depth_to_color_region`],
+  /// [`Self::map_depth_to_full_color`] and [`Self::undistort_depth`] into `metrics`, or stop recording if [`None`].
+  /// Registrations created by a device with metrics enabled record into the device metrics.
+  pub fn set_metrics(&mut self, metrics: Option<Metrics>) {
+    self.1 = metrics;
+  }
+
+  fn timed<R>(&self, f: impl FnOnce() -> R) -> R {
+    match &self.1 {
+      Some(metrics) => {
+        let start = Instant::now();
+        let res = f();
+        metrics.record_registration(start.elapsed());
+        res
+      }
+      None => f(),
+    }
+  }
+
+  /// Create a [`RegistrationContext`] which owns the output frames
+  /// of the registration and reuses them for every processed frame.
+  ///
+  /// # Arguments
+  /// * `full_color` - Whether to also map the depth frame onto the full color frame.
+  ///    If true, [`RegistrationContext::process`] calls [`Self::map_depth_to_full_color`],
+  ///    otherwise [`Self::map_depth_to_color`].
+  /// * `enable_filter` - Whether to filter out pixels not visible to both cameras.
+  pub fn create_context(&self, full_color: bool, enable_filter: bool) -> RegistrationContext<'_> {
+    RegistrationContext {
+      registration: self,
+      undistorted_depth: Frame::depth(),
+      color_depth_image: Frame::color_for_depth(),
+      big_depth: full_color.then(Frame::depth_full_color),
+      enable_filter,
+    }
   }
 
   /// Maps a depth frame to a color frame.
@@ -114,7 +195,7 @@ impl Registration {
     ensure_frame!(undistorted_depth, Float, 512, 424);
     ensure_frame!(color_depth_image, RGBX | BGRX, 512, 424);
 
-    unsafe {
+    self.timed(|| unsafe {
       self
         .0
         .map_depth_to_color(
@@ -125,7 +206,114 @@ impl Registration {
           enable_filter,
         )
         .map_err(Into::into)
-    }
+    })
+  }
+
+  /// Maps the pixels within `region` of a depth frame to a color frame.
+  /// Same as [`Self::map_depth_to_color`], but only the pixels within `region`
+  /// of `undistorted_depth` and `color_depth_image` are guaranteed to be written,
+  /// which are equal to the result of [`Self::map_depth_to_color`].
+  /// Use [`Freenect2Frame::view`] to access the region of the output frames.
+  ///
+  /// [`RegistrationEngine::Parallel`] only computes the pixels within the region.
+  /// If `enable_filter` is true, the whole depth frame is still undistorted,
+  /// since pixels outside the region may occlude pixels within it, but the
+  /// filter only covers the color pixels the region maps to.
+  /// [`RegistrationEngine::Libfreenect2`] always computes the whole frames.
+  ///
+  /// # Arguments
+  /// * `depth` - The depth frame to map.
+  ///    Must be of format [`FrameFormat::Float`] and have a resolution of 512x424.
+  /// * `color` - The color frame to map to.
+  ///    Must be of format [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] and have a resolution of 1920x1080.
+  /// * `undistorted_depth` - The resulting undistorted depth frame.
+  ///    Must be of format [`FrameFormat::Float`] and have a resolution of 512x424.
+  /// * `color_depth_image` - The resulting color depth image frame.
+  ///    Must be of format [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] and have a resolution of 512x424.
+  /// * `enable_filter` - Whether to filter out pixels not visible to both cameras.
+  /// * `region` - The region of the depth frame to map.
+  ///
+  /// # Errors
+  /// Returns an error if the frames have invalid formats or resolutions
+  /// or if the region is empty or not within the depth frame.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::frame::{Frame, Freenect2Frame};
+  /// use libfreenect2_rs::frame_listener::SharedFramesMultiFrameListener;
+  /// use libfreenect2_rs::frame_type::FrameType;
+  /// use libfreenect2_rs::frame_view::Region;
+  /// use libfreenect2_rs::freenect2::Freenect2;
+  /// use libfreenect2_rs::registration::RegistrationEngine;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  /// let frame_listener = SharedFramesMultiFrameListener::new(&[
+  ///   FrameType::Color, FrameType::Depth
+  /// ]).unwrap();
+  /// let mut device = freenect2.open_default_device().unwrap();
+  ///
+  /// device.set_color_frame_listener(&frame_listener).unwrap();
+  /// device.set_ir_and_depth_frame_listener(&frame_listener).unwrap();
+  ///
+  /// device.start().unwrap();
+  /// let registration = device.get_registration_with_engine(RegistrationEngine::Parallel, 0).unwrap();
+  ///
+  /// let frames = frame_listener.get_frames().unwrap();
+  /// let region = Region::new(128, 112, 256, 200);
+  ///
+  /// let mut undistorted_depth = Frame::depth();
+  /// let mut color_image = Frame::color_for_depth();
+  ///
+  /// registration.map_depth_to_color_region(
+  ///   frames.expect_depth().unwrap(),
+  ///   frames.expect_color().unwrap(),
+  ///   &mut undistorted_depth,
+  ///   &mut color_image,
+  ///   true,
+  ///   region,
+  /// ).unwrap();
+  ///
+  /// let crop = color_image.view(region).unwrap();
+  /// // Do something with the cropped registered image
+  /// ```
+  pub fn map_depth_to_color_region<
+    'a,
+    'b: 'a,
+    'c,
+    'd: 'c,
+    F1: AsFrame<'a, 'b>,
+    F2: AsFrame<'c, 'd>,
+  >(
+    &self,
+    depth: &'a F1,
+    color: &'c F2,
+    undistorted_depth: &mut Frame,
+    color_depth_image: &mut Frame,
+    enable_filter: bool,
+    region: Region,
+  ) -> anyhow::Result<()> {
+    let depth = depth.as_frame();
+    let color = color.as_frame();
+
+    ensure_frame!(depth, Float, 512, 424);
+    ensure_frame!(color, RGBX | BGRX, 1920, 1080);
+    ensure_frame!(undistorted_depth, Float, 512, 424);
+    ensure_frame!(color_depth_image, RGBX | BGRX, 512, 424);
+    region.ensure_within(512, 424)?;
+
+    self.timed(|| unsafe {
+      self
+        .0
+        .map_depth_to_color_region(
+          &depth.inner,
+          &color.inner,
+          undistorted_depth.inner.pin_mut(),
+          color_depth_image.inner.pin_mut(),
+          enable_filter,
+          &region,
+        )
+        .map_err(Into::into)
+    })
   }
 
   /// Map a depth frame onto a color frame.
@@ -176,7 +364,7 @@ impl Registration {
     ensure_frame!(color_depth_image, RGBX | BGRX, 512, 424);
     ensure_frame!(big_depth, Float, 1920, 1082);
 
-    unsafe {
+    self.timed(|| unsafe {
       self
         .0
         .map_depth_to_full_color(
@@ -188,7 +376,7 @@ impl Registration {
           big_depth.inner.pin_mut(),
         )
         .map_err(Into::into)
-    }
+    })
   }
 
   /// Un-distort a depth frame.
@@ -212,14 +400,489 @@ impl Registration {
     ensure_frame!(depth, Float, 512, 424);
     ensure_frame!(undistorted_depth, Float, 512, 424);
 
-    unsafe {
+    self.timed(|| unsafe {
       self
         .0
         .undistort_depth(&depth.inner, undistorted_depth.inner.pin_mut())
         .map_err(Into::into)
+    })
+  }
+
+  /// Convert an undistorted depth frame into a point cloud.
+  /// The points are written to `points` as interleaved `x, y, z` values in meters,
+  /// in the camera space of the depth camera. Equivalent to calling
+  /// `libfreenect2::Registration::getPointXYZ` for every pixel,
+  /// up to float rounding.
+  ///
+  /// # Arguments
+  /// * `undistorted_depth` - The undistorted depth frame.
+  ///    Must be of format [`FrameFormat::Float`] and have a resolution of 512x424.
+  ///    Can be created using [`Self::undistort_depth`] or [`Self::map_depth_to_color`].
+  /// * `points` - The buffer to write the points to.
+  ///    Must hold at least `3 * MAX_POINTS` values.
+  /// * `skip_invalid` - Whether to skip pixels without a valid depth.
+  ///    If false, invalid pixels are written as `NaN` and
+  ///    the point of a pixel is always at index `3 * (y * 512 + x)`.
+  ///
+  /// # Returns
+  /// The number of points written to `points`.
+  ///
+  /// # Errors
+  /// Returns an error if the frame has an invalid format or resolution
+  /// or if the buffer is too small.
+  pub fn get_points_xyz<'a, 'b: 'a, F: AsFrame<'a, 'b>>(
+    &self,
+    undistorted_depth: &'a F,
+    points: &mut [f32],
+    skip_invalid: bool,
+  ) -> anyhow::Result<usize> {
+    let undistorted_depth = undistorted_depth.as_frame();
+
+    ensure_frame!(undistorted_depth, Float, 512, 424);
+    anyhow::ensure!(
+      points.len() >= 3 * MAX_POINTS,
+      "The point buffer must hold at least {} values, got {}",
+      3 * MAX_POINTS,
+      points.len()
+    );
+
+    unsafe {
+      self
+        .0
+        .get_points_xyz(&undistorted_depth.inner, points, skip_invalid)
+        .map(|count| count as usize)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Convert an undistorted depth frame and the matching registered
+  /// color frame into a colored point cloud.
+  /// The points are written to `points` as interleaved `x, y, z, rgb` values.
+  /// `x`, `y` and `z` are in meters, `rgb` holds the four bytes of the
+  /// registered pixel reinterpreted as a float, use [`f32::to_bits`] to get them back.
+  /// Equivalent to calling `libfreenect2::Registration::getPointXYZRGB`
+  /// for every pixel, up to float rounding.
+  ///
+  /// # Arguments
+  /// * `undistorted_depth` - The undistorted depth frame.
+  ///    Must be of format [`FrameFormat::Float`] and have a resolution of 512x424.
+  /// * `color_depth_image` - The registered color frame.
+  ///    Must be of format [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] and have a resolution of 512x424.
+  /// * `points` - The buffer to write the points to.
+  ///    Must hold at least `4 * MAX_POINTS` values.
+  /// * `skip_invalid` - Whether to skip pixels without a valid depth.
+  ///    If false, invalid pixels are written as `NaN` with a color of zero and
+  ///    the point of a pixel is always at index `4 * (y * 512 + x)`.
+  ///
+  /// # Returns
+  /// The number of points written to `points`.
+  ///
+  /// # Errors
+  /// Returns an error if the frames have invalid formats or resolutions
+  /// or if the buffer is too small.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::frame_listener::SharedFramesMultiFrameListener;
+  /// use libfreenect2_rs::frame_type::FrameType;
+  /// use libfreenect2_rs::freenect2::Freenect2;
+  /// use libfreenect2_rs::registration::MAX_POINTS;
+  ///
+  /// let mut freenect2 = Freenect2::new().unwrap();
+  /// let frame_listener = SharedFramesMultiFrameListener::new(&[
+  ///   FrameType::Color, FrameType::Depth
+  /// ]).unwrap();
+  /// let mut device = freenect2.open_default_device().unwrap();
+  ///
+  /// device.set_color_frame_listener(&frame_listener).unwrap();
+  /// device.set_ir_and_depth_frame_listener(&frame_listener).unwrap();
+  ///
+  /// device.start().unwrap();
+  /// let registration = device.get_registration().unwrap();
+  /// let mut context = registration.create_context(false, true);
+  /// let mut points = vec![0.0; 4 * MAX_POINTS];
+  ///
+  /// let frames = frame_listener.get_frames().unwrap();
+  /// context.process(frames.expect_depth().unwrap(), frames.expect_color().unwrap()).unwrap();
+  ///
+  /// let count = context.get_points_xyzrgb(&mut points, true).unwrap();
+  /// for point in points[..4 * count].chunks_exact(4) {
+  ///   // The byte order depends on the format of the color frame
+  ///   let color = point[3].to_bits().to_ne_bytes();
+  ///   // Do something with the point
+  /// }
+  /// ```
+  pub fn get_points_xyzrgb<'a, 'b: 'a, 'c, 'd: 'c, F1: AsFrame<'a, 'b>, F2: AsFrame<'c, 'd>>(
+    &self,
+    undistorted_depth: &'a F1,
+    color_depth_image: &'c F2,
+    points: &mut [f32],
+    skip_invalid: bool,
+  ) -> anyhow::Result<usize> {
+    let undistorted_depth = undistorted_depth.as_frame();
+    let color_depth_image = color_depth_image.as_frame();
+
+    ensure_frame!(undistorted_depth, Float, 512, 424);
+    ensure_frame!(color_depth_image, RGBX | BGRX, 512, 424);
+    anyhow::ensure!(
+      points.len() >= 4 * MAX_POINTS,
+      "The point buffer must hold at least {} values, got {}",
+      4 * MAX_POINTS,
+      points.len()
+    );
+
+    unsafe {
+      self
+        .0
+        .get_points_xyzrgb(
+          &undistorted_depth.inner,
+          &color_depth_image.inner,
+          points,
+          skip_invalid,
+        )
+        .map(|count| count as usize)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Convert the pixels within `region` of an undistorted depth frame into a point cloud.
+  /// Same as [`Self::get_points_xyz`], but only the pixels within `region` are converted,
+  /// in row-major order of the region.
+  ///
+  /// # Arguments
+  /// * `undistorted_depth` - The undistorted depth frame.
+  ///    Must be of format [`FrameFormat::Float`] and have a resolution of 512x424.
+  /// * `region` - The region of the frame to convert.
+  /// * `points` - The buffer to write the points to.
+  ///    Must hold at least `3 * region.width * region.height` values.
+  /// * `skip_invalid` - Whether to skip pixels without a valid depth.
+  ///    If false, the point of a pixel is always at index
+  ///    `3 * ((y - region.y) * region.width + x - region.x)`.
+  ///
+  /// # Returns
+  /// The number of points written to `points`.
+  ///
+  /// # Errors
+  /// Returns an error if the frame has an invalid format or resolution,
+  /// if the region is empty or not within the frame or if the buffer is too small.
+  pub fn get_points_xyz_region<'a, 'b: 'a, F: AsFrame<'a, 'b>>(
+    &self,
+    undistorted_depth: &'a F,
+    region: Region,
+    points: &mut [f32],
+    skip_invalid: bool,
+  ) -> anyhow::Result<usize> {
+    let undistorted_depth = undistorted_depth.as_frame();
+
+    ensure_frame!(undistorted_depth, Float, 512, 424);
+    ensure_region_points(region, points, 3)?;
+
+    unsafe {
+      self
+        .0
+        .get_points_xyz_region(&undistorted_depth.inner, &region, points, skip_invalid)
+        .map(|count| count as usize)
+        .map_err(Into::into)
+    }
+  }
+
+  /// Convert the pixels within `region` of an undistorted depth frame and the
+  /// matching registered color frame into a colored point cloud.
+  /// Same as [`Self::get_points_xyzrgb`], but only the pixels within `region` are converted,
+  /// in row-major order of the region. Can be combined with
+  /// [`Self::map_depth_to_color_region`] to only compute the points of a region.
+  ///
+  /// # Arguments
+  /// * `undistorted_depth` - The undistorted depth frame.
+  ///    Must be of format [`FrameFormat::Float`] and have a resolution of 512x424.
+  /// * `color_depth_image` - The registered color frame.
+  ///    Must be of format [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] and have a resolution of 512x424.
+  /// * `region` - The region of the frames to convert.
+  /// * `points` - The buffer to write the points to.
+  ///    Must hold at least `4 * region.width * region.height` values.
+  /// * `skip_invalid` - Whether to skip pixels without a valid depth.
+  ///    If false, the point of a pixel is always at index
+  ///    `4 * ((y - region.y) * region.width + x - region.x)`.
+  ///
+  /// # Returns
+  /// The number of points written to `points`.
+  ///
+  /// # Errors
+  /// Returns an error if the frames have invalid formats or resolutions,
+  /// if the region is empty or not within the frames or if the buffer is too small.
+  pub fn get_points_xyzrgb_region<
+    'a,
+    'b: 'a,
+    'c,
+    'd: 'c,
+    F1: AsFrame<'a, 'b>,
+    F2: AsFrame<'c, 'd>,
+  >(
+    &self,
+    undistorted_depth: &'a F1,
+    color_depth_image: &'c F2,
+    region: Region,
+    points: &mut [f32],
+    skip_invalid: bool,
+  ) -> anyhow::Result<usize> {
+    let undistorted_depth = undistorted_depth.as_frame();
+    let color_depth_image = color_depth_image.as_frame();
+
+    ensure_frame!(undistorted_depth, Float, 512, 424);
+    ensure_frame!(color_depth_image, RGBX | BGRX, 512, 424);
+    ensure_region_points(region, points, 4)?;
+
+    unsafe {
+      self
+        .0
+        .get_points_xyzrgb_region(
+          &undistorted_depth.inner,
+          &color_depth_image.inner,
+          &region,
+          points,
+          skip_invalid,
+        )
+        .map(|count| count as usize)
+        .map_err(Into::into)
     }
   }
 }
 
+fn ensure_region_points(region: Region, points: &[f32], stride: usize) -> anyhow::Result<()> {
+  region.ensure_within(512, 424)?;
+
+  let required = stride * region.width as usize * region.height as usize;
+  anyhow::ensure!(
+    points.len() >= required,
+    "The point buffer must hold at least {} values, got {}",
+    required,
+    points.len()
+  );
+
+  Ok(())
+}
+
 unsafe impl Send for Registration {}
 unsafe impl Sync for Registration {}
+
+/// A registration context which owns the output frames of a [`Registration`].
+/// The output frames are allocated once when the context is created
+/// and filled in place by every call to [`Self::process`].
+/// Can be created using [`Registration::create_context`].
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::frame::SharedFrame;
+/// use libfreenect2_rs::frame_listener::SharedFramesMultiFrameListener;
+/// use libfreenect2_rs::frame_type::FrameType;
+/// use libfreenect2_rs::freenect2::Freenect2;
+///
+/// let mut freenect2 = Freenect2::new().unwrap();
+/// let frame_listener = SharedFramesMultiFrameListener::new(&[
+///   FrameType::Color, FrameType::Depth
+/// ]).unwrap();
+/// let mut device = freenect2.open_default_device().unwrap();
+///
+/// device.set_color_frame_listener(&frame_listener).unwrap();
+/// device.set_ir_and_depth_frame_listener(&frame_listener).unwrap();
+///
+/// device.start().unwrap();
+/// let registration = device.get_registration().unwrap();
+/// let mut context = registration.create_context(true, true);
+///
+/// loop {
+///   let frames = frame_listener.get_frames().unwrap();
+///   context.process(frames.expect_depth().unwrap(), frames.expect_color().unwrap()).unwrap();
+///
+///   let big_depth = context.big_depth().unwrap();
+///   // Do something with the registered frames
+/// }
+/// ```
+pub struct RegistrationContext<'r> {
+  registration: &'r Registration,
+  undistorted_depth: Frame<'static>,
+  color_depth_image: Frame<'static>,
+  big_depth: Option<Frame<'static>>,
+  enable_filter: bool,
+}
+
+impl RegistrationContext<'_> {
+  /// Map a depth frame to a color frame.
+  /// The results are written into the output frames of this context,
+  /// which can be accessed using [`Self::undistorted_depth`],
+  /// [`Self::color_depth_image`] and [`Self::big_depth`].
+  ///
+  /// # Arguments
+  /// * `depth` - The depth frame to map.
+  ///    Must be of format [`FrameFormat::Float`] and have a resolution of 512x424.
+  /// * `color` - The color frame to map to.
+  ///    Must be of format [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] and have a resolution of 1920x1080.
+  ///
+  /// # Errors
+  /// Returns an error if the frames have invalid formats or resolutions.
+  pub fn process<'a, 'b: 'a, 'c, 'd: 'c, F1: AsFrame<'a, 'b>, F2: AsFrame<'c, 'd>>(
+    &mut self,
+    depth: &'a F1,
+    color: &'c F2,
+  ) -> anyhow::Result<()> {
+    match &mut self.big_depth {
+      Some(big_depth) => self.registration.map_depth_to_full_color(
+        depth,
+        color,
+        &mut self.undistorted_depth,
+        &mut self.color_depth_image,
+        self.enable_filter,
+        big_depth,
+      ),
+      None => self.registration.map_depth_to_color(
+        depth,
+        color,
+        &mut self.undistorted_depth,
+        &mut self.color_depth_image,
+        self.enable_filter,
+      ),
+    }
+  }
+
+  /// Map the pixels within `region` of a depth frame to a color frame.
+  /// See [`Registration::map_depth_to_color_region`]. Only the pixels within
+  /// `region` of [`Self::undistorted_depth`] and [`Self::color_depth_image`]
+  /// are guaranteed to be updated.
+  ///
+  /// # Errors
+  /// Returns an error if the context was created with `full_color` set to true,
+  /// if the frames have invalid formats or resolutions or if the region is
+  /// empty or not within the depth frame.
+  pub fn process_region<'a, 'b: 'a, 'c, 'd: 'c, F1: AsFrame<'a, 'b>, F2: AsFrame<'c, 'd>>(
+    &mut self,
+    depth: &'a F1,
+    color: &'c F2,
+    region: Region,
+  ) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      self.big_depth.is_none(),
+      "Regions can't be mapped onto the full color frame"
+    );
+
+    self.registration.map_depth_to_color_region(
+      depth,
+      color,
+      &mut self.undistorted_depth,
+      &mut self.color_depth_image,
+      self.enable_filter,
+      region,
+    )
+  }
+
+  /// Map a batch of depth and color frames.
+  /// Every pair is processed using [`Self::process`] and `f` is called
+  /// with the index of the pair and this context once the pair has been processed.
+  /// The output frames are overwritten by the next pair,
+  /// so `f` must copy anything it wants to keep.
+  ///
+  /// # Arguments
+  /// * `frames` - The depth and color frame pairs to map.
+  /// * `f` - The closure to call for every processed pair.
+  ///
+  /// # Errors
+  /// Returns the first error returned by [`Self::process`] or `f`.
+  /// The remaining pairs are not processed in that case.
+  pub fn process_batch<'a, 'b: 'a, 'c, 'd: 'c, F1, F2, I, F>(
+    &mut self,
+    frames: I,
+    mut f: F,
+  ) -> anyhow::Result<()>
+  where
+    F1: AsFrame<'a, 'b> + 'a,
+    F2: AsFrame<'c, 'd> + 'c,
+    I: IntoIterator<Item = (&'a F1, &'c F2)>,
+    F: FnMut(usize, &Self) -> anyhow::Result<()>,
+  {
+    for (i, (depth, color)) in frames.into_iter().enumerate() {
+      self.process(depth, color)?;
+      f(i, self)?;
+    }
+
+    Ok(())
+  }
+
+  /// Convert the last processed frame into a point cloud.
+  /// See [`Registration::get_points_xyz`].
+  ///
+  /// # Errors
+  /// Returns an error if the buffer is too small.
+  pub fn get_points_xyz(&self, points: &mut [f32], skip_invalid: bool) -> anyhow::Result<usize> {
+    self
+      .registration
+      .get_points_xyz(&self.undistorted_depth, points, skip_invalid)
+  }
+
+  /// Convert the last processed frame into a colored point cloud.
+  /// See [`Registration::get_points_xyzrgb`].
+  ///
+  /// # Errors
+  /// Returns an error if the buffer is too small.
+  pub fn get_points_xyzrgb(&self, points: &mut [f32], skip_invalid: bool) -> anyhow::Result<usize> {
+    self.registration.get_points_xyzrgb(
+      &self.undistorted_depth,
+      &self.color_depth_image,
+      points,
+      skip_invalid,
+    )
+  }
+
+  /// Convert the pixels within `region` of the last processed frame into a point cloud.
+  /// See [`Registration::get_points_xyz_region`].
+  ///
+  /// # Errors
+  /// Returns an error if the region is not within the frame or the buffer is too small.
+  pub fn get_points_xyz_region(
+    &self,
+    region: Region,
+    points: &mut [f32],
+    skip_invalid: bool,
+  ) -> anyhow::Result<usize> {
+    self
+      .registration
+      .get_points_xyz_region(&self.undistorted_depth, region, points, skip_invalid)
+  }
+
+  /// Convert the pixels within `region` of the last processed frame into a colored point cloud.
+  /// See [`Registration::get_points_xyzrgb_region`].
+  ///
+  /// # Errors
+  /// Returns an error if the region is not within the frame or the buffer is too small.
+  pub fn get_points_xyzrgb_region(
+    &self,
+    region: Region,
+    points: &mut [f32],
+    skip_invalid: bool,
+  ) -> anyhow::Result<usize> {
+    self.registration.get_points_xyzrgb_region(
+      &self.undistorted_depth,
+      &self.color_depth_image,
+      region,
+      points,
+      skip_invalid,
+    )
+  }
+
+  /// The undistorted depth frame of the last processed frame.
+  /// Has format [`FrameFormat::Float`] and a resolution of 512x424.
+  pub fn undistorted_depth(&self) -> &Frame<'static> {
+    &self.undistorted_depth
+  }
+
+  /// The color image mapped onto the depth frame of the last processed frame.
+  /// Has format [`FrameFormat::RGBX`] or [`FrameFormat::BGRX`] and a resolution of 512x424.
+  pub fn color_depth_image(&self) -> &Frame<'static> {
+    &self.color_depth_image
+  }
+
+  /// The depth image mapped onto the color frame of the last processed frame.
+  /// Has format [`FrameFormat::Float`] and a resolution of 1920x1082.
+  /// Only available if the context was created with `full_color` set to true.
+  pub fn big_depth(&self) -> Option<&Frame<'static>> {
+    self.big_depth.as_ref()
+  }
+}
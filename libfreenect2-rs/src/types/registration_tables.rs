@@ -0,0 +1,200 @@
+//! The lookup tables used to map depth frames to color frames.
+//!
+//! Computing the tables from the camera parameters of a device takes
+//! about ten times as long as loading them, so they can be serialized
+//! and cached on disk, keyed by the serial number of the device, using
+//! a [`RegistrationCache`]. Since the tables only depend on the camera
+//! parameters, they can also be created without a device, for example
+//! to register frames of a recording.
+
+use crate::ffi;
+use crate::registration::{Registration, RegistrationEngine};
+use cxx::SharedPtr;
+use std::fs;
+use std::io::ErrorKind;
+use std::path::{Path, PathBuf};
+
+pub use crate::ffi::libfreenect2::{CameraParams, ColorCameraParams, IrCameraParams};
+
+/// The file extension of the files stored by a [`RegistrationCache`].
+pub const CACHE_FILE_EXTENSION: &str = "lf2reg";
+
+/// The immutable lookup tables of a registration.
+/// Cloning the tables is cheap, as all clones share the same tables,
+/// which can be used by any number of registrations on any number of threads.
+#[derive(Clone)]
+pub struct RegistrationTables(SharedPtr<ffi::libfreenect2::RegistrationTables>);
+
+unsafe impl Send for RegistrationTables {}
+unsafe impl Sync for RegistrationTables {}
+
+impl RegistrationTables {
+  /// Compute the tables from the camera parameters of a device.
+  ///
+  /// # Arguments
+  /// * `params` - The camera parameters, as returned by
+  ///    [`crate::freenect2_device::Freenect2Device::get_camera_params`].
+  ///
+  /// # Errors
+  /// Returns an error if the tables could not be created.
+  pub fn new(params: &CameraParams) -> anyhow::Result<Self> {
+    Ok(Self(ffi::libfreenect2::create_registration_tables(params)?))
+  }
+
+  /// Read tables serialized using [`Self::to_bytes`].
+  ///
+  /// # Errors
+  /// Returns an error if `data` is not a serialized registration,
+  /// was written by an incompatible version or on a machine with
+  /// a different byte order, or is corrupted.
+  pub fn from_bytes(data: &[u8]) -> anyhow::Result<Self> {
+    Ok(Self(ffi::libfreenect2::deserialize_registration_tables(
+      data,
+    )?))
+  }
+
+  /// Serialize the tables.
+  /// The serialized tables use the native byte order.
+  pub fn to_bytes(&self) -> Vec<u8> {
+    let mut data = vec![0; self.0.serialized_size() as usize];
+    self
+      .0
+      .serialize(&mut data)
+      .expect("The buffer has the serialized size");
+
+    data
+  }
+
+  /// Read tables from a file written by [`Self::save`].
+  ///
+  /// # Errors
+  /// Returns an error if the file could not be read or is invalid,
+  /// see [`Self::from_bytes`].
+  pub fn load<P: AsRef<Path>>(path: P) -> anyhow::Result<Self> {
+    Self::from_bytes(&fs::read(path)?)
+  }
+
+  /// Write the tables to a file.
+  /// The tables are written to a temporary file first, which then
+  /// replaces `path`, so other processes never read a partial file.
+  ///
+  /// # Errors
+  /// Returns an error if the file could not be written.
+  pub fn save<P: AsRef<Path>>(&self, path: P) -> anyhow::Result<()> {
+    let path = path.as_ref();
+    let mut tmp = path.as_os_str().to_owned();
+    tmp.push(format!(".{}.tmp", std::process::id()));
+
+    fs::write(&tmp, self.to_bytes())?;
+    fs::rename(&tmp, path).map_err(|e| {
+      let _ = fs::remove_file(&tmp);
+      anyhow::Error::from(e)
+    })
+  }
+
+  /// Get the camera parameters the tables were computed from.
+  pub fn camera_params(&self) -> CameraParams {
+    self.0.camera_params()
+  }
+
+  /// Create a registration using these tables.
+  /// See [`Registration::from_tables`].
+  pub fn create_registration(
+    &self,
+    engine: RegistrationEngine,
+    threads: usize,
+  ) -> anyhow::Result<Registration> {
+    Registration::from_tables(self, engine, threads)
+  }
+
+  pub(crate) fn inner(&self) -> &SharedPtr<ffi::libfreenect2::RegistrationTables> {
+    &self.0
+  }
+}
+
+/// A directory containing serialized [`RegistrationTables`],
+/// one file per device, named after the serial number of the device.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::freenect2::Freenect2;
+/// use libfreenect2_rs::registration::RegistrationEngine;
+/// use libfreenect2_rs::registration_tables::RegistrationCache;
+///
+/// let cache = RegistrationCache::new(std::env::temp_dir().join("libfreenect2-rs"));
+///
+/// let mut freenect2 = Freenect2::new().unwrap();
+/// let mut device = freenect2.open_default_device().unwrap();
+///
+/// device.start().unwrap();
+/// let tables = device.get_registration_tables(Some(&cache)).unwrap();
+/// let registration = tables
+///   .create_registration(RegistrationEngine::Parallel, 0)
+///   .unwrap();
+/// ```
+#[derive(Debug, Clone, PartialEq)]
+pub struct RegistrationCache {
+  dir: PathBuf,
+}
+
+impl RegistrationCache {
+  /// Create a cache in `dir`.
+  /// The directory is created when the first tables are stored.
+  pub fn new<P: Into<PathBuf>>(dir: P) -> Self {
+    Self { dir: dir.into() }
+  }
+
+  /// Get the directory of the cache.
+  pub fn dir(&self) -> &Path {
+    &self.dir
+  }
+
+  /// Get the path of the file storing the tables of a device.
+  ///
+  /// # Errors
+  /// Returns an error if `serial` is empty or contains characters
+  /// other than ASCII letters, digits, `-` and `_`.
+  pub fn path(&self, serial: &str) -> anyhow::Result<PathBuf> {
+    anyhow::ensure!(
+      !serial.is_empty()
+        && serial
+          .chars()
+          .all(|c| c.is_ascii_alphanumeric() || c == '-' || c == '_'),
+      "Invalid device serial number: {:?}",
+      serial
+    );
+
+    Ok(
+      self
+        .dir
+        .join(format!("{}.{}", serial, CACHE_FILE_EXTENSION)),
+    )
+  }
+
+  /// Load the tables of a device.
+  ///
+  /// # Returns
+  /// The tables, or [`None`] if no tables are stored for the device.
+  ///
+  /// # Errors
+  /// Returns an error if the serial number is invalid, or if the
+  /// stored tables could not be read or are invalid.
+  pub fn load(&self, serial: &str) -> anyhow::Result<Option<RegistrationTables>> {
+    match fs::read(self.path(serial)?) {
+      Ok(data) => RegistrationTables::from_bytes(&data).map(Some),
+      Err(e) if e.kind() == ErrorKind::NotFound => Ok(None),
+      Err(e) => Err(e.into()),
+    }
+  }
+
+  /// Store the tables of a device, replacing any previously stored tables.
+  ///
+  /// # Errors
+  /// Returns an error if the serial number is invalid,
+  /// or if the tables could not be written.
+  pub fn store(&self, serial: &str, tables: &RegistrationTables) -> anyhow::Result<()> {
+    let path = self.path(serial)?;
+    fs::create_dir_all(&self.dir)?;
+    tables.save(path)
+  }
+}
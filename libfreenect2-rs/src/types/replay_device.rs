@@ -0,0 +1,610 @@
+use crate::ffi;
+use crate::frame::{packed_data, Freenect2Frame, OwnedFrame};
+use crate::frame_listener::AsFrameListener;
+use crate::types::frame_type::FrameType;
+use std::marker::PhantomData;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+
+/// The duration of one timestamp tick, see [`Freenect2Frame::timestamp`].
+const TICK_SECONDS: f64 = 0.000125;
+
+/// A source of recorded frames for a [`ReplayDevice`].
+pub trait ReplaySource: Send {
+  /// Get the next frame of the recording, or [`None`] at its end.
+  ///
+  /// # Errors
+  /// Returns an error if the frame could not be read.
+  /// The replay stops at the first error.
+  fn next_frame(&mut self) -> anyhow::Result<Option<(FrameType, &dyn Freenect2Frame)>>;
+
+  /// Move back to the first frame of the recording.
+  ///
+  /// # Errors
+  /// Returns an error if the source can not be rewound.
+  fn rewind(&mut self) -> anyhow::Result<()>;
+}
+
+/// Frames recorded in memory, e.g. by calling [`crate::frame::Frame::to_owned`]
+/// in a frame listener. Frames are replayed in the order they were added.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::frame::OwnedFrame;
+/// use libfreenect2_rs::frame_listener::FrameListener;
+/// use libfreenect2_rs::replay_device::FrameRecording;
+/// use std::sync::{Arc, Mutex};
+///
+/// let recording = Arc::new(Mutex::new(FrameRecording::<OwnedFrame>::default()));
+/// let listener = FrameListener::new({
+///   let recording = recording.clone();
+///   move |ty, frame| {
+///     recording.lock().unwrap().push(ty, frame.to_owned());
+///     Ok(())
+///   }
+/// }).unwrap();
+///
+/// /// Set the listener, start the device and stop it once enough frames were recorded
+/// ```
+pub struct FrameRecording<T: Freenect2Frame + Send> {
+  frames: Vec<(FrameType, T)>,
+  position: usize,
+}
+
+impl<T: Freenect2Frame + Send> FrameRecording<T> {
+  /// Create a recording from a list of frames.
+  pub fn new(frames: Vec<(FrameType, T)>) -> Self {
+    Self {
+      frames,
+      position: 0,
+    }
+  }
+
+  /// Add a frame to the end of the recording.
+  pub fn push(&mut self, ty: FrameType, frame: T) {
+    self.frames.push((ty, frame));
+  }
+
+  /// Get the number of recorded frames.
+  pub fn len(&self) -> usize {
+    self.frames.len()
+  }
+
+  /// Check if the recording contains no frames.
+  pub fn is_empty(&self) -> bool {
+    self.frames.is_empty()
+  }
+
+  /// Get the recorded frames.
+  pub fn frames(&self) -> &[(FrameType, T)] {
+    &self.frames
+  }
+}
+
+impl<T: Freenect2Frame + Send> Default for FrameRecording<T> {
+  fn default() -> Self {
+    Self::new(Vec::new())
+  }
+}
+
+impl<T: Freenect2Frame + Send> From<Vec<(FrameType, T)>> for FrameRecording<T> {
+  fn from(frames: Vec<(FrameType, T)>) -> Self {
+    Self::new(frames)
+  }
+}
+
+impl<T: Freenect2Frame + Send> ReplaySource for FrameRecording<T> {
+  fn next_frame(&mut self) -> anyhow::Result<Option<(FrameType, &dyn Freenect2Frame)>> {
+    let frame = self.frames.get(self.position);
+    self.position += frame.is_some() as usize;
+
+    Ok(frame.map(|(ty, frame)| (*ty, frame as &dyn Freenect2Frame)))
+  }
+
+  fn rewind(&mut self) -> anyhow::Result<()> {
+    self.position = 0;
+    Ok(())
+  }
+}
+
+/// How fast a [`ReplayDevice`] replays its frames.
+#[derive(Debug, Copy, Clone, PartialEq, Default)]
+pub enum ReplayRate {
+  /// Replay frames at the rate they were recorded at,
+  /// using the differences between their timestamps.
+  #[default]
+  RealTime,
+  /// Replay frames at a multiple of the recorded rate.
+  /// `Speed(2.0)` replays twice as fast. Must be greater than zero.
+  Speed(f64),
+  /// Replay frames as fast as the listeners accept them.
+  Unthrottled,
+}
+
+/// Options for creating a [`ReplayDevice`].
+#[derive(Debug, Copy, Clone, PartialEq, Default)]
+pub struct ReplayOptions {
+  /// How fast frames are replayed. The default is [`ReplayRate::RealTime`].
+  pub rate: ReplayRate,
+  /// Whether to start again at the first frame once all frames were replayed.
+  /// The default is false.
+  pub looped: bool,
+}
+
+/// A pointer to a listener set on a [`ReplayDevice`].
+/// The device borrows the listener for its lifetime
+/// and joins the replay thread before it is dropped.
+#[derive(Copy, Clone)]
+struct ListenerRef(*const cxx::UniquePtr<ffi::libfreenect2::FrameListener<'static>>);
+
+unsafe impl Send for ListenerRef {}
+
+/// A frame taken from the source, but not replayed because the replay was stopped.
+type PendingFrame = (FrameType, OwnedFrame);
+
+#[derive(Default)]
+struct StopSignal {
+  stopped: Mutex<bool>,
+  cond: Condvar,
+}
+
+impl StopSignal {
+  fn stop(&self) {
+    *self.stopped.lock().unwrap_or_else(|e| e.into_inner()) = true;
+    self.cond.notify_all();
+  }
+
+  fn reset(&self) {
+    *self.stopped.lock().unwrap_or_else(|e| e.into_inner()) = false;
+  }
+
+  fn is_stopped(&self) -> bool {
+    *self.stopped.lock().unwrap_or_else(|e| e.into_inner())
+  }
+
+  /// Wait until `deadline` or until stopped.
+  /// Returns false if stopped.
+  fn wait_until(&self, deadline: Instant) -> bool {
+    let mut stopped = self.stopped.lock().unwrap_or_else(|e| e.into_inner());
+    loop {
+      let now = Instant::now();
+      if *stopped || now >= deadline {
+        return !*stopped;
+      }
+
+      stopped = self
+        .cond
+        .wait_timeout(stopped, deadline - now)
+        .unwrap_or_else(|e| e.into_inner())
+        .0;
+    }
+  }
+}
+
+/// Maps recorded timestamps to the time a frame is due.
+struct ReplayClock {
+  speed: Option<f64>,
+  start: Option<Instant>,
+  last: u32,
+  elapsed: i64,
+}
+
+impl ReplayClock {
+  fn new(rate: ReplayRate) -> Self {
+    Self {
+      speed: match rate {
+        ReplayRate::RealTime => Some(1.0),
+        ReplayRate::Speed(speed) => Some(speed),
+        ReplayRate::Unthrottled => None,
+      },
+      start: None,
+      last: 0,
+      elapsed: 0,
+    }
+  }
+
+  fn restart(&mut self) {
+    self.start = None;
+    self.elapsed = 0;
+  }
+
+  /// Wait until the frame with `timestamp` is due.
+  /// Returns false if the replay was stopped while waiting.
+  fn wait(&mut self, timestamp: u32, stop: &StopSignal) -> bool {
+    let (Some(speed), Some(start)) = (self.speed, self.start) else {
+      self.start.get_or_insert_with(Instant::now);
+      self.last = timestamp;
+      return !stop.is_stopped();
+    };
+
+    // Color and depth frames may arrive slightly out of order,
+    // so the timestamp difference is treated as signed
+    self.elapsed += timestamp.wrapping_sub(self.last) as i32 as i64;
+    self.last = timestamp;
+
+    let offset = Duration::from_secs_f64(self.elapsed.max(0) as f64 * TICK_SECONDS / speed);
+    stop.wait_until(start + offset)
+  }
+}
+
+struct Playback {
+  source: Box<dyn ReplaySource>,
+  pending: Option<PendingFrame>,
+  color: Option<ListenerRef>,
+  ir_and_depth: Option<ListenerRef>,
+  rate: ReplayRate,
+  looped: bool,
+  stop: Arc<StopSignal>,
+  replayed: Arc<AtomicU64>,
+}
+
+impl Playback {
+  fn run(mut self) -> (Box<dyn ReplaySource>, Option<PendingFrame>) {
+    let mut clock = ReplayClock::new(self.rate);
+    let mut replayed_since_rewind = false;
+
+    loop {
+      let pending = self.pending.take();
+      let frame = match &pending {
+        Some((ty, frame)) => Some((*ty, frame as &dyn Freenect2Frame)),
+        None => match self.source.next_frame() {
+          Ok(frame) => frame,
+          Err(e) => {
+            log::error!("Failed to read the next frame to replay: {}", e);
+            break;
+          }
+        },
+      };
+
+      let Some((ty, frame)) = frame else {
+        // Stop if the source is empty, looping would never yield a frame
+        if !self.looped || !replayed_since_rewind {
+          break;
+        }
+
+        if let Err(e) = self.source.rewind() {
+          log::error!("Failed to rewind the replay source: {}", e);
+          break;
+        }
+
+        clock.restart();
+        replayed_since_rewind = false;
+        continue;
+      };
+
+      if !clock.wait(frame.timestamp(), &self.stop) {
+        // The source already moved past the frame, keep it for the next start
+        if pending.is_none() {
+          self.pending = Some((ty, OwnedFrame::from_frame(frame)));
+        } else {
+          self.pending = pending;
+        }
+        break;
+      }
+
+      let listener = match ty {
+        FrameType::Color => self.color,
+        FrameType::Ir | FrameType::Depth => self.ir_and_depth,
+      };
+      if let Some(listener) = listener {
+        if let Err(e) = Self::replay_frame(listener, ty, frame) {
+          log::error!("Failed to replay {:?} frame: {}", ty, e);
+        }
+      }
+
+      replayed_since_rewind = true;
+      self.replayed.fetch_add(1, Ordering::Relaxed);
+    }
+
+    (self.source, self.pending)
+  }
+
+  fn replay_frame(
+    listener: ListenerRef,
+    ty: FrameType,
+    frame: &dyn Freenect2Frame,
+  ) -> anyhow::Result<()> {
+    let data = packed_data(frame);
+    anyhow::ensure!(
+      data.len() >= frame.raw_data_len(),
+      "The frame data must hold at least {} bytes, got {}",
+      frame.raw_data_len(),
+      data.len()
+    );
+
+    // The native frame only references the data, the listener receives a copy
+    let native = unsafe {
+      ffi::libfreenect2::create_frame(
+        frame.width() as _,
+        frame.height() as _,
+        frame.bytes_per_pixel() as _,
+        data.as_ptr() as *mut u8,
+        frame.timestamp(),
+        frame.sequence(),
+        frame.exposure(),
+        frame.gain(),
+        frame.gamma(),
+        frame.status(),
+        frame.format().into(),
+      )
+    };
+
+    unsafe { ffi::libfreenect2::replay_frame(&*listener.0, ty.into(), &native).map_err(Into::into) }
+  }
+}
+
+/// A device replaying recorded frames into frame listeners, without hardware.
+/// It is used like a [`crate::freenect2_device::Freenect2Device`]:
+/// listeners are set using [`Self::set_color_frame_listener`] and
+/// [`Self::set_ir_and_depth_frame_listener`], and frames are delivered
+/// from a separate thread between [`Self::start`] and [`Self::stop`].
+/// Frames keep their recorded timestamps and sequence numbers.
+///
+/// Listeners receive a copy of every frame, they may keep it like a frame
+/// received from a device.
+///
+/// # Example
+/// ```
+/// use libfreenect2_rs::frame::Frame;
+/// use libfreenect2_rs::frame_listener::FrameListener;
+/// use libfreenect2_rs::frame_type::FrameType;
+/// use libfreenect2_rs::replay_device::{
+///   FrameRecording, ReplayDevice, ReplayOptions, ReplayRate,
+/// };
+///
+/// let recording = FrameRecording::new(vec![
+///   (FrameType::Depth, Frame::depth().to_owned()),
+///   (FrameType::Depth, Frame::depth().to_owned()),
+/// ]);
+/// let listener = FrameListener::new(|ty, frame| {
+///   println!("Received frame of type {:?}", ty);
+///   Ok(())
+/// }).unwrap();
+///
+/// let mut device = ReplayDevice::new(
+///   recording,
+///   ReplayOptions {
+///     rate: ReplayRate::Unthrottled,
+///     ..Default::default()
+///   },
+/// );
+/// device.set_ir_and_depth_frame_listener(&listener).unwrap();
+///
+/// device.start().unwrap();
+/// device.wait().unwrap();
+/// assert_eq!(device.frames_replayed(), 2);
+/// ```
+pub struct ReplayDevice<'a> {
+  source: Option<Box<dyn ReplaySource>>,
+  pending: Option<PendingFrame>,
+  options: ReplayOptions,
+  color: Option<ListenerRef>,
+  ir_and_depth: Option<ListenerRef>,
+  thread: Option<JoinHandle<(Box<dyn ReplaySource>, Option<PendingFrame>)>>,
+  stop: Arc<StopSignal>,
+  replayed: Arc<AtomicU64>,
+  _listeners: PhantomData<&'a ()>,
+}
+
+impl<'a> ReplayDevice<'a> {
+  /// Create a new [`ReplayDevice`] replaying the frames from `source`.
+  ///
+  /// # Arguments
+  /// * `source` - The frames to replay.
+  /// * `options` - The options for the replay.
+  pub fn new<S: ReplaySource + 'static>(source: S, options: ReplayOptions) -> Self {
+    Self {
+      source: Some(Box::new(source)),
+      pending: None,
+      options,
+      color: None,
+      ir_and_depth: None,
+      thread: None,
+      stop: Arc::new(StopSignal::default()),
+      replayed: Arc::new(AtomicU64::new(0)),
+      _listeners: PhantomData,
+    }
+  }
+
+  fn listener_ref<'b: 'a, L: AsFrameListener<'b>>(listener: &'a L) -> ListenerRef {
+    let ptr = &listener.as_frame_listener().0 as *const cxx::UniquePtr<_>;
+    ListenerRef(ptr as *const cxx::UniquePtr<ffi::libfreenect2::FrameListener<'static>>)
+  }
+
+  /// Set the color frame listener.
+  /// The listener will be called for every replayed color frame.
+  ///
+  /// # Arguments
+  /// * `listener` - The listener to set.
+  ///
+  /// # Errors
+  /// Returns an error if the replay is running.
+  pub fn set_color_frame_listener<'b: 'a, L: AsFrameListener<'b>>(
+    &mut self,
+    listener: &'a L,
+  ) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      !self.is_started(),
+      "Device must be stopped when setting listener"
+    );
+
+    self.color = Some(Self::listener_ref(listener));
+    Ok(())
+  }
+
+  /// Set the IR and depth frame listener.
+  /// The listener will be called for every replayed IR and depth frame.
+  ///
+  /// # Arguments
+  /// * `listener` - The listener to set.
+  ///
+  /// # Errors
+  /// Returns an error if the replay is running.
+  pub fn set_ir_and_depth_frame_listener<'b: 'a, L: AsFrameListener<'b>>(
+    &mut self,
+    listener: &'a L,
+  ) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      !self.is_started(),
+      "Device must be stopped when setting listener"
+    );
+
+    self.ir_and_depth = Some(Self::listener_ref(listener));
+    Ok(())
+  }
+
+  /// Start replaying color and depth frames.
+  /// For more control over the streams, use [`Self::start_streams`] instead.
+  ///
+  /// # Errors
+  /// Returns an error if the replay is already running,
+  /// the options are invalid or the replay thread could not be spawned.
+  pub fn start(&mut self) -> anyhow::Result<()> {
+    self.start_streams(true, true)
+  }
+
+  /// Start replaying the specified streams.
+  /// Frames of disabled streams are skipped, but still paced.
+  /// If the replay was stopped before, it continues after the last replayed frame.
+  ///
+  /// # Arguments
+  /// * `color` - Whether to replay color frames.
+  /// * `depth` - Whether to replay IR and depth frames.
+  ///
+  /// # Errors
+  /// Returns an error if both `color` and `depth` are `false`, the replay is
+  /// already running, the options are invalid or the replay thread could not be spawned.
+  pub fn start_streams(&mut self, color: bool, depth: bool) -> anyhow::Result<()> {
+    anyhow::ensure!(color || depth, "At least one stream must be enabled");
+    anyhow::ensure!(
+      !self.is_started(),
+      "Device must be stopped before starting streams"
+    );
+    if let ReplayRate::Speed(speed) = self.options.rate {
+      anyhow::ensure!(
+        speed.is_finite() && speed > 0.0,
+        "The replay speed must be greater than zero, got {}",
+        speed
+      );
+    }
+
+    let source = self
+      .source
+      .take()
+      .ok_or_else(|| anyhow::anyhow!("The replay source was lost"))?;
+
+    self.stop.reset();
+    let playback = Playback {
+      source,
+      pending: self.pending.take(),
+      color: self.color.filter(|_| color),
+      ir_and_depth: self.ir_and_depth.filter(|_| depth),
+      rate: self.options.rate,
+      looped: self.options.looped,
+      stop: self.stop.clone(),
+      replayed: self.replayed.clone(),
+    };
+
+    self.thread = Some(
+      std::thread::Builder::new()
+        .name("freenect2-replay".to_string())
+        .spawn(move || playback.run())?,
+    );
+
+    Ok(())
+  }
+
+  /// Stop the replay.
+  /// The replay must be started before stopping it.
+  ///
+  /// # Errors
+  /// Returns an error if the replay is not started or the replay thread panicked.
+  pub fn stop(&mut self) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      self.is_started(),
+      "Device must be started before stopping streams"
+    );
+
+    self.stop.stop();
+    self.join()
+  }
+
+  /// Wait until all frames were replayed.
+  /// Never returns for a looped replay, unless its source fails.
+  ///
+  /// # Errors
+  /// Returns an error if the replay is not started or the replay thread panicked.
+  pub fn wait(&mut self) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      self.is_started(),
+      "Device must be started before waiting for the replay"
+    );
+
+    self.join()
+  }
+
+  fn join(&mut self) -> anyhow::Result<()> {
+    let thread = self
+      .thread
+      .take()
+      .ok_or_else(|| anyhow::anyhow!("The replay is not running"))?;
+
+    let (source, pending) = thread
+      .join()
+      .map_err(|e| anyhow::anyhow!("The replay thread panicked: {:?}", e))?;
+    self.source = Some(source);
+    self.pending = pending;
+
+    Ok(())
+  }
+
+  /// Move back to the first frame of the recording.
+  ///
+  /// # Errors
+  /// Returns an error if the replay is running or the source can not be rewound.
+  pub fn rewind(&mut self) -> anyhow::Result<()> {
+    anyhow::ensure!(
+      !self.is_started(),
+      "Device must be stopped before rewinding"
+    );
+
+    self
+      .source
+      .as_mut()
+      .ok_or_else(|| anyhow::anyhow!("The replay source was lost"))?
+      .rewind()?;
+    self.pending = None;
+    Ok(())
+  }
+
+  /// Check if the replay was started and not stopped yet.
+  pub fn is_started(&self) -> bool {
+    self.thread.is_some()
+  }
+
+  /// Check if the replay was started and all frames were replayed.
+  pub fn is_finished(&self) -> bool {
+    self.thread.as_ref().is_some_and(JoinHandle::is_finished)
+  }
+
+  /// Get the number of frames replayed since the device was created.
+  pub fn frames_replayed(&self) -> u64 {
+    self.replayed.load(Ordering::Relaxed)
+  }
+}
+
+unsafe impl Send for ReplayDevice<'_> {}
+unsafe impl Sync for ReplayDevice<'_> {}
+
+impl Drop for ReplayDevice<'_> {
+  fn drop(&mut self) {
+    // The replay thread uses the listeners, which may be dropped after the device
+    if self.is_started() {
+      if let Err(e) = self.stop() {
+        log::error!("Failed to stop the replay: {}", e);
+      }
+    }
+  }
+}
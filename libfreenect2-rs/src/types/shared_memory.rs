@@ -0,0 +1,638 @@
+//! Distribution of frames to other processes on the same machine
+//! through shared memory.
+//!
+//! Only one process can open a device. A [`SharedMemoryPublisher`] receives the
+//! frames in that process and copies every frame once into a ring of slots in
+//! shared memory. Any number of processes can open the ring using a
+//! [`SharedMemorySubscriber`] and read the frames as [`SharedMemoryFrame`]
+//! views into the mapping, without copying them. Subscribers never write to the
+//! ring, so every additional subscriber only costs its own reads.
+//!
+//! The publisher never waits for subscribers. A frame stays in the ring until
+//! the publisher wraps around to its slot. Subscribers falling behind by more
+//! frames than there are slots skip the overwritten frames.
+//! Every slot starts with a generation counter, which is odd while the slot is
+//! written and identifies the frame in the slot otherwise, so subscribers detect
+//! frames that were overwritten while they were read, see [`SharedMemoryFrame::is_valid`].
+//! Use [`SharedMemoryFrame::read_into`] or [`SharedMemoryFrame::to_owned_checked`]
+//! to get a consistent copy of a frame.
+//!
+//! On Linux, the ring is a file in `/dev/shm`, like the ones `shm_open` creates.
+//! On other platforms, the ring is a mapped file in the temporary directory.
+//!
+//! The ring starts with a 64 byte header, followed by the slots. Each slot is a
+//! 64 byte slot header followed by space for the frame data, padded to a multiple
+//! of 64 bytes. The counters are stored in native byte order,
+//! all other values in little-endian byte order.
+
+use crate::capture::{
+  format_code, format_from_code, frame_type_code, frame_type_from_code, read_f32, read_u32,
+  read_u64,
+};
+use crate::frame::{packed_data, FrameFormat, Freenect2Frame, OwnedFrame};
+use crate::frame_listener::{AsFrameListener, FrameListener};
+use crate::frame_type::FrameType;
+use memmap2::{Mmap, MmapMut};
+use std::fs::{File, OpenOptions};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{fence, AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+const MAGIC: [u8; 8] = *b"LF2RSSHM";
+const VERSION: u32 = 1;
+
+/// The alignment of slots and frame data.
+const ALIGNMENT: usize = 64;
+const HEADER_LEN: usize = 64;
+const SLOT_HEADER_LEN: usize = 64;
+/// The offset of the number of published frames in the header.
+const PUBLISHED_OFFSET: usize = 24;
+/// The offset of the flag set once the publisher is dropped.
+const CLOSED_OFFSET: usize = 32;
+
+/// The time between checks for new frames while waiting.
+const POLL_INTERVAL: Duration = Duration::from_micros(250);
+
+fn align(len: usize) -> usize {
+  len.div_ceil(ALIGNMENT) * ALIGNMENT
+}
+
+fn slot_offset(slot: u64, slot_len: usize) -> usize {
+  HEADER_LEN + slot as usize * (SLOT_HEADER_LEN + slot_len)
+}
+
+/// The generation of a slot holding the frame with the specified index.
+/// Never 0, which is the generation of empty slots.
+fn generation(index: u64) -> u64 {
+  2 * (index + 1)
+}
+
+/// Get the counter at `offset` in a mapping.
+/// Mappings are page aligned and all counters are at multiples of 8.
+fn counter(map: &[u8], offset: usize) -> &AtomicU64 {
+  let ptr = map[offset..offset + 8].as_ptr();
+  debug_assert_eq!(ptr as usize % std::mem::align_of::<AtomicU64>(), 0);
+
+  // Safety: the counters are only ever accessed atomically
+  unsafe { &*(ptr as *const AtomicU64) }
+}
+
+fn shared_memory_path(name: &str) -> anyhow::Result<PathBuf> {
+  anyhow::ensure!(
+    !name.is_empty()
+      && !name.starts_with('.')
+      && name
+        .chars()
+        .all(|c| c.is_ascii_alphanumeric() || matches!(c, '-' | '_' | '.')),
+    "Invalid shared memory name '{}', only letters, digits, '-', '_' and '.' are allowed",
+    name
+  );
+
+  let shm = Path::new("/dev/shm");
+  Ok(if cfg!(target_os = "linux") && shm.is_dir() {
+    shm.join(name)
+  } else {
+    std::env::temp_dir().join(name)
+  })
+}
+
+fn encode_slot_header(ty: FrameType, frame: &dyn Freenect2Frame) -> [u8; SLOT_HEADER_LEN] {
+  let mut buf = [0; SLOT_HEADER_LEN];
+  buf[8] = frame_type_code(ty);
+  buf[9] = format_code(frame.format());
+  buf[12..16].copy_from_slice(&(frame.width() as u32).to_le_bytes());
+  buf[16..20].copy_from_slice(&(frame.height() as u32).to_le_bytes());
+  buf[20..24].copy_from_slice(&(frame.bytes_per_pixel() as u32).to_le_bytes());
+  buf[24..28].copy_from_slice(&frame.timestamp().to_le_bytes());
+  buf[28..32].copy_from_slice(&frame.sequence().to_le_bytes());
+  buf[32..36].copy_from_slice(&frame.exposure().to_le_bytes());
+  buf[36..40].copy_from_slice(&frame.gain().to_le_bytes());
+  buf[40..44].copy_from_slice(&frame.gamma().to_le_bytes());
+  buf[44..48].copy_from_slice(&frame.status().to_le_bytes());
+  buf
+}
+
+/// Options for creating a [`SharedMemoryPublisher`].
+#[derive(Debug, Copy, Clone, Eq, PartialEq)]
+pub struct SharedMemoryOptions {
+  /// The number of frames kept in the ring.
+  /// Subscribers falling behind by more frames skip frames.
+  /// The default is 8.
+  pub slot_count: usize,
+  /// The maximum size of a frame in bytes. The default fits
+  /// a 1920x1080 color frame with 4 bytes per pixel.
+  /// The ring needs `slot_count` times this much shared memory.
+  pub max_frame_len: usize,
+}
+
+impl Default for SharedMemoryOptions {
+  fn default() -> Self {
+    Self {
+      slot_count: 8,
+      max_frame_len: 1920 * 1080 * 4,
+    }
+  }
+}
+
+struct RingWriter {
+  path: PathBuf,
+  map: MmapMut,
+  slot_count: u64,
+  slot_len: usize,
+  published: u64,
+}
+
+impl RingWriter {
+  fn create(path: PathBuf, options: SharedMemoryOptions) -> anyhow::Result<Self> {
+    anyhow::ensure!(
+      options.slot_count > 0 && options.slot_count <= u32::MAX as usize,
+      "The slot count must be between 1 and {}",
+      u32::MAX
+    );
+    anyhow::ensure!(
+      options.max_frame_len > 0,
+      "The maximum frame size must be greater than zero"
+    );
+
+    let slot_len = align(options.max_frame_len);
+    let len = options
+      .slot_count
+      .checked_mul(SLOT_HEADER_LEN + slot_len)
+      .and_then(|len| len.checked_add(HEADER_LEN))
+      .ok_or_else(|| anyhow::anyhow!("The shared memory ring is too large"))?;
+
+    // Subscribers still mapping a previous ring keep their mapping
+    // if the file is removed, truncating it would invalidate it
+    if let Err(e) = std::fs::remove_file(&path) {
+      anyhow::ensure!(
+        e.kind() == std::io::ErrorKind::NotFound,
+        "Failed to remove the previous shared memory ring: {}",
+        e
+      );
+    }
+
+    let file = OpenOptions::new()
+      .read(true)
+      .write(true)
+      .create_new(true)
+      .open(&path)?;
+    file.set_len(len as u64)?;
+    let mut map = unsafe { MmapMut::map_mut(&file)? };
+
+    map[8..12].copy_from_slice(&VERSION.to_le_bytes());
+    map[12..16].copy_from_slice(&(options.slot_count as u32).to_le_bytes());
+    map[16..24].copy_from_slice(&(slot_len as u64).to_le_bytes());
+    fence(Ordering::Release);
+    map[0..8].copy_from_slice(&MAGIC);
+
+    Ok(Self {
+      path,
+      map,
+      slot_count: options.slot_count as u64,
+      slot_len,
+      published: 0,
+    })
+  }
+
+  fn write_frame(&mut self, ty: FrameType, frame: &dyn Freenect2Frame) -> anyhow::Result<()> {
+    let data = packed_data(frame);
+    anyhow::ensure!(
+      data.len() <= self.slot_len,
+      "The {:?} frame of {} bytes doesn't fit into a slot of {} bytes",
+      ty,
+      data.len(),
+      self.slot_len
+    );
+
+    let index = self.published;
+    let offset = slot_offset(index % self.slot_count, self.slot_len);
+
+    // Mark the slot as being written before overwriting it
+    counter(&self.map, offset).store(generation(index) - 1, Ordering::Relaxed);
+    fence(Ordering::Release);
+
+    self.map[offset + 8..offset + SLOT_HEADER_LEN]
+      .copy_from_slice(&encode_slot_header(ty, frame)[8..]);
+    let data_offset = offset + SLOT_HEADER_LEN;
+    self.map[data_offset..data_offset + data.len()].copy_from_slice(&data);
+
+    counter(&self.map, offset).store(generation(index), Ordering::Release);
+    self.published = index + 1;
+    counter(&self.map, PUBLISHED_OFFSET).store(self.published, Ordering::Release);
+
+    Ok(())
+  }
+}
+
+impl Drop for RingWriter {
+  fn drop(&mut self) {
+    counter(&self.map, CLOSED_OFFSET).store(1, Ordering::Release);
+
+    if let Err(e) = std::fs::remove_file(&self.path) {
+      log::warn!(
+        "Failed to remove the shared memory ring {}: {}",
+        self.path.display(),
+        e
+      );
+    }
+  }
+}
+
+/// Publishes frames into a shared memory ring,
+/// which can be read by other processes using a [`SharedMemorySubscriber`].
+///
+/// The native callback copies every frame into the next slot of the ring,
+/// overwriting the oldest frame, and returns. No frames are queued and no
+/// subscriber is waited for, so publishing costs the same for any number of
+/// subscribers. The ring is removed once the publisher is dropped.
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::freenect2::Freenect2;
+/// use libfreenect2_rs::shared_memory::{SharedMemoryOptions, SharedMemoryPublisher};
+///
+/// let mut freenect2 = Freenect2::new().unwrap();
+/// let mut device = freenect2.open_default_device().unwrap();
+///
+/// let publisher = SharedMemoryPublisher::create("kinect0", SharedMemoryOptions::default()).unwrap();
+/// device.set_color_frame_listener(&publisher).unwrap();
+/// device.set_ir_and_depth_frame_listener(&publisher).unwrap();
+/// device.start().unwrap();
+///
+/// std::thread::sleep(std::time::Duration::from_secs(60));
+/// device.stop().unwrap();
+/// ```
+pub struct SharedMemoryPublisher {
+  listener: FrameListener<'static>,
+  writer: Arc<Mutex<RingWriter>>,
+}
+
+impl SharedMemoryPublisher {
+  /// Create a new shared memory ring called `name`.
+  /// An existing ring with the same name is replaced, subscribers of the
+  /// previous ring must open the new ring to receive its frames.
+  ///
+  /// # Arguments
+  /// * `name` - The name of the ring, which subscribers open it by.
+  ///   May only contain letters, digits, '-', '_' and '.'.
+  /// * `options` - The options for the ring.
+  ///
+  /// # Errors
+  /// Returns an error if the name or the options are invalid, the shared
+  /// memory could not be created or the underlying frame listener could
+  /// not be created.
+  pub fn create(name: &str, options: SharedMemoryOptions) -> anyhow::Result<Self> {
+    let writer = Arc::new(Mutex::new(RingWriter::create(
+      shared_memory_path(name)?,
+      options,
+    )?));
+
+    let listener = FrameListener::new({
+      let writer = writer.clone();
+      move |ty, frame| writer.lock().unwrap().write_frame(ty, &frame)
+    })?;
+
+    Ok(Self { listener, writer })
+  }
+
+  /// Publish a frame, in addition to the frames received by the listener.
+  ///
+  /// # Arguments
+  /// * `ty` - The type of the frame.
+  /// * `frame` - The frame to publish.
+  ///
+  /// # Errors
+  /// Returns an error if the frame is larger than [`SharedMemoryOptions::max_frame_len`].
+  pub fn publish<F: Freenect2Frame>(&self, ty: FrameType, frame: &F) -> anyhow::Result<()> {
+    self.writer.lock().unwrap().write_frame(ty, frame)
+  }
+
+  /// Get the number of frames published so far.
+  pub fn frames_published(&self) -> u64 {
+    self.writer.lock().unwrap().published
+  }
+}
+
+impl AsFrameListener<'static> for SharedMemoryPublisher {
+  fn as_frame_listener(&self) -> &FrameListener<'static> {
+    &self.listener
+  }
+}
+
+/// A frame in a shared memory ring.
+/// The frame data is not copied, it is read from the mapping directly.
+/// The mapping stays valid as long as a frame referencing it exists,
+/// even if the [`SharedMemorySubscriber`] or the publisher is dropped.
+///
+/// The publisher overwrites the slot of the frame once it wraps around
+/// the ring. Check [`Self::is_valid`] after using the frame data to
+/// discard results computed from a partially overwritten frame.
+///
+/// # Racy data
+/// [`Freenect2Frame::raw_data`] returns a view into memory another process
+/// writes to concurrently. The compiler assumes the data behind a `&[u8]`
+/// never changes, so it may read a byte twice and get two different values,
+/// which [`Self::is_valid`] can't detect. Only use the view for reads
+/// which tolerate this, like a single pass over the data, and prefer
+/// [`Self::read_into`] or [`Self::to_owned_checked`], which copy the data
+/// once and check it afterwards.
+#[derive(Clone)]
+pub struct SharedMemoryFrame {
+  map: Arc<Mmap>,
+  offset: usize,
+  generation: u64,
+  width: usize,
+  height: usize,
+  bytes_per_pixel: usize,
+  timestamp: u32,
+  sequence: u32,
+  exposure: f32,
+  gain: f32,
+  gamma: f32,
+  status: u32,
+  format: FrameFormat,
+}
+
+impl SharedMemoryFrame {
+  /// Check if the slot of the frame was not overwritten yet.
+  /// If this returns `true` after the frame data was read,
+  /// the data that was read is complete and consistent.
+  pub fn is_valid(&self) -> bool {
+    fence(Ordering::Acquire);
+    counter(&self.map, self.offset).load(Ordering::Relaxed) == self.generation
+  }
+
+  /// Copy the frame data into `dst`, replacing its contents.
+  /// The data is read exactly once, through a raw pointer.
+  ///
+  /// # Returns
+  /// Whether the slot was not overwritten while it was copied.
+  /// If `false`, `dst` holds inconsistent data and must be discarded.
+  pub fn read_into(&self, dst: &mut Vec<u8>) -> bool {
+    let len = self.raw_data_len();
+    let data_offset = self.offset + SLOT_HEADER_LEN;
+    let src = self.map[data_offset..data_offset + len].as_ptr();
+
+    dst.clear();
+    dst.reserve(len);
+    // Safety: `src` points to `len` bytes of the mapping, which are copied
+    // into the reserved space. The copy may race with the publisher,
+    // which the generation check below detects.
+    unsafe {
+      std::ptr::copy_nonoverlapping(src, dst.as_mut_ptr(), len);
+      dst.set_len(len);
+    }
+
+    self.is_valid()
+  }
+
+  /// Copy the frame into an [`OwnedFrame`].
+  /// Returns [`None`] if the slot was overwritten while it was copied.
+  pub fn to_owned_checked(&self) -> Option<OwnedFrame> {
+    let mut data = Vec::new();
+    if !self.read_into(&mut data) {
+      return None;
+    }
+
+    Some(OwnedFrame::from_data(self, data))
+  }
+}
+
+impl Freenect2Frame for SharedMemoryFrame {
+  fn width(&self) -> usize {
+    self.width
+  }
+
+  fn height(&self) -> usize {
+    self.height
+  }
+
+  fn bytes_per_pixel(&self) -> usize {
+    self.bytes_per_pixel
+  }
+
+  fn timestamp(&self) -> u32 {
+    self.timestamp
+  }
+
+  /// A racy view into the mapping, see [`SharedMemoryFrame`].
+  fn raw_data(&self) -> &[u8] {
+    let data_offset = self.offset + SLOT_HEADER_LEN;
+    &self.map[data_offset..data_offset + self.raw_data_len()]
+  }
+
+  fn sequence(&self) -> u32 {
+    self.sequence
+  }
+
+  fn exposure(&self) -> f32 {
+    self.exposure
+  }
+
+  fn gain(&self) -> f32 {
+    self.gain
+  }
+
+  fn gamma(&self) -> f32 {
+    self.gamma
+  }
+
+  fn status(&self) -> u32 {
+    self.status
+  }
+
+  fn format(&self) -> FrameFormat {
+    self.format
+  }
+}
+
+/// Reads the frames of a [`SharedMemoryPublisher`], usually in another process.
+///
+/// Frames are returned in the order they were published, starting with the
+/// first frame published after the ring was opened. Frames overwritten before
+/// they were read are skipped and counted, see [`Self::skipped_count`].
+///
+/// # Example
+/// ```no_run
+/// use libfreenect2_rs::frame::Freenect2Frame;
+/// use libfreenect2_rs::shared_memory::SharedMemorySubscriber;
+/// use std::time::Duration;
+///
+/// let mut subscriber = SharedMemorySubscriber::open("kinect0").unwrap();
+///
+/// while let Some((ty, frame)) = subscriber.next_timeout(Duration::from_secs(1)) {
+///   if let Some(frame) = frame.to_owned_checked() {
+///     let sum = frame.raw_data().iter().map(|&b| b as u64).sum::<u64>();
+///     println!("{:?} frame {}: {}", ty, frame.sequence(), sum);
+///   }
+/// }
+/// ```
+pub struct SharedMemorySubscriber {
+  map: Arc<Mmap>,
+  slot_count: u64,
+  slot_len: usize,
+  next: u64,
+  skipped: u64,
+}
+
+impl SharedMemorySubscriber {
+  /// Open the shared memory ring called `name`.
+  ///
+  /// # Arguments
+  /// * `name` - The name the ring was created with.
+  ///
+  /// # Errors
+  /// Returns an error if the ring doesn't exist or could not be mapped,
+  /// or if it is not a ring created by a [`SharedMemoryPublisher`].
+  pub fn open(name: &str) -> anyhow::Result<Self> {
+    let file = File::open(shared_memory_path(name)?)?;
+    // Safety: the publisher only writes the ring as described in the module docs
+    let map = unsafe { Mmap::map(&file)? };
+
+    anyhow::ensure!(
+      map.len() >= HEADER_LEN && map[0..8] == MAGIC,
+      "The shared memory is not a frame ring"
+    );
+    fence(Ordering::Acquire);
+    let version = read_u32(&map, 8);
+    anyhow::ensure!(
+      version == VERSION,
+      "Unsupported shared memory ring version {}",
+      version
+    );
+
+    let slot_count = read_u32(&map, 12) as u64;
+    let slot_len = usize::try_from(read_u64(&map, 16))?;
+    anyhow::ensure!(
+      slot_count > 0
+        && (slot_count as usize)
+          .checked_mul(SLOT_HEADER_LEN + slot_len)
+          .and_then(|len| len.checked_add(HEADER_LEN))
+          .is_some_and(|len| len <= map.len()),
+      "The shared memory ring is corrupted"
+    );
+
+    let next = counter(&map, PUBLISHED_OFFSET).load(Ordering::Acquire);
+    Ok(Self {
+      map: Arc::new(map),
+      slot_count,
+      slot_len,
+      next,
+      skipped: 0,
+    })
+  }
+
+  fn published(&self) -> u64 {
+    counter(&self.map, PUBLISHED_OFFSET).load(Ordering::Acquire)
+  }
+
+  fn read(&self, index: u64) -> Option<(FrameType, SharedMemoryFrame)> {
+    let offset = slot_offset(index % self.slot_count, self.slot_len);
+    let generation = generation(index);
+    if counter(&self.map, offset).load(Ordering::Acquire) != generation {
+      return None;
+    }
+
+    let header = &self.map[offset..offset + SLOT_HEADER_LEN];
+    let frame = SharedMemoryFrame {
+      map: self.map.clone(),
+      offset,
+      generation,
+      width: read_u32(header, 12) as _,
+      height: read_u32(header, 16) as _,
+      bytes_per_pixel: read_u32(header, 20) as _,
+      timestamp: read_u32(header, 24),
+      sequence: read_u32(header, 28),
+      exposure: read_f32(header, 32),
+      gain: read_f32(header, 36),
+      gamma: read_f32(header, 40),
+      status: read_u32(header, 44),
+      format: format_from_code(header[9]),
+    };
+    let ty = frame_type_from_code(header[8]);
+
+    // The header may have been overwritten while it was read
+    if !frame.is_valid() {
+      return None;
+    }
+
+    let fits = frame
+      .width
+      .checked_mul(frame.height)
+      .and_then(|len| len.checked_mul(frame.bytes_per_pixel))
+      .is_some_and(|len| len <= self.slot_len);
+    ty.filter(|_| fits).map(|ty| (ty, frame))
+  }
+
+  /// Get the next frame without waiting.
+  /// Returns `None` if no new frame was published yet.
+  pub fn try_next(&mut self) -> Option<(FrameType, SharedMemoryFrame)> {
+    loop {
+      let published = self.published();
+      if self.next >= published {
+        return None;
+      }
+
+      let oldest = published.saturating_sub(self.slot_count);
+      if self.next < oldest {
+        self.skipped += oldest - self.next;
+        self.next = oldest;
+      }
+
+      let index = self.next;
+      self.next += 1;
+      match self.read(index) {
+        Some(frame) => return Some(frame),
+        None => self.skipped += 1,
+      }
+    }
+  }
+
+  /// Wait for the next frame.
+  /// Returns `None` if no frame was published within `timeout`
+  /// or if the publisher was dropped.
+  ///
+  /// # Arguments
+  /// * `timeout` - The maximum time to wait for.
+  pub fn next_timeout(&mut self, timeout: Duration) -> Option<(FrameType, SharedMemoryFrame)> {
+    let deadline = Instant::now() + timeout;
+
+    loop {
+      if let Some(frame) = self.try_next() {
+        return Some(frame);
+      }
+      if self.is_closed() || Instant::now() >= deadline {
+        return None;
+      }
+
+      std::thread::sleep(POLL_INTERVAL);
+    }
+  }
+
+  /// Get the most recently published frame, which may have been returned before.
+  /// All older frames are skipped without being counted as skipped.
+  /// Returns `None` if no frame was published yet.
+  pub fn latest(&mut self) -> Option<(FrameType, SharedMemoryFrame)> {
+    let published = self.published();
+    self.next = self.next.max(published);
+
+    published.checked_sub(1).and_then(|index| self.read(index))
+  }
+
+  /// Get the number of frames which were overwritten before they were read.
+  pub fn skipped_count(&self) -> u64 {
+    self.skipped
+  }
+
+  /// Get the number of frames the ring holds.
+  pub fn slot_count(&self) -> usize {
+    self.slot_count as _
+  }
+
+  /// Check if the publisher was dropped.
+  /// No new frames will be published into this ring.
+  pub fn is_closed(&self) -> bool {
+    counter(&self.map, CLOSED_OFFSET).load(Ordering::Acquire) != 0
+  }
+}
@@ -0,0 +1,124 @@
+//! Control over the CPUs, scheduling and NUMA node of the threads
+//! frames are processed on.
+//!
+//! libfreenect2 starts the packet processor threads of a device, which
+//! decode the frames and call the frame listeners, while opening the device.
+//! Threads inherit the CPU affinity, the scheduling policy and the NUMA
+//! memory policy of the thread creating them, so a [`ThreadPolicy`] applied
+//! while opening a device, see [`crate::freenect2::Freenect2::open_with_thread_policy`],
+//! applies to all threads of the device. Frame buffers, including the frames
+//! of a [`crate::frame_pool::FramePool`], are allocated by these threads and
+//! therefore on the NUMA node of the policy.
+//!
+//! Thread policies are only supported on Linux. Real-time scheduling
+//! policies and negative nice values usually require the `CAP_SYS_NICE`
+//! capability or a matching `RLIMIT_RTPRIO` limit.
+
+use crate::ffi;
+use cxx::UniquePtr;
+
+pub use crate::ffi::libfreenect2::{SchedulingPolicy, ThreadPolicy};
+
+impl Default for SchedulingPolicy {
+  fn default() -> Self {
+    SchedulingPolicy::Inherit
+  }
+}
+
+impl Default for ThreadPolicy {
+  fn default() -> Self {
+    Self {
+      cpus: Vec::new(),
+      scheduling: SchedulingPolicy::Inherit,
+      priority: 0,
+      numa_node: -1,
+    }
+  }
+}
+
+impl ThreadPolicy {
+  /// Create a policy which restricts threads to `cpus`.
+  pub fn pinned(cpus: &[u32]) -> Self {
+    Self {
+      cpus: cpus.to_vec(),
+      ..Default::default()
+    }
+  }
+
+  /// Create a policy which restricts threads to the CPUs of a NUMA node
+  /// and allocates their memory on that node.
+  pub fn numa_local(node: u32) -> Self {
+    Self {
+      numa_node: node as i32,
+      ..Default::default()
+    }
+  }
+
+  /// Apply the policy to the calling thread until the returned guard is dropped.
+  /// All threads started by the calling thread in the meantime keep the policy.
+  ///
+  /// # Errors
+  /// Returns an error if the policy is invalid or could not be applied,
+  /// in which case the calling thread is left unchanged.
+  ///
+  /// # Example
+  /// ```no_run
+  /// use libfreenect2_rs::thread_policy::{SchedulingPolicy, ThreadPolicy};
+  ///
+  /// let policy = ThreadPolicy {
+  ///   cpus: vec![2, 3],
+  ///   scheduling: SchedulingPolicy::Fifo,
+  ///   priority: 10,
+  ///   numa_node: 0,
+  /// };
+  ///
+  /// let guard = policy.enter().unwrap();
+  /// let worker = std::thread::spawn(|| {
+  ///   // Runs on CPU 2 or 3 with SCHED_FIFO
+  /// });
+  /// drop(guard);
+  /// ```
+  pub fn enter(&self) -> anyhow::Result<ThreadPolicyGuard> {
+    Ok(ThreadPolicyGuard(ffi::libfreenect2::enter_thread_policy(
+      self,
+    )?))
+  }
+
+  /// Apply the policy to the calling thread permanently.
+  ///
+  /// # Errors
+  /// Returns an error if the policy is invalid or could not be applied,
+  /// in which case the calling thread is left unchanged.
+  pub fn apply_to_current_thread(&self) -> anyhow::Result<()> {
+    let mut guard = self.enter()?;
+    guard
+      .0
+      .as_mut()
+      .ok_or(anyhow::anyhow!(
+        "Failed to get thread policy scope as mutable"
+      ))?
+      .keep();
+
+    Ok(())
+  }
+}
+
+/// Restores the previous policy of the thread a [`ThreadPolicy`]
+/// was entered on once dropped. Must be dropped on the same thread.
+pub struct ThreadPolicyGuard(UniquePtr<ffi::libfreenect2::ThreadPolicyScope>);
+
+/// Get the CPUs the calling thread may run on.
+///
+/// # Errors
+/// Returns an error if the CPU affinity of the thread could not be retrieved.
+pub fn current_thread_cpus() -> anyhow::Result<Vec<u32>> {
+  ffi::libfreenect2::current_thread_cpus().map_err(Into::into)
+}
+
+/// Get the CPUs of a NUMA node.
+///
+/// # Errors
+/// Returns an error if the node does not exist.
+pub fn numa_node_cpus(node: u32) -> anyhow::Result<Vec<u32>> {
+  ffi::libfreenect2::numa_node_cpus(node).map_err(Into::into)
+}
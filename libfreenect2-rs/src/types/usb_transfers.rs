@@ -0,0 +1,47 @@
+//! USB transfer buffering of devices and the packets lost during capture.
+//!
+//! libfreenect2 receives the streams of a device through a fixed number of
+//! USB transfers in flight. If the host does not serve them in time, for
+//! example because several devices share a hub, packets are dropped.
+//! More and larger transfers trade memory for headroom, see
+//! [`crate::freenect2::Freenect2::open_with_usb_transfers`].
+//!
+//! Lost packets are counted per device using the sequence numbers of the
+//! delivered frames, see [`crate::freenect2_device::Freenect2Device::packet_stats`].
+//! Packets dropped on the bus, packets received incompletely and packets
+//! skipped because the packet processor was still busy with the previous
+//! one all show up as lost packets.
+
+use crate::ffi;
+use cxx::UniquePtr;
+
+pub use crate::ffi::libfreenect2::{PacketStats, StreamStats, UsbTransferConfig};
+
+impl StreamStats {
+  /// Get the fraction of packets which were lost,
+  /// or 0 if no packet was received yet.
+  pub fn loss_ratio(&self) -> f64 {
+    let total = self.frames + self.lost;
+    if total == 0 {
+      0.0
+    } else {
+      self.lost as f64 / total as f64
+    }
+  }
+}
+
+impl PacketStats {
+  /// Get the number of packets lost over all streams.
+  /// IR and depth frames are decoded from the same packets,
+  /// so a lost depth packet is counted for both of them.
+  pub fn total_lost(&self) -> u64 {
+    self.color.lost + self.ir.lost + self.depth.lost
+  }
+}
+
+impl UsbTransferConfig {
+  /// Override the USB transfer settings of libfreenect2 until the returned scope is dropped.
+  pub(crate) fn enter(&self) -> anyhow::Result<UniquePtr<ffi::libfreenect2::UsbTransferScope>> {
+    ffi::libfreenect2::enter_usb_transfer_config(self).map_err(Into::into)
+  }
+}
@@ -0,0 +1,326 @@
+use std::cell::UnsafeCell;
+use std::mem::MaybeUninit;
+use std::ops::Deref;
+use std::panic::{RefUnwindSafe, UnwindSafe};
+use std::sync::atomic::{fence, AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Condvar, Mutex};
+use std::time::{Duration, Instant};
+
+/// What to do if a value is pushed into a full [`BoundedQueue`].
+#[derive(Debug, Copy, Clone, Eq, PartialEq, Default)]
+pub enum DropPolicy {
+  /// Drop the oldest value in the queue to make room for the new one.
+  /// Keeps the latency to the newest value bounded.
+  #[default]
+  DropOldest,
+  /// Drop the new value and keep the queue as is.
+  DropNewest,
+  /// Block the producer until there is room in the queue.
+  Block,
+}
+
+#[repr(align(64))]
+struct CachePadded<T>(T);
+
+impl<T> Deref for CachePadded<T> {
+  type Target = T;
+
+  fn deref(&self) -> &T {
+    &self.0
+  }
+}
+
+/// A slot of the queue.
+/// The sequence is `2 * pos` while the slot is free for the push at `pos`
+/// and `2 * pos + 1` once it holds the value pushed at `pos`.
+/// Doubling the position keeps both states distinct even with a capacity of one.
+struct Slot<T> {
+  sequence: AtomicUsize,
+  value: UnsafeCell<MaybeUninit<T>>,
+}
+
+/// Blocking side of the queue.
+/// Only used if a producer or consumer actually has to wait,
+/// the fast path never touches the mutex.
+#[derive(Default)]
+struct Waiters {
+  count: AtomicUsize,
+  mutex: Mutex<()>,
+  condvar: Condvar,
+}
+
+impl Waiters {
+  /// Wake all waiters.
+  /// Must be called after the state the waiters check has been published.
+  fn notify(&self) {
+    // Pairs with the fence in `wait_for`. Without it, the load of the count
+    // may be ordered before the store publishing the state, so the waiter
+    // misses the state and this misses the waiter, which then sleeps forever.
+    fence(Ordering::SeqCst);
+    if self.count.load(Ordering::SeqCst) > 0 {
+      let _lock = self.mutex.lock().unwrap_or_else(|e| e.into_inner());
+      self.condvar.notify_all();
+    }
+  }
+
+  /// Wait until `f` returns [`Some`] or the deadline is reached.
+  fn wait_for<R>(&self, deadline: Option<Instant>, mut f: impl FnMut() -> Option<R>) -> Option<R> {
+    loop {
+      if let Some(res) = f() {
+        return Some(res);
+      }
+
+      let lock = self.mutex.lock().unwrap_or_else(|e| e.into_inner());
+      self.count.fetch_add(1, Ordering::SeqCst);
+      fence(Ordering::SeqCst);
+
+      // Check again after registering to not miss a notification
+      if let Some(res) = f() {
+        self.count.fetch_sub(1, Ordering::SeqCst);
+        return Some(res);
+      }
+
+      let timed_out = match deadline {
+        Some(deadline) => {
+          let now = Instant::now();
+          if now >= deadline {
+            true
+          } else {
+            drop(
+              self
+                .condvar
+                .wait_timeout(lock, deadline - now)
+                .unwrap_or_else(|e| e.into_inner()),
+            );
+            false
+          }
+        }
+        None => {
+          drop(self.condvar.wait(lock).unwrap_or_else(|e| e.into_inner()));
+          false
+        }
+      };
+
+      self.count.fetch_sub(1, Ordering::SeqCst);
+      if timed_out {
+        return None;
+      }
+    }
+  }
+}
+
+/// A bounded, lock-free multi-producer multi-consumer queue.
+/// Based on Dmitry Vyukov's bounded MPMC queue.
+/// Pushing and popping never lock unless the caller has to wait
+/// because the queue is empty or, with [`DropPolicy::Block`], full.
+pub(crate) struct BoundedQueue<T> {
+  buffer: Box<[Slot<T>]>,
+  head: CachePadded<AtomicUsize>,
+  tail: CachePadded<AtomicUsize>,
+  drop_policy: DropPolicy,
+  dropped: AtomicU64,
+  closed: AtomicBool,
+  not_empty: Waiters,
+  not_full: Waiters,
+}
+
+unsafe impl<T: Send> Send for BoundedQueue<T> {}
+unsafe impl<T: Send> Sync for BoundedQueue<T> {}
+impl<T> UnwindSafe for BoundedQueue<T> {}
+impl<T> RefUnwindSafe for BoundedQueue<T> {}
+
+impl<T> BoundedQueue<T> {
+  pub(crate) fn new(capacity: usize, drop_policy: DropPolicy) -> anyhow::Result<Self> {
+    anyhow::ensure!(capacity > 0, "The queue capacity must be at least 1");
+
+    Ok(Self {
+      buffer: (0..capacity)
+        .map(|i| Slot {
+          sequence: AtomicUsize::new(2 * i),
+          value: UnsafeCell::new(MaybeUninit::uninit()),
+        })
+        .collect(),
+      head: CachePadded(AtomicUsize::new(0)),
+      tail: CachePadded(AtomicUsize::new(0)),
+      drop_policy,
+      dropped: AtomicU64::new(0),
+      closed: AtomicBool::new(false),
+      not_empty: Waiters::default(),
+      not_full: Waiters::default(),
+    })
+  }
+
+  pub(crate) fn capacity(&self) -> usize {
+    self.buffer.len()
+  }
+
+  /// Get the number of values dropped because the queue was full.
+  pub(crate) fn dropped_count(&self) -> u64 {
+    self.dropped.load(Ordering::Relaxed)
+  }
+
+  /// Get the number of values currently in the queue.
+  /// The value may already be outdated when it is returned.
+  pub(crate) fn len(&self) -> usize {
+    let tail = self.tail.load(Ordering::Acquire);
+    let head = self.head.load(Ordering::Acquire);
+
+    tail.saturating_sub(head).min(self.capacity())
+  }
+
+  /// Close the queue.
+  /// Waiting consumers return once the queue is empty
+  /// and blocked producers drop their value.
+  pub(crate) fn close(&self) {
+    self.closed.store(true, Ordering::SeqCst);
+    self.not_empty.notify();
+    self.not_full.notify();
+  }
+
+  pub(crate) fn is_closed(&self) -> bool {
+    self.closed.load(Ordering::SeqCst)
+  }
+
+  /// Push a value into the queue, applying the drop policy if it is full.
+  /// Returns `false` if a value was dropped.
+  pub(crate) fn push(&self, value: T) -> bool {
+    let res = match self.drop_policy {
+      DropPolicy::DropNewest => {
+        let pushed = self.try_push(value).is_ok();
+        if !pushed {
+          self.dropped.fetch_add(1, Ordering::Relaxed);
+        }
+
+        pushed
+      }
+      DropPolicy::DropOldest => {
+        let mut value = value;
+        let mut pushed = true;
+
+        while let Err(v) = self.try_push(value) {
+          value = v;
+          if self.try_pop().is_some() {
+            self.dropped.fetch_add(1, Ordering::Relaxed);
+            pushed = false;
+          }
+        }
+
+        pushed
+      }
+      DropPolicy::Block => {
+        let mut value = Some(value);
+        self.not_full.wait_for(None, || {
+          if self.is_closed() {
+            return Some(());
+          }
+
+          match self.try_push(value.take()?) {
+            Ok(()) => Some(()),
+            Err(v) => {
+              value = Some(v);
+              None
+            }
+          }
+        });
+
+        // The queue was closed while waiting
+        let pushed = value.is_none();
+        if !pushed {
+          self.dropped.fetch_add(1, Ordering::Relaxed);
+        }
+
+        pushed
+      }
+    };
+
+    self.not_empty.notify();
+    res
+  }
+
+  /// Pop a value, waiting until one is available.
+  /// If `timeout` is [`None`], this waits indefinitely.
+  /// Returns [`None`] on timeout or if the queue is closed and empty.
+  pub(crate) fn pop(&self, timeout: Option<Duration>) -> Option<T> {
+    let deadline = timeout.map(|timeout| Instant::now() + timeout);
+    self
+      .not_empty
+      .wait_for(deadline, || match self.try_pop() {
+        Some(value) => Some(Some(value)),
+        None if self.is_closed() => Some(None),
+        None => None,
+      })
+      .flatten()
+  }
+
+  pub(crate) fn try_push(&self, value: T) -> Result<(), T> {
+    let mut pos = self.tail.load(Ordering::Relaxed);
+
+    loop {
+      let slot = &self.buffer[pos % self.capacity()];
+      let sequence = slot.sequence.load(Ordering::Acquire);
+      let diff = sequence as isize - (2 * pos) as isize;
+
+      if diff == 0 {
+        match self
+          .tail
+          .compare_exchange_weak(pos, pos + 1, Ordering::Relaxed, Ordering::Relaxed)
+        {
+          Ok(_) => {
+            unsafe { (*slot.value.get()).write(value) };
+            slot.sequence.store(2 * pos + 1, Ordering::Release);
+
+            return Ok(());
+          }
+          Err(current) => pos = current,
+        }
+      } else if diff < 0 {
+        return Err(value);
+      } else {
+        pos = self.tail.load(Ordering::Relaxed);
+      }
+    }
+  }
+
+  pub(crate) fn try_pop(&self) -> Option<T> {
+    let mut pos = self.head.load(Ordering::Relaxed);
+
+    let res = loop {
+      let slot = &self.buffer[pos % self.capacity()];
+      let sequence = slot.sequence.load(Ordering::Acquire);
+      let diff = sequence as isize - (2 * pos + 1) as isize;
+
+      if diff == 0 {
+        match self
+          .head
+          .compare_exchange_weak(pos, pos + 1, Ordering::Relaxed, Ordering::Relaxed)
+        {
+          Ok(_) => {
+            let value = unsafe { (*slot.value.get()).assume_init_read() };
+            slot
+              .sequence
+              .store(2 * (pos + self.capacity()), Ordering::Release);
+
+            break Some(value);
+          }
+          Err(current) => pos = current,
+        }
+      } else if diff < 0 {
+        break None;
+      } else {
+        pos = self.head.load(Ordering::Relaxed);
+      }
+    };
+
+    if res.is_some() && self.drop_policy == DropPolicy::Block {
+      self.not_full.notify();
+    }
+
+    res
+  }
+}
+
+impl<T> Drop for BoundedQueue<T> {
+  fn drop(&mut self) {
+    while self.try_pop().is_some() {}
+  }
+}
@@ -1,17 +1,37 @@
-use crate::ffi::libfreenect2::create_logger;
+use crate::ffi::libfreenect2::{create_logger, LogLevel};
+use log::LevelFilter;
 use std::sync::Once;
 
 static LOGGER_INIT: Once = Once::new();
 
+/// Map a `log` level filter to the most verbose libfreenect2
+/// level it lets through.
+pub(crate) fn to_log_level(filter: LevelFilter) -> LogLevel {
+  match filter {
+    LevelFilter::Off => LogLevel::None,
+    LevelFilter::Error => LogLevel::Error,
+    LevelFilter::Warn => LogLevel::Warning,
+    LevelFilter::Info => LogLevel::Info,
+    LevelFilter::Debug | LevelFilter::Trace => LogLevel::Debug,
+  }
+}
+
+fn max_log_level() -> LogLevel {
+  to_log_level(log::max_level())
+}
+
 pub(crate) fn init_logger() {
   LOGGER_INIT.call_once(|| {
-    create_logger(|level, message| match level {
-      crate::ffi::libfreenect2::LogLevel::Error => log::error!("{}", message),
-      crate::ffi::libfreenect2::LogLevel::Warning => log::warn!("{}", message),
-      crate::ffi::libfreenect2::LogLevel::Info => log::info!("{}", message),
-      crate::ffi::libfreenect2::LogLevel::Debug => log::debug!("{}", message),
-      _ => log::error!("Unknown log level: {}", message),
-    })
+    create_logger(
+      |level, message| match level {
+        LogLevel::Error => log::error!("{}", message),
+        LogLevel::Warning => log::warn!("{}", message),
+        LogLevel::Info => log::info!("{}", message),
+        LogLevel::Debug => log::debug!("{}", message),
+        _ => log::error!("Unknown log level: {}", message),
+      },
+      max_log_level,
+    )
     .unwrap();
   });
 }
@@ -1 +1,2 @@
+pub(crate) mod bounded_queue;
 pub(crate) mod logger;